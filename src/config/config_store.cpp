@@ -265,7 +265,14 @@ void WssConfigStore::set_defaults() {
   root["sd_cs_gpio"] = board_default_gpio("sd.cs", 13);
   root["sd_required"] = false;
   root["log_retention_days"] = 365;
+  root["log_quota_mb"] = 0;
+  root["log_min_free_mb"] = 64;
+  root["log_archive_after_days"] = 30;
   root["hash_chain_logs"] = true;
+  root["sd_flush_mode"] = "severity";
+  root["sd_flush_interval_ms"] = 1000;
+  root["log_prealloc_kb"] = 1024;
+  root["log_format"] = "jsonl";
   root["factory_restore_wipes_logs"] = false;
   root["factory_restore_wipes_allowlist"] = true;
   root["factory_restore_requires_hold"] = true;
@@ -366,6 +373,13 @@ bool WssConfigStore::validate_or_recover(String& err) {
   if (!root["sd_enabled"].is<bool>()) root["sd_enabled"] = true;
   if (!root["sd_cs_gpio"].is<long>()) root["sd_cs_gpio"] = board_default_gpio("sd.cs", 13);
   if (!root["sd_required"].is<bool>()) root["sd_required"] = false;
+  if (!root.containsKey("sd_flush_mode") || !root["sd_flush_mode"].is<const char*>()) root["sd_flush_mode"] = "severity";
+  if (!root["sd_flush_interval_ms"].is<long>()) root["sd_flush_interval_ms"] = 1000;
+  if (!root["log_prealloc_kb"].is<long>()) root["log_prealloc_kb"] = 1024;
+  if (!root.containsKey("log_format") || !root["log_format"].is<const char*>()) root["log_format"] = "jsonl";
+  if (!root["log_quota_mb"].is<long>()) root["log_quota_mb"] = 0;
+  if (!root["log_min_free_mb"].is<long>()) root["log_min_free_mb"] = 64;
+  if (!root["log_archive_after_days"].is<long>()) root["log_archive_after_days"] = 30;
 
   return true;
 }
@@ -0,0 +1,22 @@
+// src/crc32.cpp
+// Role: CRC-32 (IEEE 802.3, as used by gzip) for streams and on-flash records.
+
+#include "crc32.h"
+
+uint32_t wss_crc32_update(uint32_t crc, const uint8_t* data, size_t len) {
+  // Nibble table: 64 bytes of flash instead of 1 KB.
+  static const uint32_t kTable[16] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+      0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+      0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ kTable[crc & 0x0F];
+    crc = (crc >> 4) ^ kTable[crc & 0x0F];
+  }
+  return crc;
+}
+
+uint32_t wss_crc32(const void* data, size_t len) {
+  return wss_crc32_update(0xFFFFFFFFUL, static_cast<const uint8_t*>(data), len) ^ 0xFFFFFFFFUL;
+}
@@ -0,0 +1,10 @@
+// src/crc32.h
+// Role: CRC-32 (IEEE 802.3, as used by gzip) for streams and on-flash records.
+#pragma once
+#include <Arduino.h>
+
+// Start with 0xFFFFFFFF, feed any number of buffers, finish with ^ 0xFFFFFFFF.
+uint32_t wss_crc32_update(uint32_t crc, const uint8_t* data, size_t len);
+
+// One-shot CRC-32 of a buffer.
+uint32_t wss_crc32(const void* data, size_t len);
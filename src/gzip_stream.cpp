@@ -0,0 +1,216 @@
+// src/gzip_stream.cpp
+// Role: Streaming gzip encoder (LZ77 + fixed-Huffman deflate) with a bounded window.
+//
+// Input is buffered in a 2-window array; matches are found through hash chains limited to
+// WSS_GZIP_MAX_CHAIN candidates and encoded with the fixed Huffman tables (RFC 1951 3.2.6),
+// so no per-block statistics are needed and output leaves in 512-byte pieces. JSONL logs
+// are repetitive enough that this already yields several-fold compression.
+
+#include "gzip_stream.h"
+
+#include <string.h>
+
+#include "crc32.h"
+#include "psram_alloc.h"
+
+static_assert(WSS_GZIP_WINDOW_BITS >= 9 && WSS_GZIP_WINDOW_BITS <= 14,
+              "WSS_GZIP_WINDOW_BITS must be 9..14 (positions are stored as uint16)");
+
+static const size_t kWindow = (size_t)1 << WSS_GZIP_WINDOW_BITS;
+static const size_t kWindowMask = kWindow - 1;
+static const size_t kBufBytes = 2 * kWindow;
+static const uint32_t kHashBits = 12;
+static const uint32_t kHashSize = 1UL << kHashBits;
+static const size_t kMinMatch = 3;
+static const size_t kMaxMatch = 258;
+
+static const uint16_t kLenBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,
+                                      15, 17, 19, 23, 27, 31, 35, 43, 51,  59,
+                                      67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t kLenExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t kDistBase[30] = {1,    2,    3,    4,    5,    7,     9,     13,
+                                       17,   25,   33,   49,   65,   97,    129,   193,
+                                       257,  385,  513,  769,  1025, 1537,  2049,  3073,
+                                       4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                       6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static uint32_t reverse_bits(uint32_t v, uint32_t n) {
+  uint32_t r = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    r = (r << 1) | (v & 1);
+    v >>= 1;
+  }
+  return r;
+}
+
+WssGzipStream::~WssGzipStream() {
+  wss_large_free(_win);
+  wss_large_free(_head);
+  wss_large_free(_prev);
+}
+
+bool WssGzipStream::reserve() {
+  if (_win && _head && _prev) return true;
+  if (!_win) _win = static_cast<uint8_t*>(wss_large_alloc(kBufBytes));
+  if (!_head) _head = static_cast<uint16_t*>(wss_large_alloc(kHashSize * sizeof(uint16_t)));
+  if (!_prev) _prev = static_cast<uint16_t*>(wss_large_alloc(kWindow * sizeof(uint16_t)));
+  return _win && _head && _prev;
+}
+
+bool WssGzipStream::begin(Print& out) {
+  _out = &out;
+  if (!reserve()) {
+    _failed = true;
+    return false;
+  }
+  memset(_head, 0, kHashSize * sizeof(uint16_t));
+  memset(_prev, 0, kWindow * sizeof(uint16_t));
+
+  // gzip member header: deflate, no name, mtime 0, OS unknown.
+  static const uint8_t kHeader[10] = {0x1F, 0x8B, 0x08, 0x00, 0, 0, 0, 0, 0x00, 0xFF};
+  for (uint8_t b : kHeader) put_byte(b);
+  put_bits(0 | (1 << 1), 3); // BFINAL=0, BTYPE=01 (fixed Huffman); one block until finish()
+  return true;
+}
+
+size_t WssGzipStream::write(const uint8_t* data, size_t len) {
+  if (_failed || _finished || !_win) return 0;
+  size_t done = 0;
+  while (done < len) {
+    if (_end == kBufBytes) slide();
+    size_t n = kBufBytes - _end;
+    if (n > len - done) n = len - done;
+    memcpy(_win + _end, data + done, n);
+    _crc = wss_crc32_update(_crc, data + done, n);
+    _end += n;
+    done += n;
+    compress(false);
+  }
+  _bytes_in += len;
+  return _failed ? 0 : len;
+}
+
+bool WssGzipStream::finish() {
+  if (_finished) return !_failed;
+  _finished = true;
+  if (!_win) return false;
+  compress(true);
+  put_huff(256);             // end of the streaming block
+  put_bits(1 | (1 << 1), 3); // empty final fixed block
+  put_huff(256);
+  if (_bitcount) put_bits(0, 8 - _bitcount);
+  uint32_t crc = _crc ^ 0xFFFFFFFFUL;
+  uint32_t isize = (uint32_t)_bytes_in;
+  for (int i = 0; i < 4; i++) put_byte((uint8_t)(crc >> (8 * i)));
+  for (int i = 0; i < 4; i++) put_byte((uint8_t)(isize >> (8 * i)));
+  flush_out();
+  return !_failed;
+}
+
+// Keeps the newest window of history; positions in the hash tables shift down with it.
+void WssGzipStream::slide() {
+  memmove(_win, _win + kWindow, kBufBytes - kWindow);
+  _pos -= kWindow;
+  _end -= kWindow;
+  for (uint32_t i = 0; i < kHashSize; i++) _head[i] = _head[i] > kWindow ? _head[i] - kWindow : 0;
+  for (size_t i = 0; i < kWindow; i++) _prev[i] = _prev[i] > kWindow ? _prev[i] - kWindow : 0;
+}
+
+static inline uint32_t hash3(const uint8_t* p) {
+  uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+  return (uint32_t)(v * 2654435761UL) >> (32 - kHashBits);
+}
+
+void WssGzipStream::insert(size_t pos) {
+  uint32_t h = hash3(_win + pos);
+  _prev[pos & kWindowMask] = _head[h];
+  _head[h] = (uint16_t)(pos + 1);
+}
+
+void WssGzipStream::compress(bool final_input) {
+  while (_pos < _end) {
+    size_t avail = _end - _pos;
+    // Keep a full match of lookahead until the input is complete.
+    if (!final_input && avail < kMaxMatch) break;
+    size_t best_len = 0;
+    size_t best_dist = 0;
+    if (avail >= kMinMatch) {
+      uint32_t h = hash3(_win + _pos);
+      uint32_t cand = _head[h];
+      _prev[_pos & kWindowMask] = (uint16_t)cand;
+      _head[h] = (uint16_t)(_pos + 1);
+      size_t max_len = avail < kMaxMatch ? avail : kMaxMatch;
+      for (uint32_t chain = WSS_GZIP_MAX_CHAIN; cand && chain; chain--) {
+        size_t c = cand - 1;
+        if (c >= _pos || _pos - c > kWindow) break;
+        if (_win[c + best_len] == _win[_pos + best_len]) {
+          size_t len = 0;
+          while (len < max_len && _win[c + len] == _win[_pos + len]) len++;
+          if (len > best_len) {
+            best_len = len;
+            best_dist = _pos - c;
+            if (len == max_len) break;
+          }
+        }
+        cand = _prev[c & kWindowMask];
+      }
+    }
+    if (best_len >= kMinMatch) {
+      emit_match(best_len, best_dist);
+      for (size_t i = 1; i < best_len; i++) {
+        if (_end - (_pos + i) >= kMinMatch) insert(_pos + i);
+      }
+      _pos += best_len;
+    } else {
+      emit_literal(_win[_pos]);
+      _pos++;
+    }
+  }
+}
+
+void WssGzipStream::put_huff(uint32_t sym) {
+  if (sym < 144) put_bits(reverse_bits(0x30 + sym, 8), 8);
+  else if (sym < 256) put_bits(reverse_bits(0x190 + (sym - 144), 9), 9);
+  else if (sym < 280) put_bits(reverse_bits(sym - 256, 7), 7);
+  else put_bits(reverse_bits(0xC0 + (sym - 280), 8), 8);
+}
+
+void WssGzipStream::emit_literal(uint8_t c) {
+  put_huff(c);
+}
+
+void WssGzipStream::emit_match(size_t len, size_t dist) {
+  int li = 28;
+  while (li > 0 && kLenBase[li] > len) li--;
+  put_huff(257 + li);
+  if (kLenExtra[li]) put_bits((uint32_t)(len - kLenBase[li]), kLenExtra[li]);
+  int di = 29;
+  while (di > 0 && kDistBase[di] > dist) di--;
+  put_bits(reverse_bits((uint32_t)di, 5), 5);
+  if (kDistExtra[di]) put_bits((uint32_t)(dist - kDistBase[di]), kDistExtra[di]);
+}
+
+void WssGzipStream::put_bits(uint32_t bits, uint32_t n) {
+  _bitbuf |= bits << _bitcount;
+  _bitcount += n;
+  while (_bitcount >= 8) {
+    put_byte((uint8_t)_bitbuf);
+    _bitbuf >>= 8;
+    _bitcount -= 8;
+  }
+}
+
+void WssGzipStream::put_byte(uint8_t b) {
+  _obuf[_olen++] = b;
+  if (_olen == sizeof(_obuf)) flush_out();
+}
+
+void WssGzipStream::flush_out() {
+  if (!_olen || !_out) return;
+  size_t wrote = _out->write(_obuf, _olen);
+  if (wrote != _olen) _failed = true;
+  _bytes_out += wrote;
+  _olen = 0;
+}
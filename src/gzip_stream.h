@@ -0,0 +1,68 @@
+// src/gzip_stream.h
+// Role: Streaming gzip encoder (LZ77 + fixed-Huffman deflate) with a bounded window, used to
+// compress log exports on the fly without buffering whole files.
+#pragma once
+
+#include <Arduino.h>
+
+// Window size as a power of two (max 14). The working set is about 6 * 2^bits bytes plus an
+// 8 KB hash table; it comes from PSRAM when available (wss_large_alloc).
+#ifndef WSS_GZIP_WINDOW_BITS
+#define WSS_GZIP_WINDOW_BITS 12
+#endif
+
+// Hash-chain candidates examined per position (speed vs. ratio).
+#ifndef WSS_GZIP_MAX_CHAIN
+#define WSS_GZIP_MAX_CHAIN 16
+#endif
+
+class WssGzipStream : public Print {
+ public:
+  WssGzipStream() = default;
+  ~WssGzipStream();
+  WssGzipStream(const WssGzipStream&) = delete;
+  WssGzipStream& operator=(const WssGzipStream&) = delete;
+
+  // Allocates the window; lets callers pick gzip before committing response headers.
+  bool reserve();
+
+  // reserve() if needed, then starts the gzip member on `out`. False when out of memory.
+  bool begin(Print& out);
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* data, size_t len) override;
+
+  // Compresses pending input and writes the final block and gzip trailer.
+  bool finish();
+
+  uint64_t bytes_in() const { return _bytes_in; }
+  uint64_t bytes_out() const { return _bytes_out; }
+  bool failed() const { return _failed; }
+
+ private:
+  void compress(bool final_input);
+  void insert(size_t pos);
+  void slide();
+  void emit_literal(uint8_t c);
+  void emit_match(size_t len, size_t dist);
+  void put_huff(uint32_t sym);
+  void put_bits(uint32_t bits, uint32_t n);
+  void put_byte(uint8_t b);
+  void flush_out();
+
+  Print* _out = nullptr;
+  uint8_t* _win = nullptr;    // 2 * window bytes: history + lookahead
+  uint16_t* _head = nullptr;  // hash -> pos + 1 (0 = empty)
+  uint16_t* _prev = nullptr;  // pos & mask -> previous pos + 1 with the same hash
+  size_t _pos = 0;            // next byte to encode
+  size_t _end = 0;            // end of buffered input
+  uint32_t _bitbuf = 0;
+  uint32_t _bitcount = 0;
+  uint8_t _obuf[512];
+  size_t _olen = 0;
+  uint32_t _crc = 0xFFFFFFFFUL;
+  uint64_t _bytes_in = 0;
+  uint64_t _bytes_out = 0;
+  bool _finished = false;
+  bool _failed = false;
+};
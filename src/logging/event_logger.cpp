@@ -6,45 +6,87 @@
 #include <Preferences.h>
 #include <time.h>
 
+#include "../psram_alloc.h"
 #include "../storage/storage_manager.h"
 
 static const char* kPrefsNamespace = "wss";
 static const char* kPrefsKeySeq = "event_seq";
 
-bool WssEventLogger::begin() {
-  // Ensure sequence key exists.
+static bool seq_lease_load(uint32_t& out_high_water, void* ctx) {
+  (void)ctx;
   Preferences prefs;
-  if (!prefs.begin(kPrefsNamespace, false)) {
-    // No persistence, but logger still works.
-    return false;
-  }
-  (void)prefs.getULong(kPrefsKeySeq, 0);
+  if (!prefs.begin(kPrefsNamespace, false)) return false;
+  // Older firmware stored the last used seq here; it is a valid high-water mark too.
+  out_high_water = prefs.getULong(kPrefsKeySeq, 0);
   prefs.end();
   return true;
 }
 
+static bool seq_lease_store(uint32_t high_water, void* ctx) {
+  (void)ctx;
+  Preferences prefs;
+  if (!prefs.begin(kPrefsNamespace, false)) return false;
+  bool ok = prefs.putULong(kPrefsKeySeq, high_water) > 0;
+  prefs.end();
+  return ok;
+}
+
+bool WssEventLogger::begin() {
+  // Recent-events ring (PSRAM on boards that have it). Allocated once.
+  if (!_ring_lock) _ring_lock = xSemaphoreCreateMutex();
+  if (!_seq_lock) _seq_lock = xSemaphoreCreateMutex();
+  if (!_ring.ok()) {
+    uint8_t* arena = static_cast<uint8_t*>(wss_large_alloc(WSS_EVENT_RING_BYTES));
+    auto* index = static_cast<WssEventRing::IndexEntry*>(
+      wss_large_alloc(sizeof(WssEventRing::IndexEntry) * WSS_EVENT_RING_MAX_RECORDS));
+    if (!_ring.begin(arena, WSS_EVENT_RING_BYTES, index, WSS_EVENT_RING_MAX_RECORDS)) {
+      wss_large_free(arena);
+      wss_large_free(index);
+    }
+  }
+
+  // Line slots for the storage writer's queue, so producers never allocate.
+  (void)wss_storage_queue_begin();
+
+  // Resume past the last persisted lease so seqs stay monotonic after a crash.
+  _seq.begin(WSS_LOG_SEQ_LEASE_BLOCK, seq_lease_load, seq_lease_store, nullptr);
+  // No persistence still leaves a working (RAM-only) logger.
+  return _seq.stats().persistent;
+}
+
 uint32_t WssEventLogger::reserve_seq() {
   return next_seq();
 }
 
 uint32_t WssEventLogger::next_seq() {
-  Preferences prefs;
-  uint32_t seq = 0;
-  if (prefs.begin(kPrefsNamespace, false)) {
-    seq = prefs.getULong(kPrefsKeySeq, 0);
-    seq++;
-    prefs.putULong(kPrefsKeySeq, seq);
-    prefs.end();
-  } else {
-    // Best effort in RAM only.
-    static uint32_t fallback = 0;
-    seq = ++fallback;
-  }
+  if (!_seq.started()) (void)begin();
+  // One NVS write per WSS_LOG_SEQ_LEASE_BLOCK seqs instead of one per event. The loop task
+  // and the storage writer (file headers, checkpoints) both draw seqs, so the lease check,
+  // increment and extension run under one lock; the NVS commit of a new lease happens inside
+  // it, which only ever stalls the other caller once per block.
+  xSemaphoreTake(_seq_lock, portMAX_DELAY);
+  const uint32_t seq = _seq.next();
+  xSemaphoreGive(_seq_lock);
   return seq;
 }
 
-String WssEventLogger::iso8601_now(bool& time_valid) const {
-  time_t now = time(nullptr);
+WssSeqLeaseStats WssEventLogger::seq_stats() const {
+  if (!_seq_lock) return _seq.stats();
+  xSemaphoreTake(_seq_lock, portMAX_DELAY);
+  WssSeqLeaseStats s = _seq.stats();
+  xSemaphoreGive(_seq_lock);
+  return s;
+}
+
+static WssLogSeverity severity_from_string(const char* severity) {
+  if (!severity) return WSS_LOG_SEV_INFO;
+  if (strcmp(severity, "debug") == 0) return WSS_LOG_SEV_DEBUG;
+  if (strcmp(severity, "warn") == 0) return WSS_LOG_SEV_WARN;
+  if (strcmp(severity, "error") == 0) return WSS_LOG_SEV_ERROR;
+  return WSS_LOG_SEV_INFO;
+}
+
+String WssEventLogger::iso8601_at(time_t now, bool& time_valid) const {
   // If time hasn't been set, ESP32 time will often be near epoch.
   time_valid = (now > 1700000000);
   struct tm tm_utc;
@@ -56,10 +98,18 @@ String WssEventLogger::iso8601_now(bool& time_valid) const {
 
 void WssEventLogger::log_internal(const char* severity, const char* source, const char* event_type,
                                   const String& msg, const JsonObjectConst* extra) {
+  if (!_seq.started()) (void)begin();
+  // Seq order is publication order: the recent-events ring is binary-searched by seq
+  // (after_seq) and day-file readers stop at the first seq past a query's range. So the
+  // seq is drawn, and the event pushed to the ring and the storage queue, under one lock;
+  // otherwise the loop task and the storage writer could publish N+1 before N.
+  xSemaphoreTake(_seq_lock, portMAX_DELAY);
   StaticJsonDocument<512> d;
   bool time_valid = false;
-  d["ts"] = iso8601_now(time_valid);
-  d["seq"] = next_seq();
+  const time_t now = time(nullptr);
+  const uint32_t seq = _seq.next();
+  d["ts"] = iso8601_at(now, time_valid);
+  d["seq"] = seq;
   d["event_type"] = event_type;
   d["severity"] = severity;
   d["source"] = source;
@@ -75,15 +125,36 @@ void WssEventLogger::log_internal(const char* severity, const char* source, cons
   String line;
   serializeJson(d, line);
 
-  _events[_head] = line;
-  _head = (_head + 1) % kMaxEvents;
-  if (_count < kMaxEvents) _count++;
+  // RAM ring keeps structured fields; `extra` is stored pre-serialized (braces stripped).
+  WssEventRecordIn rec;
+  rec.seq = seq;
+  rec.ts_epoch = (uint32_t)now;
+  rec.time_valid = time_valid;
+  rec.severity = (uint8_t)severity_from_string(severity);
+  rec.source = source;
+  rec.event_type = event_type;
+  rec.msg = msg.c_str();
+  rec.msg_len = msg.length();
+  char extra_buf[WssEventRing::kMaxExtraBytes + 3];
+  if (extra && extra->size() > 0) {
+    size_t n = serializeJson(*extra, extra_buf, sizeof(extra_buf));
+    if (n > 2 && n < sizeof(extra_buf) - 1) {
+      rec.extra_json = extra_buf + 1;
+      rec.extra_len = n - 2;
+    }
+  }
+  ring_push(rec);
+
+  // Queue for the storage writer (SD preferred, flash ring fallback). Never blocks;
+  // under overflow, debug lines are dropped first (counted in /api/status).
+  // State transitions are alarm evidence: flushed at once in `severity` durability mode.
+  uint8_t flags = (event_type && strcmp(event_type, "state_transition") == 0)
+    ? WSS_LOG_FLAG_DURABLE : WSS_LOG_FLAG_NONE;
+  (void)wss_storage_append_line(line, severity_from_string(severity), flags);
+  xSemaphoreGive(_seq_lock);
 
   // Serial is useful during bring-up; no secrets should reach here.
   Serial.println(line);
-
-  // Persist to active backend (SD preferred, flash ring fallback). Best-effort.
-  (void)wss_storage_append_line(line);
 }
 
 void WssEventLogger::log_debug(const char* source, const char* event_type, const String& msg, const JsonObjectConst* extra) {
@@ -109,20 +180,45 @@ void WssEventLogger::log_config_change(const char* source, const JsonArrayConst&
   log_internal("info", source, "config_change", "config keys updated", &o);
 }
 
-void WssEventLogger::recent_events(JsonDocument& out, size_t limit) const {
-  out.clear();
-  JsonArray arr = out.to<JsonArray>();
-  if (_count == 0) return;
+void WssEventLogger::ring_push(const WssEventRecordIn& rec) {
+  if (!_ring_lock || !_ring.ok()) return;
+  xSemaphoreTake(_ring_lock, portMAX_DELAY);
+  _ring.push(rec);
+  xSemaphoreGive(_ring_lock);
+}
 
-  size_t n = _count;
-  if (limit > 0 && limit < n) n = limit;
+size_t WssEventLogger::write_recent_events_json(Print& out, size_t limit, uint32_t after_seq) {
+  out.print('[');
+  if (!_ring_lock || !_ring.ok()) {
+    out.print(']');
+    return 0;
+  }
 
-  // Oldest first.
-  size_t start = (_head + kMaxEvents - _count) % kMaxEvents;
-  for (size_t i = 0; i < n; i++) {
-    size_t idx = (start + i) % kMaxEvents;
-    StaticJsonDocument<512> line;
-    DeserializationError de = deserializeJson(line, _events[idx]);
-    if (!de) arr.add(line);
+  xSemaphoreTake(_ring_lock, portMAX_DELAY);
+  uint64_t no = after_seq ? _ring.record_no_after_seq(after_seq) : _ring.oldest_record_no();
+  uint64_t end = _ring.end_record_no();
+  xSemaphoreGive(_ring_lock);
+  if (limit > 0 && end - no > limit) {
+    if (after_seq) end = no + limit;
+    else no = end - limit;
+  }
+
+  char* buf = static_cast<char*>(malloc(WssEventRing::kMaxJsonBytes));
+  if (!buf) {
+    out.print(']');
+    return 0;
+  }
+  size_t written = 0;
+  for (; no < end; no++) {
+    xSemaphoreTake(_ring_lock, portMAX_DELAY);
+    size_t len = _ring.format_json(no, buf, WssEventRing::kMaxJsonBytes);
+    xSemaphoreGive(_ring_lock);
+    if (!len) continue; // evicted while streaming
+    if (written) out.print(',');
+    out.write(reinterpret_cast<const uint8_t*>(buf), len);
+    written++;
   }
+  free(buf);
+  out.print(']');
+  return written;
 }
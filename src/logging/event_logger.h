@@ -4,11 +4,21 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "event_ring.h"
+#include "seq_lease.h"
+
+// Number of seqs reserved per NVS commit (see seq_lease.h).
+#ifndef WSS_LOG_SEQ_LEASE_BLOCK
+#define WSS_LOG_SEQ_LEASE_BLOCK 256
+#endif
 
 // NOTE: Persistent SD logging + hash chaining arrives in later milestones.
 // In M1, this logger provides:
-// - A monotonic sequence number (best-effort persisted in NVS)
-// - A RAM ring buffer of recent events for `/api/events`
+// - A monotonic sequence number (persisted in NVS as a leased high-water mark)
+// - A binary RAM ring of recent events for `/api/events` (see event_ring.h)
 // - A single helper to guarantee "no secrets in logs" (values are never accepted here)
 
 class WssEventLogger {
@@ -27,18 +37,29 @@ class WssEventLogger {
   // Adds a config change event. Only key names are allowed.
   void log_config_change(const char* source, const JsonArrayConst& changed_keys);
 
-  // Copies the last N events into `out` as a JSON array of objects.
-  void recent_events(JsonDocument& out, size_t limit) const;
+  // Streams recent events (oldest first) to `out` as a JSON array of objects.
+  // after_seq == 0: the last `limit` events; otherwise the first `limit` events with
+  // seq > after_seq. Records are formatted one at a time straight from the binary ring,
+  // and the ring lock is never held while writing to `out`. Returns events written.
+  size_t write_recent_events_json(Print& out, size_t limit, uint32_t after_seq = 0);
+
+  // Number of events currently held by the RAM ring (upper bound for `limit`).
+  size_t recent_capacity() const { return _ring.capacity_records(); }
+
+  // Sequence lease counters for `/api/status`.
+  WssSeqLeaseStats seq_stats() const;
 
  private:
   void log_internal(const char* severity, const char* source, const char* event_type, const String& msg,
                     const JsonObjectConst* extra);
 
-  String iso8601_now(bool& time_valid) const;
+  String iso8601_at(time_t now, bool& time_valid) const;
   uint32_t next_seq();
+  void ring_push(const WssEventRecordIn& rec);
+
+  WssSeqLease _seq;
+  SemaphoreHandle_t _seq_lock = nullptr; // serializes _seq and publishes events in seq order
 
-  static constexpr size_t kMaxEvents = 60;
-  String _events[kMaxEvents];
-  size_t _head = 0;
-  size_t _count = 0;
+  WssEventRing _ring;
+  SemaphoreHandle_t _ring_lock = nullptr;
 };
@@ -0,0 +1,261 @@
+// src/logging/event_ring.cpp
+// Role: Compact binary RAM ring of recent events (backs `/api/events` without JSON re-parsing).
+
+#include "event_ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Record layout (little-endian, packed):
+//   u32 seq | u32 ts_epoch | u16 source_id | u16 event_type_id | u16 msg_len | u16 extra_len
+//   | u8 severity | u8 flags | msg bytes | extra bytes
+static const uint8_t kFlagTimeInvalid = 0x01;
+
+static void put_u16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)(v & 0xFF);
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (uint8_t)((v >> (8 * i)) & 0xFF);
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t fnv1a(const char* s) {
+  uint32_t h = 2166136261UL;
+  while (*s) {
+    h ^= (uint8_t)*s++;
+    h *= 16777619UL;
+  }
+  return h;
+}
+
+static const char* severity_name(uint8_t sev) {
+  switch (sev) {
+    case 0: return "debug";
+    case 2: return "warn";
+    case 3: return "error";
+    default: return "info";
+  }
+}
+
+bool WssEventRing::begin(uint8_t* arena, size_t arena_bytes, IndexEntry* index, size_t max_records) {
+  if (!arena || !index || max_records == 0 || arena_bytes < kHeaderBytes + kMaxMsgBytes + kMaxExtraBytes) {
+    _arena = nullptr;
+    return false;
+  }
+  _arena = arena;
+  _arena_bytes = arena_bytes;
+  _index = index;
+  _max_records = max_records;
+  _oldest = 0;
+  _count = 0;
+  _write_off = 0;
+  _pushed = 0;
+  _evicted = 0;
+  return true;
+}
+
+uint16_t WssEventRing::intern(const char* s) {
+  if (!s) s = "";
+  const size_t nslots = sizeof(_slots) / sizeof(_slots[0]);
+  size_t i = fnv1a(s) & (nslots - 1);
+  for (size_t probe = 0; probe < nslots; probe++) {
+    uint16_t v = _slots[i];
+    if (v == 0) break;
+    if (strcmp(_strings[v - 1], s) == 0) return (uint16_t)(v - 1);
+    i = (i + 1) & (nslots - 1);
+  }
+  if (_string_count >= kInternSlots) return kNoId;
+  char* copy = strdup(s);
+  if (!copy) return kNoId;
+  _strings[_string_count] = copy;
+  _slots[i] = (uint16_t)(_string_count + 1);
+  return _string_count++;
+}
+
+const char* WssEventRing::interned(uint16_t id) const {
+  if (id == kNoId || id >= _string_count) return "unknown";
+  return _strings[id];
+}
+
+void WssEventRing::evict_oldest() {
+  if (_count == 0) return;
+  _oldest = (_oldest + 1) % _max_records;
+  _count--;
+  _evicted++;
+}
+
+// Returns the offset for a `len`-byte record, evicting the oldest records it overlaps.
+// Live bytes always run from the oldest record up to _write_off (circularly).
+size_t WssEventRing::reserve_at(size_t len) {
+  size_t p = _write_off;
+  for (;;) {
+    if (_count == 0) {
+      if (p + len > _arena_bytes) p = 0;
+      return p;
+    }
+    size_t oldest_off = entry(0).off;
+    if (oldest_off < p) {
+      // Live data sits behind us; [p, end) is free.
+      if (p + len <= _arena_bytes) return p;
+      p = 0;  // wrap; the tail gap stays unused
+      continue;
+    }
+    if (oldest_off - p >= len) return p;
+    evict_oldest();
+  }
+}
+
+void WssEventRing::push(const WssEventRecordIn& rec) {
+  if (!_arena) return;
+  size_t msg_len = rec.msg ? rec.msg_len : 0;
+  size_t extra_len = rec.extra_json ? rec.extra_len : 0;
+  if (msg_len > kMaxMsgBytes) {
+    msg_len = kMaxMsgBytes;
+    // Don't split a UTF-8 sequence.
+    while (msg_len > 0 && ((uint8_t)rec.msg[msg_len] & 0xC0) == 0x80) msg_len--;
+  }
+  // A cut extra fragment would be invalid JSON; drop it instead.
+  if (extra_len > kMaxExtraBytes) extra_len = 0;
+  const size_t len = kHeaderBytes + msg_len + extra_len;
+
+  if (_count == _max_records) evict_oldest();
+  size_t off = reserve_at(len);
+
+  uint8_t* p = _arena + off;
+  put_u32(p, rec.seq);
+  put_u32(p + 4, rec.ts_epoch);
+  put_u16(p + 8, intern(rec.source));
+  put_u16(p + 10, intern(rec.event_type));
+  put_u16(p + 12, (uint16_t)msg_len);
+  put_u16(p + 14, (uint16_t)extra_len);
+  p[16] = rec.severity;
+  p[17] = rec.time_valid ? 0 : kFlagTimeInvalid;
+  if (msg_len) memcpy(p + kHeaderBytes, rec.msg, msg_len);
+  if (extra_len) memcpy(p + kHeaderBytes + msg_len, rec.extra_json, extra_len);
+
+  IndexEntry& e = _index[(_oldest + _count) % _max_records];
+  e.seq = rec.seq;
+  e.off = (uint32_t)off;
+  e.len = (uint16_t)len;
+  _count++;
+  _pushed++;
+  _write_off = off + len;
+}
+
+uint64_t WssEventRing::record_no_after_seq(uint32_t seq) const {
+  size_t lo = 0;
+  size_t hi = _count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (entry(mid).seq <= seq) lo = mid + 1;
+    else hi = mid;
+  }
+  return oldest_record_no() + lo;
+}
+
+namespace {
+
+struct JsonOut {
+  char* buf;
+  size_t cap;
+  size_t len;
+  bool overflow;
+
+  void raw(const char* s, size_t n) {
+    if (overflow || len + n >= cap) {
+      overflow = true;
+      return;
+    }
+    memcpy(buf + len, s, n);
+    len += n;
+  }
+  void raw(const char* s) { raw(s, strlen(s)); }
+
+  // JSON string body (without quotes); stops early (keeping `reserve` bytes) instead of failing.
+  void escaped(const char* s, size_t n, size_t reserve) {
+    for (size_t i = 0; i < n && !overflow; i++) {
+      if (len + 6 + reserve >= cap) return;
+      char c = s[i];
+      if (c == '"' || c == '\\') {
+        char e[2] = {'\\', c};
+        raw(e, 2);
+      } else if (c == '\n') {
+        raw("\\n", 2);
+      } else if (c == '\r') {
+        raw("\\r", 2);
+      } else if (c == '\t') {
+        raw("\\t", 2);
+      } else if ((uint8_t)c < 0x20) {
+        char e[8];
+        snprintf(e, sizeof(e), "\\u%04x", (unsigned)(uint8_t)c);
+        raw(e);
+      } else {
+        raw(&c, 1);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+size_t WssEventRing::format_json(uint64_t no, char* buf, size_t cap, uint32_t* seq_out) const {
+  if (!_arena || !buf || cap == 0) return 0;
+  if (no < oldest_record_no() || no >= end_record_no()) return 0;
+  const IndexEntry& e = entry((size_t)(no - oldest_record_no()));
+  const uint8_t* p = _arena + e.off;
+
+  uint32_t seq = get_u32(p);
+  time_t ts = (time_t)get_u32(p + 4);
+  const char* source = interned(get_u16(p + 8));
+  const char* event_type = interned(get_u16(p + 10));
+  uint16_t msg_len = get_u16(p + 12);
+  uint16_t extra_len = get_u16(p + 14);
+  uint8_t sev = p[16];
+  bool time_valid = (p[17] & kFlagTimeInvalid) == 0;
+  const char* msg = reinterpret_cast<const char*>(p + kHeaderBytes);
+  const char* extra = msg + msg_len;
+
+  struct tm tm_utc;
+  gmtime_r(&ts, &tm_utc);
+  char ts_buf[32];
+  strftime(ts_buf, sizeof(ts_buf), "%Y-%m-%dT%H:%M:%SZ", &tm_utc);
+  char seq_buf[12];
+  snprintf(seq_buf, sizeof(seq_buf), "%lu", (unsigned long)seq);
+
+  // Same key order as WssEventLogger::log_internal().
+  JsonOut o{buf, cap, 0, false};
+  o.raw("{\"ts\":\"");
+  o.raw(ts_buf);
+  o.raw("\",\"seq\":");
+  o.raw(seq_buf);
+  o.raw(",\"event_type\":\"");
+  o.escaped(event_type, strlen(event_type), 0);
+  o.raw("\",\"severity\":\"");
+  o.raw(severity_name(sev));
+  o.raw("\",\"source\":\"");
+  o.escaped(source, strlen(source), 0);
+  o.raw("\",\"msg\":\"");
+  o.escaped(msg, msg_len, extra_len + 24);
+  o.raw("\"");
+  if (!time_valid) o.raw(",\"time_valid\":false");
+  if (extra_len) {
+    o.raw(",");
+    o.raw(extra, extra_len);
+  }
+  o.raw("}");
+  if (o.overflow) return 0;
+  buf[o.len] = 0;
+  if (seq_out) *seq_out = seq;
+  return o.len;
+}
@@ -0,0 +1,93 @@
+// src/logging/event_ring.h
+// Role: Compact binary RAM ring of recent events (backs `/api/events` without JSON re-parsing).
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Arena + index sizes. The S3 build raises these (records live in PSRAM there).
+#ifndef WSS_EVENT_RING_BYTES
+#define WSS_EVENT_RING_BYTES 8192
+#endif
+#ifndef WSS_EVENT_RING_MAX_RECORDS
+#define WSS_EVENT_RING_MAX_RECORDS 128
+#endif
+
+// Structured fields of one event. `extra_json` is the already-serialized body of the
+// `extra` object without its braces (e.g. `"k":1,"s":"v"`), so it is emitted verbatim.
+struct WssEventRecordIn {
+  uint32_t seq = 0;
+  uint32_t ts_epoch = 0;
+  bool time_valid = true;
+  uint8_t severity = 1;  // WssLogSeverity
+  const char* source = "";
+  const char* event_type = "";
+  const char* msg = "";
+  size_t msg_len = 0;
+  const char* extra_json = "";
+  size_t extra_len = 0;
+};
+
+// Records are packed back to back in a circular byte arena; a parallel index ring keeps
+// (seq, offset, length) per live record. source/event_type are interned to 16-bit IDs.
+// Not thread-safe: the owner serializes access.
+class WssEventRing {
+ public:
+  struct IndexEntry {
+    uint32_t seq;
+    uint32_t off;
+    uint16_t len;
+  };
+
+  static const size_t kMaxMsgBytes = 200;
+  static const size_t kMaxExtraBytes = 600;
+  // Worst case JSON for one record (escaped msg + extra + fixed fields).
+  static const size_t kMaxJsonBytes = 2048;
+
+  bool begin(uint8_t* arena, size_t arena_bytes, IndexEntry* index, size_t max_records);
+  bool ok() const { return _arena != nullptr; }
+
+  void push(const WssEventRecordIn& rec);
+
+  size_t count() const { return _count; }
+  size_t capacity_records() const { return _max_records; }
+  size_t arena_bytes() const { return _arena_bytes; }
+  uint32_t evicted() const { return _evicted; }
+
+  // Record numbers are a monotonic cursor (total records ever pushed); they stay valid
+  // across eviction so a reader can resume without holding the owner's lock.
+  uint64_t oldest_record_no() const { return _pushed - _count; }
+  uint64_t end_record_no() const { return _pushed; }
+  // First live record with seq > `seq` (seqs are near-monotonic; binary search on the index).
+  uint64_t record_no_after_seq(uint32_t seq) const;
+
+  // Formats record `no` as one JSON object into `buf`. Returns the length, or 0 if the
+  // record was evicted / does not exist.
+  size_t format_json(uint64_t no, char* buf, size_t cap, uint32_t* seq_out = nullptr) const;
+
+ private:
+  static const uint16_t kNoId = 0xFFFF;
+  static const size_t kInternSlots = 512;
+  static const size_t kHeaderBytes = 18;
+
+  uint16_t intern(const char* s);
+  const char* interned(uint16_t id) const;
+  const IndexEntry& entry(size_t i) const { return _index[(_oldest + i) % _max_records]; }
+  void evict_oldest();
+  size_t reserve_at(size_t len);
+
+  uint8_t* _arena = nullptr;
+  size_t _arena_bytes = 0;
+  IndexEntry* _index = nullptr;
+  size_t _max_records = 0;
+  size_t _oldest = 0;
+  size_t _count = 0;
+  size_t _write_off = 0;
+  uint64_t _pushed = 0;
+  uint32_t _evicted = 0;
+
+  // Intern table: open addressing over FNV-1a; id = insertion order.
+  char* _strings[kInternSlots] = {};
+  uint16_t _slots[kInternSlots * 2] = {};
+  uint16_t _string_count = 0;
+};
@@ -0,0 +1,52 @@
+// src/logging/log_chain_line.cpp
+// Role: Single-pass M3 hash chaining of log lines that already are canonical JSON.
+
+#include "log_chain_line.h"
+
+#include <string.h>
+
+#include "sha256_hex.h"
+
+// strstr() bounded to [s, s+len): the line need not be NUL-terminated at len.
+static bool contains(const char* s, size_t len, const char* needle) {
+  const size_t n = strlen(needle);
+  if (n > len) return false;
+  for (size_t i = 0; i + n <= len; i++) {
+    if (s[i] == needle[0] && memcmp(s + i, needle, n) == 0) return true;
+  }
+  return false;
+}
+
+bool wss_log_chain_line(const char* line, size_t len, const char* prev_hash, String& out_line,
+                        char out_hash[65]) {
+  if (!line) return false;
+  while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ')) len--;
+  if (len < 2 || line[0] != '{' || line[len - 1] != '}') return false;
+  if (contains(line, len, "\"hash\":") || contains(line, len, "\"prev_hash\":")) return false;
+
+  if (prev_hash) {
+    uint8_t digest[32];
+    WssSha256 sha;
+    sha.update(line, len);
+    sha.update(prev_hash, 64);
+    sha.finish(digest);
+    wss_hex_lower(digest, sizeof(digest), out_hash);
+  } else if (out_hash) {
+    out_hash[0] = 0;
+  }
+
+  out_line = "";
+  out_line.reserve(len + kWssLogChainSuffixMax);
+  out_line.concat(line, len - 1);
+  if (len > 2) out_line += ',';
+  if (prev_hash) {
+    out_line += "\"prev_hash\":\"";
+    out_line.concat(prev_hash, 64);
+    out_line += "\",\"hash\":\"";
+    out_line.concat(out_hash, 64);
+    out_line += "\"}";
+  } else {
+    out_line += "\"prev_hash\":null,\"hash\":null}";
+  }
+  return true;
+}
@@ -0,0 +1,18 @@
+// src/logging/log_chain_line.h
+// Role: Single-pass M3 hash chaining of log lines that already are canonical JSON.
+#pragma once
+
+#include <Arduino.h>
+
+// Longest suffix wss_log_chain_line() appends: ,"prev_hash":"<64>","hash":"<64>"}
+static const size_t kWssLogChainSuffixMax = 160;
+
+// Chains one line produced by the logger. Those bytes already are the canonical
+// serialization, so they are streamed into SHA-256 together with `prev_hash` (64 hex chars)
+// and the chain fields replace the closing brace; output is identical to parsing the line,
+// hashing `serialized + prev_hash` and serializing it again with prev_hash/hash added.
+// `prev_hash` == nullptr appends explicit nulls (hash chaining disabled) and leaves
+// `out_hash` empty. Trailing '\n', '\r' and ' ' are ignored. Returns false when the line
+// needs the parse path instead (not a JSON object, or it already carries hash fields).
+bool wss_log_chain_line(const char* line, size_t len, const char* prev_hash, String& out_line,
+                        char out_hash[65]);
@@ -0,0 +1,61 @@
+// src/logging/seq_lease.cpp
+// Role: Leased event sequence allocator (one NVS commit per block of seqs).
+
+#include "seq_lease.h"
+
+void WssSeqLease::begin(uint32_t block, LoadFn load, StoreFn store, void* ctx) {
+  _block = block ? block : 1;
+  _store = store;
+  _ctx = ctx;
+  _commits = 0;
+  _commits_avoided = 0;
+  _commit_failures = 0;
+  _unsaved = false;
+
+  uint32_t high_water = 0;
+  _persistent = load && load(high_water, ctx);
+  if (!_persistent) high_water = 0;
+
+  // Resume past the last lease: seqs in (last_used, high_water] are skipped on purpose.
+  _last = high_water;
+  _lease_end = high_water;
+  _started = true;
+}
+
+void WssSeqLease::extend_lease() {
+  uint32_t next_end = _last + _block;
+  if (next_end < _last) next_end = 0xFFFFFFFFUL; // saturate instead of wrapping
+  bool ok = _persistent && _store && _store(next_end, _ctx);
+  if (ok) {
+    _commits++;
+    _unsaved = false;
+  } else {
+    // Best effort in RAM only. Retried on every next() until it persists: the seqs issued
+    // meanwhile are only safe from reuse once a later commit covers them.
+    _commit_failures++;
+    _unsaved = _persistent && _store;
+  }
+  _lease_end = next_end;
+}
+
+uint32_t WssSeqLease::next() {
+  if (_last >= _lease_end || _unsaved) {
+    extend_lease();
+  } else {
+    _commits_avoided++;
+  }
+  _last++;
+  return _last;
+}
+
+WssSeqLeaseStats WssSeqLease::stats() const {
+  WssSeqLeaseStats s;
+  s.lease_block = _block;
+  s.last_seq = _last;
+  s.lease_end = _lease_end;
+  s.commits = _commits;
+  s.commits_avoided = _commits_avoided;
+  s.commit_failures = _commit_failures;
+  s.persistent = _persistent;
+  return s;
+}
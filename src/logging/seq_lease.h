@@ -0,0 +1,54 @@
+// src/logging/seq_lease.h
+// Role: Leased event sequence allocator (one NVS commit per block of seqs).
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The persisted value is a lease high-water mark: every seq ever handed out is <= it.
+// A new lease is committed *before* the first seq beyond the old one is issued, so a
+// power loss at any point can only skip seqs (never repeat them) on the next boot. When a
+// commit fails, seqs keep coming from RAM and the commit is retried with every next(); only
+// a reset before a retry succeeds can repeat the seqs issued in between.
+// Not thread-safe: callers drawing seqs from several tasks must serialize next() (the
+// event logger holds a mutex around it).
+struct WssSeqLeaseStats {
+  uint32_t lease_block = 0;
+  uint32_t last_seq = 0;          // last seq issued (resume point right after boot)
+  uint32_t lease_end = 0;         // highest seq covered by the persisted lease
+  uint32_t commits = 0;           // lease writes since boot
+  uint32_t commits_avoided = 0;   // seqs issued without a lease write
+  uint32_t commit_failures = 0;   // lease writes that did not persist (retried per seq)
+  bool persistent = false;        // false when the backing store was unavailable at begin()
+};
+
+class WssSeqLease {
+ public:
+  // Backing store hooks. `load` returns false when the store is unavailable;
+  // a missing key should load as 0 and return true.
+  typedef bool (*LoadFn)(uint32_t& out_high_water, void* ctx);
+  typedef bool (*StoreFn)(uint32_t high_water, void* ctx);
+
+  void begin(uint32_t block, LoadFn load, StoreFn store, void* ctx);
+  bool started() const { return _started; }
+
+  // Returns the next monotonic seq, committing a new lease first when needed.
+  uint32_t next();
+
+  WssSeqLeaseStats stats() const;
+
+ private:
+  void extend_lease();
+
+  bool _started = false;
+  bool _persistent = false;
+  bool _unsaved = false; // the last lease commit failed; retry on the next seq
+  uint32_t _block = 1;
+  uint32_t _last = 0;
+  uint32_t _lease_end = 0;
+  uint32_t _commits = 0;
+  uint32_t _commits_avoided = 0;
+  uint32_t _commit_failures = 0;
+  StoreFn _store = nullptr;
+  void* _ctx = nullptr;
+};
@@ -3,8 +3,6 @@
 
 #include "sha256_hex.h"
 
-#include "mbedtls/sha256.h"
-
 static String hex_lower(const uint8_t* bytes, size_t len) {
   static const char* kHex = "0123456789abcdef";
   String out;
@@ -37,4 +35,53 @@ String wss_sha256_hex_str(const String& s) {
   return wss_sha256_hex(reinterpret_cast<const uint8_t*>(s.c_str()), s.length());
 }
 
+void wss_hex_lower(const uint8_t* bytes, size_t len, char* out) {
+  static const char* kHex = "0123456789abcdef";
+  for (size_t i = 0; i < len; ++i) {
+    out[i * 2] = kHex[(bytes[i] >> 4) & 0x0F];
+    out[i * 2 + 1] = kHex[bytes[i] & 0x0F];
+  }
+  out[len * 2] = 0;
+}
+
+static int hex_nibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool wss_hex_parse(const char* hex, uint8_t* out, size_t len) {
+  if (!hex) return false;
+  for (size_t i = 0; i < len; ++i) {
+    int hi = hex_nibble(hex[i * 2]);
+    int lo = hi < 0 ? -1 : hex_nibble(hex[i * 2 + 1]);
+    if (lo < 0) return false;
+    out[i] = (uint8_t)((hi << 4) | lo);
+  }
+  return true;
+}
+
+WssSha256::WssSha256() {
+  mbedtls_sha256_init(&_ctx);
+  mbedtls_sha256_starts_ret(&_ctx, 0);
+}
+
+WssSha256::~WssSha256() {
+  mbedtls_sha256_free(&_ctx);
+}
+
+void WssSha256::update(const uint8_t* data, size_t len) {
+  if (!data || len == 0) return;
+  mbedtls_sha256_update_ret(&_ctx, data, len);
+}
+
+void WssSha256::finish(uint8_t out[32]) {
+  mbedtls_sha256_finish_ret(&_ctx, out);
+}
+
+void WssSha256::copy_from(const WssSha256& other) {
+  mbedtls_sha256_clone(&_ctx, &other._ctx);
+}
+
 // src/logging/sha256_hex.cpp EOF
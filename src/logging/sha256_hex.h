@@ -4,10 +4,36 @@
 
 #include <Arduino.h>
 
+#include "mbedtls/sha256.h"
+
 // Returns lowercase hex SHA-256 of the provided bytes.
 String wss_sha256_hex(const uint8_t* data, size_t len);
 
 // Convenience wrapper for Arduino String input.
 String wss_sha256_hex_str(const String& s);
 
+// Writes 2*len lowercase hex chars plus a NUL terminator into `out`.
+void wss_hex_lower(const uint8_t* bytes, size_t len, char* out);
+
+// Parses 2*len hex chars (either case) into `out`. False on a non-hex char.
+bool wss_hex_parse(const char* hex, uint8_t* out, size_t len);
+
+// Incremental SHA-256, so callers can hash several buffers without concatenating them.
+class WssSha256 {
+ public:
+  WssSha256();
+  ~WssSha256();
+  WssSha256(const WssSha256&) = delete;
+  WssSha256& operator=(const WssSha256&) = delete;
+
+  void update(const uint8_t* data, size_t len);
+  void update(const char* data, size_t len) { update(reinterpret_cast<const uint8_t*>(data), len); }
+  void finish(uint8_t out[32]);
+  // Continues from another hasher's state, e.g. a precomputed common prefix.
+  void copy_from(const WssSha256& other);
+
+ private:
+  mbedtls_sha256_context _ctx;
+};
+
 // src/logging/sha256_hex.h EOF
@@ -0,0 +1,80 @@
+// src/nfc/allowlist_journal.cpp
+// Role: Encode, check and replay allowlist journal records.
+
+#include "allowlist_journal.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../crc32.h"
+#include "../logging/sha256_hex.h"
+#include "allowlist_table.h"
+#include "nfc_allowlist.h"
+
+static const size_t kBodyLen = 66;  // op, ' ', 64 hex
+
+static char op_for(uint8_t role, bool remove) {
+  if (remove) return 'R';
+  if (role == WSS_NFC_ROLE_ADMIN) return 'A';
+  if (role == WSS_NFC_ROLE_USER) return 'U';
+  return 'K';
+}
+
+void wss_allowlist_journal_record(const uint8_t digest[32], uint8_t role, bool remove,
+                                  char out[kWssAllowlistJournalRecLen + 1]) {
+  out[0] = op_for(role, remove);
+  out[1] = ' ';
+  wss_hex_lower(digest, 32, out + 2);
+  snprintf(out + kBodyLen, kWssAllowlistJournalRecLen + 1 - kBodyLen, " %08lx\n",
+           (unsigned long)wss_crc32(out, kBodyLen));
+}
+
+bool wss_allowlist_journal_apply(const char* rec, size_t len, WssAllowlistTable& table) {
+  if (len == kWssAllowlistJournalRecLen) {
+    if (rec[len - 1] != '\n') return false;
+    len--;
+  }
+  if (len != kWssAllowlistJournalRecLen - 1 || rec[1] != ' ' || rec[kBodyLen] != ' ') {
+    return false;
+  }
+  uint8_t crc_be[4];
+  if (!wss_hex_parse(rec + kBodyLen + 1, crc_be, sizeof(crc_be))) return false;
+  const uint32_t crc = ((uint32_t)crc_be[0] << 24) | ((uint32_t)crc_be[1] << 16) |
+                       ((uint32_t)crc_be[2] << 8) | crc_be[3];
+  if (crc != wss_crc32(rec, kBodyLen)) return false;
+  uint8_t digest[32];
+  if (!wss_hex_parse(rec + 2, digest, sizeof(digest))) return false;
+
+  bool changed = false;
+  switch (rec[0]) {
+    case 'A':
+      return table.put(digest, WSS_NFC_ROLE_ADMIN, changed);
+    case 'U':
+      return table.put(digest, WSS_NFC_ROLE_USER, changed);
+    case 'K':
+      return table.put(digest, WSS_NFC_ROLE_UNKNOWN, changed);
+    case 'R':
+      (void)table.remove(digest);
+      return true;
+    default:
+      return false;
+  }
+}
+
+size_t WssAllowlistJournalReplay::write(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len;) {
+    size_t n = kWssAllowlistJournalRecLen - _len;
+    if (n > len - i) n = len - i;
+    memcpy(_rec + _len, data + i, n);
+    _len += n;
+    i += n;
+    if (_len < kWssAllowlistJournalRecLen) break;
+    if (wss_allowlist_journal_apply(_rec, _len, _table)) {
+      _applied++;
+    } else {
+      _bad++;
+    }
+    _len = 0;
+  }
+  return len;
+}
@@ -0,0 +1,62 @@
+// src/nfc/allowlist_journal.h
+// Role: Allowlist journal records: one fixed-size line per add/remove, appended instead of
+// rewriting the whole list, replayed over the last snapshot at boot.
+#pragma once
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+class WssAllowlistTable;
+
+// Changes appended since the last snapshot before it is rewritten (compaction).
+#ifndef WSS_NFC_ALLOWLIST_JOURNAL_MAX
+#define WSS_NFC_ALLOWLIST_JOURNAL_MAX 32
+#endif
+
+// Quiet time after the last change before a due compaction runs, so a batch of
+// enrollments pays for one snapshot.
+#ifndef WSS_NFC_ALLOWLIST_COMPACT_IDLE_MS
+#define WSS_NFC_ALLOWLIST_COMPACT_IDLE_MS 2000
+#endif
+
+// How often a card copy that missed changes (card out, write error) is rewritten.
+#ifndef WSS_NFC_ALLOWLIST_SD_RETRY_MS
+#define WSS_NFC_ALLOWLIST_SD_RETRY_MS 30000
+#endif
+
+// "<op> <64 hex tag hash> <8 hex CRC-32 of the first 66 chars>\n", op 'A' / 'U' / 'K' (set
+// role admin / user / unknown) or 'R' (remove). Every record states the final role of its
+// tag, so replaying a journal that a snapshot already folded in changes nothing: a crash
+// between the snapshot swap and the journal reset is harmless.
+static const size_t kWssAllowlistJournalRecLen = 76;  // including the '\n'
+
+// Writes the record plus a NUL into `out`.
+void wss_allowlist_journal_record(const uint8_t digest[32], uint8_t role, bool remove,
+                                  char out[kWssAllowlistJournalRecLen + 1]);
+
+// Applies one record (the trailing '\n' is optional). False when it is not valid.
+bool wss_allowlist_journal_apply(const char* rec, size_t len, WssAllowlistTable& table);
+
+// Print sink that applies journal bytes to `table` in order as they arrive. A record with a
+// bad CRC or op is skipped and counted in bad(); a torn tail shorter than a record is
+// ignored.
+class WssAllowlistJournalReplay : public Print {
+ public:
+  explicit WssAllowlistJournalReplay(WssAllowlistTable& table) : _table(table) {}
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* data, size_t len) override;
+
+  uint32_t applied() const { return _applied; }
+  uint32_t bad() const { return _bad; }
+  uint32_t records() const { return _applied + _bad; }
+
+ private:
+  WssAllowlistTable& _table;
+  char _rec[kWssAllowlistJournalRecLen];
+  size_t _len = 0;
+  uint32_t _applied = 0;
+  uint32_t _bad = 0;
+};
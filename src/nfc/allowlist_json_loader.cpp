@@ -0,0 +1,211 @@
+// src/nfc/allowlist_json_loader.cpp
+// Role: Incremental JSON scanner for allowlist snapshots.
+
+#include "allowlist_json_loader.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#include "../logging/sha256_hex.h"
+#include "allowlist_table.h"
+#include "nfc_allowlist.h"
+
+static bool is_scalar_char(char c) {
+  return isalnum((unsigned char)c) || c == '+' || c == '-' || c == '.';
+}
+
+size_t WssAllowlistJsonLoader::write(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len && !_failed; i++) {
+    if (!feed((char)data[i])) _failed = true;
+  }
+  return _failed ? 0 : len;
+}
+
+bool WssAllowlistJsonLoader::finish() {
+  if (_in_scalar) {
+    _in_scalar = false;
+    _in_generation = false;
+    value_done();
+  }
+  return !_failed && !_in_string && _state == kDone && _entries_seen;
+}
+
+bool WssAllowlistJsonLoader::feed(char c) {
+  if (_in_string) {
+    if (_escape) {
+      _escape = false;
+    } else if (c == '\\') {
+      _escape = true;
+      return true;
+    } else if (c == '"') {
+      _in_string = false;
+      end_string();
+      return true;
+    } else if ((uint8_t)c < 0x20) {
+      return false;
+    }
+    if (_str_len < kStrMax) {
+      _str[_str_len++] = c;
+    } else {
+      _str_over = true;
+    }
+    return true;
+  }
+  if (_in_scalar) {
+    if (is_scalar_char(c)) {
+      if (_in_generation) generation_digit(c);
+      return true;
+    }
+    _in_scalar = false;
+    _in_generation = false;
+    value_done();
+  }
+  if (c == ' ' || c == '\t' || c == '\n' || c == '\r') return true;
+  _started = true;
+
+  switch (_state) {
+    case kValueOrEnd:
+      if (c == ']') return close(c);
+      return begin_value(c);
+    case kValue:
+      return begin_value(c);
+    case kKeyOrEnd:
+      if (c == '}') return close(c);
+      // fall through
+    case kKey:
+      if (c != '"') return false;
+      _in_string = true;
+      _string_is_key = true;
+      _str_len = 0;
+      _str_over = false;
+      return true;
+    case kColon:
+      if (c != ':') return false;
+      _state = kValue;
+      return true;
+    case kCommaOrEnd:
+      if (c == ',') {
+        _state = _stack[_depth - 1] == '{' ? kKey : kValue;
+        return true;
+      }
+      if (c == '}' || c == ']') return close(c);
+      return false;
+    case kDone:
+    default:
+      return false;
+  }
+}
+
+bool WssAllowlistJsonLoader::begin_value(char c) {
+  const bool key_entries = _key_entries;
+  const bool key_generation = _key_generation;
+  _key_entries = false;
+  _key_generation = false;
+  if (c == '"') {
+    _in_string = true;
+    _string_is_key = false;
+    _str_len = 0;
+    _str_over = false;
+    return true;
+  }
+  if (c == '{' || c == '[') {
+    if (_depth == kMaxDepth) return false;
+    const bool entries = c == '[' && !_entries_seen && (_depth == 0 || key_entries);
+    const bool entry = c == '{' && _entries_depth && _depth == _entries_depth;
+    _stack[_depth++] = c;
+    if (entries) {
+      _entries_seen = true;
+      _entries_depth = _depth;
+    }
+    if (entry) {
+      _in_entry = true;
+      _field = kFieldOther;
+      _tag_len = 0;
+      _tag_over = false;
+      _role[0] = 0;
+    }
+    _state = c == '{' ? kKeyOrEnd : kValueOrEnd;
+    return true;
+  }
+  if (is_scalar_char(c)) {
+    _in_scalar = true;
+    if (key_generation) {
+      _in_generation = true;
+      _generation = 0;
+      generation_digit(c);
+    }
+    return true;
+  }
+  return false;
+}
+
+// Anything but a plain uint32 (sign, fraction, exponent, overflow) reads as 0.
+void WssAllowlistJsonLoader::generation_digit(char c) {
+  const uint32_t d = (uint32_t)(c - '0');
+  if (c < '0' || c > '9' || _generation > (UINT32_MAX - d) / 10) {
+    _generation = 0;
+    _in_generation = false;
+    return;
+  }
+  _generation = _generation * 10 + d;
+}
+
+bool WssAllowlistJsonLoader::close(char c) {
+  if (!_depth || (c == '}') != (_stack[_depth - 1] == '{')) return false;
+  if (at_entry_level()) {
+    commit_entry();
+    _in_entry = false;
+  }
+  if (_entries_depth && _depth == _entries_depth) _entries_depth = 0;
+  _depth--;
+  value_done();
+  return true;
+}
+
+void WssAllowlistJsonLoader::end_string() {
+  _str[_str_len] = 0;
+  if (_string_is_key) {
+    if (_depth == 1 && _stack[0] == '{') {
+      _key_entries = !_str_over && strcmp(_str, "entries") == 0;
+      _key_generation = !_str_over && strcmp(_str, "generation") == 0;
+    }
+    if (at_entry_level()) {
+      _field = _str_over                  ? kFieldOther
+               : strcmp(_str, "tag") == 0  ? kFieldTag
+               : strcmp(_str, "role") == 0 ? kFieldRole
+                                           : kFieldOther;
+    }
+    _state = kColon;
+    return;
+  }
+  if (at_entry_level()) {
+    if (_field == kFieldTag) {
+      memcpy(_tag, _str, (size_t)_str_len + 1);
+      _tag_len = _str_len;
+      _tag_over = _str_over;
+    } else if (_field == kFieldRole) {
+      size_t n = _str_len < kRoleMax ? _str_len : kRoleMax;
+      for (size_t i = 0; i < n; i++) _role[i] = (char)tolower((unsigned char)_str[i]);
+      _role[n] = 0;
+    }
+  }
+  value_done();
+}
+
+void WssAllowlistJsonLoader::commit_entry() {
+  if (!_tag_len) return;
+  uint8_t digest[32];
+  if (_tag_over || _tag_len != 64 || !wss_hex_parse(_tag, digest, sizeof(digest))) {
+    _skipped++;
+    return;
+  }
+  WssNfcRole role = WSS_NFC_ROLE_UNKNOWN;
+  if (strcmp(_role, "admin") == 0) role = WSS_NFC_ROLE_ADMIN;
+  else if (strcmp(_role, "user") == 0) role = WSS_NFC_ROLE_USER;
+  bool changed = false;
+  if (!_table.put(digest, (uint8_t)role, changed)) {
+    _skipped++;
+    return;
+  }
+  _entries++;
+}
@@ -0,0 +1,86 @@
+// src/nfc/allowlist_json_loader.h
+// Role: Streaming reader for the allowlist snapshot JSON: entries go straight into the
+// lookup table as the bytes arrive, so memory does not grow with the file.
+#pragma once
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+class WssAllowlistTable;
+
+// Accepts the snapshot shapes the allowlist has always read: {"entries":[...], ...} or a
+// bare top-level array, each entry {"tag":"<64 hex>","role":"admin|user"}. A top-level
+// "generation" number is kept; other keys and values are checked for syntax and skipped.
+// Entries without a string tag are ignored; tags that are not 64 hex chars are counted in
+// skipped(). Holds only the key or string value in flight (a tag is the longest one kept),
+// whatever the chunk or file size.
+class WssAllowlistJsonLoader : public Print {
+ public:
+  explicit WssAllowlistJsonLoader(WssAllowlistTable& table) : _table(table) {}
+
+  // Consumes all of `data`; returns 0 once the document is malformed so the sender can
+  // stop early.
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* data, size_t len) override;
+
+  // True when a complete document with an entries array was read.
+  bool finish();
+  // Nothing but whitespace seen so far (missing or empty snapshot).
+  bool empty() const { return !_started; }
+
+  uint32_t entries() const { return _entries; }
+  uint32_t skipped() const { return _skipped; }
+  // Changes the snapshot folds in; 0 when absent (snapshots written before generations).
+  uint32_t generation() const { return _generation; }
+
+ private:
+  enum State : uint8_t { kValue, kValueOrEnd, kKey, kKeyOrEnd, kColon, kCommaOrEnd, kDone };
+  static const uint8_t kMaxDepth = 16;
+  static const uint8_t kStrMax = 72;
+  static const uint8_t kRoleMax = 8;
+  static const uint8_t kFieldOther = 0;
+  static const uint8_t kFieldTag = 1;
+  static const uint8_t kFieldRole = 2;
+
+  bool feed(char c);
+  bool begin_value(char c);
+  bool close(char c);
+  void end_string();
+  void generation_digit(char c);
+  void value_done() { _state = _depth ? kCommaOrEnd : kDone; }
+  bool at_entry_level() const { return _in_entry && _depth == _entries_depth + 1; }
+  void commit_entry();
+
+  WssAllowlistTable& _table;
+  char _stack[kMaxDepth];
+  uint8_t _depth = 0;
+  State _state = kValue;
+  bool _started = false;
+  bool _failed = false;
+
+  bool _in_string = false;
+  bool _string_is_key = false;
+  bool _escape = false;
+  bool _in_scalar = false;
+  char _str[kStrMax + 1];
+  uint8_t _str_len = 0;
+  bool _str_over = false;
+
+  uint8_t _entries_depth = 0;  // depth of the entries array while inside it
+  bool _entries_seen = false;
+  bool _key_entries = false;    // the top-level key just read was "entries"
+  bool _key_generation = false; // ...or "generation"
+  bool _in_generation = false;  // reading its digits
+  bool _in_entry = false;
+  uint8_t _field = kFieldOther;
+  char _tag[kStrMax + 1];
+  uint8_t _tag_len = 0;
+  bool _tag_over = false;
+  char _role[kRoleMax + 1];
+
+  uint32_t _entries = 0;
+  uint32_t _skipped = 0;
+  uint32_t _generation = 0;
+};
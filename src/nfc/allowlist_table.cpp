@@ -0,0 +1,179 @@
+// src/nfc/allowlist_table.cpp
+// Role: Open-addressing hash index of allowlist tag digests.
+
+#include "allowlist_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../psram_alloc.h"
+
+static const size_t kMinSlots = 16;
+static const int kBloomProbes = 4;
+
+WssAllowlistTable::~WssAllowlistTable() {
+  wss_large_free(_entries);
+  wss_large_free(_slots);
+  free(_bloom);
+}
+
+uint32_t WssAllowlistTable::home(const uint8_t digest[32]) const {
+  uint32_t h;
+  memcpy(&h, digest, sizeof(h));
+  return h & _mask;
+}
+
+uint32_t WssAllowlistTable::slot_of(const uint8_t digest[32]) const {
+  if (!_slots) return kEmpty;
+  for (uint32_t s = home(digest);; s = (s + 1) & _mask) {
+    const uint32_t e = _slots[s];
+    if (e == kEmpty) return kEmpty;
+    if (memcmp(_entries[e].digest, digest, 32) == 0) return s;
+  }
+}
+
+// Probe bits come from digest bytes 4..19, independent of the slot hash (bytes 0..3).
+static inline uint32_t bloom_bit(const uint8_t digest[32], int probe, uint32_t bit_mask) {
+  uint32_t w;
+  memcpy(&w, digest + 4 + probe * 4, sizeof(w));
+  return w & bit_mask;
+}
+
+bool WssAllowlistTable::may_contain(const uint8_t digest[32]) const {
+  if (!_bloom) return true;
+  const uint32_t bit_mask = ((_mask + 1) << 3) - 1;
+  for (int i = 0; i < kBloomProbes; i++) {
+    const uint32_t b = bloom_bit(digest, i, bit_mask);
+    if (!(_bloom[b >> 3] & (1u << (b & 7)))) return false;
+  }
+  return true;
+}
+
+void WssAllowlistTable::bloom_add(const uint8_t digest[32]) {
+  if (!_bloom) return;
+  const uint32_t bit_mask = ((_mask + 1) << 3) - 1;
+  for (int i = 0; i < kBloomProbes; i++) {
+    const uint32_t b = bloom_bit(digest, i, bit_mask);
+    _bloom[b >> 3] |= (uint8_t)(1u << (b & 7));
+  }
+}
+
+void WssAllowlistTable::bloom_rebuild() {
+  if (!_bloom) return;
+  memset(_bloom, 0, (size_t)_mask + 1);
+  for (size_t i = 0; i < _count; i++) bloom_add(_entries[i].digest);
+}
+
+// Slots for up to 3/4 load, entries for exactly `min_entries` (at least double the old).
+bool WssAllowlistTable::grow(size_t min_entries) {
+  size_t cap = _entry_cap ? _entry_cap * 2 : kMinSlots / 2;
+  if (cap < min_entries) cap = min_entries;
+  size_t slots = kMinSlots;
+  while (slots * 3 / 4 < cap) slots *= 2;
+  if (slots > 0x80000000u) return false;
+
+  Entry* entries = static_cast<Entry*>(wss_large_alloc(cap * sizeof(Entry)));
+  uint32_t* slot_tab = static_cast<uint32_t*>(wss_large_alloc(slots * sizeof(uint32_t)));
+  if (!entries || !slot_tab) {
+    wss_large_free(entries);
+    wss_large_free(slot_tab);
+    return false;
+  }
+  if (_count) memcpy(entries, _entries, _count * sizeof(Entry));
+  wss_large_free(_entries);
+  wss_large_free(_slots);
+  _entries = entries;
+  _entry_cap = cap;
+  _slots = slot_tab;
+  _mask = (uint32_t)(slots - 1);
+  // Internal RAM on purpose; without it lookups just skip the filter.
+  free(_bloom);
+  _bloom = static_cast<uint8_t*>(malloc(slots));
+  rehash();
+  return true;
+}
+
+void WssAllowlistTable::rehash() {
+  memset(_slots, 0xFF, ((size_t)_mask + 1) * sizeof(uint32_t));
+  for (size_t i = 0; i < _count; i++) {
+    uint32_t s = home(_entries[i].digest);
+    while (_slots[s] != kEmpty) s = (s + 1) & _mask;
+    _slots[s] = (uint32_t)i;
+  }
+  bloom_rebuild();
+}
+
+bool WssAllowlistTable::reserve(size_t n) {
+  return n <= _entry_cap || grow(n);
+}
+
+void WssAllowlistTable::clear() {
+  _count = 0;
+  memset(_role_count, 0, sizeof(_role_count));
+  if (_slots) memset(_slots, 0xFF, ((size_t)_mask + 1) * sizeof(uint32_t));
+  if (_bloom) memset(_bloom, 0, (size_t)_mask + 1);
+}
+
+bool WssAllowlistTable::put(const uint8_t digest[32], uint8_t role, bool& changed) {
+  changed = false;
+  if (role >= kRoles) return false;
+  const uint32_t s = slot_of(digest);
+  if (s != kEmpty) {
+    Entry& e = _entries[_slots[s]];
+    if (e.role != role) {
+      _role_count[e.role]--;
+      _role_count[role]++;
+      e.role = role;
+      changed = true;
+    }
+    return true;
+  }
+  if (_count == _entry_cap && !grow(_count + 1)) return false;
+  Entry& e = _entries[_count];
+  memcpy(e.digest, digest, 32);
+  e.role = role;
+  uint32_t slot = home(digest);
+  while (_slots[slot] != kEmpty) slot = (slot + 1) & _mask;
+  _slots[slot] = (uint32_t)_count;
+  bloom_add(digest);
+  _count++;
+  _role_count[role]++;
+  changed = true;
+  return true;
+}
+
+bool WssAllowlistTable::remove(const uint8_t digest[32]) {
+  uint32_t hole = slot_of(digest);
+  if (hole == kEmpty) return false;
+  const uint32_t idx = _slots[hole];
+  _role_count[_entries[idx].role]--;
+
+  // Backward-shift deletion: pull later members of the probe run into the hole, so
+  // lookups never need tombstones.
+  for (uint32_t s = (hole + 1) & _mask; _slots[s] != kEmpty; s = (s + 1) & _mask) {
+    const uint32_t h = home(_entries[_slots[s]].digest);
+    // Movable when its home is not cyclically within (hole, s].
+    const bool stays = hole <= s ? (hole < h && h <= s) : (hole < h || h <= s);
+    if (stays) continue;
+    _slots[hole] = _slots[s];
+    hole = s;
+  }
+  _slots[hole] = kEmpty;
+
+  // Keep the entries dense: the last one takes the freed index.
+  const uint32_t last = (uint32_t)(_count - 1);
+  if (idx != last) {
+    _entries[idx] = _entries[last];
+    const uint32_t s = slot_of(_entries[idx].digest);
+    if (s == kEmpty) return false; // cannot happen: the last entry is still indexed
+    _slots[s] = idx;
+  }
+  _count--;
+  bloom_rebuild();  // a Bloom filter cannot forget one member
+  return true;
+}
+
+uint8_t WssAllowlistTable::find(const uint8_t digest[32]) const {
+  const uint32_t s = slot_of(digest);
+  return s == kEmpty ? 0 : _entries[_slots[s]].role;
+}
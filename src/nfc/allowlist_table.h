@@ -0,0 +1,71 @@
+// src/nfc/allowlist_table.h
+// Role: In-memory allowlist index: 32-byte tag digests in an open-addressing hash table, so
+// a tap costs the same with 10 or 10,000 enrolled tags.
+#pragma once
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Entries live densely in insertion order (removal moves the last one into the gap); the
+// slot table maps a digest to its entry index with linear probing. Tag digests are
+// salted SHA-256 output, so their first bytes are already a uniform hash. Both arrays
+// come from wss_large_alloc() (PSRAM when the board has it): about 37-45 bytes per tag
+// at the 1/2..3/4 load the table keeps. Not thread-safe: the NFC task owns it.
+//
+// A Bloom filter (one byte per slot, so 11-21 bits per tag and 4 probes: under 1% false
+// positives) sits in internal RAM in front of it. An unknown tag, the common case under
+// a brute-force scan, is then turned away with four bit tests and no PSRAM access. It is
+// kept in step by put(), and rebuilt by remove() and whenever the table grows.
+class WssAllowlistTable {
+ public:
+  struct Entry {
+    uint8_t digest[32];
+    uint8_t role; // WssNfcRole
+  };
+
+  WssAllowlistTable() = default;
+  ~WssAllowlistTable();
+  WssAllowlistTable(const WssAllowlistTable&) = delete;
+  WssAllowlistTable& operator=(const WssAllowlistTable&) = delete;
+
+  // Room for `n` entries without growing. False when out of memory.
+  bool reserve(size_t n);
+  void clear(); // keeps the allocation
+
+  // Adds or updates. `changed` is false when the entry already had this role. False when
+  // out of memory.
+  bool put(const uint8_t digest[32], uint8_t role, bool& changed);
+  bool remove(const uint8_t digest[32]);
+  // Role of the tag; 0 (WSS_NFC_ROLE_UNKNOWN) when not enrolled. Exact; does not consult
+  // the filter.
+  uint8_t find(const uint8_t digest[32]) const;
+  // False only when the tag is certainly not enrolled. True without a filter (its
+  // allocation failed).
+  bool may_contain(const uint8_t digest[32]) const;
+
+  size_t count() const { return _count; }
+  size_t count_role(uint8_t role) const { return role < kRoles ? _role_count[role] : 0; }
+  // Entries in insertion order (changed by remove()).
+  const Entry& at(size_t i) const { return _entries[i]; }
+
+ private:
+  static const uint32_t kEmpty = 0xFFFFFFFFu;
+  static const uint8_t kRoles = 4;
+
+  uint32_t home(const uint8_t digest[32]) const;
+  uint32_t slot_of(const uint8_t digest[32]) const; // slot holding the digest, or kEmpty
+  bool grow(size_t min_entries);
+  void rehash();
+  void bloom_add(const uint8_t digest[32]);
+  void bloom_rebuild();
+
+  Entry* _entries = nullptr;
+  size_t _entry_cap = 0;
+  uint32_t* _slots = nullptr; // entry index per slot, kEmpty = free
+  uint32_t _mask = 0;         // slot count - 1 (power of two)
+  uint8_t* _bloom = nullptr;  // slot count bytes, internal RAM
+  size_t _count = 0;
+  uint32_t _role_count[kRoles] = {0};
+};
@@ -6,131 +6,357 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <Preferences.h>
-#include <vector>
 
 #include "../logging/event_logger.h"
 #include "../logging/sha256_hex.h"
 #include "../storage/storage_manager.h"
+#include "allowlist_journal.h"
+#include "allowlist_json_loader.h"
+#include "allowlist_table.h"
 
 namespace {
 
-struct AllowEntry {
-  String taghash;
-  WssNfcRole role;
-};
-
-static std::vector<AllowEntry> g_allowlist;
+static WssAllowlistTable g_allowlist;
 static const char* kPrefsNs = "wss_nfc_allow";
 static const char* kPrefsKey = "entries_json";
+// NVS journal: record i under "j<i>", count under "jn"; the snapshot's generation is "sg".
+static const char* kPrefsJournalCountKey = "jn";
+static const char* kPrefsGenerationKey = "sg";
 static const uint32_t kAllowlistSchemaVersion = 1;
 
+static WssEventLogger* g_log = nullptr;
+static uint32_t g_journal_records = 0;  // appended since the last snapshot
+static bool g_compact_due = false;
+static uint32_t g_last_change_ms = 0;
+static uint32_t g_filter_rejects = 0;  // unknown tags turned away by the Bloom filter
+
+// Generations: every change counts one. A copy's generation is its snapshot's plus the
+// records in its journal, so when one copy missed changes (the card was out, or the NVS
+// journal was full) boot takes the copy with the higher generation instead of a fixed
+// favourite. A copy that misses a change stops journaling until a snapshot catches it up,
+// so its count never skips a record it lacks.
+static uint32_t g_generation = 0;
+static bool g_nvs_behind = false;
+static bool g_sd_behind = false;
+static uint32_t g_sd_retry_ms = 0;
+
 static uint64_t device_salt() {
   return ESP.getEfuseMac();
 }
 
-static bool parse_allowlist_json(const String& payload, WssEventLogger* log) {
-  DynamicJsonDocument d(4096);
-  DeserializationError de = deserializeJson(d, payload);
-  if (de) return false;
+// SHA-256 state after the big-endian salt, set up once: a tag digest starts from a copy.
+static WssSha256 g_salt_sha;
+static bool g_salt_sha_ready = false;
 
-  JsonArray arr;
-  if (d.is<JsonArray>()) {
-    arr = d.as<JsonArray>();
-  } else {
-    arr = d["entries"].as<JsonArray>();
+// Recently seen UIDs and their digests, so repeated reads of one tag (hold-to-clear,
+// debounce) skip the hash. ISO 14443 UIDs are 4, 7 or 10 bytes; longer ones are not kept.
+static const size_t kDigestCacheUidMax = 10;
+struct DigestCacheEntry {
+  uint8_t uid_len = 0;  // 0 = free
+  uint8_t uid[kDigestCacheUidMax];
+  uint8_t digest[32];
+  uint32_t used = 0;    // LRU stamp
+};
+static DigestCacheEntry g_digest_cache[WSS_NFC_TAG_DIGEST_CACHE];
+static uint32_t g_digest_cache_clock = 0;
+static uint32_t g_digest_cache_hits = 0;
+
+static void salt_hasher_init() {
+  if (g_salt_sha_ready) return;
+  uint8_t salt_be[8];
+  uint64_t salt = device_salt();
+  for (int i = 0; i < 8; i++) {
+    salt_be[i] = (uint8_t)((salt >> (56 - i * 8)) & 0xFF);
   }
-  if (arr.isNull()) return false;
+  g_salt_sha.update(salt_be, sizeof(salt_be));
+  g_salt_sha_ready = true;
+}
+
+// Tag hashes are 64 hex chars (either case); anything else is not a tag.
+static bool parse_taghash(const String& taghash, uint8_t digest[32]) {
+  return taghash.length() == 64 && wss_hex_parse(taghash.c_str(), digest, 32);
+}
+
+// Counts a finished load (snapshot plus journal) and logs it.
+static void loaded(const char* source, const WssAllowlistJsonLoader& snapshot,
+                   const WssAllowlistJournalReplay& journal, WssEventLogger* log) {
+  g_journal_records = journal.records();
+  g_compact_due = g_journal_records >= WSS_NFC_ALLOWLIST_JOURNAL_MAX;
+  if (!log) return;
+  StaticJsonDocument<192> extra;
+  extra["source"] = source;
+  extra["entries"] = (uint32_t)g_allowlist.count();
+  extra["skipped"] = snapshot.skipped();
+  extra["journal_records"] = journal.applied();
+  if (journal.bad()) extra["journal_bad"] = journal.bad();
+  JsonObjectConst o = extra.as<JsonObjectConst>();
+  log->log_info("nfc", "allowlist_loaded", "allowlist loaded", &o);
+}
+
+static void nvs_journal_key(uint32_t i, char out[12]) {
+  snprintf(out, 12, "j%lu", (unsigned long)i);
+}
 
+// Generation of the NVS copy without loading it.
+static uint32_t nvs_generation() {
+  Preferences prefs;
+  if (!prefs.begin(kPrefsNs, true)) return 0;
+  const uint32_t g =
+      prefs.getUInt(kPrefsGenerationKey, 0) + prefs.getUInt(kPrefsJournalCountKey, 0);
+  prefs.end();
+  return g;
+}
+
+// Loads the card's snapshot and journal. False with `err` set when the card has no usable
+// copy ("allowlist_parse_failed" when it does not parse) or when its generation is below
+// `min_generation` ("allowlist_stale"); `generation` is set whenever it was read.
+static bool load_allowlist_from_sd(WssEventLogger* log, uint32_t min_generation,
+                                   uint32_t& generation, String& err) {
   g_allowlist.clear();
-  for (JsonVariantConst v : arr) {
-    JsonObjectConst o = v.as<JsonObjectConst>();
-    if (o.isNull()) continue;
-    String taghash = o["tag"] | String("");
-    String role_str = o["role"] | String("");
-    if (!taghash.length()) continue;
-    WssNfcRole role = WSS_NFC_ROLE_UNKNOWN;
-    role_str.toLowerCase();
-    if (role_str == "admin") role = WSS_NFC_ROLE_ADMIN;
-    else if (role_str == "user") role = WSS_NFC_ROLE_USER;
-    g_allowlist.push_back({taghash, role});
-  }
-  if (log) log->log_info("nfc", "allowlist_loaded", "allowlist loaded");
+  WssAllowlistJsonLoader snapshot(g_allowlist);
+  WssAllowlistJournalReplay journal(g_allowlist);
+  if (!wss_storage_read_allowlist(snapshot, journal, err)) return false;
+  if (!snapshot.empty() && !snapshot.finish()) {
+    err = "allowlist_parse_failed";
+    return false;
+  }
+  generation = snapshot.generation() + journal.records();
+  if (generation < min_generation) {
+    err = "allowlist_stale";
+    return false;
+  }
+  loaded("sd", snapshot, journal, log);
   return true;
 }
 
+// NVS cannot hand out a string in parts; the copy is bounded by the NVS string limit and
+// goes through the same streaming loader as the card's.
 static bool load_allowlist_from_nvs(WssEventLogger* log) {
+  g_allowlist.clear();
   Preferences prefs;
   if (!prefs.begin(kPrefsNs, true)) return false;
-  String payload = prefs.getString(kPrefsKey, "");
+  WssAllowlistJsonLoader snapshot(g_allowlist);
+  {
+    String payload = prefs.getString(kPrefsKey, "");
+    snapshot.write(reinterpret_cast<const uint8_t*>(payload.c_str()), payload.length());
+  }
+  if (!snapshot.empty() && !snapshot.finish()) {
+    prefs.end();
+    return false;
+  }
+  WssAllowlistJournalReplay journal(g_allowlist);
+  uint32_t n = prefs.getUInt(kPrefsJournalCountKey, 0);
+  for (uint32_t i = 0; i < n; i++) {
+    char key[12];
+    nvs_journal_key(i, key);
+    journal.print(prefs.getString(key, ""));
+  }
   prefs.end();
-  if (!payload.length()) return false;
-  return parse_allowlist_json(payload, log);
+  if (snapshot.empty() && !journal.records()) return false;
+  loaded("nvs", snapshot, journal, log);
+  return true;
 }
 
+// Same document shape as before, written directly: the list can outgrow any fixed
+// ArduinoJson document.
 static String build_allowlist_json() {
-  DynamicJsonDocument d(4096);
-  d["version"] = kAllowlistSchemaVersion;
-  JsonArray arr = d.createNestedArray("entries");
-  for (const auto& e : g_allowlist) {
-    JsonObject o = arr.createNestedObject();
-    o["tag"] = e.taghash;
-    o["role"] = wss_nfc_role_to_string(e.role);
-  }
+  static const size_t kEntryBytes = 96;  // {"tag":"<64>","role":"admin"},
   String out;
-  serializeJson(d, out);
+  out.reserve(40 + g_allowlist.count() * kEntryBytes);
+  out += "{\"version\":";
+  out += String(kAllowlistSchemaVersion);
+  out += ",\"generation\":";
+  out += String(g_generation);
+  out += ",\"entries\":[";
+  for (size_t i = 0; i < g_allowlist.count(); i++) {
+    const WssAllowlistTable::Entry& e = g_allowlist.at(i);
+    char hex[65];
+    wss_hex_lower(e.digest, 32, hex);
+    if (i) out += ',';
+    out += "{\"tag\":\"";
+    out += hex;
+    out += "\",\"role\":\"";
+    out += wss_nfc_role_to_string((WssNfcRole)e.role);
+    out += "\"}";
+  }
+  out += "]}";
   return out;
 }
 
+// Writes the snapshot; once it is stored the NVS journal is folded in and cleared.
 static bool save_allowlist_to_nvs(const String& payload) {
   Preferences prefs;
   if (!prefs.begin(kPrefsNs, false)) return false;
-  bool ok = prefs.putString(kPrefsKey, payload) > 0;
+  bool ok = prefs.putString(kPrefsKey, payload) > 0 &&
+            prefs.putUInt(kPrefsGenerationKey, g_generation) > 0;
+  if (ok) {
+    uint32_t n = prefs.getUInt(kPrefsJournalCountKey, 0);
+    prefs.remove(kPrefsJournalCountKey);
+    for (uint32_t i = 0; i < n; i++) {
+      char key[12];
+      nvs_journal_key(i, key);
+      prefs.remove(key);
+    }
+  }
   prefs.end();
   return ok;
 }
 
-} // namespace
+// NVS is the fallback copy and shares its partition with the config: when the snapshot
+// does not fit (large lists) the journal stops at twice the compaction threshold and the
+// NVS copy lags behind the card.
+static bool append_nvs_journal(const char* rec) {
+  Preferences prefs;
+  if (!prefs.begin(kPrefsNs, false)) return false;
+  uint32_t n = prefs.getUInt(kPrefsJournalCountKey, 0);
+  bool ok = false;
+  if (n < 2 * WSS_NFC_ALLOWLIST_JOURNAL_MAX) {
+    char key[12];
+    nvs_journal_key(n, key);
+    ok = prefs.putString(key, rec) > 0 && prefs.putUInt(kPrefsJournalCountKey, n + 1) > 0;
+  }
+  prefs.end();
+  return ok;
+}
 
-bool wss_nfc_allowlist_begin(WssEventLogger* log) {
+// Compaction: full snapshot to NVS and SD, each dropping its journal.
+static void persist_allowlist(WssEventLogger* log) {
+  String payload = build_allowlist_json();
+  if (save_allowlist_to_nvs(payload)) g_nvs_behind = false;
+  String err;
+  g_sd_behind = !wss_storage_write_allowlist(payload, err);
+  g_sd_retry_ms = millis();
+  if (g_sd_behind && log && err.length()) {
+    StaticJsonDocument<128> extra;
+    extra["error"] = err;
+    JsonObjectConst o = extra.as<JsonObjectConst>();
+    log->log_warn("nfc", "allowlist_sd_write_failed", "allowlist SD write failed", &o);
+  }
+  g_journal_records = 0;
+  g_compact_due = false;
+}
+
+// Rewrites the card's copy once it can take it again (the card was out during changes).
+static void sd_catch_up(WssEventLogger* log) {
+  g_sd_retry_ms = millis();
+  String err;
+  if (!wss_storage_write_allowlist(build_allowlist_json(), err)) return;
+  g_sd_behind = false;
+  if (log) log->log_info("nfc", "allowlist_sd_synced", "allowlist SD copy rewritten");
+}
+
+// One change: a single fixed-size record appended to each store, whatever the list size.
+static void journal_change(const uint8_t digest[32], uint8_t role, bool remove,
+                           WssEventLogger* log) {
+  char rec[kWssAllowlistJournalRecLen + 1];
+  wss_allowlist_journal_record(digest, role, remove, rec);
+  g_generation++;
+  if (!g_nvs_behind && !append_nvs_journal(rec)) g_nvs_behind = true;
   String err;
-  String payload;
-  if (wss_storage_read_allowlist(payload, err)) {
-    if (parse_allowlist_json(payload, log)) return true;
-    if (log) log->log_warn("nfc", "allowlist_parse_failed", "allowlist parse failed; falling back to NVS");
-  } else {
+  if (!g_sd_behind && !wss_storage_append_allowlist_journal(rec, kWssAllowlistJournalRecLen, err)) {
+    g_sd_behind = true;
+    g_sd_retry_ms = millis();
     if (log && err.length()) {
       StaticJsonDocument<128> extra;
       extra["error"] = err;
       JsonObjectConst o = extra.as<JsonObjectConst>();
-      log->log_warn("nfc", "allowlist_sd_unavailable", "allowlist SD unavailable; using NVS", &o);
+      log->log_warn("nfc", "allowlist_sd_write_failed", "allowlist SD write failed", &o);
     }
   }
-  return load_allowlist_from_nvs(log);
+  g_journal_records++;
+  g_last_change_ms = millis();
+  if (g_journal_records >= WSS_NFC_ALLOWLIST_JOURNAL_MAX) g_compact_due = true;
 }
 
-String wss_nfc_taghash(const uint8_t* uid, size_t uid_len) {
-  if (!uid || uid_len == 0) return String();
-  uint8_t* data = nullptr;
-  size_t len = 0;
-  uint8_t stack_buf[8 + 16];
-  if (uid_len <= 16) {
-    data = stack_buf;
-    len = 8 + uid_len;
-  } else {
-    data = new uint8_t[8 + uid_len];
-    len = 8 + uid_len;
+} // namespace
+
+bool wss_nfc_allowlist_begin(WssEventLogger* log) {
+  g_log = log;
+  salt_hasher_init();
+  const uint32_t nvs_gen = nvs_generation();
+  uint32_t sd_gen = 0;
+  String err;
+  if (load_allowlist_from_sd(log, nvs_gen, sd_gen, err)) {
+    g_generation = sd_gen;
+    if (nvs_gen < sd_gen) {
+      g_nvs_behind = true;
+      g_compact_due = true;
+    }
+    return true;
   }
+  if (log && err == "allowlist_stale") {
+    StaticJsonDocument<128> extra;
+    extra["sd_generation"] = sd_gen;
+    extra["nvs_generation"] = nvs_gen;
+    JsonObjectConst o = extra.as<JsonObjectConst>();
+    log->log_warn("nfc", "allowlist_sd_stale", "allowlist SD copy is older than NVS; using NVS",
+                  &o);
+  } else if (log && err == "allowlist_parse_failed") {
+    log->log_warn("nfc", "allowlist_parse_failed", "allowlist parse failed; falling back to NVS");
+  } else if (log && err.length()) {
+    StaticJsonDocument<128> extra;
+    extra["error"] = err;
+    JsonObjectConst o = extra.as<JsonObjectConst>();
+    log->log_warn("nfc", "allowlist_sd_unavailable", "allowlist SD unavailable; using NVS", &o);
+  }
+  // Card mounted, but without a usable, current allowlist on it.
+  const bool sd_unusable = err == "allowlist_missing" || err == "allowlist_empty" ||
+                           err == "allowlist_parse_failed" || err == "allowlist_stale";
+  if (!load_allowlist_from_nvs(log)) {
+    // An older card copy still beats none.
+    if (err != "allowlist_stale" || !load_allowlist_from_sd(log, 0, sd_gen, err)) return false;
+    g_generation = sd_gen > nvs_gen ? sd_gen : nvs_gen;
+    g_nvs_behind = true;
+    g_compact_due = true;
+    return true;
+  }
+  g_generation = nvs_gen > sd_gen ? nvs_gen : sd_gen;
+  // Whatever the card holds (if one comes later) is rewritten from this copy. Journal
+  // records on the card only make sense over a snapshot there: seed it now.
+  g_sd_behind = err != "sd_disabled";
+  if (sd_unusable) sd_catch_up(log);
+  return true;
+}
 
-  uint64_t salt = device_salt();
-  for (int i = 0; i < 8; i++) {
-    data[i] = (uint8_t)((salt >> (56 - i * 8)) & 0xFF);
+bool wss_nfc_tag_digest(const uint8_t* uid, size_t uid_len, uint8_t out[32]) {
+  if (!uid || uid_len == 0) return false;
+  DigestCacheEntry* victim = nullptr;
+  if (uid_len <= kDigestCacheUidMax) {
+    victim = &g_digest_cache[0];
+    for (DigestCacheEntry& e : g_digest_cache) {
+      if (e.uid_len == uid_len && memcmp(e.uid, uid, uid_len) == 0) {
+        e.used = ++g_digest_cache_clock;
+        memcpy(out, e.digest, 32);
+        g_digest_cache_hits++;
+        return true;
+      }
+      if (e.used < victim->used) victim = &e;
+    }
   }
-  memcpy(data + 8, uid, uid_len);
-  String out = wss_sha256_hex(data, len);
-  if (data != stack_buf) {
-    delete[] data;
+  salt_hasher_init();
+  WssSha256 sha;
+  sha.copy_from(g_salt_sha);
+  sha.update(uid, uid_len);
+  sha.finish(out);
+  if (victim) {
+    victim->uid_len = (uint8_t)uid_len;
+    memcpy(victim->uid, uid, uid_len);
+    memcpy(victim->digest, out, 32);
+    victim->used = ++g_digest_cache_clock;
   }
-  return out;
+  return true;
+}
+
+uint32_t wss_nfc_tag_digest_cache_hits() {
+  return g_digest_cache_hits;
+}
+
+String wss_nfc_taghash(const uint8_t* uid, size_t uid_len) {
+  uint8_t digest[32];
+  if (!wss_nfc_tag_digest(uid, uid_len, digest)) return String();
+  char hex[65];
+  wss_hex_lower(digest, sizeof(digest), hex);
+  return String(hex);
 }
 
 bool wss_nfc_allowlist_is_allowed(const String& taghash) {
@@ -138,18 +364,33 @@ bool wss_nfc_allowlist_is_allowed(const String& taghash) {
 }
 
 WssNfcRole wss_nfc_allowlist_get_role(const String& taghash) {
-  if (!taghash.length()) return WSS_NFC_ROLE_UNKNOWN;
-  for (const auto& e : g_allowlist) {
-    if (taghash == e.taghash) return e.role;
+  uint8_t digest[32];
+  if (!parse_taghash(taghash, digest)) return WSS_NFC_ROLE_UNKNOWN;
+  return wss_nfc_allowlist_get_role_digest(digest);
+}
+
+WssNfcRole wss_nfc_allowlist_get_role_digest(const uint8_t digest[32]) {
+  if (!g_allowlist.may_contain(digest)) {
+    g_filter_rejects++;
+    return WSS_NFC_ROLE_UNKNOWN;
   }
-  return WSS_NFC_ROLE_UNKNOWN;
+  return (WssNfcRole)g_allowlist.find(digest);
+}
+
+uint32_t wss_nfc_allowlist_filter_rejects() {
+  return g_filter_rejects;
 }
 
 bool wss_nfc_allowlist_has_admin() {
-  for (const auto& e : g_allowlist) {
-    if (e.role == WSS_NFC_ROLE_ADMIN) return true;
-  }
-  return false;
+  return g_allowlist.count_role(WSS_NFC_ROLE_ADMIN) > 0;
+}
+
+size_t wss_nfc_allowlist_count() {
+  return g_allowlist.count();
+}
+
+size_t wss_nfc_allowlist_admin_count() {
+  return g_allowlist.count_role(WSS_NFC_ROLE_ADMIN);
 }
 
 const char* wss_nfc_role_to_string(WssNfcRole role) {
@@ -165,72 +406,38 @@ const char* wss_nfc_role_to_string(WssNfcRole role) {
 }
 
 bool wss_nfc_allowlist_add(const String& taghash, WssNfcRole role, WssEventLogger* log) {
-  if (!taghash.length()) return false;
+  uint8_t digest[32];
+  if (!parse_taghash(taghash, digest)) return false;
   bool changed = false;
-  for (auto& e : g_allowlist) {
-    if (e.taghash == taghash) {
-      if (e.role != role) {
-        e.role = role;
-        changed = true;
-      }
-      String payload = build_allowlist_json();
-      (void)save_allowlist_to_nvs(payload);
-      String err;
-      if (!wss_storage_write_allowlist(payload, err) && log && err.length()) {
-        StaticJsonDocument<128> extra;
-        extra["error"] = err;
-        JsonObjectConst o = extra.as<JsonObjectConst>();
-        log->log_warn("nfc", "allowlist_sd_write_failed", "allowlist SD write failed", &o);
-      }
-      return changed;
-    }
-  }
-  g_allowlist.push_back({taghash, role});
-  changed = true;
-  String payload = build_allowlist_json();
-  (void)save_allowlist_to_nvs(payload);
-  String err;
-  if (!wss_storage_write_allowlist(payload, err) && log && err.length()) {
-    StaticJsonDocument<128> extra;
-    extra["error"] = err;
-    JsonObjectConst o = extra.as<JsonObjectConst>();
-    log->log_warn("nfc", "allowlist_sd_write_failed", "allowlist SD write failed", &o);
+  if (!g_allowlist.put(digest, (uint8_t)role, changed)) {
+    if (log) log->log_warn("nfc", "allowlist_full", "allowlist out of memory");
+    return false;
   }
+  if (changed) journal_change(digest, (uint8_t)role, false, log);
   return changed;
 }
 
 bool wss_nfc_allowlist_remove(const String& taghash, WssEventLogger* log) {
-  if (!taghash.length()) return false;
-  bool removed = false;
-  for (size_t i = 0; i < g_allowlist.size(); i++) {
-    if (g_allowlist[i].taghash == taghash) {
-      g_allowlist.erase(g_allowlist.begin() + i);
-      removed = true;
-      break;
-    }
-  }
-  String payload = build_allowlist_json();
-  (void)save_allowlist_to_nvs(payload);
-  String err;
-  if (!wss_storage_write_allowlist(payload, err) && log && err.length()) {
-    StaticJsonDocument<128> extra;
-    extra["error"] = err;
-    JsonObjectConst o = extra.as<JsonObjectConst>();
-    log->log_warn("nfc", "allowlist_sd_write_failed", "allowlist SD write failed", &o);
-  }
+  uint8_t digest[32];
+  if (!parse_taghash(taghash, digest)) return false;
+  const bool removed = g_allowlist.remove(digest);
+  if (removed) journal_change(digest, WSS_NFC_ROLE_UNKNOWN, true, log);
   return removed;
 }
 
+void wss_nfc_allowlist_loop() {
+  if (g_sd_behind && !g_compact_due &&
+      (uint32_t)(millis() - g_sd_retry_ms) >= WSS_NFC_ALLOWLIST_SD_RETRY_MS) {
+    sd_catch_up(g_log);
+  }
+  if (!g_compact_due) return;
+  if ((uint32_t)(millis() - g_last_change_ms) < WSS_NFC_ALLOWLIST_COMPACT_IDLE_MS) return;
+  persist_allowlist(g_log);
+}
+
 void wss_nfc_allowlist_factory_reset(WssEventLogger& log) {
   g_allowlist.clear();
-  String payload = build_allowlist_json();
-  (void)save_allowlist_to_nvs(payload);
-  String err;
-  if (!wss_storage_write_allowlist(payload, err) && err.length()) {
-    StaticJsonDocument<128> extra;
-    extra["error"] = err;
-    JsonObjectConst o = extra.as<JsonObjectConst>();
-    log.log_warn("nfc", "allowlist_sd_write_failed", "allowlist SD write failed", &o);
-  }
+  g_generation++;  // newer than any copy that missed the reset
+  persist_allowlist(&log);
   log.log_info("nfc", "allowlist_factory_reset", "allowlist reset");
 }
@@ -6,28 +6,50 @@
 
 class WssEventLogger;
 
+#ifndef WSS_NFC_TAG_DIGEST_CACHE
+#define WSS_NFC_TAG_DIGEST_CACHE 8
+#endif
+
 enum WssNfcRole {
   WSS_NFC_ROLE_UNKNOWN = 0,
   WSS_NFC_ROLE_ADMIN = 1,
   WSS_NFC_ROLE_USER = 2,
 };
 
-// Loads allowlist from persistent storage (SD preferred, NVS fallback).
+// Loads the allowlist from persistent storage: the SD or NVS copy that has seen more
+// changes (SD on a tie), NVS when the card has none. A stale card copy is rewritten.
 bool wss_nfc_allowlist_begin(WssEventLogger* log);
 
 // M6: per-device-salted, non-reversible tag identifier.
 String wss_nfc_taghash(const uint8_t* uid, size_t uid_len);
-
-// Allowlist queries (provisioning arrives later).
+// The same identifier as 32 raw bytes (SHA-256 of the big-endian salt and the UID). Hashes
+// from a precomputed salt state; the last WSS_NFC_TAG_DIGEST_CACHE UIDs are answered from
+// an LRU cache.
+bool wss_nfc_tag_digest(const uint8_t* uid, size_t uid_len, uint8_t out[32]);
+uint32_t wss_nfc_tag_digest_cache_hits();
+
+// Allowlist queries. Entries are held as raw 32-byte digests in a hash table, so a lookup
+// is one hex parse plus O(1) probes regardless of the allowlist size; anything that is
+// not a 64-hex tag hash is never allowed.
 bool wss_nfc_allowlist_is_allowed(const String& taghash);
 WssNfcRole wss_nfc_allowlist_get_role(const String& taghash);
-bool wss_nfc_allowlist_has_admin();
+// Tap path: a Bloom filter answers most unknown tags before the table is probed.
+WssNfcRole wss_nfc_allowlist_get_role_digest(const uint8_t digest[32]);
+uint32_t wss_nfc_allowlist_filter_rejects();
+bool wss_nfc_allowlist_has_admin();  // cached count, no scan
+size_t wss_nfc_allowlist_count();
+size_t wss_nfc_allowlist_admin_count();
 const char* wss_nfc_role_to_string(WssNfcRole role);
 
-// Provisioning operations.
+// Provisioning operations. Each change appends one journal record (SD and NVS); the full
+// snapshot is rewritten only by compaction.
 bool wss_nfc_allowlist_add(const String& taghash, WssNfcRole role, WssEventLogger* log);
 bool wss_nfc_allowlist_remove(const String& taghash, WssEventLogger* log);
 
+// Compacts the journal into a new snapshot once it holds WSS_NFC_ALLOWLIST_JOURNAL_MAX
+// records and no change came for WSS_NFC_ALLOWLIST_COMPACT_IDLE_MS. Called from the NFC loop.
+void wss_nfc_allowlist_loop();
+
 // Allowlist persistence and provisioning arrive in later milestones.
 // This hook exists so Factory Restore can explicitly clear allowlist state.
 void wss_nfc_allowlist_factory_reset(WssEventLogger& log);
@@ -9,6 +9,7 @@
 #include "../config/config_store.h"
 #include "../config/pin_policy.h"
 #include "../logging/event_logger.h"
+#include "../logging/sha256_hex.h"
 #include "nfc_allowlist.h"
 #include "../state_machine/state_machine.h"
 #include "../storage/time_manager.h"
@@ -16,13 +17,34 @@
 
 namespace {
 
+// A tap's tag identity as the raw salted digest. The hex forms are only made when an event
+// or the allowlist API needs them.
+struct TagId {
+  uint8_t digest[32];
+  bool valid = false;
+
+  bool same(const TagId& o) const {
+    return valid && o.valid && memcmp(digest, o.digest, sizeof(digest)) == 0;
+  }
+  // First 8 hex chars, the only part of a tag that goes into the log.
+  const char* prefix(char out[9]) const {
+    wss_hex_lower(digest, 4, out);
+    return out;
+  }
+  String hex() const {
+    char out[65];
+    wss_hex_lower(digest, sizeof(digest), out);
+    return String(out);
+  }
+};
+
 static WssConfigStore* g_cfg = nullptr;
 static WssEventLogger* g_log = nullptr;
 static WssNfcStatus g_status;
 static uint32_t g_last_poll_ms = 0;
 static bool g_logged_unavailable = false;
 static bool g_last_enabled_cfg = true;
-static String g_last_taghash;
+static TagId g_last_tap_tag;
 static uint32_t g_last_tag_ms = 0;
 static uint32_t g_last_debounce_log_ms = 0;
 static bool g_lockout_active = false;
@@ -37,7 +59,7 @@ static bool g_hold_active = false;
 static bool g_hold_ready = false;
 static uint32_t g_hold_started_ms = 0;
 static uint32_t g_hold_last_seen_ms = 0;
-static String g_hold_taghash;
+static TagId g_hold_tag;
 static uint32_t g_last_hold_cancel_log_ms = 0;
 static bool g_prov_active = false;
 static uint32_t g_prov_until_ms = 0;
@@ -56,6 +78,31 @@ static String g_last_writeback_result;
 static String g_last_writeback_reason;
 static String g_last_writeback_ts;
 
+static const char* const kStageNames[WSS_NFC_STAGE_COUNT] = {
+    "taghash", "lookup", "log", "lockout", "reject",
+};
+
+// Adds the time since `since_us` to a stage; returns the current micros() so stages can be
+// chained.
+static uint32_t stage_add(WssNfcScanStage stage, uint32_t since_us) {
+  const uint32_t now_us = micros();
+  const uint32_t us = now_us - since_us;
+  WssNfcStageTiming& t = g_status.scan_timing[stage];
+  t.count++;
+  t.total_us += us;
+  if (us > t.max_us) t.max_us = us;
+  return now_us;
+}
+
+// Times a rejected tap on whichever path it leaves on_uid.
+struct RejectTimer {
+  bool active;
+  uint32_t start_us;
+  ~RejectTimer() {
+    if (active) (void)stage_add(WSS_NFC_STAGE_REJECT, start_us);
+  }
+};
+
 static bool feature_enabled() {
 #if defined(WSS_FEATURE_NFC) && WSS_FEATURE_NFC
   return true;
@@ -138,7 +185,7 @@ static void log_scan_event(bool ok, const char* reason) {
   }
 }
 
-static void log_scan_ok(const char* role, const char* reason, const String& taghash) {
+static void log_scan_ok(const char* role, const char* reason, const TagId& tag) {
   uint32_t now_ms = millis();
   g_status.last_scan_ms = now_ms;
   g_status.last_scan_ok_ms = now_ms;
@@ -157,20 +204,22 @@ static void log_scan_ok(const char* role, const char* reason, const String& tagh
   extra["result"] = "ok";
   extra["role"] = g_status.last_role;
   if (reason && reason[0]) extra["reason"] = reason;
-  if (taghash.length()) extra["tag_prefix"] = taghash.substring(0, 8);
+  char prefix[9];
+  if (tag.valid) extra["tag_prefix"] = tag.prefix(prefix);
   JsonObjectConst o = extra.as<JsonObjectConst>();
   g_log->log_info("nfc", "nfc_scan", "nfc scan ok", &o);
 }
 
 static void log_action_event(const char* action, const char* outcome, const char* reason,
-                             const char* role, const String& taghash) {
+                             const char* role, const TagId& tag) {
   if (!g_log) return;
   StaticJsonDocument<256> extra;
   if (action && action[0]) extra["action"] = action;
   if (outcome && outcome[0]) extra["outcome"] = outcome;
   if (role && role[0]) extra["role"] = role;
   if (reason && reason[0]) extra["reason"] = reason;
-  if (taghash.length()) extra["tag_prefix"] = taghash.substring(0, 8);
+  char prefix[9];
+  if (tag.valid) extra["tag_prefix"] = tag.prefix(prefix);
   JsonObjectConst o = extra.as<JsonObjectConst>();
   if (outcome && strcmp(outcome, "allowed") == 0) {
     g_log->log_info("nfc", "nfc_action", "nfc action allowed", &o);
@@ -180,37 +229,40 @@ static void log_action_event(const char* action, const char* outcome, const char
 }
 
 static void log_hold_event(const char* event_type, const char* reason, const char* role,
-                           const String& taghash) {
+                           const TagId& tag) {
   if (!g_log) return;
   StaticJsonDocument<192> extra;
   if (reason && reason[0]) extra["reason"] = reason;
   if (role && role[0]) extra["role"] = role;
-  if (taghash.length()) extra["tag_prefix"] = taghash.substring(0, 8);
+  char prefix[9];
+  if (tag.valid) extra["tag_prefix"] = tag.prefix(prefix);
   JsonObjectConst o = extra.as<JsonObjectConst>();
   g_log->log_info("nfc", event_type, "nfc hold event", &o);
 }
 
 static void log_prov_event(const char* action, const char* outcome, const char* role,
-                           const String& taghash) {
+                           const TagId& tag) {
   if (!g_log) return;
   StaticJsonDocument<192> extra;
   if (action && action[0]) extra["action"] = action;
   if (outcome && outcome[0]) extra["outcome"] = outcome;
   if (role && role[0]) extra["role"] = role;
-  if (taghash.length()) extra["tag_prefix"] = taghash.substring(0, 8);
+  char prefix[9];
+  if (tag.valid) extra["tag_prefix"] = tag.prefix(prefix);
   JsonObjectConst o = extra.as<JsonObjectConst>();
   g_log->log_info("nfc", "nfc_provision", "nfc provisioning event", &o);
 }
 
 static void log_writeback_event(const char* result, const char* reason, const char* variant,
-                                uint32_t bytes_written, const String& taghash) {
+                                uint32_t bytes_written, const TagId& tag) {
   if (!g_log) return;
   StaticJsonDocument<256> extra;
   if (result && result[0]) extra["result"] = result;
   if (reason && reason[0]) extra["reason"] = reason;
   if (variant && variant[0]) extra["payload_variant"] = variant;
   if (bytes_written) extra["bytes_written"] = bytes_written;
-  if (taghash.length()) extra["tag_prefix"] = taghash.substring(0, 8);
+  char prefix[9];
+  if (tag.valid) extra["tag_prefix"] = tag.prefix(prefix);
   JsonObjectConst o = extra.as<JsonObjectConst>();
   g_log->log_info("nfc", "nfc_writeback", "nfc writeback", &o);
 }
@@ -323,27 +375,27 @@ static void hold_reset(const char* reason, const char* role) {
     uint32_t now_ms = millis();
     if ((uint32_t)(now_ms - g_last_hold_cancel_log_ms) >= 2000) {
       g_last_hold_cancel_log_ms = now_ms;
-      log_hold_event("hold_cancel", reason ? reason : "cancel", role, g_hold_taghash);
+      log_hold_event("hold_cancel", reason ? reason : "cancel", role, g_hold_tag);
     }
   }
   g_hold_active = false;
   g_hold_ready = false;
   g_hold_started_ms = 0;
   g_hold_last_seen_ms = 0;
-  g_hold_taghash = "";
+  g_hold_tag = TagId();
 }
 
-static bool hold_update(const String& taghash, uint32_t now_ms, const char* role) {
+static bool hold_update(const TagId& tag, uint32_t now_ms, const char* role) {
   static const uint32_t kHoldMs = 3000;
   static const uint32_t kHoldPresentTimeoutMs = 350;
 
-  if (!g_hold_active || taghash != g_hold_taghash) {
-    if (g_hold_active && taghash != g_hold_taghash) {
+  if (!g_hold_active || !tag.same(g_hold_tag)) {
+    if (g_hold_active && !tag.same(g_hold_tag)) {
       hold_reset("tag_changed", role);
     }
     g_hold_active = true;
     g_hold_ready = false;
-    g_hold_taghash = taghash;
+    g_hold_tag = tag;
     g_hold_started_ms = now_ms;
     g_hold_last_seen_ms = now_ms;
     return false;
@@ -563,7 +615,7 @@ static bool ndef_fits(const String& ndef, uint32_t capacity) {
   return (ndef.length() <= capacity);
 }
 
-static bool attempt_incident_writeback(const String& taghash, String& reason_out) {
+static bool attempt_incident_writeback(const TagId& tag, String& reason_out) {
   reason_out = "";
   if (!g_reader_ok) {
     reason_out = "reader_unavailable";
@@ -572,7 +624,7 @@ static bool attempt_incident_writeback(const String& taghash, String& reason_out
     bool tv = false;
     g_last_writeback_ts = wss_time_now_iso8601_utc(tv);
     if (!tv) g_last_writeback_ts = "u";
-    log_writeback_event("fail", reason_out.c_str(), "none", 0, taghash);
+    log_writeback_event("fail", reason_out.c_str(), "none", 0, tag);
     return false;
   }
   uint32_t now_ms = millis();
@@ -583,7 +635,7 @@ static bool attempt_incident_writeback(const String& taghash, String& reason_out
     bool tv = false;
     g_last_writeback_ts = wss_time_now_iso8601_utc(tv);
     if (!tv) g_last_writeback_ts = "u";
-    log_writeback_event("fail", reason_out.c_str(), "none", 0, taghash);
+    log_writeback_event("fail", reason_out.c_str(), "none", 0, tag);
     return false;
   }
   if (g_last_tag.capacity_bytes == 0) {
@@ -593,7 +645,7 @@ static bool attempt_incident_writeback(const String& taghash, String& reason_out
     bool tv = false;
     g_last_writeback_ts = wss_time_now_iso8601_utc(tv);
     if (!tv) g_last_writeback_ts = "u";
-    log_writeback_event("fail", reason_out.c_str(), "none", 0, taghash);
+    log_writeback_event("fail", reason_out.c_str(), "none", 0, tag);
     return false;
   }
 
@@ -669,7 +721,7 @@ static bool attempt_incident_writeback(const String& taghash, String& reason_out
     bool tv = false;
     g_last_writeback_ts = wss_time_now_iso8601_utc(tv);
     if (!tv) g_last_writeback_ts = "u";
-    log_writeback_event("fail", reason_out.c_str(), variant.c_str(), bytes_written, taghash);
+    log_writeback_event("fail", reason_out.c_str(), variant.c_str(), bytes_written, tag);
     return false;
   }
 
@@ -678,7 +730,7 @@ static bool attempt_incident_writeback(const String& taghash, String& reason_out
   bool tv = false;
   g_last_writeback_ts = wss_time_now_iso8601_utc(tv);
   if (!tv) g_last_writeback_ts = "u";
-  log_writeback_event(g_last_writeback_result.c_str(), g_last_writeback_reason.c_str(), variant.c_str(), bytes_written, taghash);
+  log_writeback_event(g_last_writeback_result.c_str(), g_last_writeback_reason.c_str(), variant.c_str(), bytes_written, tag);
   return true;
 }
 
@@ -705,17 +757,17 @@ static void invalid_scan_record(uint32_t now_ms, uint32_t window_s, uint32_t max
   }
 }
 
-static bool debounced(const String& taghash, uint32_t now_ms) {
-  if (taghash.length() == 0) return false;
+static bool debounced(const TagId& tag, uint32_t now_ms) {
+  if (!tag.valid) return false;
   static const uint32_t kDebounceMs = 1500;
-  if (taghash == g_last_taghash && (uint32_t)(now_ms - g_last_tag_ms) < kDebounceMs) {
+  if (tag.same(g_last_tap_tag) && (uint32_t)(now_ms - g_last_tag_ms) < kDebounceMs) {
     if ((uint32_t)(now_ms - g_last_debounce_log_ms) >= 2000) {
       g_last_debounce_log_ms = now_ms;
-      log_action_event("tap", "ignored", "debounced", g_status.last_role.c_str(), taghash);
+      log_action_event("tap", "ignored", "debounced", g_status.last_role.c_str(), tag);
     }
     return true;
   }
-  g_last_taghash = taghash;
+  g_last_tap_tag = tag;
   g_last_tag_ms = now_ms;
   return false;
 }
@@ -734,7 +786,7 @@ void wss_nfc_begin(WssConfigStore* cfg, WssEventLogger* log) {
   g_last_enabled_cfg = g_status.enabled_cfg;
   g_last_poll_ms = 0;
   g_logged_unavailable = false;
-  g_last_taghash = "";
+  g_last_tap_tag = TagId();
   g_last_tag_ms = 0;
   g_last_debounce_log_ms = 0;
   g_lockout_active = false;
@@ -747,7 +799,7 @@ void wss_nfc_begin(WssConfigStore* cfg, WssEventLogger* log) {
   g_hold_ready = false;
   g_hold_started_ms = 0;
   g_hold_last_seen_ms = 0;
-  g_hold_taghash = "";
+  g_hold_tag = TagId();
   g_last_hold_cancel_log_ms = 0;
   g_prov_active = false;
   g_prov_until_ms = 0;
@@ -824,6 +876,7 @@ void wss_nfc_begin(WssConfigStore* cfg, WssEventLogger* log) {
 
 void wss_nfc_loop() {
   if (!g_cfg) return;
+  wss_nfc_allowlist_loop();
 
   g_status.feature_enabled = feature_enabled();
   g_status.enabled_cfg = cfg_bool("control_nfc_enabled", true);
@@ -936,25 +989,31 @@ void wss_nfc_loop() {
 void wss_nfc_on_uid(const uint8_t* uid, size_t uid_len) {
   if (!g_status.feature_enabled || !g_status.enabled_cfg) {
     log_scan_event(false, "nfc_disabled");
-    log_action_event("tap", "rejected", "nfc_disabled", "unknown", "");
+    log_action_event("tap", "rejected", "nfc_disabled", "unknown", TagId());
     return;
   }
   if (!uid || uid_len == 0) {
     log_scan_event(false, "uid_invalid");
-    log_action_event("tap", "rejected", "uid_invalid", "unknown", "");
+    log_action_event("tap", "rejected", "uid_invalid", "unknown", TagId());
     return;
   }
   uint32_t now_ms = millis();
   lockout_update(now_ms);
   prov_tick(now_ms);
 
-  String taghash = wss_nfc_taghash(uid, uid_len);
-  WssNfcRole role = wss_nfc_allowlist_get_role(taghash);
+  const uint32_t tap_start_us = micros();
+  TagId tag;
+  tag.valid = wss_nfc_tag_digest(uid, uid_len, tag.digest);
+  uint32_t t_us = stage_add(WSS_NFC_STAGE_TAGHASH, tap_start_us);
+  WssNfcRole role = wss_nfc_allowlist_get_role_digest(tag.digest);
+  t_us = stage_add(WSS_NFC_STAGE_LOOKUP, t_us);
+  RejectTimer reject_timer{role == WSS_NFC_ROLE_UNKNOWN && !g_prov_active, tap_start_us};
   const char* role_str = wss_nfc_role_to_string(role);
   const char* reason = (role == WSS_NFC_ROLE_UNKNOWN) ? "allowlist_unknown" : "allowlist_match";
-  log_scan_ok(role_str, reason, taghash);
+  log_scan_ok(role_str, reason, tag);
+  (void)stage_add(WSS_NFC_STAGE_LOG, t_us);
 
-  bool hold_ready = hold_update(taghash, now_ms, role_str);
+  bool hold_ready = hold_update(tag, now_ms, role_str);
 
   uint32_t window_s = cfg_u32("invalid_scan_window_s", 30);
   uint32_t max_scans = cfg_u32("invalid_scan_max", 5);
@@ -966,14 +1025,15 @@ void wss_nfc_on_uid(const uint8_t* uid, size_t uid_len) {
       if (g_log) {
         StaticJsonDocument<128> extra;
         extra["cleared_by"] = "admin";
-        if (taghash.length()) extra["tag_prefix"] = taghash.substring(0, 8);
+        char prefix[9];
+        extra["tag_prefix"] = tag.prefix(prefix);
         JsonObjectConst o = extra.as<JsonObjectConst>();
         g_log->log_info("nfc", "lockout_cleared", "nfc lockout cleared by admin", &o);
       }
     } else {
       if ((uint32_t)(now_ms - g_last_lockout_ignored_log_ms) >= 2000) {
         g_last_lockout_ignored_log_ms = now_ms;
-        log_action_event("tap", "ignored", "ignored_due_to_lockout", role_str, taghash);
+        log_action_event("tap", "ignored", "ignored_due_to_lockout", role_str, tag);
       }
       return;
     }
@@ -984,18 +1044,18 @@ void wss_nfc_on_uid(const uint8_t* uid, size_t uid_len) {
   }
 
   if (g_prov_active) {
-    if (debounced(taghash, now_ms)) return;
+    if (debounced(tag, now_ms)) return;
     if (g_prov_mode == "add_user") {
-      bool changed = wss_nfc_allowlist_add(taghash, WSS_NFC_ROLE_USER, g_log);
-      log_prov_event("add_user", changed ? "added" : "unchanged", "user", taghash);
+      bool changed = wss_nfc_allowlist_add(tag.hex(), WSS_NFC_ROLE_USER, g_log);
+      log_prov_event("add_user", changed ? "added" : "unchanged", "user", tag);
     } else if (g_prov_mode == "add_admin") {
-      bool changed = wss_nfc_allowlist_add(taghash, WSS_NFC_ROLE_ADMIN, g_log);
-      log_prov_event("add_admin", changed ? "added" : "unchanged", "admin", taghash);
+      bool changed = wss_nfc_allowlist_add(tag.hex(), WSS_NFC_ROLE_ADMIN, g_log);
+      log_prov_event("add_admin", changed ? "added" : "unchanged", "admin", tag);
     } else if (g_prov_mode == "remove") {
-      bool removed = wss_nfc_allowlist_remove(taghash, g_log);
-      log_prov_event("remove", removed ? "removed" : "not_found", "", taghash);
+      bool removed = wss_nfc_allowlist_remove(tag.hex(), g_log);
+      log_prov_event("remove", removed ? "removed" : "not_found", "", tag);
     } else {
-      log_prov_event("unknown", "rejected", "", taghash);
+      log_prov_event("unknown", "rejected", "", tag);
     }
     return;
   }
@@ -1003,37 +1063,39 @@ void wss_nfc_on_uid(const uint8_t* uid, size_t uid_len) {
   if (hold_ready) {
     WssStateStatus sm = wss_state_status();
     if (role != WSS_NFC_ROLE_ADMIN) {
-      log_action_event("clear", "rejected", "not_admin", role_str, taghash);
+      log_action_event("clear", "rejected", "not_admin", role_str, tag);
       hold_reset("not_admin", role_str);
       return;
     }
     if (sm.state != "TRIGGERED") {
-      log_action_event("clear", "rejected", "not_triggered", role_str, taghash);
+      log_action_event("clear", "rejected", "not_triggered", role_str, tag);
       hold_reset("not_triggered", role_str);
       return;
     }
     String wb_reason;
-    if (!attempt_incident_writeback(taghash, wb_reason)) {
-      log_action_event("clear", "rejected", "writeback_failed", role_str, taghash);
+    if (!attempt_incident_writeback(tag, wb_reason)) {
+      log_action_event("clear", "rejected", "writeback_failed", role_str, tag);
       hold_reset("writeback_failed", role_str);
       return;
     }
     bool ok = wss_state_clear("nfc_clear:admin");
     if (ok) {
-      log_action_event("clear", "allowed", "ok", role_str, taghash);
+      log_action_event("clear", "allowed", "ok", role_str, tag);
     } else {
-      log_action_event("clear", "rejected", "state_rejected", role_str, taghash);
+      log_action_event("clear", "rejected", "state_rejected", role_str, tag);
     }
     hold_reset("completed", role_str);
     return;
   }
 
-  if (debounced(taghash, now_ms)) return;
+  if (debounced(tag, now_ms)) return;
 
   if (role == WSS_NFC_ROLE_UNKNOWN) {
+    t_us = micros();
     invalid_scan_record(now_ms, window_s, max_scans, duration_s);
+    (void)stage_add(WSS_NFC_STAGE_LOCKOUT, t_us);
     if (g_lockout_active) return;
-    log_action_event("tap", "rejected", "not_in_allowlist", role_str, taghash);
+    log_action_event("tap", "rejected", "not_in_allowlist", role_str, tag);
     return;
   }
 
@@ -1042,14 +1104,14 @@ void wss_nfc_on_uid(const uint8_t* uid, size_t uid_len) {
     bool allow_user_arm = cfg_bool("allow_user_arm", true);
     bool allowed = (role == WSS_NFC_ROLE_ADMIN) || (role == WSS_NFC_ROLE_USER && allow_user_arm);
     if (!allowed) {
-      log_action_event("arm", "rejected", "role_not_permitted", role_str, taghash);
+      log_action_event("arm", "rejected", "role_not_permitted", role_str, tag);
       return;
     }
     bool ok = wss_state_arm((role == WSS_NFC_ROLE_ADMIN) ? "nfc_arm:admin" : "nfc_arm:user");
     if (ok) {
-      log_action_event("arm", "allowed", "ok", role_str, taghash);
+      log_action_event("arm", "allowed", "ok", role_str, tag);
     } else {
-      log_action_event("arm", "rejected", "state_rejected", role_str, taghash);
+      log_action_event("arm", "rejected", "state_rejected", role_str, tag);
     }
     return;
   }
@@ -1058,19 +1120,19 @@ void wss_nfc_on_uid(const uint8_t* uid, size_t uid_len) {
     bool allow_user_disarm = cfg_bool("allow_user_disarm", true);
     bool allowed = (role == WSS_NFC_ROLE_ADMIN) || (role == WSS_NFC_ROLE_USER && allow_user_disarm);
     if (!allowed) {
-      log_action_event("disarm", "rejected", "role_not_permitted", role_str, taghash);
+      log_action_event("disarm", "rejected", "role_not_permitted", role_str, tag);
       return;
     }
     bool ok = wss_state_disarm((role == WSS_NFC_ROLE_ADMIN) ? "nfc_disarm:admin" : "nfc_disarm:user");
     if (ok) {
-      log_action_event("disarm", "allowed", "ok", role_str, taghash);
+      log_action_event("disarm", "allowed", "ok", role_str, tag);
     } else {
-      log_action_event("disarm", "rejected", "state_rejected", role_str, taghash);
+      log_action_event("disarm", "rejected", "state_rejected", role_str, tag);
     }
     return;
   }
 
-  log_action_event("tap", "rejected", "state_not_supported_in_slice2", role_str, taghash);
+  log_action_event("tap", "rejected", "state_not_supported_in_slice2", role_str, tag);
 }
 
 bool wss_nfc_provision_start(const char* mode) {
@@ -1155,6 +1217,10 @@ WssNfcStatus wss_nfc_status() {
   g_status.present = g_status.reader_present;
   g_status.fault = (g_status.health_state == "fault");
   g_status.last_error = g_reader_ok ? String("") : g_reader.last_error();
+  g_status.allowlist_entries = (uint32_t)wss_nfc_allowlist_count();
+  g_status.allowlist_admins = (uint32_t)wss_nfc_allowlist_admin_count();
+  g_status.allowlist_filter_rejects = wss_nfc_allowlist_filter_rejects();
+  g_status.taghash_cache_hits = wss_nfc_tag_digest_cache_hits();
   return g_status;
 }
 
@@ -1188,6 +1254,18 @@ void wss_nfc_write_status_json(JsonObject out) {
   out["last_scan_fail_ms"] = st.last_scan_fail_ms;
   out["scan_ok_count"] = st.scan_ok_count;
   out["scan_fail_count"] = st.scan_fail_count;
+  out["allowlist_entries"] = st.allowlist_entries;
+  out["allowlist_admins"] = st.allowlist_admins;
+  out["allowlist_filter_rejects"] = st.allowlist_filter_rejects;
+  out["taghash_cache_hits"] = st.taghash_cache_hits;
+  JsonObject timing = out.createNestedObject("scan_timing");
+  for (int i = 0; i < WSS_NFC_STAGE_COUNT; i++) {
+    const WssNfcStageTiming& t = st.scan_timing[i];
+    JsonObject o = timing.createNestedObject(kStageNames[i]);
+    o["count"] = t.count;
+    o["avg_us"] = t.count ? (uint32_t)(t.total_us / t.count) : 0;
+    o["max_us"] = t.max_us;
+  }
   out["hold_active"] = st.hold_active;
   out["hold_ready"] = st.hold_ready;
   out["hold_progress_s"] = st.hold_progress_s;
@@ -14,6 +14,23 @@
 class WssConfigStore;
 class WssEventLogger;
 
+// Stages of handling one tap, timed with micros(), so the reject path can be checked
+// against the reader's poll interval under a brute-force scan.
+enum WssNfcScanStage : uint8_t {
+  WSS_NFC_STAGE_TAGHASH = 0,  // salted digest of the UID (digest cache or SHA-256)
+  WSS_NFC_STAGE_LOOKUP,       // Bloom filter and allowlist table
+  WSS_NFC_STAGE_LOG,          // the nfc_scan event every tap emits
+  WSS_NFC_STAGE_LOCKOUT,      // invalid-scan window and lockout entry (unknown tags)
+  WSS_NFC_STAGE_REJECT,       // the whole tap, unknown tags only
+  WSS_NFC_STAGE_COUNT,
+};
+
+struct WssNfcStageTiming {
+  uint32_t count = 0;
+  uint64_t total_us = 0;
+  uint32_t max_us = 0;
+};
+
 struct WssNfcStatus {
   bool feature_enabled = false;   // build-time NFC feature flag
   bool enabled_cfg = false;       // control_nfc_enabled
@@ -54,6 +71,11 @@ struct WssNfcStatus {
   uint32_t last_scan_fail_ms = 0;
   uint32_t scan_ok_count = 0;
   uint32_t scan_fail_count = 0;
+  uint32_t allowlist_entries = 0;
+  uint32_t allowlist_admins = 0;
+  uint32_t allowlist_filter_rejects = 0;
+  uint32_t taghash_cache_hits = 0;
+  WssNfcStageTiming scan_timing[WSS_NFC_STAGE_COUNT];
 };
 
 void wss_nfc_begin(WssConfigStore* cfg, WssEventLogger* log);
@@ -0,0 +1,26 @@
+// src/psram_alloc.cpp
+#include "psram_alloc.h"
+
+#include <esp_heap_caps.h>
+
+bool wss_psram_available() {
+#if defined(BOARD_HAS_PSRAM)
+  return psramFound();
+#else
+  return false;
+#endif
+}
+
+void* wss_large_alloc(size_t bytes) {
+  if (bytes == 0) return nullptr;
+  if (wss_psram_available()) {
+    void* p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (p) return p;
+  }
+  return malloc(bytes);
+}
+
+void wss_large_free(void* p) {
+  // heap_caps_malloc() memory is released by free() on ESP-IDF.
+  free(p);
+}
@@ -0,0 +1,12 @@
+// src/psram_alloc.h
+// Role: Large-buffer allocation helper (PSRAM on boards that have it, internal heap otherwise).
+#pragma once
+#include <Arduino.h>
+
+// Allocates `bytes` from PSRAM when the board has it (BOARD_HAS_PSRAM + psramFound()),
+// otherwise from the internal heap. Release with wss_large_free().
+void* wss_large_alloc(size_t bytes);
+void wss_large_free(void* p);
+
+// True when wss_large_alloc() will use PSRAM.
+bool wss_psram_available();
@@ -0,0 +1,437 @@
+// src/storage/flash_log.cpp
+// Role: Append-only segment log on a raw flash region with CRC'd records.
+//
+// Recovery relies on two NOR properties: erased bytes read 0xFF and a write can only
+// clear bits. A record is written in one program operation; after a power cut the head
+// sector ends either in 0xFF (clean) or in a record whose length check or CRC fails
+// (torn), in which case the sector is sealed and appends continue in the next one.
+// Records are only appended to the head sector, so only it is CRC-checked at mount; the
+// others are walked by record headers and verified when read. A torn record found at
+// mount has its header programmed to zeros, so once its sector is no longer the head the
+// header walk still stops there. The one in-place write elsewhere is clearing a record's
+// flags when it has been drained; a torn flag write still reads as drained (any value but
+// 0xFFFF).
+
+#include "flash_log.h"
+
+#include <string.h>
+
+#include "../crc32.h"
+#include "../psram_alloc.h"
+
+static const uint32_t kSectorMagic = 0x474C4657UL; // "WFLG"
+static const uint16_t kSectorHeaderBytes = 16;
+static const uint16_t kRecordHeaderBytes = 12;
+static const uint16_t kFlagsPending = 0xFFFF;
+
+struct SectorHeader {
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t wear;
+  uint32_t crc; // over the first 12 bytes
+};
+
+struct RecordHeader {
+  uint16_t len;
+  uint16_t len_inv;
+  uint16_t flags; // kFlagsPending until drained
+  uint16_t rsv;
+  uint32_t crc;   // payload
+};
+
+static_assert(sizeof(SectorHeader) == kSectorHeaderBytes, "sector header layout changed");
+static_assert(sizeof(RecordHeader) == kRecordHeaderBytes, "record header layout changed");
+
+static uint32_t record_span(size_t len) {
+  return (uint32_t)((kRecordHeaderBytes + len + 3) & ~(size_t)3);
+}
+
+static bool all_ff(const uint8_t* p, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (p[i] != 0xFF) return false;
+  }
+  return true;
+}
+
+static bool all_zero(const uint8_t* p, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (p[i] != 0) return false;
+  }
+  return true;
+}
+
+WssRamFlash::WssRamFlash(uint32_t size) {
+  size -= size % WssFlashLog::kSectorBytes;
+  _mem = static_cast<uint8_t*>(wss_large_alloc(size));
+  if (!_mem) return;
+  _size = size;
+  memset(_mem, 0xFF, size);
+}
+
+WssRamFlash::~WssRamFlash() {
+  wss_large_free(_mem);
+}
+
+bool WssRamFlash::read(uint32_t offset, void* buf, size_t len) {
+  if (!_mem || offset > _size || len > _size - offset) return false;
+  memcpy(buf, _mem + offset, len);
+  return true;
+}
+
+bool WssRamFlash::write(uint32_t offset, const void* buf, size_t len) {
+  if (!_mem || offset > _size || len > _size - offset) return false;
+  const uint8_t* src = static_cast<const uint8_t*>(buf);
+  for (size_t i = 0; i < len; i++) _mem[offset + i] &= src[i];
+  return true;
+}
+
+bool WssRamFlash::erase_sector(uint32_t offset) {
+  if (!_mem || offset % WssFlashLog::kSectorBytes || offset >= _size) return false;
+  memset(_mem + offset, 0xFF, WssFlashLog::kSectorBytes);
+  return true;
+}
+
+WssFlashLog::~WssFlashLog() {
+  wss_large_free(_sec);
+}
+
+bool WssFlashLog::read_header(uint32_t s, uint32_t& seq, uint32_t& wear, bool& blank) {
+  SectorHeader h;
+  seq = 0;
+  wear = 0;
+  blank = false;
+  if (!_dev->read(addr(s), &h, sizeof(h))) return false;
+  blank = all_ff(reinterpret_cast<const uint8_t*>(&h), sizeof(h));
+  if (h.magic != kSectorMagic || h.crc != wss_crc32(&h, 12) || h.seq == 0) return false;
+  seq = h.seq;
+  wear = h.wear;
+  return true;
+}
+
+// Counts the records of a live sector and finds where its free space starts.
+void WssFlashLog::scan_records(uint32_t s) {
+  SectorInfo& si = _sec[s];
+  si.records = 0;
+  si.pending = 0;
+  uint16_t pos = kSectorHeaderBytes;
+  const bool check_crc = (s == _head);
+  for (;;) {
+    if ((uint32_t)pos + kRecordHeaderBytes > kSectorBytes) break;
+    RecordHeader r;
+    if (!_dev->read(addr(s) + pos, &r, sizeof(r))) {
+      pos = kSectorBytes;
+      break;
+    }
+    if (all_ff(reinterpret_cast<const uint8_t*>(&r), sizeof(r))) break; // free space
+    if (all_zero(reinterpret_cast<const uint8_t*>(&r), sizeof(r))) {
+      pos = kSectorBytes; // torn record sealed at an earlier mount
+      break;
+    }
+    bool ok = (uint16_t)~r.len == r.len_inv && r.len <= kMaxRecord &&
+              pos + record_span(r.len) <= kSectorBytes;
+    if (ok && check_crc) {
+      ok = _dev->read(addr(s) + pos + kRecordHeaderBytes, _buf, r.len) &&
+           wss_crc32(_buf, r.len) == r.crc;
+    }
+    if (!ok) {
+      // Torn write: nothing after it can be trusted or programmed.
+      static const uint8_t kSealed[kRecordHeaderBytes] = {0};
+      _torn++;
+      (void)_dev->write(addr(s) + pos, kSealed, sizeof(kSealed));
+      pos = kSectorBytes;
+      break;
+    }
+    si.records++;
+    if (r.flags == kFlagsPending) si.pending++;
+    pos += record_span(r.len);
+  }
+  si.used = pos;
+}
+
+bool WssFlashLog::begin(WssFlashDevice* dev) {
+  _dev = nullptr;
+  wss_large_free(_sec);
+  _sec = nullptr;
+  if (!dev) return false;
+  _nsectors = dev->size() / kSectorBytes;
+  if (_nsectors < 3) return false;
+  _sec = static_cast<SectorInfo*>(wss_large_alloc(_nsectors * sizeof(SectorInfo)));
+  if (!_sec) return false;
+  _dev = dev;
+  _records = 0;
+  _pending = 0;
+  _used_bytes = 0;
+  _erase_pending = -1;
+  _torn = 0;
+
+  uint32_t best_seq = 0;
+  for (uint32_t s = 0; s < _nsectors; s++) {
+    bool blank = false;
+    SectorInfo& si = _sec[s];
+    (void)read_header(s, si.seq, si.wear, blank);
+    si.records = 0;
+    si.pending = 0;
+    si.used = 0;
+    if (si.seq > best_seq) {
+      best_seq = si.seq;
+      _head = s;
+    }
+  }
+
+  if (best_seq == 0) {
+    // Blank or foreign partition.
+    _head = 0;
+    _tail = 0;
+    if (!open_sector(0, 1)) {
+      _dev = nullptr;
+      return false;
+    }
+    maintain();
+    return true;
+  }
+
+  // Live run: consecutive seqs going back from the head. Anything else is stale.
+  _tail = _head;
+  uint32_t expect = best_seq;
+  for (uint32_t s = prev(_head); s != _head; s = prev(s)) {
+    if (expect <= 1 || _sec[s].seq != expect - 1) break;
+    expect--;
+    _tail = s;
+  }
+  const uint32_t run = (_head + _nsectors - _tail) % _nsectors;
+  for (uint32_t s = 0; s < _nsectors; s++) {
+    if ((s + _nsectors - _tail) % _nsectors > run) {
+      _sec[s].seq = 0;
+      continue;
+    }
+    scan_records(s);
+    _records += _sec[s].records;
+    _pending += _sec[s].pending;
+    _used_bytes += _sec[s].used - kSectorHeaderBytes;
+  }
+
+  // Erase-ahead target for the next rollover.
+  uint32_t n = next(_head);
+  uint32_t seq = 0;
+  uint32_t wear = 0;
+  bool blank = false;
+  (void)read_header(n, seq, wear, blank);
+  if (_sec[n].seq != 0 || !blank) _erase_pending = (int32_t)n;
+  return true;
+}
+
+bool WssFlashLog::is_blank(uint32_t s) {
+  for (uint32_t off = 0; off < kSectorBytes; off += sizeof(_buf) & ~(size_t)3) {
+    size_t n = kSectorBytes - off;
+    if (n > (sizeof(_buf) & ~(size_t)3)) n = sizeof(_buf) & ~(size_t)3;
+    if (!_dev->read(addr(s) + off, _buf, n) || !all_ff(_buf, n)) return false;
+  }
+  return true;
+}
+
+void WssFlashLog::drop_sector(uint32_t s) {
+  SectorInfo& si = _sec[s];
+  if (si.seq == 0) return;
+  _records -= si.records;
+  _pending -= si.pending;
+  _used_bytes -= si.used - kSectorHeaderBytes;
+  si.seq = 0;
+  si.records = 0;
+  si.pending = 0;
+  si.used = 0;
+  if (s == _tail && s != _head) _tail = next(s);
+}
+
+bool WssFlashLog::erase(uint32_t s) {
+  drop_sector(s);
+  if (!_dev->erase_sector(addr(s))) return false;
+  _sec[s].wear++;
+  _erases++;
+  return true;
+}
+
+bool WssFlashLog::open_sector(uint32_t s, uint32_t seq) {
+  if (_erase_pending == (int32_t)s) _erase_pending = -1;
+  if (_sec[s].seq != 0 || !is_blank(s)) {
+    if (!erase(s)) return false;
+  }
+  SectorHeader h{kSectorMagic, seq, _sec[s].wear, 0};
+  h.crc = wss_crc32(&h, 12);
+  if (!_dev->write(addr(s), &h, sizeof(h))) return false;
+  _sec[s].seq = seq;
+  _sec[s].records = 0;
+  _sec[s].pending = 0;
+  _sec[s].used = kSectorHeaderBytes;
+
+  uint32_t n = next(s);
+  uint32_t nseq = 0;
+  uint32_t nwear = 0;
+  bool blank = false;
+  (void)read_header(n, nseq, nwear, blank);
+  if (_sec[n].seq != 0 || !blank) _erase_pending = (int32_t)n;
+  return true;
+}
+
+void WssFlashLog::maintain() {
+  if (!_dev || _erase_pending < 0) return;
+  uint32_t s = (uint32_t)_erase_pending;
+  _erase_pending = -1;
+  (void)erase(s);
+}
+
+bool WssFlashLog::append(const uint8_t* data, size_t len) {
+  if (!_dev) return false;
+  if (len > kMaxRecord) len = kMaxRecord;
+  const uint32_t span = record_span(len);
+  if (_sec[_head].used + span > kSectorBytes) {
+    uint32_t n = next(_head);
+    if (!open_sector(n, _sec[_head].seq + 1)) return false;
+    _head = n;
+  }
+
+  RecordHeader r{(uint16_t)len, (uint16_t)~(uint16_t)len, kFlagsPending, 0xFFFF,
+                 wss_crc32(data, len)};
+  memcpy(_buf, &r, sizeof(r));
+  memcpy(_buf + sizeof(r), data, len);
+  memset(_buf + sizeof(r) + len, 0xFF, span - sizeof(r) - len);
+  SectorInfo& si = _sec[_head];
+  if (!_dev->write(addr(_head) + si.used, _buf, span)) {
+    si.used = kSectorBytes; // don't program over a failed write
+    return false;
+  }
+  si.used += span;
+  si.records++;
+  si.pending++;
+  _records++;
+  _pending++;
+  _used_bytes += span;
+  return true;
+}
+
+// Reads the record at `pos` (payload into `out` when given). False at the end of the
+// sector's records or on a header/CRC mismatch.
+bool WssFlashLog::read_record(uint32_t s, uint16_t& pos, String* out) {
+  if (pos + kRecordHeaderBytes > _sec[s].used) return false;
+  RecordHeader r;
+  if (!_dev->read(addr(s) + pos, &r, sizeof(r))) return false;
+  if ((uint16_t)~r.len != r.len_inv || r.len > kMaxRecord) return false;
+  if (pos + record_span(r.len) > _sec[s].used) return false;
+  if (out) {
+    if (!_dev->read(addr(s) + pos + kRecordHeaderBytes, _buf, r.len)) return false;
+    if (wss_crc32(_buf, r.len) != r.crc) return false;
+    _buf[r.len] = 0;
+    *out = reinterpret_cast<const char*>(_buf);
+  }
+  pos += record_span(r.len);
+  return true;
+}
+
+size_t WssFlashLog::read_recent(String* out, size_t max_items) {
+  if (!_dev || !out || max_items == 0 || _records == 0) return 0;
+  uint32_t want = _records < max_items ? _records : (uint32_t)max_items;
+
+  // Walk back from the head until the sectors hold `want` records.
+  uint32_t s = _head;
+  uint32_t have = _sec[s].records;
+  while (have < want && s != _tail) {
+    s = prev(s);
+    have += _sec[s].records;
+  }
+  uint32_t skip = have > want ? have - want : 0;
+
+  size_t n = 0;
+  for (;; s = next(s)) {
+    uint16_t pos = kSectorHeaderBytes;
+    for (uint32_t i = 0; i < _sec[s].records && n < want; i++) {
+      String* dst = skip ? nullptr : &out[n];
+      if (!read_record(s, pos, dst)) break; // corrupt tail of a sector: skip the rest
+      if (skip) skip--;
+      else n++;
+    }
+    if (s == _head) break;
+  }
+  return n;
+}
+
+bool WssFlashLog::next_pending(WssFlashLogCursor& cur, String& out, WssFlashLogCursor& at) {
+  if (!_dev || _pending == 0) return false;
+  if (cur.seq == 0 || cur.sector >= _nsectors || _sec[cur.sector].seq != cur.seq) {
+    // Fresh start, or the sector was dropped/erased since: resume at the oldest.
+    cur.sector = _tail;
+    cur.seq = _sec[_tail].seq;
+    cur.pos = kSectorHeaderBytes;
+  }
+  for (;;) {
+    const uint32_t s = cur.sector;
+    const SectorInfo& si = _sec[s];
+    bool sector_done = (si.pending == 0 && s != _head);
+    while (!sector_done && cur.pos + kRecordHeaderBytes <= si.used) {
+      RecordHeader r;
+      if (!_dev->read(addr(s) + cur.pos, &r, sizeof(r)) || (uint16_t)~r.len != r.len_inv ||
+          r.len > kMaxRecord || cur.pos + record_span(r.len) > si.used) {
+        sector_done = true;
+        break;
+      }
+      WssFlashLogCursor here = cur;
+      cur.pos += record_span(r.len);
+      if (r.flags != kFlagsPending) continue;
+      bool ok = _dev->read(addr(s) + here.pos + kRecordHeaderBytes, _buf, r.len) &&
+                wss_crc32(_buf, r.len) == r.crc;
+      if (!ok) {
+        (void)mark_drained(here); // unreadable: never offer it again
+        continue;
+      }
+      _buf[r.len] = 0;
+      out = reinterpret_cast<const char*>(_buf);
+      at = here;
+      return true;
+    }
+    if (s == _head) return false; // caught up; new appends land after cur.pos
+    cur.sector = next(s);
+    cur.seq = _sec[cur.sector].seq;
+    cur.pos = kSectorHeaderBytes;
+  }
+}
+
+bool WssFlashLog::mark_drained(const WssFlashLogCursor& at) {
+  if (!_dev || at.sector >= _nsectors || _sec[at.sector].seq != at.seq) return false;
+  if ((uint32_t)at.pos + kRecordHeaderBytes > _sec[at.sector].used) return false;
+  // Marking twice (a retried batch) must not count the record out twice.
+  uint16_t flags = 0;
+  if (!_dev->read(addr(at.sector) + at.pos + 4, &flags, sizeof(flags))) return false;
+  if (flags != kFlagsPending) return true;
+  const uint16_t cleared = 0;
+  if (!_dev->write(addr(at.sector) + at.pos + 4, &cleared, sizeof(cleared))) return false;
+  if (_sec[at.sector].pending) _sec[at.sector].pending--;
+  if (_pending) _pending--;
+  return true;
+}
+
+void WssFlashLog::clear() {
+  if (!_dev) return;
+  uint32_t seq = _sec[_head].seq + 1;
+  for (uint32_t s = 0; s < _nsectors; s++) {
+    if (_sec[s].seq != 0) (void)erase(s);
+  }
+  uint32_t n = next(_head);
+  _head = n;
+  _tail = n;
+  (void)open_sector(n, seq);
+}
+
+WssFlashLogStats WssFlashLog::stats() const {
+  WssFlashLogStats st;
+  if (!_dev) return st;
+  st.sectors = _nsectors;
+  for (uint32_t s = 0; s < _nsectors; s++) {
+    if (_sec[s].seq != 0) st.used_sectors++;
+    if (_sec[s].wear > st.max_wear) st.max_wear = _sec[s].wear;
+  }
+  st.capacity_bytes = (_nsectors - 1) * (kSectorBytes - kSectorHeaderBytes);
+  st.used_bytes = _used_bytes;
+  st.records = _records;
+  st.pending = _pending;
+  st.erases = _erases;
+  st.torn_records = _torn;
+  return st;
+}
@@ -0,0 +1,131 @@
+// src/storage/flash_log.h
+// Role: Append-only segment log on a raw flash region (the `logring` partition) with
+// CRC'd, length-prefixed records, sequential erase-ahead and mount-time head recovery.
+#pragma once
+
+#include <Arduino.h>
+
+// Raw NOR flash region: writes only clear bits, erase sets a whole sector to 0xFF.
+class WssFlashDevice {
+ public:
+  virtual ~WssFlashDevice() = default;
+  virtual uint32_t size() const = 0;
+  virtual bool read(uint32_t offset, void* buf, size_t len) = 0;
+  virtual bool write(uint32_t offset, const void* buf, size_t len) = 0;
+  virtual bool erase_sector(uint32_t offset) = 0;
+};
+
+// WssFlashDevice in RAM with the same NOR rules (writes AND into the bytes, erase sets
+// 0xFF), for running the flash tier without the `logring` partition (host builds,
+// benchmarks). `size` is rounded down to whole sectors; starts erased.
+class WssRamFlash : public WssFlashDevice {
+ public:
+  explicit WssRamFlash(uint32_t size);
+  ~WssRamFlash() override;
+  WssRamFlash(const WssRamFlash&) = delete;
+  WssRamFlash& operator=(const WssRamFlash&) = delete;
+
+  bool ok() const { return _mem != nullptr; }
+  uint32_t size() const override { return _size; }
+  bool read(uint32_t offset, void* buf, size_t len) override;
+  bool write(uint32_t offset, const void* buf, size_t len) override;
+  bool erase_sector(uint32_t offset) override;
+
+ private:
+  uint8_t* _mem = nullptr;
+  uint32_t _size = 0;
+};
+
+// Position of one record (see WssFlashLog::next_pending). seq == 0 starts at the oldest.
+struct WssFlashLogCursor {
+  uint32_t seq = 0;    // sector seq the position belongs to (detects a dropped sector)
+  uint32_t sector = 0;
+  uint16_t pos = 0;
+};
+
+struct WssFlashLogStats {
+  uint32_t sectors = 0;
+  uint32_t used_sectors = 0;   // sectors holding records (including the head)
+  uint32_t capacity_bytes = 0; // record space excluding the erase-ahead sector
+  uint32_t used_bytes = 0;
+  uint32_t records = 0;
+  uint32_t pending = 0;        // records not yet marked drained
+  uint32_t erases = 0;         // since boot
+  uint32_t max_wear = 0;       // highest per-sector erase count seen
+  uint32_t torn_records = 0;   // partial writes found at mount (power cut)
+};
+
+// Sector layout: 16-byte header {magic, seq, wear, crc} then records
+// {len u16, ~len u16, flags u16, rsv u16, crc32 u32, payload, 0xFF pad to 4 bytes}.
+// flags 0xFFFF = pending; draining programs it to 0 in place. The sector with the
+// highest seq is the head; the sector after it is kept erased so a rollover never waits
+// for an erase (maintain() does it off the write path when possible).
+class WssFlashLog {
+ public:
+  static const uint32_t kSectorBytes = 4096;
+  static const size_t kMaxRecord = 1024;
+
+  WssFlashLog() = default;
+  ~WssFlashLog();
+  WssFlashLog(const WssFlashLog&) = delete;
+  WssFlashLog& operator=(const WssFlashLog&) = delete;
+
+  // Scans sector headers and the head sector's records. Needs at least 3 sectors.
+  bool begin(WssFlashDevice* dev);
+  bool ready() const { return _dev != nullptr; }
+
+  // Appends one record (truncated to kMaxRecord). The oldest sector is dropped when full.
+  bool append(const uint8_t* data, size_t len);
+
+  // Runs a pending erase-ahead; call from an idle path.
+  void maintain();
+
+  // Up to `max_items` newest records, oldest first.
+  size_t read_recent(String* out, size_t max_items);
+
+  // Erases every sector that holds records.
+  void clear();
+
+  // Next pending record at or after `cur` (oldest first); `at` is its position for
+  // mark_drained(). Records appended meanwhile are picked up by later calls.
+  bool next_pending(WssFlashLogCursor& cur, String& out, WssFlashLogCursor& at);
+  bool mark_drained(const WssFlashLogCursor& at);
+
+  uint32_t count() const { return _records; }
+  uint32_t pending() const { return _pending; }
+  WssFlashLogStats stats() const;
+
+ private:
+  struct SectorInfo {
+    uint32_t seq;     // 0 = erased / invalid
+    uint32_t wear;
+    uint16_t records;
+    uint16_t pending;
+    uint16_t used;    // bytes used including the header (kSectorBytes = sealed)
+    uint16_t rsv;
+  };
+
+  uint32_t next(uint32_t s) const { return (s + 1) % _nsectors; }
+  uint32_t prev(uint32_t s) const { return (s + _nsectors - 1) % _nsectors; }
+  uint32_t addr(uint32_t s) const { return s * kSectorBytes; }
+  bool read_header(uint32_t s, uint32_t& seq, uint32_t& wear, bool& blank);
+  void scan_records(uint32_t s);
+  bool erase(uint32_t s);
+  bool is_blank(uint32_t s);
+  bool open_sector(uint32_t s, uint32_t seq);
+  void drop_sector(uint32_t s);
+  bool read_record(uint32_t s, uint16_t& pos, String* out);
+
+  WssFlashDevice* _dev = nullptr;
+  SectorInfo* _sec = nullptr;
+  uint32_t _nsectors = 0;
+  uint32_t _head = 0;
+  uint32_t _tail = 0;        // oldest sector with records (== _head when only one)
+  uint32_t _records = 0;
+  uint32_t _pending = 0;
+  uint32_t _used_bytes = 0;
+  int32_t _erase_pending = -1;
+  uint32_t _erases = 0;
+  uint32_t _torn = 0;
+  uint8_t _buf[12 + kMaxRecord + 4];
+};
@@ -1,20 +1,57 @@
 // src/storage/flash_ring.cpp
-// Role: Small persistent log fallback ring buffer stored in NVS (Preferences).
+// Role: Persistent log fallback ring (raw `logring` partition, NVS ring as legacy).
 
 #include "flash_ring.h"
 
 #include <Preferences.h>
+#include <esp_partition.h>
 
 static const char* kPrefsNamespace = "wss_log";
 static const char* kKeyHead = "head";
 static const char* kKeyCount = "count";
+static const char* kPartitionLabel = "logring";
 static Preferences g_prefs;
 
+// WssFlashDevice over an esp_partition_t (offsets are partition-relative).
+class WssPartitionFlash : public WssFlashDevice {
+ public:
+  explicit WssPartitionFlash(const esp_partition_t* p) : _p(p) {}
+  uint32_t size() const override { return _p->size; }
+  bool read(uint32_t offset, void* buf, size_t len) override {
+    return esp_partition_read(_p, offset, buf, len) == ESP_OK;
+  }
+  bool write(uint32_t offset, const void* buf, size_t len) override {
+    return esp_partition_write(_p, offset, buf, len) == ESP_OK;
+  }
+  bool erase_sector(uint32_t offset) override {
+    return esp_partition_erase_range(_p, offset, WssFlashLog::kSectorBytes) == ESP_OK;
+  }
+
+ private:
+  const esp_partition_t* _p;
+};
+
+static WssPartitionFlash* g_part_dev = nullptr;
+
 String WssFlashRing::key_for(uint32_t idx) const {
   return String("e") + String(idx);
 }
 
 bool WssFlashRing::begin() {
+  const esp_partition_t* p =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, kPartitionLabel);
+  if (p) {
+    if (!g_part_dev) g_part_dev = new WssPartitionFlash(p);
+    if (_log.begin(g_part_dev)) {
+      _partition = true;
+      _dev_name = "partition";
+      _ok = true;
+      return true;
+    }
+    Serial.println("[storage] WARN: logring partition unusable; using NVS fallback ring");
+  }
+
+  _partition = false;
   if (!g_prefs.begin(kPrefsNamespace, false)) {
     _ok = false;
     return false;
@@ -24,6 +61,13 @@ bool WssFlashRing::begin() {
   return true;
 }
 
+bool WssFlashRing::begin(WssFlashDevice* dev, const char* name) {
+  _partition = dev && _log.begin(dev);
+  _ok = _partition;
+  if (_ok) _dev_name = name;
+  return _ok;
+}
+
 void WssFlashRing::load_meta() {
   if (!_ok) return;
   _head = g_prefs.getUInt(kKeyHead, 0);
@@ -38,8 +82,56 @@ void WssFlashRing::save_meta() {
   g_prefs.putUInt(kKeyCount, _count);
 }
 
+uint32_t WssFlashRing::count() const {
+  return _partition ? _log.count() : _count;
+}
+
+const char* WssFlashRing::backend() const {
+  if (!_ok) return "";
+  return _partition ? _dev_name : "nvs";
+}
+
+void WssFlashRing::maintain() {
+  if (_partition) _log.maintain();
+}
+
+uint32_t WssFlashRing::pending() const {
+  if (!_ok) return 0;
+  return _partition ? _log.pending() : _count - _nvs_drained;
+}
+
+bool WssFlashRing::next_pending(WssFlashLogCursor& cur, String& out, WssFlashLogCursor& at) {
+  if (!_ok) return false;
+  if (_partition) return _log.next_pending(cur, out, at);
+  // NVS: cur.pos counts entries from the oldest.
+  if (cur.pos < _nvs_drained) cur.pos = (uint16_t)_nvs_drained;
+  if (cur.pos >= _count) return false;
+  uint32_t oldest = (_head + kSlots - _count) % kSlots;
+  out = g_prefs.getString(key_for((oldest + cur.pos) % kSlots).c_str(), "");
+  at = cur;
+  cur.pos++;
+  return true;
+}
+
+void WssFlashRing::mark_drained(const WssFlashLogCursor& at) {
+  if (!_ok) return;
+  if (_partition) {
+    (void)_log.mark_drained(at);
+    return;
+  }
+  _nvs_drained = at.pos + 1U;
+  if (_nvs_drained >= _count) {
+    clear();
+    _nvs_drained = 0;
+  }
+}
+
 void WssFlashRing::clear() {
   if (!_ok) return;
+  if (_partition) {
+    _log.clear();
+    return;
+  }
   for (uint32_t i = 0; i < kSlots; ++i) {
     g_prefs.remove(key_for(i).c_str());
   }
@@ -50,6 +142,9 @@ void WssFlashRing::clear() {
 
 bool WssFlashRing::append(const String& line) {
   if (!_ok) return false;
+  if (_partition) {
+    return _log.append(reinterpret_cast<const uint8_t*>(line.c_str()), line.length());
+  }
   String trimmed = line;
   if (trimmed.length() > kMaxLine) {
     trimmed.remove(kMaxLine);
@@ -65,6 +160,7 @@ bool WssFlashRing::append(const String& line) {
 
 size_t WssFlashRing::read_recent(String* out, size_t max_items) {
   if (!_ok || !out || max_items == 0) return 0;
+  if (_partition) return _log.read_recent(out, max_items);
   uint32_t n = _count;
   if (n > max_items) n = max_items;
 
@@ -1,12 +1,19 @@
 // src/storage/flash_ring.h
-// Role: Small persistent log fallback ring buffer stored in NVS (Preferences).
+// Role: Persistent log fallback ring used while SD is unavailable. Backed by the raw
+// `logring` flash partition (WssFlashLog); firmware running on an older partition table
+// without it keeps the small NVS (Preferences) ring.
 #pragma once
 
 #include <Arduino.h>
 
+#include "flash_log.h"
+
 class WssFlashRing {
 public:
   bool begin();
+  // Runs the ring on another device (e.g. a WssRamFlash) instead of the partition; no NVS
+  // fallback. `name` is what backend() reports.
+  bool begin(WssFlashDevice* dev, const char* name);
   void clear();
 
   // Append a line to the ring. Lines are truncated to a safe max.
@@ -15,15 +22,33 @@ public:
   // Export up to `max_items` most-recent entries, newest-last.
   size_t read_recent(String* out, size_t max_items);
 
-  uint32_t count() const { return _count; }
+  // Idle-time housekeeping (erase-ahead of the next partition sector).
+  void maintain();
+
+  // Backfill: lines not yet copied to SD, oldest first (see WssFlashLog::next_pending).
+  // The legacy NVS ring has no per-entry flags: it is emptied once every entry has been
+  // marked, so callers should drain it in one go.
+  bool next_pending(WssFlashLogCursor& cur, String& out, WssFlashLogCursor& at);
+  void mark_drained(const WssFlashLogCursor& at);
+  uint32_t pending() const;
+
+  uint32_t count() const;
+
+  // "partition" | "nvs" | the begin(dev, name) name | "" (not started)
+  const char* backend() const;
+  WssFlashLogStats stats() const { return _log.stats(); }
 
 private:
   static const uint32_t kSlots = 40;
   static const uint32_t kMaxLine = 240;
 
   bool _ok = false;
+  bool _partition = false;   // segment log (partition or begin(dev)) rather than NVS
+  const char* _dev_name = "partition";
   uint32_t _head = 0;
   uint32_t _count = 0;
+  uint32_t _nvs_drained = 0;
+  WssFlashLog _log;
 
   void load_meta();
   void save_meta();
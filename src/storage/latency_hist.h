@@ -0,0 +1,33 @@
+// src/storage/latency_hist.h
+// Role: Fixed-bucket latency histogram for storage operations (reported in /api/status).
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Buckets grow by about 4x from 250 us: <250us, <1ms, <4ms, <16ms, <64ms, <256ms, <1s, >=1s.
+// A healthy card keeps appends in the first two; a worn or throttling one spreads right.
+struct WssLatencyHist {
+  static const size_t kBuckets = 8;
+
+  uint32_t count = 0;
+  uint32_t max_us = 0;
+  uint64_t total_us = 0;
+  uint32_t buckets[kBuckets] = {0};
+
+  // Upper bound of bucket i in microseconds (the last bucket has none).
+  static uint32_t bound_us(size_t i) {
+    static const uint32_t kBounds[kBuckets - 1] = {250,   1000,   4000,   16000,
+                                                   64000, 256000, 1000000};
+    return kBounds[i];
+  }
+
+  void add(uint32_t us) {
+    size_t i = 0;
+    while (i + 1 < kBuckets && us >= bound_us(i)) i++;
+    buckets[i]++;
+    count++;
+    total_us += us;
+    if (us > max_us) max_us = us;
+  }
+};
@@ -0,0 +1,328 @@
+// src/storage/log_archive.cpp
+// Role: Monthly gzip archives of closed day files and their index (/logs/archives.bin).
+//
+// Index layout: 16-byte header {magic, version, record size, count} followed by `count`
+// WssLogArchiveMonth records sorted by month. The current month's record is rewritten in
+// place after each archived day; other changes rewrite the (small) file through
+// /logs/archives.tmp. An archive file may run past its record's gz_bytes only by a member
+// torn by a power cut, which the next compaction of that month cuts off.
+
+#include "log_archive.h"
+
+#include <new>
+#include <string.h>
+
+#include "../gzip_stream.h"
+#include "../logging/sha256_hex.h"
+#include "log_record_codec.h"
+
+static const char* kArchiveIndexPath = "/logs/archives.bin";
+static const char* kArchiveIndexTmpPath = "/logs/archives.tmp";
+static const uint32_t kArchiveMagic = 0x52414C57; // "WLAR"
+static const uint16_t kArchiveVersion = 1;
+static const uint32_t kHeaderBytes = 16;
+static const uint32_t kRecordBytes = sizeof(WssLogArchiveMonth);
+
+static_assert(sizeof(WssLogArchiveMonth) == 64, "archive record layout changed");
+
+struct ArchiveHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_bytes;
+  uint32_t count;
+  uint32_t reserved;
+};
+
+static uint32_t record_pos(uint32_t i) {
+  return kHeaderBytes + i * kRecordBytes;
+}
+
+static bool read_record(WssStorageFile& f, uint32_t i, WssLogArchiveMonth& out) {
+  return f.seek(record_pos(i)) && f.read(&out, kRecordBytes) == (int)kRecordBytes;
+}
+
+static bool write_archive_header(WssStorageFile& f, uint32_t count) {
+  ArchiveHeader h{kArchiveMagic, kArchiveVersion, (uint16_t)kRecordBytes, count, 0};
+  return f.seek(0) && f.write(&h, sizeof(h)) == sizeof(h);
+}
+
+// Gzip output straight into the archive file; remembers a short write.
+class WssLogArchive::FileSink : public Print {
+ public:
+  explicit FileSink(WssStorageFile* f) : _f(f) {}
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* data, size_t len) override {
+    size_t wrote = _f->write(data, len);
+    if (wrote != len) _failed = true;
+    return wrote;
+  }
+  bool failed() const { return _failed; }
+
+ private:
+  WssStorageFile* _f;
+  bool _failed = false;
+};
+
+WssLogArchive::~WssLogArchive() {
+  close_compaction();
+}
+
+String WssLogArchive::path_for(uint32_t month) {
+  char buf[56];
+  unsigned long y = month / 100;
+  unsigned long m = month % 100;
+  snprintf(buf, sizeof(buf), "/logs/%04lu/%02lu/archive_%04lu-%02lu.jsonl.gz", y, m, y, m);
+  return String(buf);
+}
+
+bool WssLogArchive::begin(WssStorageBackend* fs) {
+  end();
+  _fs = fs;
+  return _fs && load();
+}
+
+void WssLogArchive::end() {
+  close_compaction();
+  _fs = nullptr;
+  _count = 0;
+  _total_bytes = 0;
+}
+
+bool WssLogArchive::load() {
+  _count = 0;
+  _total_bytes = 0;
+  WssStorageFile f = _fs->open(kArchiveIndexPath, WSS_FS_READ);
+  if (!f) return true; // no archives yet
+  ArchiveHeader h;
+  bool ok = f.read(&h, sizeof(h)) == sizeof(h) && h.magic == kArchiveMagic &&
+            h.version == kArchiveVersion && h.record_bytes == kRecordBytes &&
+            f.size() >= (uint64_t)record_pos(h.count);
+  WssLogArchiveMonth m;
+  for (uint32_t i = 0; ok && i < h.count; i++) {
+    ok = read_record(f, i, m);
+    _total_bytes += m.gz_bytes;
+  }
+  f.close();
+  if (ok) _count = h.count;
+  else _total_bytes = 0;
+  return ok;
+}
+
+bool WssLogArchive::oldest(WssLogArchiveMonth& out) {
+  if (!_fs || _count == 0) return false;
+  WssStorageFile f = _fs->open(kArchiveIndexPath, WSS_FS_READ);
+  if (!f) return false;
+  bool ok = read_record(f, 0, out);
+  f.close();
+  return ok;
+}
+
+bool WssLogArchive::find(uint32_t month, WssLogArchiveMonth& out) {
+  if (!_fs || _count == 0) return false;
+  WssStorageFile f = _fs->open(kArchiveIndexPath, WSS_FS_READ);
+  if (!f) return false;
+  bool found = false;
+  WssLogArchiveMonth m;
+  // Newest first: compaction almost always extends the last month.
+  for (uint32_t i = _count; i-- > 0;) {
+    if (!read_record(f, i, m) || m.month < month) break;
+    if (m.month == month) {
+      out = m;
+      found = true;
+      break;
+    }
+  }
+  f.close();
+  return found;
+}
+
+// Copies records [skip_first, _count) to the tmp index, merging `insert` in month order
+// (replacing a record of the same month), then swaps it in.
+bool WssLogArchive::rewrite(uint32_t skip_first, const WssLogArchiveMonth* insert) {
+  WssStorageFile in = _fs->open(kArchiveIndexPath, WSS_FS_READ);
+  (void)_fs->remove(kArchiveIndexTmpPath);
+  WssStorageFile out = _fs->open(kArchiveIndexTmpPath, WSS_FS_RDWR | WSS_FS_CREATE | WSS_FS_TRUNC);
+  if (!out) {
+    if (in) in.close();
+    return false;
+  }
+  bool ok = write_archive_header(out, 0);
+  uint32_t n = 0;
+  uint64_t total = 0;
+  bool inserted = (insert == nullptr);
+  for (uint32_t i = skip_first; ok && in && i < _count; i++) {
+    WssLogArchiveMonth m;
+    if (!read_record(in, i, m)) {
+      ok = false;
+      break;
+    }
+    if (!inserted && insert->month <= m.month) {
+      ok = out.write(insert, kRecordBytes) == kRecordBytes;
+      n++;
+      total += insert->gz_bytes;
+      inserted = true;
+      if (insert->month == m.month) continue;
+    }
+    ok = ok && out.write(&m, kRecordBytes) == kRecordBytes;
+    n++;
+    total += m.gz_bytes;
+  }
+  if (ok && !inserted) {
+    ok = out.write(insert, kRecordBytes) == kRecordBytes;
+    n++;
+    total += insert->gz_bytes;
+  }
+  if (in) in.close();
+  ok = ok && write_archive_header(out, n) && out.sync();
+  out.close();
+  if (!ok) {
+    (void)_fs->remove(kArchiveIndexTmpPath);
+    return false;
+  }
+  (void)_fs->remove(kArchiveIndexPath);
+  if (!_fs->rename(kArchiveIndexTmpPath, kArchiveIndexPath)) return false;
+  _count = n;
+  _total_bytes = total;
+  return true;
+}
+
+bool WssLogArchive::put(const WssLogArchiveMonth& m) {
+  WssStorageFile f = _fs->open(kArchiveIndexPath, WSS_FS_RDWR);
+  if (!f) return rewrite(0, &m);
+  WssLogArchiveMonth last;
+  bool ok = false;
+  if (_count > 0 && read_record(f, _count - 1, last) && last.month == m.month) {
+    ok = f.seek(record_pos(_count - 1)) && f.write(&m, kRecordBytes) == kRecordBytes;
+    if (ok) _total_bytes = _total_bytes - last.gz_bytes + m.gz_bytes;
+  } else if (_count == 0 || last.month < m.month) {
+    ok = f.seek(record_pos(_count)) && f.write(&m, kRecordBytes) == kRecordBytes &&
+         write_archive_header(f, _count + 1);
+    if (ok) {
+      _count++;
+      _total_bytes += m.gz_bytes;
+    }
+  } else {
+    // An older month (day files left behind by a clock step): rare, so rewrite.
+    f.close();
+    return rewrite(0, &m);
+  }
+  ok = ok && f.sync();
+  f.close();
+  return ok;
+}
+
+bool WssLogArchive::drop_oldest() {
+  WssLogArchiveMonth m;
+  if (!oldest(m)) return false;
+  (void)_fs->remove(path_for(m.month).c_str()); // already gone after a crash: fine
+  return rewrite(1, nullptr);
+}
+
+bool WssLogArchive::compact_begin(const WssLogIndexEntry& day, bool& already) {
+  already = false;
+  if (!_fs || _gz) return false;
+  const uint32_t month = day.date / 100;
+  _month = WssLogArchiveMonth();
+  _month.month = month;
+  (void)find(month, _month);
+  if (_month.days > 0 && day.date <= _month.last_date) {
+    already = true;
+    return true;
+  }
+
+  _src = _fs->open(WssLogIndex::path_for(day.date).c_str(), WSS_FS_READ);
+  if (!_src) return false;
+  _dst = _fs->open(path_for(month).c_str(), WSS_FS_RDWR | WSS_FS_CREATE);
+  bool ok = (bool)_dst;
+  // Only committed members count; cut off one torn by a power cut.
+  if (ok && _dst.size() != _month.gz_bytes) ok = _dst.truncate(_month.gz_bytes);
+  ok = ok && _dst.seek(_month.gz_bytes);
+  if (ok) {
+    _gz = new (std::nothrow) WssGzipStream();
+    _sink = new (std::nothrow) FileSink(&_dst);
+    ok = _gz && _sink && _gz->begin(*_sink);
+  }
+  uint8_t first = 0;
+  if (ok && _src.read(&first, 1) == 1 && first == kWssLogRecordMarker) {
+    _export = new (std::nothrow) WssLogJsonlExport();
+    ok = _export && _export->begin(*_gz);
+  }
+  ok = ok && _src.seek(0);
+  if (!ok) {
+    close_compaction();
+    return false;
+  }
+  _day = day;
+  _src_pos = 0;
+  return true;
+}
+
+bool WssLogArchive::compact_step(size_t budget, bool& done) {
+  done = false;
+  if (!_gz) return false;
+  // The index size is the logical EOF; a file closed by a power cut may still carry its
+  // zero-filled preallocated tail.
+  uint32_t end = (uint32_t)_src.size();
+  if (_day.size_bytes && _day.size_bytes < end) end = _day.size_bytes;
+  Print* out = _export ? static_cast<Print*>(_export) : static_cast<Print*>(_gz);
+  uint8_t buf[512];
+  while (budget > 0 && _src_pos < end) {
+    size_t n = sizeof(buf);
+    if (n > budget) n = budget;
+    if (n > end - _src_pos) n = end - _src_pos;
+    int32_t got = _src.read(buf, n);
+    if (got <= 0) return false;
+    if (out->write(buf, (size_t)got) != (size_t)got) return false;
+    _src_pos += (uint32_t)got;
+    budget -= (size_t)got;
+  }
+  done = _src_pos >= end;
+  return !_sink->failed();
+}
+
+bool WssLogArchive::compact_commit() {
+  if (!_gz) return false;
+  bool ok = (!_export || _export->finish()) && _gz->finish() && !_sink->failed() &&
+            _dst.sync();
+  if (ok) {
+    WssLogArchiveMonth m = _month;
+    if (m.days == 0) m.first_date = _day.date;
+    if (!m.first_seq) m.first_seq = _day.first_seq;
+    m.days++;
+    m.last_date = _day.date;
+    if (_day.last_seq > m.last_seq) m.last_seq = _day.last_seq;
+    m.raw_bytes += _export ? (uint32_t)_export->bytes_out() : _src_pos;
+    m.gz_bytes = (uint32_t)_dst.position();
+
+    uint8_t date_le[4] = {(uint8_t)_day.date, (uint8_t)(_day.date >> 8),
+                          (uint8_t)(_day.date >> 16), (uint8_t)(_day.date >> 24)};
+    WssSha256 sha;
+    sha.update(m.digest, sizeof(m.digest));
+    sha.update(date_le, sizeof(date_le));
+    sha.update(_day.chain_head, sizeof(_day.chain_head));
+    sha.finish(m.digest);
+    ok = put(m);
+  }
+  if (!ok) {
+    compact_abort();
+    return false;
+  }
+  close_compaction();
+  return true;
+}
+
+void WssLogArchive::compact_abort() {
+  if (_dst) (void)_dst.truncate(_month.gz_bytes);
+  close_compaction();
+}
+
+void WssLogArchive::close_compaction() {
+  delete _export;
+  _export = nullptr;
+  delete _gz;
+  _gz = nullptr;
+  delete _sink;
+  _sink = nullptr;
+  if (_src) _src.close();
+  if (_dst) _dst.close();
+}
@@ -0,0 +1,86 @@
+// src/storage/log_archive.h
+// Role: Monthly compressed archives of closed day files (/logs/YYYY/MM/archive_YYYY-MM.jsonl.gz)
+// and their on-card index (/logs/archives.bin), filled one day at a time in small slices.
+#pragma once
+
+#include <Arduino.h>
+
+#include "storage_backend.h"
+
+#include "log_index.h"
+
+class WssGzipStream;
+class WssLogJsonlExport;
+
+// One record per archived month, sorted by month. 64 bytes on card.
+struct WssLogArchiveMonth {
+  uint32_t month = 0;       // YYYYMM
+  uint32_t days = 0;        // day files compacted into the archive
+  uint32_t first_date = 0;  // YYYYMMDD
+  uint32_t last_date = 0;
+  uint32_t first_seq = 0;
+  uint32_t last_seq = 0;
+  uint32_t raw_bytes = 0;   // JSONL bytes before compression
+  uint32_t gz_bytes = 0;    // committed length of the archive file
+  uint8_t digest[32] = {0}; // SHA256 fold of (date, chain head) over the archived days
+};
+
+// The archive is a multi-member gzip file (one member per day, in date order), so `zcat`
+// yields the original JSONL byte for byte and every line still verifies against its hash.
+// Day files kept as binary records (`log_format=binary`) are archived as their JSONL text.
+// `digest` = SHA256(digest || date (LE32) || chain head) per day keeps the day chain heads
+// checkable after the day files are gone.
+class WssLogArchive {
+ public:
+  WssLogArchive() = default;
+  ~WssLogArchive();
+  WssLogArchive(const WssLogArchive&) = delete;
+  WssLogArchive& operator=(const WssLogArchive&) = delete;
+
+  bool begin(WssStorageBackend* fs);
+  void end();
+
+  uint32_t count() const { return _count; }
+  uint64_t total_bytes() const { return _total_bytes; }
+
+  bool oldest(WssLogArchiveMonth& out);
+  bool find(uint32_t month, WssLogArchiveMonth& out);
+  // Deletes the oldest month's archive file, then its record.
+  bool drop_oldest();
+
+  // Compaction of one closed day file into its month archive. begin() sets `already` when
+  // the month record already covers the day (a crash after commit): the caller only
+  // deletes the day file then.
+  bool compact_begin(const WssLogIndexEntry& day, bool& already);
+  // Compresses up to `budget` more bytes of the day file; `done` once all of it is in.
+  bool compact_step(size_t budget, bool& done);
+  // Finishes the gzip member, syncs, and updates the month record.
+  bool compact_commit();
+  // Cuts a partial member off the archive (also done by the next compact_begin()).
+  void compact_abort();
+  bool compacting() const { return _gz != nullptr; }
+
+  static String path_for(uint32_t month);
+
+ private:
+  class FileSink;
+
+  bool load();
+  bool put(const WssLogArchiveMonth& m);
+  bool rewrite(uint32_t skip_first, const WssLogArchiveMonth* insert);
+  void close_compaction();
+
+  WssStorageBackend* _fs = nullptr;
+  uint32_t _count = 0;
+  uint64_t _total_bytes = 0;
+
+  // Compaction in progress
+  WssGzipStream* _gz = nullptr;
+  FileSink* _sink = nullptr;
+  WssLogJsonlExport* _export = nullptr; // binary day file: decodes records into _gz
+  WssStorageFile _src;
+  WssStorageFile _dst;
+  WssLogIndexEntry _day;
+  WssLogArchiveMonth _month;
+  uint32_t _src_pos = 0;
+};
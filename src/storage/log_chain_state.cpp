@@ -0,0 +1,157 @@
+// src/storage/log_chain_state.cpp
+// Role: Chain-state record for O(1) hash-chain recovery on SD mount.
+//
+// The record is 64 bytes at offset 0 of /logs/chain.bin, overwritten in place after the
+// day file's data has been flushed, so it never points past data on the card. A power cut
+// during the rewrite leaves a CRC mismatch and the caller falls back to the index/tail scan.
+
+#include "log_chain_state.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../crc32.h"
+#include "../logging/sha256_hex.h"
+#include "log_record_codec.h"
+
+static const char* kChainStatePath = "/logs/chain.bin";
+static const uint32_t kChainStateMagic = 0x53484357; // "WCHS"
+static const uint16_t kChainStateVersion = 1;
+static const size_t kScanHeadKeep = 144; // `"seq"` follows `"ts"`; a record head is <= 141
+static const size_t kScanTailKeep = 160; // `,"prev_hash":"..","hash":".."}` is 154
+
+struct ChainStateDisk {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t date;
+  uint32_t seq;
+  uint64_t offset;
+  uint8_t head[32];
+  uint32_t reserved2;
+  uint32_t crc; // CRC-32 of the preceding bytes
+};
+
+static_assert(sizeof(ChainStateDisk) == 64, "chain state layout changed");
+
+bool WssLogChainState::begin(WssStorageBackend* fs) {
+  end();
+  if (!fs) return false;
+  if (!fs->exists("/logs") && !fs->mkdir("/logs")) return false;
+  _f = fs->open(kChainStatePath, WSS_FS_RDWR | WSS_FS_CREATE);
+  return (bool)_f;
+}
+
+void WssLogChainState::end() {
+  if (_f) _f.close();
+  _have_last = false;
+}
+
+bool WssLogChainState::load(WssLogChainStateRecord& out) {
+  ChainStateDisk d;
+  if (!_f || !_f.seek(0) || _f.read(&d, sizeof(d)) != (int)sizeof(d)) return false;
+  if (d.magic != kChainStateMagic || d.version != kChainStateVersion) return false;
+  if (wss_crc32(&d, offsetof(ChainStateDisk, crc)) != d.crc) return false;
+  out.date = d.date;
+  out.seq = d.seq;
+  out.offset = d.offset;
+  memcpy(out.head, d.head, sizeof(out.head));
+  _last = out;
+  _have_last = true;
+  return true;
+}
+
+bool WssLogChainState::store(const WssLogChainStateRecord& r) {
+  if (!_f) return false;
+  if (_have_last && _last.date == r.date && _last.offset == r.offset && _last.seq == r.seq &&
+      memcmp(_last.head, r.head, sizeof(r.head)) == 0) {
+    return true;
+  }
+  ChainStateDisk d;
+  memset(&d, 0, sizeof(d));
+  d.magic = kChainStateMagic;
+  d.version = kChainStateVersion;
+  d.date = r.date;
+  d.seq = r.seq;
+  d.offset = r.offset;
+  memcpy(d.head, r.head, sizeof(d.head));
+  d.crc = wss_crc32(&d, offsetof(ChainStateDisk, crc));
+  bool ok = _f.seek(0) && _f.write(&d, sizeof(d)) == sizeof(d) && _f.sync();
+  _have_last = ok;
+  if (ok) {
+    _last = r;
+    _writes++;
+  }
+  return ok;
+}
+
+// Last `"hash":"<64 hex>"` in a line (the chain suffix is at its end).
+static bool parse_tail_hash(const char* s, size_t len, uint8_t out[32]) {
+  static const char kKey[] = "\"hash\":\"";
+  const size_t key_len = sizeof(kKey) - 1;
+  if (len < key_len + 64) return false;
+  for (size_t i = len - key_len - 64 + 1; i-- > 0;) {
+    if (memcmp(s + i, kKey, key_len) != 0) continue;
+    char hex[65];
+    memcpy(hex, s + i + key_len, 64);
+    hex[64] = 0;
+    return wss_hex_parse(hex, out, 32);
+  }
+  return false;
+}
+
+bool WssLogChainState::scan_forward(WssStorageFile& f, uint64_t from, uint64_t to,
+                                    uint32_t& last_seq, uint8_t head[32]) {
+  if (from >= to) return true;
+  if (!f.seek(from)) return false;
+  char first[kScanHeadKeep + 1];
+  char tail[kScanTailKeep]; // ring of the line's last bytes
+  char line_tail[kScanTailKeep];
+  size_t first_len = 0;
+  size_t tail_total = 0;
+  uint8_t buf[256];
+  uint64_t pos = from;
+  while (pos < to) {
+    size_t want = sizeof(buf);
+    if ((uint64_t)want > to - pos) want = (size_t)(to - pos);
+    int32_t got = f.read(buf, want);
+    if (got <= 0) return false;
+    pos += (uint64_t)got;
+    for (int32_t i = 0; i < got; i++) {
+      const char c = (char)buf[i];
+      if (c == 0) continue; // zero-filled preallocated tail
+      if (c != '\n') {
+        if (first_len < kScanHeadKeep) first[first_len++] = c;
+        tail[tail_total % kScanTailKeep] = c;
+        tail_total++;
+        continue;
+      }
+      if (wss_log_record_is_binary(first, first_len)) {
+        uint32_t seq = 0;
+        bool has_hash = false;
+        uint8_t h[32];
+        if (wss_log_record_peek(first, first_len, &seq, &has_hash, h)) {
+          if (seq > last_seq) last_seq = seq;
+          if (has_hash) memcpy(head, h, 32);
+        }
+      } else if (first_len > 0) {
+        first[first_len] = 0;
+        const char* p = strstr(first, "\"seq\":");
+        if (p) {
+          uint32_t seq = (uint32_t)strtoul(p + 6, nullptr, 10);
+          if (seq > last_seq) last_seq = seq;
+        }
+        size_t n = tail_total < kScanTailKeep ? tail_total : kScanTailKeep;
+        for (size_t k = 0; k < n; k++) {
+          line_tail[k] = tail[(tail_total - n + k) % kScanTailKeep];
+        }
+        uint8_t h[32];
+        if (parse_tail_hash(line_tail, n, h)) memcpy(head, h, 32);
+      }
+      first_len = 0;
+      tail_total = 0;
+    }
+  }
+  return true;
+}
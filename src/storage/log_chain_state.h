@@ -0,0 +1,42 @@
+// src/storage/log_chain_state.h
+// Role: Fixed-layout chain-state record (/logs/chain.bin) rewritten on every SD flush, so a
+// remount resumes the M3 hash chain with one 64-byte read instead of re-parsing the file tail.
+#pragma once
+
+#include <Arduino.h>
+
+#include "storage_backend.h"
+
+// State of the active day file as of the last flush.
+struct WssLogChainStateRecord {
+  uint32_t date = 0;     // YYYYMMDD of the day file
+  uint32_t seq = 0;      // highest seq written to it
+  uint64_t offset = 0;   // logical EOF (end of the last flushed line)
+  uint8_t head[32] = {0}; // hash of that line (zeros = none / chaining off)
+};
+
+class WssLogChainState {
+ public:
+  // Opens (or creates) the record file on a mounted volume.
+  bool begin(WssStorageBackend* fs);
+  void end();
+
+  // False when the record is missing, torn or from another layout version.
+  bool load(WssLogChainStateRecord& out);
+  // Rewrites the record in place (skipped when nothing changed since the last store).
+  bool store(const WssLogChainStateRecord& r);
+
+  uint32_t writes() const { return _writes; }
+
+  // Folds the complete lines in [from, to) of a day file into last_seq/head. Only the
+  // first and last bytes of each line are kept, so line length is not limited; a torn
+  // trailing line (no newline) is ignored.
+  static bool scan_forward(WssStorageFile& f, uint64_t from, uint64_t to, uint32_t& last_seq,
+                           uint8_t head[32]);
+
+ private:
+  WssStorageFile _f;
+  WssLogChainStateRecord _last;
+  bool _have_last = false;
+  uint32_t _writes = 0;
+};
@@ -0,0 +1,278 @@
+// src/storage/log_checkpoint.cpp
+// Role: Merkle checkpoints over the M3 line hash chain and the streaming chain verifier.
+//
+// A chained line is the canonical JSON object with `,"prev_hash":"<64>","hash":"<64>"}`
+// in place of its closing brace (both the fast and the parse/re-serialize writer paths
+// produce that layout), and hash = SHA256(canonical + prev_hash). The verifier therefore
+// re-hashes each line straight from the bytes read, without parsing JSON. In checkpoint
+// mode a first pass over a segment costs one Merkle node per line instead; only segments
+// that fail it are read again and re-hashed.
+
+#include "log_checkpoint.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../logging/sha256_hex.h"
+
+static const char kPrevKey[] = ",\"prev_hash\":\"";
+static const char kHashKey[] = "\",\"hash\":\"";
+static const size_t kPrevKeyLen = sizeof(kPrevKey) - 1;
+static const size_t kHashKeyLen = sizeof(kHashKey) - 1;
+static const size_t kChainSuffixLen = kPrevKeyLen + 64 + kHashKeyLen + 64 + 2; // + "}
+
+static void merkle_node(const uint8_t left[32], const uint8_t right[32], uint8_t out[32]) {
+  WssSha256 sha;
+  sha.update(left, 32);
+  sha.update(right, 32);
+  sha.finish(out);
+}
+
+void WssMerkle::reset() {
+  _depth = 0;
+  _count = 0;
+}
+
+void WssMerkle::add(const uint8_t leaf[32]) {
+  if (_depth == kMaxLevels) return; // 2^32 leaves; unreachable with uint32 counts
+  memcpy(_node[_depth], leaf, 32);
+  _level[_depth] = 0;
+  _depth++;
+  _count++;
+  // Merge equal-height subtrees (binary counter carry).
+  while (_depth >= 2 && _level[_depth - 1] == _level[_depth - 2]) {
+    merkle_node(_node[_depth - 2], _node[_depth - 1], _node[_depth - 2]);
+    _level[_depth - 2]++;
+    _depth--;
+  }
+}
+
+void WssMerkle::root(uint8_t out[32]) const {
+  if (_depth == 0) {
+    memset(out, 0, 32);
+    return;
+  }
+  uint8_t acc[32];
+  memcpy(acc, _node[_depth - 1], 32);
+  for (int i = (int)_depth - 2; i >= 0; i--) merkle_node(_node[i], acc, acc);
+  memcpy(out, acc, 32);
+}
+
+static bool event_type_is(const char* line, const char* type) {
+  const char* p = strstr(line, "\"event_type\":\"");
+  if (!p) return false;
+  p += 14;
+  size_t n = strlen(type);
+  return strncmp(p, type, n) == 0 && p[n] == '"';
+}
+
+WssLogMetaKind wss_log_meta_kind(const char* line) {
+  if (!line || !strstr(line, "\"source\":\"log\"")) return WSS_LOG_META_NONE;
+  if (event_type_is(line, "file_header")) return WSS_LOG_META_FILE_HEADER;
+  if (event_type_is(line, "log_checkpoint")) return WSS_LOG_META_CHECKPOINT;
+  if (event_type_is(line, "day_close")) return WSS_LOG_META_DAY_CLOSE;
+  if (event_type_is(line, "log_resume")) return WSS_LOG_META_RESUME;
+  return WSS_LOG_META_NONE;
+}
+
+bool wss_log_strip_chain(String& line) {
+  static const char kNullSuffix[] = ",\"prev_hash\":null,\"hash\":null}";
+  const size_t null_len = sizeof(kNullSuffix) - 1;
+  const char* s = line.c_str();
+  size_t len = line.length();
+  while (len > 0 && (s[len - 1] == '\r' || s[len - 1] == '\n' || s[len - 1] == ' ')) len--;
+  size_t cut = 0;
+  if (len > kChainSuffixLen && strncmp(s + len - kChainSuffixLen, kPrevKey, kPrevKeyLen) == 0 &&
+      strncmp(s + len - kChainSuffixLen + kPrevKeyLen + 64, kHashKey, kHashKeyLen) == 0) {
+    cut = kChainSuffixLen;
+  } else if (len > null_len && strncmp(s + len - null_len, kNullSuffix, null_len) == 0) {
+    cut = null_len;
+  } else {
+    return false;
+  }
+  line.remove(len - cut);
+  line += '}';
+  return true;
+}
+
+// Pointer to the 64 hex chars after `"key":"`, or nullptr.
+static const char* find_hex64(const char* line, const char* key) {
+  const char* p = strstr(line, key);
+  if (!p) return nullptr;
+  p += strlen(key);
+  for (size_t i = 0; i < 64; i++) {
+    if (!isxdigit((unsigned char)p[i])) return nullptr;
+  }
+  return p;
+}
+
+void WssLogChainVerifier::begin_file(const String& name) {
+  _file = name;
+  _report.files++;
+  _segment.reset();
+  // Every day file starts its chain from the zero hash.
+  memset(_prev, '0', 64);
+  _prev[64] = 0;
+  _prev_known = true;
+  _due = false;
+  _rehashing = false;
+  _seg_suspect = false;
+  close_segment(0);
+}
+
+// Starts a new segment at `next`, or, when the one ending here failed the checkpoint pass,
+// keeps its start state so rehash_due() can hand it back.
+void WssLogChainVerifier::close_segment(uint64_t next) {
+  if (_mode != WSS_LOG_VERIFY_CHECKPOINT) return;
+  if (_seg_suspect && !_rehashing) {
+    _due = true;
+    _due_end = next;
+    return;
+  }
+  _seg_start = next;
+  _seg_lines = 0;
+  _seg_suspect = false;
+  memcpy(_seg_prev, _prev, sizeof(_prev));
+  _seg_prev_known = _prev_known;
+  _seg_report = _report;
+}
+
+void WssLogChainVerifier::end_data(uint64_t eof) {
+  // Nothing to check the tail's stored hashes against: it is always re-hashed.
+  if (_mode == WSS_LOG_VERIFY_CHECKPOINT && !_rehashing && !_due && _seg_lines > 0) {
+    _due = true;
+    _due_end = eof;
+  }
+}
+
+bool WssLogChainVerifier::rehash_due(uint64_t& start, uint64_t& end) const {
+  if (!_due) return false;
+  start = _seg_start;
+  end = _due_end;
+  return true;
+}
+
+void WssLogChainVerifier::begin_rehash() {
+  if (!_due) return;
+  // Rewind to the segment start; the full pass recounts it.
+  _due = false;
+  _rehashing = true;
+  memcpy(_prev, _seg_prev, sizeof(_prev));
+  _prev_known = _seg_prev_known;
+  _report = _seg_report;
+  _report.rehashed_spans++;
+  _segment.reset();
+  _seg_suspect = false;
+}
+
+void WssLogChainVerifier::end_rehash() {
+  _rehashing = false;
+}
+
+void WssLogChainVerifier::end_file() {
+  _due = false;
+  _rehashing = false;
+  _report.uncheckpointed_lines += _segment.count();
+  _segment.reset();
+  _have_last_file_head = _prev_known;
+  if (_prev_known) memcpy(_last_file_head, _prev, sizeof(_prev));
+}
+
+void WssLogChainVerifier::fail(uint32_t seq, const char* reason) {
+  _seg_suspect = true;
+  _report.bad_lines++;
+  if (_report.first_bad_reason.length()) return;
+  _report.first_bad_seq = seq;
+  _report.first_bad_file = _file;
+  _report.first_bad_reason = reason;
+}
+
+void WssLogChainVerifier::line(const char* line, size_t len, uint64_t next) {
+  while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' ')) len--;
+  if (len == 0) return;
+  _report.lines++;
+  _seg_lines++;
+  const char* seq_p = strstr(line, "\"seq\":");
+  const uint32_t seq = seq_p ? (uint32_t)strtoul(seq_p + 6, nullptr, 10) : 0;
+
+  const char* suffix = len > kChainSuffixLen ? line + len - kChainSuffixLen : nullptr;
+  if (!suffix || strncmp(suffix, kPrevKey, kPrevKeyLen) != 0 ||
+      strncmp(suffix + kPrevKeyLen + 64, kHashKey, kHashKeyLen) != 0 ||
+      suffix[kChainSuffixLen - 2] != '"' || suffix[kChainSuffixLen - 1] != '}') {
+    if (strstr(line, "\"hash\":null")) {
+      // Chaining was off; the next chained line links to a hash we never saw.
+      _report.unchained_lines++;
+      _prev_known = false;
+      return;
+    }
+    fail(seq, "malformed");
+    _prev_known = false;
+    return;
+  }
+  const char* prev = suffix + kPrevKeyLen;
+  const char* hash = prev + 64 + kHashKeyLen;
+  const WssLogMetaKind kind = wss_log_meta_kind(line);
+
+  uint8_t digest[32];
+  bool hash_ok = true;
+  if (full() || kind != WSS_LOG_META_NONE) {
+    WssSha256 sha;
+    sha.update(line, (size_t)(suffix - line));
+    sha.update("}", 1);
+    sha.update(prev, 64);
+    sha.finish(digest);
+    char computed[65];
+    wss_hex_lower(digest, sizeof(digest), computed);
+    hash_ok = strncmp(computed, hash, 64) == 0;
+    _report.rehashed_lines++;
+  }
+  if (!hash_ok) fail(seq, "hash_mismatch");
+  else if (_prev_known && strncmp(_prev, prev, 64) != 0) fail(seq, "prev_link");
+  // Continue from the stored hash: the lines after an edit still verify against it.
+  memcpy(_prev, hash, 64);
+  _prev[64] = 0;
+  _prev_known = true;
+
+  switch (kind) {
+    case WSS_LOG_META_FILE_HEADER: {
+      const char* link = find_hex64(line, "\"prev_day_head\":\"");
+      if (link && _have_last_file_head) {
+        if (strncmp(link, _last_file_head, 64) == 0) _report.day_links++;
+        else fail(seq, "day_link");
+      }
+      return;
+    }
+    case WSS_LOG_META_CHECKPOINT:
+    case WSS_LOG_META_DAY_CLOSE: {
+      const char* root_hex = find_hex64(line, "\"merkle_root\":\"");
+      const char* lines_p = strstr(line, "\"lines\":");
+      uint8_t want[32];
+      uint8_t got[32];
+      _segment.root(got);
+      bool ok = root_hex && wss_hex_parse(root_hex, want, sizeof(want)) &&
+                memcmp(want, got, sizeof(got)) == 0 && lines_p &&
+                (uint32_t)strtoul(lines_p + 8, nullptr, 10) == _segment.count();
+      if (ok) {
+        _report.checkpoints++;
+      } else {
+        const char* first_p = strstr(line, "\"first_seq\":");
+        fail(first_p ? (uint32_t)strtoul(first_p + 12, nullptr, 10) : seq, "merkle_mismatch");
+      }
+      _segment.reset();
+      close_segment(next);
+      return;
+    }
+    case WSS_LOG_META_RESUME:
+      // The lines before a resume have no root: re-hash them like an open tail.
+      if (_segment.count() && !full()) _seg_suspect = true;
+      _report.uncheckpointed_lines += _segment.count();
+      _segment.reset();
+      close_segment(next);
+      return;
+    case WSS_LOG_META_NONE:
+      break;
+  }
+  (void)wss_hex_parse(hash, digest, sizeof(digest));
+  _segment.add(digest);
+}
@@ -0,0 +1,121 @@
+// src/storage/log_checkpoint.h
+// Role: Merkle checkpoints over the M3 line hash chain and the streaming verifier that
+// checks day files on the device (first broken seq instead of a full off-device re-hash).
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef WSS_LOG_CHECKPOINT_LINES
+#define WSS_LOG_CHECKPOINT_LINES 256 // one log_checkpoint record every N chained lines
+#endif
+
+// Streaming Merkle root over 32-byte leaves. Keeps one pending subtree per level, so
+// memory is O(log n) hashes. node = SHA256(left || right); an unpaired right-most
+// subtree is folded in as-is (RFC 6962 shape).
+class WssMerkle {
+ public:
+  void reset();
+  void add(const uint8_t leaf[32]);
+  uint32_t count() const { return _count; }
+
+  // Root of the leaves added so far; all zeros when empty.
+  void root(uint8_t out[32]) const;
+
+ private:
+  static const uint8_t kMaxLevels = 33;
+  uint8_t _node[kMaxLevels][32];
+  uint8_t _level[kMaxLevels];
+  uint8_t _depth = 0;
+  uint32_t _count = 0;
+};
+
+// Line roles that are not Merkle leaves (chained records the storage layer writes itself).
+enum WssLogMetaKind {
+  WSS_LOG_META_NONE = 0,
+  WSS_LOG_META_FILE_HEADER, // first line of a day file; may carry extra.prev_day_head
+  WSS_LOG_META_CHECKPOINT,  // log_checkpoint: Merkle root of the preceding segment
+  WSS_LOG_META_DAY_CLOSE,   // final checkpoint written when the day rotates
+  WSS_LOG_META_RESUME,      // segment restart after a reopen (earlier lines stay uncovered)
+};
+
+WssLogMetaKind wss_log_meta_kind(const char* line);
+
+// Removes the trailing `,"prev_hash":..,"hash":..` pair (hashes or nulls) so the line can
+// be chained again. False when the line carries no chain fields in that layout.
+bool wss_log_strip_chain(String& line);
+
+enum WssLogVerifyMode : uint8_t {
+  WSS_LOG_VERIFY_CHECKPOINT = 0, // stored hashes against checkpoint roots; see below
+  WSS_LOG_VERIFY_FULL = 1,       // re-hash every line
+};
+
+struct WssLogVerifyReport {
+  uint32_t files = 0;
+  uint32_t lines = 0;
+  uint32_t rehashed_lines = 0;       // lines whose bytes were hashed again
+  uint32_t rehashed_spans = 0;       // checkpoint mode: intervals that had to be re-hashed
+  uint32_t unchained_lines = 0;      // written with hash chaining disabled
+  uint32_t checkpoints = 0;          // checkpoint/day_close records whose root matched
+  uint32_t uncheckpointed_lines = 0; // chained lines not covered by any checkpoint
+  uint32_t day_links = 0;            // file headers whose prev_day_head matched
+  uint32_t bad_lines = 0;
+  uint32_t first_bad_seq = 0;
+  String first_bad_file;
+  String first_bad_reason; // hash_mismatch|prev_link|merkle_mismatch|day_link|malformed
+};
+
+// Feeds day files line by line (oldest first). Links are checked against the previous
+// line, checkpoint roots against the segment since the last checkpoint, and file headers
+// against the previous file's last hash.
+//
+// WSS_LOG_VERIFY_FULL recomputes every line's hash from its canonical bytes and prev_hash.
+// WSS_LOG_VERIFY_CHECKPOINT only re-hashes the checkpoint, day_close and file header
+// records; event lines contribute their stored hash to the segment root. A segment whose
+// root, links or format fail, and any lines no checkpoint covers (the open tail of a day,
+// before a log_resume), are handed back through rehash_due() to be fed again in full mode,
+// which pins the first broken seq. What it cannot see is a line edited in place with its
+// stored hash left alone: that only fails the full re-hash.
+class WssLogChainVerifier {
+ public:
+  explicit WssLogChainVerifier(WssLogVerifyMode mode = WSS_LOG_VERIFY_FULL) : _mode(mode) {}
+
+  void begin_file(const String& name);
+  // `next` is the file offset of the line after this one (used in checkpoint mode).
+  void line(const char* line, size_t len, uint64_t next = 0);
+  // Checkpoint mode, after the last line of a file: queues its uncovered tail.
+  void end_data(uint64_t eof);
+  void end_file();
+
+  // Checkpoint mode: true when [start, end) of the current file has to be re-hashed. Call
+  // begin_rehash(), feed exactly those lines again, then end_rehash().
+  bool rehash_due(uint64_t& start, uint64_t& end) const;
+  void begin_rehash();
+  void end_rehash();
+
+  const WssLogVerifyReport& report() const { return _report; }
+
+ private:
+  void fail(uint32_t seq, const char* reason);
+  void close_segment(uint64_t next);
+  bool full() const { return _mode == WSS_LOG_VERIFY_FULL || _rehashing; }
+
+  WssLogVerifyMode _mode;
+  WssLogVerifyReport _report;
+  WssMerkle _segment;
+  String _file;
+  char _prev[65] = {0};
+  bool _prev_known = false;
+  char _last_file_head[65] = {0};
+  bool _have_last_file_head = false;
+
+  // Checkpoint mode: where the open segment starts, and the state to rewind to there.
+  uint64_t _seg_start = 0;
+  uint32_t _seg_lines = 0;
+  bool _seg_suspect = false;
+  char _seg_prev[65] = {0};
+  bool _seg_prev_known = false;
+  WssLogVerifyReport _seg_report;
+  bool _due = false;
+  uint64_t _due_end = 0;
+  bool _rehashing = false;
+};
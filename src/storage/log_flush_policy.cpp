@@ -0,0 +1,39 @@
+// src/storage/log_flush_policy.cpp
+// Role: SD durability policy: which log lines force buffered bytes out to the card at once.
+
+#include "log_flush_policy.h"
+
+#include <string.h>
+
+WssLogFlushMode wss_log_flush_mode_parse(const char* s) {
+  if (s && strcmp(s, "per_event") == 0) return WSS_LOG_FLUSH_PER_EVENT;
+  if (s && strcmp(s, "interval") == 0) return WSS_LOG_FLUSH_INTERVAL;
+  return WSS_LOG_FLUSH_SEVERITY;
+}
+
+const char* wss_log_flush_mode_str(WssLogFlushMode m) {
+  switch (m) {
+    case WSS_LOG_FLUSH_PER_EVENT: return "per_event";
+    case WSS_LOG_FLUSH_INTERVAL: return "interval";
+    case WSS_LOG_FLUSH_SEVERITY:
+    default: return "severity";
+  }
+}
+
+uint32_t wss_log_flush_interval_clamp(uint32_t ms) {
+  if (ms < kWssLogFlushIntervalMinMs) return kWssLogFlushIntervalMinMs;
+  if (ms > kWssLogFlushIntervalMaxMs) return kWssLogFlushIntervalMaxMs;
+  return ms;
+}
+
+bool wss_log_flush_required(WssLogFlushMode m, WssLogSeverity sev, uint8_t flags) {
+  switch (m) {
+    case WSS_LOG_FLUSH_PER_EVENT:
+      return true;
+    case WSS_LOG_FLUSH_SEVERITY:
+      return sev >= WSS_LOG_SEV_WARN || (flags & WSS_LOG_FLAG_DURABLE);
+    case WSS_LOG_FLUSH_INTERVAL:
+    default:
+      return false;
+  }
+}
@@ -0,0 +1,32 @@
+// src/storage/log_flush_policy.h
+// Role: SD durability policy: which log lines force buffered bytes out to the card at once
+// (config `sd_flush_mode` / `sd_flush_interval_ms`).
+#pragma once
+
+#include <stdint.h>
+
+#include "log_queue.h"
+
+//   per_event: flush after every line (strongest, slowest)
+//   interval:  flush at most every sd_flush_interval_ms
+//   severity:  flush at once for warn/error/WSS_LOG_FLAG_DURABLE lines, batch the rest
+//              (still bounded by sd_flush_interval_ms)
+enum WssLogFlushMode : uint8_t {
+  WSS_LOG_FLUSH_PER_EVENT = 0,
+  WSS_LOG_FLUSH_INTERVAL,
+  WSS_LOG_FLUSH_SEVERITY,
+};
+
+static const uint32_t kWssLogFlushIntervalMinMs = 50;
+static const uint32_t kWssLogFlushIntervalMaxMs = 60000;
+
+// Config value to mode; anything unknown (or null) is `severity`.
+WssLogFlushMode wss_log_flush_mode_parse(const char* s);
+const char* wss_log_flush_mode_str(WssLogFlushMode m);
+
+// `sd_flush_interval_ms` clamped to the supported range.
+uint32_t wss_log_flush_interval_clamp(uint32_t ms);
+
+// True when a line must reach the card as soon as it is written; the others wait for the
+// interval.
+bool wss_log_flush_required(WssLogFlushMode m, WssLogSeverity sev, uint8_t flags);
@@ -0,0 +1,502 @@
+// src/storage/log_index.cpp
+// Role: On-card index of daily SD log files (/logs/index.bin).
+//
+// Layout: 32-byte header {magic, version, record size, count, first, total bytes} followed
+// by WssLogIndexEntry records sorted by date, live from slot `first`. The active day's
+// record is rewritten in place and retention drops only advance `first`; out-of-order
+// inserts and the occasional compaction of dropped slots rewrite the whole index through
+// /logs/index.tmp, so a crash leaves either the old index, the new one, or none (which
+// triggers a rebuild).
+
+#include "log_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "log_record_codec.h"
+
+static const char* kIndexPath = "/logs/index.bin";
+static const char* kIndexTmpPath = "/logs/index.tmp";
+static const uint32_t kIndexMagic = 0x58494C57; // "WLIX"
+static const uint16_t kIndexVersion = 3; // 3: format byte (older indexes are rebuilt)
+static const uint32_t kHeaderBytes = 32;
+static const uint32_t kCompactFirst = 64; // dropped slots tolerated before a rewrite
+static const uint32_t kRecordBytes = sizeof(WssLogIndexEntry);
+static const uint32_t kScanHeadBytes = 256;
+static const uint32_t kScanTailBytes = 2048;
+static const size_t kMaxYears = 64;
+static const size_t kMaxDaysPerMonth = 40;
+
+static_assert(sizeof(WssLogIndexEntry) == 52, "index record layout changed");
+
+struct IndexHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_bytes;
+  uint32_t count;
+  uint32_t first;       // slots before it were dropped by retention
+  uint64_t total_bytes; // sum of size_bytes over the live records
+  uint64_t reserved;
+};
+
+static_assert(sizeof(IndexHeader) == kHeaderBytes, "index header layout changed");
+
+static uint32_t record_pos(uint32_t first, uint32_t i) {
+  return kHeaderBytes + (first + i) * kRecordBytes;
+}
+
+static bool parse_uint(const char* s, size_t n, uint32_t& out) {
+  out = 0;
+  if (n == 0) return false;
+  for (size_t i = 0; i < n; i++) {
+    if (s[i] < '0' || s[i] > '9') return false;
+    out = out * 10 + (uint32_t)(s[i] - '0');
+  }
+  return true;
+}
+
+static int hex_nibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Parses `"seq":<n>` and `"hash":"<64 hex>"` from one JSONL line (first occurrence wins).
+static void parse_line_fields(const char* line, uint32_t* seq, uint8_t* hash32) {
+  if (wss_log_record_is_binary(line, strlen(line))) {
+    uint32_t s = 0;
+    bool has_hash = false;
+    uint8_t tmp[32];
+    if (!wss_log_record_peek(line, strlen(line), &s, &has_hash, tmp)) return;
+    if (seq) *seq = s;
+    if (hash32 && has_hash) memcpy(hash32, tmp, 32);
+    return;
+  }
+  if (seq) {
+    const char* p = strstr(line, "\"seq\":");
+    if (p) *seq = (uint32_t)strtoul(p + 6, nullptr, 10);
+  }
+  if (hash32) {
+    const char* p = strstr(line, "\"hash\":\"");
+    if (!p) return;
+    p += 8;
+    uint8_t tmp[32];
+    for (size_t i = 0; i < 32; i++) {
+      int hi = hex_nibble(p[2 * i]);
+      int lo = hi < 0 ? -1 : hex_nibble(p[2 * i + 1]);
+      if (lo < 0) return;
+      tmp[i] = (uint8_t)((hi << 4) | lo);
+    }
+    memcpy(hash32, tmp, 32);
+  }
+}
+
+uint32_t WssLogIndex::date_from_key(const String& key) {
+  if (key.length() != 10 || key[4] != '-' || key[7] != '-') return 0;
+  const char* s = key.c_str();
+  uint32_t y = 0, m = 0, d = 0;
+  if (!parse_uint(s, 4, y) || !parse_uint(s + 5, 2, m) || !parse_uint(s + 8, 2, d)) return 0;
+  if (m < 1 || m > 12 || d < 1 || d > 31) return 0;
+  return y * 10000 + m * 100 + d;
+}
+
+String WssLogIndex::key_for(uint32_t date) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%04lu-%02lu-%02lu", (unsigned long)(date / 10000),
+           (unsigned long)((date / 100) % 100), (unsigned long)(date % 100));
+  return String(buf);
+}
+
+String WssLogIndex::path_for(uint32_t date) {
+  char buf[48];
+  unsigned long y = date / 10000;
+  unsigned long m = (date / 100) % 100;
+  unsigned long d = date % 100;
+  snprintf(buf, sizeof(buf), "/logs/%04lu/%02lu/events_%04lu-%02lu-%02lu.txt", y, m, y, m, d);
+  return String(buf);
+}
+
+bool WssLogIndex::begin(WssStorageBackend* fs) {
+  _fs = fs;
+  _count = 0;
+  _first = 0;
+  _total_bytes = 0;
+  if (!_fs) return false;
+  _loaded = load() || rebuild();
+  return _loaded;
+}
+
+void WssLogIndex::end() {
+  _fs = nullptr;
+  _loaded = false;
+  _count = 0;
+  _first = 0;
+  _total_bytes = 0;
+}
+
+static bool write_index_header(WssStorageFile& f, uint32_t count, uint32_t first, uint64_t total) {
+  IndexHeader h{kIndexMagic, kIndexVersion, (uint16_t)kRecordBytes, count, first, total, 0};
+  if (!f.seek(0)) return false;
+  return f.write(&h, sizeof(h)) == sizeof(h);
+}
+
+bool WssLogIndex::write_header(WssStorageFile& f, uint32_t count) {
+  return write_index_header(f, count, _first, _total_bytes);
+}
+
+bool WssLogIndex::read_at(WssStorageFile& f, uint32_t pos, WssLogIndexEntry& out) {
+  if (!f.seek(record_pos(_first, pos))) return false;
+  return f.read(&out, kRecordBytes) == (int)kRecordBytes;
+}
+
+uint32_t WssLogIndex::lower_bound(WssStorageFile& f, uint32_t date) {
+  uint32_t lo = 0;
+  uint32_t hi = _count;
+  WssLogIndexEntry e;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (!read_at(f, mid, e)) return _count;
+    if (e.date < date) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+bool WssLogIndex::load() {
+  WssStorageFile f = _fs->open(kIndexPath, WSS_FS_READ);
+  if (!f) return false;
+  IndexHeader h;
+  bool ok = f.read(&h, sizeof(h)) == sizeof(h) && h.magic == kIndexMagic &&
+            h.version == kIndexVersion && h.record_bytes == kRecordBytes &&
+            f.size() >= (uint64_t)record_pos(h.first, h.count);
+  if (ok) {
+    _count = h.count;
+    _first = h.first;
+    _total_bytes = h.total_bytes;
+  }
+  // Stale check: the newest record must still name an existing file.
+  if (ok && _count > 0) {
+    WssLogIndexEntry last;
+    ok = read_at(f, _count - 1, last) && _fs->exists(path_for(last.date).c_str());
+  }
+  f.close();
+  if (!ok) {
+    _count = 0;
+    _first = 0;
+    _total_bytes = 0;
+  }
+  return ok;
+}
+
+bool WssLogIndex::next_at_or_after(uint32_t min_date, WssLogIndexEntry& out) {
+  if (!_fs || _count == 0) return false;
+  WssStorageFile f = _fs->open(kIndexPath, WSS_FS_READ);
+  if (!f) return false;
+  uint32_t pos = lower_bound(f, min_date);
+  bool ok = pos < _count && read_at(f, pos, out);
+  f.close();
+  return ok;
+}
+
+bool WssLogIndex::find(uint32_t date, WssLogIndexEntry& out) {
+  WssLogIndexEntry e;
+  if (!next_at_or_after(date, e) || e.date != date) return false;
+  out = e;
+  return true;
+}
+
+bool WssLogIndex::oldest(WssLogIndexEntry& out) {
+  return next_at_or_after(0, out);
+}
+
+bool WssLogIndex::last_before(uint32_t before, WssLogIndexEntry& out) {
+  if (!_fs || _count == 0) return false;
+  WssStorageFile f = _fs->open(kIndexPath, WSS_FS_READ);
+  if (!f) return false;
+  uint32_t pos = lower_bound(f, before);
+  bool ok = pos > 0 && read_at(f, pos - 1, out);
+  f.close();
+  return ok;
+}
+
+// Copies live records [from, count) to the tmp index (compacting dropped slots away),
+// merging `insert` in date order (replacing a record with the same date), then swaps it in.
+static bool rewrite_index(WssStorageBackend* fs, uint32_t first, uint32_t& count, uint64_t& total,
+                          uint32_t from, const WssLogIndexEntry* insert) {
+  WssStorageFile in = fs->open(kIndexPath, WSS_FS_READ);
+  (void)fs->remove(kIndexTmpPath);
+  WssStorageFile out = fs->open(kIndexTmpPath, WSS_FS_RDWR | WSS_FS_CREATE | WSS_FS_TRUNC);
+  if (!out) {
+    if (in) in.close();
+    return false;
+  }
+  bool ok = write_index_header(out, 0, 0, 0);
+  uint32_t n = 0;
+  uint64_t bytes = 0;
+  bool inserted = (insert == nullptr);
+  for (uint32_t i = from; ok && in && i < count; i++) {
+    WssLogIndexEntry e;
+    if (!in.seek(record_pos(first, i)) || in.read(&e, kRecordBytes) != (int)kRecordBytes) {
+      ok = false;
+      break;
+    }
+    if (!inserted && insert->date <= e.date) {
+      ok = out.write(insert, kRecordBytes) == kRecordBytes;
+      n++;
+      bytes += insert->size_bytes;
+      inserted = true;
+      if (insert->date == e.date) continue;
+    }
+    ok = ok && out.write(&e, kRecordBytes) == kRecordBytes;
+    n++;
+    bytes += e.size_bytes;
+  }
+  if (ok && !inserted) {
+    ok = out.write(insert, kRecordBytes) == kRecordBytes;
+    n++;
+    bytes += insert->size_bytes;
+  }
+  if (in) in.close();
+  ok = ok && write_index_header(out, n, 0, bytes) && out.sync();
+  out.close();
+  if (!ok) {
+    (void)fs->remove(kIndexTmpPath);
+    return false;
+  }
+  (void)fs->remove(kIndexPath);
+  if (!fs->rename(kIndexTmpPath, kIndexPath)) return false;
+  count = n;
+  total = bytes;
+  return true;
+}
+
+bool WssLogIndex::put(const WssLogIndexEntry& e) {
+  if (!_fs) return false;
+  WssStorageFile f = _fs->open(kIndexPath, WSS_FS_RDWR);
+  if (!f) return rebuild() && put(e);
+  uint32_t pos = lower_bound(f, e.date);
+  WssLogIndexEntry cur;
+  bool ok = false;
+  if (pos < _count && read_at(f, pos, cur) && cur.date == e.date) {
+    // Common case: the active day's record (normally the last one).
+    const uint64_t total = _total_bytes - cur.size_bytes + e.size_bytes;
+    ok = f.seek(record_pos(_first, pos)) && f.write(&e, kRecordBytes) == kRecordBytes;
+    if (ok && total != _total_bytes) {
+      _total_bytes = total;
+      ok = write_header(f, _count);
+    }
+  } else if (pos == _count) {
+    ok = f.seek(record_pos(_first, pos)) && f.write(&e, kRecordBytes) == kRecordBytes;
+    if (ok) {
+      _total_bytes += e.size_bytes;
+      ok = write_header(f, _count + 1);
+    }
+    if (ok) _count++;
+  } else {
+    // Out-of-order day (clock stepped back): rare, so rewrite.
+    f.close();
+    bool rewritten = rewrite_index(_fs, _first, _count, _total_bytes, 0, &e);
+    if (rewritten) _first = 0;
+    return rewritten;
+  }
+  ok = ok && f.sync();
+  f.close();
+  return ok;
+}
+
+uint32_t WssLogIndex::drop_before(uint32_t cutoff,
+                                  void (*on_drop)(const WssLogIndexEntry& e, void* ctx),
+                                  void* ctx) {
+  if (!_fs || _count == 0) return 0;
+  WssStorageFile f = _fs->open(kIndexPath, WSS_FS_READ);
+  if (!f) return 0;
+  uint32_t k = lower_bound(f, cutoff);
+  uint64_t dropped_bytes = 0;
+  for (uint32_t i = 0; i < k; i++) {
+    WssLogIndexEntry e;
+    if (!read_at(f, i, e)) break;
+    dropped_bytes += e.size_bytes;
+    if (on_drop) on_drop(e, ctx);
+  }
+  f.close();
+  if (k == 0) return 0;
+  // Records whose files were already deleted are dropped regardless; a crash before the
+  // header update just retries (remove of a missing file is harmless).
+  if (_first + k >= kCompactFirst) {
+    if (!rewrite_index(_fs, _first, _count, _total_bytes, k, nullptr)) return 0;
+    _first = 0;
+    return k;
+  }
+  f = _fs->open(kIndexPath, WSS_FS_RDWR);
+  if (!f) return 0;
+  const uint32_t first = _first;
+  const uint64_t total = _total_bytes;
+  _first += k;
+  _total_bytes = dropped_bytes > total ? 0 : total - dropped_bytes;
+  bool ok = write_header(f, _count - k) && f.sync();
+  f.close();
+  if (!ok) {
+    _first = first;
+    _total_bytes = total;
+    return 0;
+  }
+  _count -= k;
+  return k;
+}
+
+bool WssLogIndex::scan_file(uint32_t date, WssLogIndexEntry& out) {
+  out = WssLogIndexEntry();
+  out.date = date;
+  WssStorageFile f = _fs ? _fs->open(path_for(date).c_str(), WSS_FS_READ) : WssStorageFile();
+  if (!f) return false;
+  uint64_t sz = f.size();
+  out.size_bytes = (uint32_t)sz;
+  if (sz == 0) {
+    f.close();
+    return true;
+  }
+  char* buf = static_cast<char*>(malloc(kScanTailBytes + 1));
+  if (!buf) {
+    f.close();
+    return false;
+  }
+
+  // First line: format and first seq.
+  int32_t got = f.read(buf, kScanHeadBytes);
+  if (got > 0) {
+    out.format = (uint8_t)buf[0] == kWssLogRecordMarker ? WSS_LOG_FILE_BINARY : WSS_LOG_FILE_JSONL;
+    buf[got] = 0;
+    char* nl = strchr(buf, '\n');
+    if (nl) *nl = 0;
+    parse_line_fields(buf, &out.first_seq, nullptr);
+  }
+
+  // Last complete line: last seq and chain head. A zero-filled preallocated tail is skipped,
+  // and so is an unterminated last line (an append cut by a full card or power loss).
+  uint32_t to_read = sz > kScanTailBytes ? kScanTailBytes : (uint32_t)sz;
+  got = f.seek(sz - to_read) ? f.read(buf, to_read) : -1;
+  f.close();
+  if (got > 0) {
+    int end = got - 1;
+    while (end >= 0 && buf[end] == 0) end--;
+    while (end >= 0 && buf[end] != '\n') end--;
+    while (end >= 0 && (buf[end] == '\n' || buf[end] == '\r' || buf[end] == 0)) end--;
+    buf[end + 1] = 0;
+    int start = end;
+    while (start > 0 && buf[start - 1] != '\n') start--;
+    if (end >= 0) parse_line_fields(buf + start, &out.last_seq, out.chain_head);
+  }
+  free(buf);
+  return true;
+}
+
+static void sort_u32(uint32_t* v, size_t n) {
+  for (size_t i = 1; i < n; i++) {
+    uint32_t x = v[i];
+    size_t j = i;
+    while (j > 0 && v[j - 1] > x) {
+      v[j] = v[j - 1];
+      j--;
+    }
+    v[j] = x;
+  }
+}
+
+// Collects numeric subdirectory names of `dir` with exactly `digits` digits, sorted.
+struct NumericDirs {
+  size_t digits;
+  uint32_t* out;
+  size_t max_out;
+  size_t n;
+};
+
+static bool collect_numeric_dir(const WssStorageDirEntry& e, void* ctx) {
+  NumericDirs* c = static_cast<NumericDirs*>(ctx);
+  uint32_t v = 0;
+  if (e.is_dir && strlen(e.name) == c->digits && parse_uint(e.name, c->digits, v) &&
+      c->n < c->max_out) {
+    c->out[c->n++] = v;
+  }
+  return true;
+}
+
+static size_t list_numeric_dirs(WssStorageBackend* fs, const String& dir, size_t digits,
+                                uint32_t* out, size_t max_out) {
+  NumericDirs c{digits, out, max_out, 0};
+  if (!fs->list(dir.c_str(), collect_numeric_dir, &c)) return 0;
+  sort_u32(out, c.n);
+  return c.n;
+}
+
+struct MonthDays {
+  uint32_t dates[kMaxDaysPerMonth];
+  size_t n;
+};
+
+static bool collect_day_file(const WssStorageDirEntry& e, void* ctx) {
+  MonthDays* c = static_cast<MonthDays*>(ctx);
+  String s(e.name);
+  if (e.is_dir || !s.startsWith("events_") || !s.endsWith(".txt") || s.length() != 21) return true;
+  uint32_t date = WssLogIndex::date_from_key(s.substring(7, 17));
+  if (date && c->n < kMaxDaysPerMonth) c->dates[c->n++] = date;
+  return true;
+}
+
+bool WssLogIndex::scan_month(WssStorageFile& out, const String& dir, uint32_t& count) {
+  MonthDays days;
+  days.n = 0;
+  if (!_fs->list(dir.c_str(), collect_day_file, &days)) return true;
+  uint32_t* dates = days.dates;
+  const size_t n = days.n;
+  sort_u32(dates, n);
+  for (size_t i = 0; i < n; i++) {
+    WssLogIndexEntry e;
+    if (!scan_file(dates[i], e)) continue;
+    if (out.write(&e, kRecordBytes) != kRecordBytes) return false;
+    _total_bytes += e.size_bytes;
+    count++;
+  }
+  return true;
+}
+
+bool WssLogIndex::rebuild() {
+  if (!_fs) return false;
+  _rebuilds++;
+  _count = 0;
+  if (!_fs->exists("/logs") && !_fs->mkdir("/logs")) return false;
+  (void)_fs->remove(kIndexTmpPath);
+  WssStorageFile out = _fs->open(kIndexTmpPath, WSS_FS_RDWR | WSS_FS_CREATE | WSS_FS_TRUNC);
+  if (!out) return false;
+  _first = 0;
+  _total_bytes = 0;
+  bool ok = write_header(out, 0);
+  uint32_t n = 0;
+
+  // Walk years and months in numeric order so records come out sorted without
+  // holding the whole list in RAM.
+  uint32_t years[kMaxYears];
+  size_t ny = list_numeric_dirs(_fs, String("/logs"), 4, years, kMaxYears);
+  for (size_t yi = 0; ok && yi < ny; yi++) {
+    char ydir[24];
+    snprintf(ydir, sizeof(ydir), "/logs/%04lu", (unsigned long)years[yi]);
+    uint32_t months[13];
+    size_t nm = list_numeric_dirs(_fs, String(ydir), 2, months, 13);
+    for (size_t mi = 0; ok && mi < nm; mi++) {
+      char mdir[32];
+      snprintf(mdir, sizeof(mdir), "%s/%02lu", ydir, (unsigned long)months[mi]);
+      ok = scan_month(out, String(mdir), n);
+    }
+  }
+  ok = ok && write_header(out, n) && out.sync();
+  out.close();
+  if (!ok) {
+    (void)_fs->remove(kIndexTmpPath);
+    return false;
+  }
+  (void)_fs->remove(kIndexPath);
+  if (!_fs->rename(kIndexTmpPath, kIndexPath)) return false;
+  _count = n;
+  _loaded = true;
+  return true;
+}
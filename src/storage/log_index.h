@@ -0,0 +1,79 @@
+// src/storage/log_index.h
+// Role: On-card index of daily SD log files (/logs/index.bin) so list, size, range and
+// retention queries touch only the files they need instead of walking the /logs tree.
+#pragma once
+
+#include <Arduino.h>
+
+#include "storage_backend.h"
+
+// Line format of a day file (fixed when the file is created).
+enum WssLogFileFormat : uint8_t {
+  WSS_LOG_FILE_UNKNOWN = 0, // not known (empty, or unreadable when scanned)
+  WSS_LOG_FILE_JSONL = 1,
+  WSS_LOG_FILE_BINARY = 2,  // log_record_codec.h records
+};
+
+// One record per day file, sorted by date. 52 bytes on card.
+struct WssLogIndexEntry {
+  uint32_t date = 0;         // YYYYMMDD (UTC day of the file)
+  uint32_t size_bytes = 0;   // logical size of the file
+  uint32_t first_seq = 0;    // 0 = no sequenced line yet
+  uint32_t last_seq = 0;
+  uint8_t chain_head[32] = {0}; // hash of the last line (zeros = none / chaining off)
+  uint8_t format = WSS_LOG_FILE_UNKNOWN; // WssLogFileFormat
+  uint8_t reserved[3] = {0};
+};
+
+class WssLogIndex {
+ public:
+  // Loads the index from a mounted volume. A missing or unreadable index, or one whose
+  // newest record names a file that no longer exists, is rebuilt from the /logs tree.
+  bool begin(WssStorageBackend* fs);
+  void end();
+  bool ready() const { return _loaded; }
+
+  uint32_t count() const { return _count; }
+  uint32_t rebuilds() const { return _rebuilds; }
+  uint64_t total_bytes() const { return _total_bytes; } // sum of size_bytes (as last put)
+
+  // First record with date >= min_date. Reads the index, so it is safe to call again
+  // after the index changed (iterate with next_at_or_after(prev.date + 1, ...)).
+  bool next_at_or_after(uint32_t min_date, WssLogIndexEntry& out);
+  bool find(uint32_t date, WssLogIndexEntry& out);
+  bool oldest(WssLogIndexEntry& out);
+  // Newest record with date < before (the previous day that has a file).
+  bool last_before(uint32_t before, WssLogIndexEntry& out);
+
+  // Adds or replaces the record for e.date.
+  bool put(const WssLogIndexEntry& e);
+
+  // Removes records older than `cutoff`; on_drop runs for each first (e.g. to delete the
+  // file). Returns the number of records removed. Normally a header update only.
+  uint32_t drop_before(uint32_t cutoff, void (*on_drop)(const WssLogIndexEntry& e, void* ctx),
+                       void* ctx);
+
+  // Re-creates the index from the /logs/YYYY/MM tree.
+  bool rebuild();
+
+  // Reads first/last seq, size, chain head and format from a day file.
+  bool scan_file(uint32_t date, WssLogIndexEntry& out);
+
+  static uint32_t date_from_key(const String& yyyy_mm_dd); // 0 when malformed
+  static String key_for(uint32_t date);                    // YYYY-MM-DD
+  static String path_for(uint32_t date);
+
+ private:
+  WssStorageBackend* _fs = nullptr;
+  bool _loaded = false;
+  uint32_t _count = 0;
+  uint32_t _first = 0;
+  uint64_t _total_bytes = 0;
+  uint32_t _rebuilds = 0;
+
+  bool load();
+  bool read_at(WssStorageFile& f, uint32_t pos, WssLogIndexEntry& out);
+  uint32_t lower_bound(WssStorageFile& f, uint32_t date);
+  bool write_header(WssStorageFile& f, uint32_t count);
+  bool scan_month(WssStorageFile& out, const String& dir, uint32_t& count);
+};
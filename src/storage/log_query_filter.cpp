@@ -0,0 +1,63 @@
+// src/storage/log_query_filter.cpp
+// Role: Byte-level field filters for /api/logs/query.
+
+#include "log_query_filter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char* const kSeverityLevels[] = {"debug", "info", "warn", "error", "critical"};
+static const size_t kSeverityCount = sizeof(kSeverityLevels) / sizeof(kSeverityLevels[0]);
+
+bool WssLogFieldFilter::add(const char* v, size_t n) {
+  if (n == 0 || n >= kMaxValueLen || _count >= kMaxValues) return false;
+  memcpy(_values[_count], v, n);
+  _values[_count][n] = 0;
+  _lens[_count] = (uint8_t)n;
+  _count++;
+  return true;
+}
+
+bool WssLogFieldFilter::begin(const char* key, const String& csv, bool severity_levels) {
+  _count = 0;
+  int n = snprintf(_needle, sizeof(_needle), "\"%s\":\"", key);
+  _needle_len = (n > 0 && (size_t)n < sizeof(_needle)) ? (size_t)n : 0;
+  if (!_needle_len) return false;
+  if (!csv.length()) return true;
+
+  const char* p = csv.c_str();
+  while (true) {
+    const char* comma = strchr(p, ',');
+    size_t len = comma ? (size_t)(comma - p) : strlen(p);
+    if (severity_levels && len > 1 && p[len - 1] == '+') {
+      size_t i = 0;
+      while (i < kSeverityCount && !(strlen(kSeverityLevels[i]) == len - 1 &&
+                                     strncmp(kSeverityLevels[i], p, len - 1) == 0)) {
+        i++;
+      }
+      if (i == kSeverityCount) return false;
+      for (; i < kSeverityCount; i++) {
+        if (!add(kSeverityLevels[i], strlen(kSeverityLevels[i]))) return false;
+      }
+    } else if (!add(p, len)) {
+      return false;
+    }
+    if (!comma) break;
+    p = comma + 1;
+  }
+  return true;
+}
+
+bool WssLogFieldFilter::match(const char* line) const {
+  if (!_count) return true;
+  const char* p = strstr(line, _needle);
+  if (!p) return false;
+  p += _needle_len;
+  const char* end = strchr(p, '"');
+  if (!end) return false;
+  const size_t n = (size_t)(end - p);
+  for (size_t i = 0; i < _count; i++) {
+    if (_lens[i] == n && memcmp(_values[i], p, n) == 0) return true;
+  }
+  return false;
+}
@@ -0,0 +1,32 @@
+// src/storage/log_query_filter.h
+// Role: Byte-level field filters for /api/logs/query (no JSON parse per line).
+#pragma once
+
+#include <Arduino.h>
+
+// Matches one top-level string field of a log line ("event_type", "source", "severity")
+// against a comma-separated list of accepted values. The logger writes those fields before
+// `msg` and the extras, so the first `"key":"` in a line is the field itself.
+class WssLogFieldFilter {
+ public:
+  static const size_t kMaxValues = 8;
+  static const size_t kMaxValueLen = 32;
+
+  // `csv` empty = accept every line. False when the list has an empty item, too many
+  // items or an item longer than kMaxValueLen. With `severity_levels`, an item "warn+"
+  // stands for warn and every level above it (debug < info < warn < error < critical).
+  bool begin(const char* key, const String& csv, bool severity_levels = false);
+  bool active() const { return _count > 0; }
+
+  // `line` is NUL-terminated. A line without the field does not match an active filter.
+  bool match(const char* line) const;
+
+ private:
+  bool add(const char* v, size_t n);
+
+  char _needle[24] = {0}; // "key":"
+  size_t _needle_len = 0;
+  char _values[kMaxValues][kMaxValueLen];
+  uint8_t _lens[kMaxValues] = {0};
+  size_t _count = 0;
+};
@@ -0,0 +1,141 @@
+// src/storage/log_queue.cpp
+// Role: Bounded lock-free MPSC queue of pending log lines (producers never block on SD).
+
+#include "log_queue.h"
+
+#include <string.h>
+
+#include "../psram_alloc.h"
+
+WssLogQueue::WssLogQueue()
+    : _enqueue_pos(0),
+      _dequeue_pos(0),
+      _high_water(0),
+      _enqueued(0),
+      _dropped_debug(0),
+      _dropped_info(0),
+      _dropped_warn(0),
+      _dropped_overlong(0) {
+  for (uint32_t i = 0; i < kCapacity; i++) {
+    _cells[i].seq.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool WssLogQueue::begin() {
+  if (_arena) return true;
+  _arena = static_cast<char*>(wss_large_alloc(kCapacity * kSlotBytes));
+  return _arena != nullptr;
+}
+
+uint32_t WssLogQueue::admit_limit(WssLogSeverity sev) const {
+  switch (sev) {
+    case WSS_LOG_SEV_DEBUG:
+      return kCapacity / 2;
+    case WSS_LOG_SEV_INFO:
+      return kCapacity - kCapacity / 8;
+    default:
+      return kCapacity;
+  }
+}
+
+void WssLogQueue::count_drop(WssLogSeverity sev) {
+  if (sev == WSS_LOG_SEV_DEBUG) {
+    _dropped_debug.fetch_add(1, std::memory_order_relaxed);
+  } else if (sev == WSS_LOG_SEV_INFO) {
+    _dropped_info.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    _dropped_warn.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool WssLogQueue::push(const char* line, size_t len, WssLogSeverity sev, uint8_t flags) {
+  if (!line) return false;
+  if (len > WSS_LOG_LINE_MAX) {
+    _dropped_overlong.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (!_arena) {
+    count_drop(sev);
+    return false;
+  }
+
+  // Cheap pre-check so low-severity lines never take slots reserved for alarms.
+  if (depth() >= admit_limit(sev)) {
+    count_drop(sev);
+    return false;
+  }
+
+  // Vyukov bounded queue: claim a cell by advancing the enqueue ticket.
+  Cell* cell = nullptr;
+  uint32_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+  for (;;) {
+    cell = &_cells[pos & (kCapacity - 1)];
+    uint32_t seq = cell->seq.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      count_drop(sev);
+      return false;
+    } else {
+      pos = _enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+
+  // The claimed cell's slot is ours until the consumer pops it.
+  char* slot = _arena + (size_t)(pos & (kCapacity - 1)) * kSlotBytes;
+  memcpy(slot, line, len);
+  slot[len] = 0;
+  cell->item.data = slot;
+  cell->item.len = (uint16_t)len;
+  cell->item.sev = sev;
+  cell->item.flags = flags;
+  cell->seq.store(pos + 1, std::memory_order_release);
+
+  _enqueued.fetch_add(1, std::memory_order_relaxed);
+  uint32_t d = depth();
+  uint32_t hw = _high_water.load(std::memory_order_relaxed);
+  while (d > hw && !_high_water.compare_exchange_weak(hw, d, std::memory_order_relaxed)) {
+  }
+  return true;
+}
+
+bool WssLogQueue::peek(WssLogQueueItem& out) const {
+  uint32_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+  const Cell* cell = &_cells[pos & (kCapacity - 1)];
+  uint32_t seq = cell->seq.load(std::memory_order_acquire);
+  if ((int32_t)(seq - (pos + 1)) < 0) return false;
+  out = cell->item;
+  return true;
+}
+
+void WssLogQueue::pop() {
+  uint32_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+  Cell* cell = &_cells[pos & (kCapacity - 1)];
+  uint32_t seq = cell->seq.load(std::memory_order_acquire);
+  if ((int32_t)(seq - (pos + 1)) < 0) return;
+  cell->item = WssLogQueueItem{};
+  cell->seq.store(pos + kCapacity, std::memory_order_release);
+  _dequeue_pos.store(pos + 1, std::memory_order_release);
+}
+
+uint32_t WssLogQueue::depth() const {
+  uint32_t enq = _enqueue_pos.load(std::memory_order_acquire);
+  uint32_t deq = _dequeue_pos.load(std::memory_order_acquire);
+  uint32_t d = enq - deq;
+  return d > kCapacity ? kCapacity : d;
+}
+
+WssLogQueueStats WssLogQueue::stats() const {
+  WssLogQueueStats s;
+  s.capacity = kCapacity;
+  s.depth = depth();
+  s.high_water = _high_water.load(std::memory_order_relaxed);
+  s.enqueued = _enqueued.load(std::memory_order_relaxed);
+  s.dropped_debug = _dropped_debug.load(std::memory_order_relaxed);
+  s.dropped_info = _dropped_info.load(std::memory_order_relaxed);
+  s.dropped_warn = _dropped_warn.load(std::memory_order_relaxed);
+  s.dropped_overlong = _dropped_overlong.load(std::memory_order_relaxed);
+  s.dropped = s.dropped_debug + s.dropped_info + s.dropped_warn + s.dropped_overlong;
+  return s;
+}
@@ -0,0 +1,101 @@
+// src/storage/log_queue.h
+// Role: Bounded lock-free MPSC queue of pending log lines (producers never block on SD).
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "log_record_codec.h"
+
+// Capacity must be a power of two. Each slot holds one line of up to WSS_LOG_LINE_MAX bytes.
+#ifndef WSS_LOG_QUEUE_SLOTS
+#define WSS_LOG_QUEUE_SLOTS 64
+#endif
+
+enum WssLogSeverity : uint8_t {
+  WSS_LOG_SEV_DEBUG = 0,
+  WSS_LOG_SEV_INFO = 1,
+  WSS_LOG_SEV_WARN = 2,
+  WSS_LOG_SEV_ERROR = 3,
+};
+
+// Per-line hints for the writer.
+enum WssLogFlags : uint8_t {
+  WSS_LOG_FLAG_NONE = 0,
+  WSS_LOG_FLAG_DURABLE = 0x01,  // flush immediately in `severity` durability mode (e.g. state transitions)
+};
+
+struct WssLogQueueItem {
+  const char* data = nullptr;  // the slot's copy (NUL-terminated), valid until pop()
+  uint16_t len = 0;
+  WssLogSeverity sev = WSS_LOG_SEV_INFO;
+  uint8_t flags = WSS_LOG_FLAG_NONE;
+};
+
+struct WssLogQueueStats {
+  uint32_t capacity = 0;
+  uint32_t depth = 0;
+  uint32_t high_water = 0;
+  uint32_t enqueued = 0;
+  uint32_t dropped = 0;
+  uint32_t dropped_debug = 0;
+  uint32_t dropped_info = 0;
+  uint32_t dropped_warn = 0;  // warn + error (queue completely full)
+  uint32_t dropped_overlong = 0;  // longer than WSS_LOG_LINE_MAX (any severity)
+};
+
+// Overflow policy (drop-debug-first):
+// - debug is admitted only while the queue is under half full
+// - info is admitted only while the queue is under 7/8 full
+// - warn/error may use every slot; they are dropped only when the queue is full
+// Lines are copied into a slot arena reserved by begin() (kCapacity x WSS_LOG_LINE_MAX bytes,
+// PSRAM on boards that have it), so push() never allocates. Longer lines are refused whole
+// rather than cut into an unterminated JSON line.
+// Multiple producers may push concurrently; exactly one consumer may peek/pop.
+class WssLogQueue {
+ public:
+  static const uint32_t kCapacity = WSS_LOG_QUEUE_SLOTS;
+  static const size_t kSlotBytes = WSS_LOG_LINE_MAX + 1;
+
+  WssLogQueue();
+
+  // Reserves the slot arena. Call once before the first push(); later calls are no-ops.
+  bool begin();
+
+  // Copies `len` bytes of `line` into a free slot. Returns false (and counts a drop) when
+  // rejected, including before begin() and for lines over WSS_LOG_LINE_MAX.
+  bool push(const char* line, size_t len, WssLogSeverity sev, uint8_t flags = WSS_LOG_FLAG_NONE);
+
+  // Single consumer only. peek() gives the oldest line in place; pop() frees its slot.
+  bool peek(WssLogQueueItem& out) const;
+  void pop();
+
+  uint32_t depth() const;
+  bool empty() const { return depth() == 0; }
+  WssLogQueueStats stats() const;
+
+ private:
+  static_assert((WSS_LOG_QUEUE_SLOTS & (WSS_LOG_QUEUE_SLOTS - 1)) == 0,
+                "WSS_LOG_QUEUE_SLOTS must be a power of two");
+
+  struct Cell {
+    std::atomic<uint32_t> seq;
+    WssLogQueueItem item;
+  };
+
+  uint32_t admit_limit(WssLogSeverity sev) const;
+  void count_drop(WssLogSeverity sev);
+
+  Cell _cells[kCapacity];
+  char* _arena = nullptr;  // kCapacity slots of kSlotBytes, slot i for cell i
+  std::atomic<uint32_t> _enqueue_pos;
+  std::atomic<uint32_t> _dequeue_pos;
+  std::atomic<uint32_t> _high_water;
+  std::atomic<uint32_t> _enqueued;
+  std::atomic<uint32_t> _dropped_debug;
+  std::atomic<uint32_t> _dropped_info;
+  std::atomic<uint32_t> _dropped_warn;
+  std::atomic<uint32_t> _dropped_overlong;
+};
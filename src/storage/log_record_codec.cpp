@@ -0,0 +1,561 @@
+// src/storage/log_record_codec.cpp
+// Role: Binary SD log records (interned JSONL tokens) and the JSONL export stream.
+
+#include "log_record_codec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t kRecordVersion = 1;
+static const uint8_t kFlagSeq = 0x01;
+static const uint8_t kFlagChain = 0x02;
+
+static const uint8_t kStuff = 0x1B;
+static const uint8_t kStuffXor = 0x40;
+
+// Token bytes. 0x20..0x7E are literal characters, 0x80 + i is kDict[i].
+static const uint8_t kTokLiteral = 0x01; // next byte is a literal character
+static const uint8_t kTokDigest = 0x02;  // 32 bytes: 64 lowercase hex characters
+static const uint8_t kTokNumber = 0x03;  // LEB128: decimal without leading zeros
+static const uint8_t kTokTime = 0x04;    // u32 LE epoch: "YYYY-MM-DDTHH:MM:SSZ"
+static const uint8_t kTokSeq = 0x05;     // the header seq, in decimal
+static const uint8_t kTokChain = 0x06;   // `,"prev_hash":"<prev>","hash":"<hash>"}`
+
+// Interned strings, in the order serializeJson() emits the logger's fields. Append-only:
+// a record names entries by position, so existing ones never move or change.
+static const char* const kDict[] = {
+    "{\"ts\":\"", "\",\"seq\":", ",\"event_type\":\"", "\",\"severity\":\"",
+    "\",\"source\":\"", "\",\"msg\":\"", "\",\"time_valid\":false", ",\"time_valid\":",
+    ",\"extra\":{", ",\"prev_hash\":null,\"hash\":null}", ",\"prev_hash\":\"", "\",\"hash\":\"",
+    "\"}", "\":\"", "\",\"", "\":", ",\"", "true", "false", "null",
+    // severity
+    "debug", "info", "warn", "error", "critical",
+    // source
+    "nfc", "sensor", "power", "wifi", "rtc", "state", "config", "time", "core", "outputs",
+    // event_type
+    "nfc_scan", "nfc_action", "state_transition", "sensor_trigger", "log_checkpoint",
+    "day_close", "file_header", "log_resume", "time_status", "sd_status", "wifi_mode_change",
+    "lockout_enter", "lockout_exit", "config_change", "ota_update", "tamper_event", "boot",
+    "invalid_transition", "trigger_ignored", "log_retention", "log_backfill", "log_verify",
+    "admin_required", "admin_mode_entered", "admin_mode_exited", "fault_active",
+    "fault_cleared", "provision_", "allowlist_", "logs_download", "logs_query",
+    // common extra keys and values
+    "\"reason\":\"", "\"result\":\"", "\"action\":\"", "\"role\":\"", "\"tag_prefix\":\"",
+    "\"transport\":\"", "\"status\":\"", "\"mode\":\"", "\"from\":\"", "\"to\":\"",
+    "\"state\":\"", "\"sensor_type\":\"", "\"sensor_id\":\"", "\"error\":\"", "\"outcome\":\"",
+    "\"first_seq\":", "\"last_seq\":", "\"lines\":", "\"merkle_root\":\"",
+    "\"firmware\":\"", "\"log_schema_version\":", "\"config_schema_version\":",
+    "\"nfc_record_version\":", "\"device_suffix\":\"", "\"prev_day_head\":\"",
+    "\"elapsed_ms\":", "\"window_s\":", "\"active\":", "DISARMED", "ARMED", "TRIGGERED",
+    "SILENCED", "FAULT", "admin", "user", "allow", "deny", "invalid", "unknown", "failed",
+    "mounted", " log ", "log ", "lockout", "sd_",
+};
+static const size_t kDictCount = sizeof(kDict) / sizeof(kDict[0]);
+static_assert(sizeof(kDict) / sizeof(kDict[0]) <= 0x7F, "dictionary tokens are 0x80..0xFE");
+
+static const char kChainHead[] = ",\"prev_hash\":\"";
+static const char kChainMid[] = "\",\"hash\":\"";
+static const size_t kChainHeadLen = sizeof(kChainHead) - 1;
+static const size_t kChainMidLen = sizeof(kChainMid) - 1;
+static const size_t kChainLen = kChainHeadLen + 64 + kChainMidLen + 64 + 2; // 154
+
+static const char kHex[] = "0123456789abcdef";
+
+static int hex_val(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+static bool is_hex64(const char* s) {
+  for (size_t i = 0; i < 64; i++) {
+    if (hex_val(s[i]) < 0) return false;
+  }
+  return true;
+}
+
+static void hex_to_bytes(const char* s, uint8_t* out) {
+  for (size_t i = 0; i < 32; i++) {
+    out[i] = (uint8_t)(hex_val(s[2 * i]) << 4 | hex_val(s[2 * i + 1]));
+  }
+}
+
+// Civil-date helpers (proleptic Gregorian, days since 1970-01-01).
+static int32_t days_from_civil(int32_t y, uint32_t m, uint32_t d) {
+  y -= m <= 2;
+  const int32_t era = (y >= 0 ? y : y - 399) / 400;
+  const uint32_t yoe = (uint32_t)(y - era * 400);
+  const uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+static void civil_from_days(int32_t z, int32_t& y, uint32_t& m, uint32_t& d) {
+  z += 719468;
+  const int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const uint32_t doe = (uint32_t)(z - era * 146097);
+  const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const uint32_t mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = (int32_t)yoe + era * 400 + (m <= 2);
+}
+
+static void put2(char* p, uint32_t v) {
+  p[0] = (char)('0' + v / 10 % 10);
+  p[1] = (char)('0' + v % 10);
+}
+
+// "YYYY-MM-DDTHH:MM:SSZ" (20 characters).
+static void render_time(uint32_t epoch, char* out) {
+  int32_t y;
+  uint32_t m, d;
+  civil_from_days((int32_t)(epoch / 86400), y, m, d);
+  const uint32_t sod = epoch % 86400;
+  put2(out, (uint32_t)y / 100);
+  put2(out + 2, (uint32_t)y % 100);
+  out[4] = '-';
+  put2(out + 5, m);
+  out[7] = '-';
+  put2(out + 8, d);
+  out[10] = 'T';
+  put2(out + 11, sod / 3600);
+  out[13] = ':';
+  put2(out + 14, sod / 60 % 60);
+  out[16] = ':';
+  put2(out + 17, sod % 60);
+  out[19] = 'Z';
+}
+
+static bool digits(const char* s, size_t n, uint32_t& v) {
+  v = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (s[i] < '0' || s[i] > '9') return false;
+    v = v * 10 + (uint32_t)(s[i] - '0');
+  }
+  return true;
+}
+
+// A timestamp that renders back to the same 20 characters (so the token is lossless).
+static bool parse_time(const char* s, uint32_t& epoch) {
+  uint32_t y, mo, d, h, mi, sec;
+  if (s[4] != '-' || s[7] != '-' || s[10] != 'T' || s[13] != ':' || s[16] != ':' ||
+      s[19] != 'Z') {
+    return false;
+  }
+  if (!digits(s, 4, y) || !digits(s + 5, 2, mo) || !digits(s + 8, 2, d) ||
+      !digits(s + 11, 2, h) || !digits(s + 14, 2, mi) || !digits(s + 17, 2, sec)) {
+    return false;
+  }
+  if (y < 1970 || y > 2105 || mo < 1 || mo > 12 || d < 1 || d > 31 || h > 23 || mi > 59 ||
+      sec > 59) {
+    return false;
+  }
+  const int64_t e = (int64_t)days_from_civil((int32_t)y, mo, d) * 86400 + h * 3600 + mi * 60 + sec;
+  if (e < 0 || e > (int64_t)UINT32_MAX) return false;
+  epoch = (uint32_t)e;
+  char back[20];
+  render_time(epoch, back);
+  return memcmp(back, s, sizeof(back)) == 0;
+}
+
+// ---- encoder ----
+
+static void put_raw(String& out, uint8_t b) {
+  if (b == 0x00 || b == '\n' || b == '\r' || b == kStuff) {
+    out += (char)kStuff;
+    b ^= kStuffXor;
+  }
+  out += (char)b;
+}
+
+static void put_u32(String& out, uint32_t v) {
+  for (int i = 0; i < 4; i++) put_raw(out, (uint8_t)(v >> (8 * i)));
+}
+
+static size_t dict_match(const char* s, size_t avail) {
+  size_t best = 0;
+  size_t best_len = 0;
+  for (size_t i = 0; i < kDictCount; i++) {
+    const char* e = kDict[i];
+    if (e[0] != s[0]) continue;
+    const size_t n = strlen(e);
+    if (n > best_len && n <= avail && memcmp(e, s, n) == 0) {
+      best = i + 1;
+      best_len = n;
+    }
+  }
+  return best; // index + 1, 0 = none
+}
+
+bool wss_log_record_encode(const char* text, size_t len, String& out) {
+  out = "";
+  if (!out.reserve(len / 2 + 80)) return false;
+
+  // seq: the first `"seq":<n>` whose digits print back the same.
+  size_t seq_at = len;
+  size_t seq_end = len;
+  uint32_t seq = 0;
+  const char* p = strstr(text, "\"seq\":");
+  if (p && (size_t)(p - text) < len) {
+    const size_t at = (size_t)(p - text) + 6;
+    size_t n = 0;
+    uint64_t v = 0;
+    while (at + n < len && n < 11 && text[at + n] >= '0' && text[at + n] <= '9') {
+      v = v * 10 + (uint64_t)(text[at + n] - '0');
+      n++;
+    }
+    if (n > 0 && n <= 10 && v <= UINT32_MAX && (n == 1 || text[at] != '0')) {
+      seq_at = at;
+      seq_end = at + n;
+      seq = (uint32_t)v;
+    }
+  }
+
+  // Chain suffix at the very end of the line.
+  size_t limit = len;
+  bool chain = false;
+  if (len >= kChainLen) {
+    const char* s = text + len - kChainLen;
+    chain = memcmp(s, kChainHead, kChainHeadLen) == 0 && is_hex64(s + kChainHeadLen) &&
+            memcmp(s + kChainHeadLen + 64, kChainMid, kChainMidLen) == 0 &&
+            is_hex64(s + kChainHeadLen + 64 + kChainMidLen) && s[kChainLen - 2] == '"' &&
+            s[kChainLen - 1] == '}' && seq_end <= len - kChainLen;
+    if (chain) limit = len - kChainLen;
+  }
+
+  out += (char)kWssLogRecordMarker;
+  put_raw(out, kRecordVersion);
+  put_raw(out, (uint8_t)((seq_at < len ? kFlagSeq : 0) | (chain ? kFlagChain : 0)));
+  if (seq_at < len) put_u32(out, seq);
+  if (chain) {
+    uint8_t h[32];
+    hex_to_bytes(text + limit + kChainHeadLen, h);
+    for (size_t i = 0; i < 32; i++) put_raw(out, h[i]);
+    hex_to_bytes(text + limit + kChainHeadLen + 64 + kChainMidLen, h);
+    for (size_t i = 0; i < 32; i++) put_raw(out, h[i]);
+  }
+
+  size_t i = 0;
+  while (i < limit) {
+    if (i == seq_at) {
+      put_raw(out, kTokSeq);
+      i = seq_end;
+      continue;
+    }
+    // Tokens never run into the seq digits.
+    const size_t stop = i < seq_at && seq_at < limit ? seq_at : limit;
+    const size_t avail = stop - i;
+    const char* s = text + i;
+    uint32_t epoch;
+    if (avail >= 20 && s[0] >= '1' && s[0] <= '2' && parse_time(s, epoch)) {
+      put_raw(out, kTokTime);
+      put_u32(out, epoch);
+      i += 20;
+      continue;
+    }
+    if (avail >= 64 && hex_val(s[0]) >= 0 && is_hex64(s)) {
+      uint8_t h[32];
+      hex_to_bytes(s, h);
+      put_raw(out, kTokDigest);
+      for (size_t k = 0; k < 32; k++) put_raw(out, h[k]);
+      i += 64;
+      continue;
+    }
+    if (s[0] >= '1' && s[0] <= '9') {
+      size_t n = 0;
+      uint64_t v = 0;
+      while (n < avail && n < 19 && s[n] >= '0' && s[n] <= '9') {
+        v = v * 10 + (uint64_t)(s[n] - '0');
+        n++;
+      }
+      if (n >= 3) {
+        put_raw(out, kTokNumber);
+        while (v >= 0x80) {
+          put_raw(out, (uint8_t)(v | 0x80));
+          v >>= 7;
+        }
+        put_raw(out, (uint8_t)v);
+        i += n;
+        continue;
+      }
+    }
+    const size_t d = dict_match(s, avail);
+    if (d) {
+      put_raw(out, (uint8_t)(0x80 + d - 1));
+      i += strlen(kDict[d - 1]);
+      continue;
+    }
+    const uint8_t c = (uint8_t)s[0];
+    if (c < 0x20 || c >= 0x7F) put_raw(out, kTokLiteral);
+    put_raw(out, c);
+    i++;
+  }
+  if (chain) put_raw(out, kTokChain);
+  return out.length() > 0;
+}
+
+// ---- decoder ----
+
+namespace {
+
+// Reads the stuffed bytes after the marker back.
+struct Unstuffer {
+  const uint8_t* p;
+  const uint8_t* end;
+  bool bad = false;
+
+  Unstuffer(const char* rec, size_t len)
+      : p(reinterpret_cast<const uint8_t*>(rec) + 1),
+        end(reinterpret_cast<const uint8_t*>(rec) + len) {}
+
+  bool next(uint8_t& b) {
+    if (p >= end) return false;
+    b = *p++;
+    if (b != kStuff) return true;
+    if (p >= end) {
+      bad = true;
+      return false;
+    }
+    b = (uint8_t)(*p++ ^ kStuffXor);
+    return true;
+  }
+  bool next_n(uint8_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      if (!next(out[i])) return false;
+    }
+    return true;
+  }
+  bool next_u32(uint32_t& v) {
+    uint8_t b[4];
+    if (!next_n(b, 4)) return false;
+    v = (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+    return true;
+  }
+};
+
+// Collects text into a bounded buffer, or only counts it.
+struct TextSink {
+  char* out;
+  size_t cap;
+  size_t len = 0;
+  bool overflow = false;
+
+  void put(const char* s, size_t n) {
+    if (out) {
+      if (len + n + 1 > cap) {
+        overflow = true;
+        return;
+      }
+      memcpy(out + len, s, n);
+    }
+    len += n;
+  }
+  void put_hex(const uint8_t* b) {
+    char hex[64];
+    for (size_t i = 0; i < 32; i++) {
+      hex[2 * i] = kHex[b[i] >> 4];
+      hex[2 * i + 1] = kHex[b[i] & 0x0F];
+    }
+    put(hex, sizeof(hex));
+  }
+  void put_u64(uint64_t v) {
+    char buf[20];
+    size_t n = 0;
+    do {
+      buf[sizeof(buf) - 1 - n++] = (char)('0' + v % 10);
+      v /= 10;
+    } while (v);
+    put(buf + sizeof(buf) - n, n);
+  }
+};
+
+struct RecordHead {
+  uint8_t flags = 0;
+  uint32_t seq = 0;
+  uint8_t prev[32];
+  uint8_t hash[32];
+};
+
+bool read_head(Unstuffer& in, RecordHead& h) {
+  uint8_t version = 0;
+  if (!in.next(version) || version != kRecordVersion || !in.next(h.flags)) return false;
+  if ((h.flags & kFlagSeq) && !in.next_u32(h.seq)) return false;
+  if (h.flags & kFlagChain) return in.next_n(h.prev, 32) && in.next_n(h.hash, 32);
+  return true;
+}
+
+} // namespace
+
+bool wss_log_record_decode(const char* rec, size_t len, char* out, size_t cap,
+                           size_t& text_len) {
+  text_len = 0;
+  if (!wss_log_record_is_binary(rec, len)) return false;
+  Unstuffer in(rec, len);
+  RecordHead h;
+  if (!read_head(in, h)) return false;
+  TextSink sink{out, cap};
+  bool chain_done = false;
+  uint8_t t;
+  while (!chain_done && in.next(t)) {
+    if (t >= 0x20 && t < 0x7F) {
+      const char c = (char)t;
+      sink.put(&c, 1);
+    } else if (t >= 0x80 && t < 0x80 + kDictCount) {
+      const char* e = kDict[t - 0x80];
+      sink.put(e, strlen(e));
+    } else if (t == kTokLiteral) {
+      uint8_t c;
+      if (!in.next(c)) return false;
+      sink.put(reinterpret_cast<const char*>(&c), 1);
+    } else if (t == kTokDigest) {
+      uint8_t b[32];
+      if (!in.next_n(b, sizeof(b))) return false;
+      sink.put_hex(b);
+    } else if (t == kTokNumber) {
+      uint64_t v = 0;
+      uint8_t b;
+      int shift = 0;
+      do {
+        if (shift > 63 || !in.next(b)) return false;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        shift += 7;
+      } while (b & 0x80);
+      sink.put_u64(v);
+    } else if (t == kTokTime) {
+      uint32_t epoch;
+      if (!in.next_u32(epoch)) return false;
+      char ts[20];
+      render_time(epoch, ts);
+      sink.put(ts, sizeof(ts));
+    } else if (t == kTokSeq && (h.flags & kFlagSeq)) {
+      sink.put_u64(h.seq);
+    } else if (t == kTokChain && (h.flags & kFlagChain)) {
+      sink.put(kChainHead, kChainHeadLen);
+      sink.put_hex(h.prev);
+      sink.put(kChainMid, kChainMidLen);
+      sink.put_hex(h.hash);
+      sink.put("\"}", 2);
+      chain_done = true;
+    } else {
+      return false;
+    }
+  }
+  // Nothing may follow the chain suffix, and a record with one must end with it.
+  if (in.bad || in.p != in.end || ((h.flags & kFlagChain) != 0) != chain_done) return false;
+  if (sink.overflow) return false;
+  if (out) out[sink.len] = 0;
+  text_len = sink.len;
+  return true;
+}
+
+bool wss_log_record_to_text(String& line) {
+  if (!wss_log_record_is_binary(line.c_str(), line.length())) return true;
+  size_t n = 0;
+  if (!wss_log_record_decode(line.c_str(), line.length(), nullptr, 0, n)) return false;
+  char* buf = static_cast<char*>(malloc(n + 1));
+  if (!buf) return false;
+  bool ok = wss_log_record_decode(line.c_str(), line.length(), buf, n + 1, n);
+  if (ok) line = buf;
+  free(buf);
+  return ok;
+}
+
+bool wss_log_record_peek(const char* rec, size_t len, uint32_t* seq, bool* has_hash,
+                         uint8_t hash[32]) {
+  if (!wss_log_record_is_binary(rec, len)) return false;
+  Unstuffer in(rec, len);
+  RecordHead h;
+  if (!read_head(in, h)) return false;
+  if (seq) *seq = (h.flags & kFlagSeq) ? h.seq : 0;
+  if (has_hash) *has_hash = (h.flags & kFlagChain) != 0;
+  if (hash && (h.flags & kFlagChain)) memcpy(hash, h.hash, 32);
+  return true;
+}
+
+// ---- JSONL export ----
+
+WssLogJsonlExport::~WssLogJsonlExport() { end(); }
+
+bool WssLogJsonlExport::begin(Print& out) {
+  end();
+  _rec = static_cast<char*>(malloc(WSS_LOG_LINE_MAX));
+  _text = static_cast<char*>(malloc(WSS_LOG_LINE_MAX + 1));
+  if (!_rec || !_text) {
+    end();
+    return false;
+  }
+  _out = &out;
+  _rec_len = 0;
+  _line_start = true;
+  _in_record = false;
+  _overlong = false;
+  _failed = false;
+  _bytes_out = 0;
+  _records = 0;
+  _dropped = 0;
+  return true;
+}
+
+void WssLogJsonlExport::end() {
+  free(_rec);
+  free(_text);
+  _rec = nullptr;
+  _text = nullptr;
+  _out = nullptr;
+}
+
+bool WssLogJsonlExport::emit(const uint8_t* data, size_t len) {
+  if (_failed) return false;
+  if (len && _out->write(data, len) != len) {
+    _failed = true;
+    return false;
+  }
+  _bytes_out += len;
+  return true;
+}
+
+size_t WssLogJsonlExport::write(const uint8_t* data, size_t len) {
+  if (!_out || _failed) return 0;
+  size_t i = 0;
+  while (i < len) {
+    if (_line_start) {
+      _line_start = false;
+      _in_record = data[i] == kWssLogRecordMarker;
+      _rec_len = 0;
+      _overlong = false;
+    }
+    const uint8_t* nl = static_cast<const uint8_t*>(memchr(data + i, '\n', len - i));
+    const size_t run = nl ? (size_t)(nl - (data + i)) : len - i;
+    if (!_in_record) {
+      // Text passes through as is, '\n' included.
+      if (!emit(data + i, nl ? run + 1 : run)) return i;
+    } else {
+      if (_rec_len + run > WSS_LOG_LINE_MAX) _overlong = true;
+      else memcpy(_rec + _rec_len, data + i, run);
+      _rec_len += run;
+      if (nl) {
+        size_t n = 0;
+        if (!_overlong && wss_log_record_decode(_rec, _rec_len, _text, WSS_LOG_LINE_MAX + 1, n)) {
+          _text[n] = '\n';
+          if (!emit(reinterpret_cast<const uint8_t*>(_text), n + 1)) return i;
+          _records++;
+        } else {
+          _dropped++;
+        }
+      }
+    }
+    i += nl ? run + 1 : run;
+    if (nl) _line_start = true;
+  }
+  return len;
+}
+
+bool WssLogJsonlExport::finish() {
+  if (!_line_start && _in_record) _dropped++;
+  _line_start = true;
+  _in_record = false;
+  _rec_len = 0;
+  return !_failed;
+}
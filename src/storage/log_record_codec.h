@@ -0,0 +1,90 @@
+// src/storage/log_record_codec.h
+// Role: Compact binary form of SD log lines (config `log_format=binary`) and the streaming
+// converter that turns day files back into JSONL for downloads, queries and archives.
+#pragma once
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A binary record is still one '\n'-terminated line in the day file:
+//
+//   0x1E | stuffed( version, flags, [seq u32 LE], [prev_hash 32, hash 32], tokens )
+//
+// Stuffing replaces 0x00, '\n', '\r' and 0x1B with 0x1B, b ^ 0x40, so the line scanners,
+// the write-behind ring's line boundaries and the zero-filled preallocated tail work on
+// both formats unchanged. The tokens spell out the exact JSON text of the line: interned
+// keys and common values are one byte, ISO timestamps five, 64-hex digests 33 and numbers
+// a varint. Decoding gives back the very bytes that were hashed, so the hash chain,
+// checkpoints and the verifier are defined over the JSONL text as before.
+static const uint8_t kWssLogRecordMarker = 0x1E;
+
+// Longest line (JSON text or record) the readers assemble; longer ones are malformed.
+#ifndef WSS_LOG_LINE_MAX
+#define WSS_LOG_LINE_MAX 2048
+#endif
+
+inline bool wss_log_record_is_binary(const char* line, size_t len) {
+  return len > 0 && (uint8_t)line[0] == kWssLogRecordMarker;
+}
+
+// Encodes one JSONL line (no '\n'). Always succeeds for text without NUL bytes; `out`
+// gets the record without its '\n'.
+bool wss_log_record_encode(const char* text, size_t len, String& out);
+
+// Decodes a record into `out` (NUL-terminated; `cap` includes the NUL). With out ==
+// nullptr only measures. False when the record is malformed or does not fit.
+bool wss_log_record_decode(const char* rec, size_t len, char* out, size_t cap,
+                           size_t& text_len);
+
+// Replaces a binary record with its JSONL text; text lines are left alone. False when
+// the record is malformed.
+bool wss_log_record_to_text(String& line);
+
+// seq and chain hash from the head of a record (the first 141 bytes always suffice, even
+// when the rest of the line was not kept). False for text lines; `has_hash` is false
+// for records written with hash chaining disabled.
+bool wss_log_record_peek(const char* rec, size_t len, uint32_t* seq, bool* has_hash,
+                         uint8_t hash[32]);
+
+// Print decorator that passes day-file bytes through as JSONL: text lines are copied,
+// binary records are decoded line by line. write() reports the raw bytes taken. A record
+// that is malformed or torn (no '\n' by finish()) is dropped and counted.
+class WssLogJsonlExport : public Print {
+ public:
+  WssLogJsonlExport() = default;
+  ~WssLogJsonlExport();
+  WssLogJsonlExport(const WssLogJsonlExport&) = delete;
+  WssLogJsonlExport& operator=(const WssLogJsonlExport&) = delete;
+
+  // Allocates the record and text buffers. False when out of memory.
+  bool begin(Print& out);
+  // Ends the current file: a partial text line was already passed on, a partial record is
+  // dropped. The next byte starts a line again.
+  bool finish();
+  void end();
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* data, size_t len) override;
+
+  uint64_t bytes_out() const { return _bytes_out; }
+  uint32_t records() const { return _records; }
+  uint32_t dropped() const { return _dropped; }
+  bool failed() const { return _failed; }
+
+ private:
+  bool emit(const uint8_t* data, size_t len);
+
+  Print* _out = nullptr;
+  char* _rec = nullptr;   // WSS_LOG_LINE_MAX bytes
+  char* _text = nullptr;  // WSS_LOG_LINE_MAX + 1 bytes
+  size_t _rec_len = 0;
+  bool _line_start = true;
+  bool _in_record = false;
+  bool _overlong = false;
+  bool _failed = false;
+  uint64_t _bytes_out = 0;
+  uint32_t _records = 0;
+  uint32_t _dropped = 0;
+};
@@ -0,0 +1,189 @@
+// src/storage/log_retention.cpp
+// Role: Sliced, index-driven log retention.
+//
+// Every decision reads only the oldest index/archive record, so a step costs one file
+// delete plus a header update, or one compaction slice, regardless of how many days are
+// on the card. Free space is tracked as an estimate from the sizes removed and written;
+// the caller re-plans with a fresh figure on the next pass.
+
+#include "log_retention.h"
+
+#include "log_seek_index.h"
+
+bool WssLogRetention::begin(WssStorageBackend* fs, WssLogIndex* index) {
+  end();
+  _fs = fs;
+  _index = index;
+  return _fs && _index && _archive.begin(fs);
+}
+
+void WssLogRetention::end() {
+  _archive.end();
+  _phase = PHASE_IDLE;
+  _fs = nullptr;
+  _index = nullptr;
+}
+
+bool WssLogRetention::start(const WssLogRetentionPolicy& p) {
+  if (!_fs || !_index || running()) return false;
+  _p = p;
+  _free_est = p.free_bytes;
+  _stats.quota_unreachable = false;
+  _stats.last_error = "";
+  _phase = PHASE_AGE;
+  return true;
+}
+
+WssLogRetentionStats WssLogRetention::stats() const {
+  WssLogRetentionStats s = _stats;
+  s.running = running();
+  switch (_phase) {
+    case PHASE_AGE: s.phase = "age"; break;
+    case PHASE_QUOTA: s.phase = "quota"; break;
+    case PHASE_ARCHIVE: s.phase = "archive"; break;
+    case PHASE_IDLE:
+    default: s.phase = "idle"; break;
+  }
+  s.archive_bytes = _archive.total_bytes();
+  s.archive_months = _archive.count();
+  s.used_bytes = (_index ? _index->total_bytes() : 0) + s.archive_bytes;
+  return s;
+}
+
+void WssLogRetention::finish(const char* err) {
+  if (_archive.compacting()) _archive.compact_abort();
+  if (err) _stats.last_error = err;
+  _stats.passes++;
+  _phase = PHASE_IDLE;
+}
+
+bool WssLogRetention::delete_day(const WssLogIndexEntry& e) {
+  String path = WssLogIndex::path_for(e.date);
+  (void)_fs->remove(WssLogSeekIndex::path_for(path).c_str());
+  (void)_fs->remove(path.c_str()); // a record whose file is already gone is dropped too
+  if (_index->drop_before(e.date + 1, nullptr, nullptr) == 0) return false;
+  _free_est += e.size_bytes;
+  return true;
+}
+
+bool WssLogRetention::over_quota() const {
+  const uint64_t used = _index->total_bytes() + _archive.total_bytes();
+  if (_p.quota_bytes && used > _p.quota_bytes) return true;
+  return _p.min_free_bytes && _free_est < _p.min_free_bytes;
+}
+
+bool WssLogRetention::step() {
+  if (!running()) return false;
+  switch (_phase) {
+    case PHASE_AGE:
+      if (!step_age()) _phase = PHASE_QUOTA;
+      break;
+    case PHASE_QUOTA:
+      if (!step_quota()) _phase = PHASE_ARCHIVE;
+      break;
+    case PHASE_ARCHIVE:
+      if (!step_archive()) finish(nullptr);
+      break;
+    case PHASE_IDLE:
+    default:
+      break;
+  }
+  return running();
+}
+
+// One expired day file or fully expired archive per step. False when none is left.
+bool WssLogRetention::step_age() {
+  if (!_p.age_cutoff) return false;
+  WssLogIndexEntry e;
+  if (_index->oldest(e) && e.date < _p.age_cutoff && e.date != _p.active_date) {
+    if (!delete_day(e)) {
+      _stats.last_error = "index_drop_failed";
+      return false;
+    }
+    _stats.files_deleted++;
+    _stats.bytes_freed += e.size_bytes;
+    return true;
+  }
+  WssLogArchiveMonth m;
+  if (_archive.oldest(m) && m.last_date < _p.age_cutoff) {
+    if (!_archive.drop_oldest()) {
+      _stats.last_error = "archive_drop_failed";
+      return false;
+    }
+    _free_est += m.gz_bytes;
+    _stats.bytes_freed += m.gz_bytes;
+    _stats.archives_deleted++;
+    return true;
+  }
+  return false;
+}
+
+// Drops the oldest day file or archive while over quota. False when within limits.
+bool WssLogRetention::step_quota() {
+  if (!over_quota()) return false;
+  WssLogIndexEntry e;
+  WssLogArchiveMonth m;
+  bool have_day = _index->oldest(e) && e.date != _p.active_date;
+  bool have_month = _archive.oldest(m);
+  if (have_month && (!have_day || m.first_date <= e.date)) {
+    if (!_archive.drop_oldest()) {
+      _stats.last_error = "archive_drop_failed";
+      return false;
+    }
+    _free_est += m.gz_bytes;
+    _stats.bytes_freed += m.gz_bytes;
+    _stats.archives_deleted++;
+    return true;
+  }
+  if (have_day) {
+    if (!delete_day(e)) {
+      _stats.last_error = "index_drop_failed";
+      return false;
+    }
+    _stats.files_deleted++;
+    _stats.bytes_freed += e.size_bytes;
+    return true;
+  }
+  // Only the active day is left.
+  _stats.quota_unreachable = true;
+  return false;
+}
+
+// Compacts closed day files older than the archive cutoff, oldest first, one slice per
+// step. False when nothing is left to archive (or the card is too full to try).
+bool WssLogRetention::step_archive() {
+  if (!_p.archive_cutoff) return false;
+  if (!_archive.compacting()) {
+    if (_p.min_free_bytes && _free_est < _p.min_free_bytes) return false;
+    WssLogIndexEntry e;
+    if (!_index->oldest(e) || e.date >= _p.archive_cutoff || e.date == _p.active_date) {
+      return false;
+    }
+    bool already = false;
+    if (!_archive.compact_begin(e, already)) {
+      _stats.last_error = "archive_open_failed"; // also: no memory for the compressor
+      return false;
+    }
+    return !already || delete_day(e);
+  }
+
+  bool done = false;
+  if (!_archive.compact_step(WSS_LOG_COMPACT_SLICE_BYTES, done)) {
+    _archive.compact_abort();
+    _stats.last_error = "archive_write_failed";
+    return false;
+  }
+  if (!done) return true;
+
+  const uint64_t gz_before = _archive.total_bytes();
+  WssLogIndexEntry e;
+  if (!_index->oldest(e) || !_archive.compact_commit()) {
+    _stats.last_error = "archive_commit_failed";
+    return false;
+  }
+  const uint64_t gz_added = _archive.total_bytes() - gz_before;
+  _free_est = _free_est > gz_added ? _free_est - gz_added : 0;
+  _stats.days_archived++;
+  // The archive now holds the day; a failed drop is caught by compact_begin() next pass.
+  return delete_day(e);
+}
@@ -0,0 +1,75 @@
+// src/storage/log_retention.h
+// Role: Index-driven log retention (age limit, byte quota / minimum free space, monthly
+// archive compaction) that runs as a sequence of small slices instead of one long pass.
+#pragma once
+
+#include <Arduino.h>
+
+#include "storage_backend.h"
+
+#include "log_archive.h"
+#include "log_index.h"
+
+// Size of one compaction slice (uncompressed bytes read from the day file).
+#ifndef WSS_LOG_COMPACT_SLICE_BYTES
+#define WSS_LOG_COMPACT_SLICE_BYTES 4096
+#endif
+
+struct WssLogRetentionPolicy {
+  uint32_t age_cutoff = 0;     // YYYYMMDD; day files and whole archives before it go (0 = off)
+  uint32_t archive_cutoff = 0; // YYYYMMDD; closed day files before it are compacted (0 = off)
+  uint32_t active_date = 0;    // the open day file, never touched
+  uint64_t quota_bytes = 0;    // day files + archives (0 = no fixed quota)
+  uint64_t min_free_bytes = 0; // oldest logs go first while the card has less free
+  uint64_t free_bytes = 0;     // card free space when the pass starts
+};
+
+struct WssLogRetentionStats {
+  bool running = false;
+  const char* phase = "idle"; // idle|age|quota|archive
+  uint32_t passes = 0;
+  uint32_t files_deleted = 0;    // day files removed by age or quota
+  uint32_t archives_deleted = 0; // monthly archives removed by age or quota
+  uint32_t days_archived = 0;
+  uint64_t bytes_freed = 0;      // day file + archive bytes deleted by age or quota
+  uint64_t used_bytes = 0;       // day files + archives
+  uint64_t archive_bytes = 0;
+  uint32_t archive_months = 0;
+  bool quota_unreachable = false; // last pass ran out of old logs while still over quota
+  String last_error;
+};
+
+// start() plans a pass; each step() then does one unit of work: delete one day file or
+// archive, or compress WSS_LOG_COMPACT_SLICE_BYTES of the day being archived. Phases run
+// age -> quota -> archive, always oldest first, so everything lives off the index.
+class WssLogRetention {
+ public:
+  bool begin(WssStorageBackend* fs, WssLogIndex* index);
+  void end(); // abandons a pass (a partial archive member is cut off next time)
+
+  // False when a pass is already running.
+  bool start(const WssLogRetentionPolicy& p);
+  // True while the pass has more work.
+  bool step();
+  bool running() const { return _phase != PHASE_IDLE; }
+
+  WssLogRetentionStats stats() const;
+
+ private:
+  enum Phase { PHASE_IDLE = 0, PHASE_AGE, PHASE_QUOTA, PHASE_ARCHIVE };
+
+  bool step_age();
+  bool step_quota();
+  bool step_archive();
+  bool delete_day(const WssLogIndexEntry& e);
+  bool over_quota() const;
+  void finish(const char* err);
+
+  WssStorageBackend* _fs = nullptr;
+  WssLogIndex* _index = nullptr;
+  WssLogArchive _archive;
+  WssLogRetentionPolicy _p;
+  Phase _phase = PHASE_IDLE;
+  uint64_t _free_est = 0;
+  WssLogRetentionStats _stats;
+};
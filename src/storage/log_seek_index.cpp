@@ -0,0 +1,164 @@
+// src/storage/log_seek_index.cpp
+// Role: Sparse per-day seek index for seq/time range queries.
+//
+// The sidecar is a flat array of WssLogSeekSample records in file order. seq always grows
+// within a day file and ts is treated as non-decreasing, so both can be binary searched;
+// the query still filters every line it emits, so a clock step only costs extra reading.
+
+#include "log_seek_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const uint32_t kSampleBytes = sizeof(WssLogSeekSample);
+
+static_assert(sizeof(WssLogSeekSample) == 12, "seek sample layout changed");
+
+static bool parse_digits(const char* s, size_t n, uint32_t& out) {
+  out = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (s[i] < '0' || s[i] > '9') return false;
+    out = out * 10 + (uint32_t)(s[i] - '0');
+  }
+  return true;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's algorithm).
+static int32_t days_from_civil(int32_t y, uint32_t m, uint32_t d) {
+  y -= m <= 2;
+  const int32_t era = (y >= 0 ? y : y - 399) / 400;
+  const uint32_t yoe = (uint32_t)(y - era * 400);
+  const uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+uint32_t wss_iso8601_to_epoch(const char* s) {
+  if (!s || strlen(s) < 16) return 0;
+  if (s[4] != '-' || s[7] != '-' || (s[10] != 'T' && s[10] != ' ') || s[13] != ':') return 0;
+  uint32_t y, mo, d, h, mi, sec = 0;
+  if (!parse_digits(s, 4, y) || !parse_digits(s + 5, 2, mo) || !parse_digits(s + 8, 2, d) ||
+      !parse_digits(s + 11, 2, h) || !parse_digits(s + 14, 2, mi)) {
+    return 0;
+  }
+  if (s[16] == ':' && !parse_digits(s + 17, 2, sec)) return 0;
+  if (y < 1970 || mo < 1 || mo > 12 || d < 1 || d > 31 || h > 23 || mi > 59 || sec > 60) return 0;
+  int32_t days = days_from_civil((int32_t)y, mo, d);
+  return (uint32_t)days * 86400UL + h * 3600UL + mi * 60UL + sec;
+}
+
+bool wss_log_line_seq_ts(const char* line, uint32_t& seq_out, uint32_t& ts_out) {
+  seq_out = 0;
+  ts_out = 0;
+  const char* p = strstr(line, "\"seq\":");
+  if (!p) return false;
+  seq_out = (uint32_t)strtoul(p + 6, nullptr, 10);
+  const char* t = strstr(line, "\"ts\":\"");
+  if (t && !strstr(line, "\"time_valid\":false")) ts_out = wss_iso8601_to_epoch(t + 6);
+  return true;
+}
+
+String WssLogSeekIndex::path_for(const String& log_path) {
+  if (!log_path.endsWith(".txt")) return log_path + String(".idx");
+  return log_path.substring(0, log_path.length() - 4) + String(".idx");
+}
+
+void WssLogSeekIndex::begin(WssStorageBackend* fs, const String& log_path) {
+  _fs = fs;
+  _path = path_for(log_path);
+  _pending_count = 0;
+  _lines_since_sample = WSS_LOG_SEEK_STRIDE; // sample the first line written
+  if (!_fs) return;
+  WssStorageFile f = _fs->open(_path.c_str(), WSS_FS_RDWR);
+  if (!f) return;
+  uint64_t sz = f.size();
+  if (sz % kSampleBytes) (void)f.truncate(sz - (sz % kSampleBytes));
+  f.close();
+}
+
+void WssLogSeekIndex::end() {
+  (void)flush();
+  _fs = nullptr;
+  _path = "";
+}
+
+void WssLogSeekIndex::note_line(const char* line, uint64_t offset) {
+  if (!_fs) return;
+  if (++_lines_since_sample < WSS_LOG_SEEK_STRIDE) return;
+  WssLogSeekSample s;
+  if (!wss_log_line_seq_ts(line, s.seq, s.ts)) return; // try again on the next line
+  s.offset = (uint32_t)offset;
+  _lines_since_sample = 0;
+  _pending[_pending_count++] = s;
+  if (_pending_count == kPendingMax) (void)flush();
+}
+
+bool WssLogSeekIndex::flush() {
+  if (!_fs || _pending_count == 0) return true;
+  WssStorageFile f = _fs->open(_path.c_str(), WSS_FS_WRITE | WSS_FS_CREATE | WSS_FS_APPEND);
+  if (!f) return false;
+  size_t bytes = _pending_count * kSampleBytes;
+  bool ok = f.write(_pending, bytes) == bytes;
+  f.close();
+  // Samples are hints; drop them on failure rather than retrying forever.
+  if (ok) _samples_written += (uint32_t)_pending_count;
+  _pending_count = 0;
+  return ok;
+}
+
+static bool read_sample(WssStorageFile& f, uint32_t i, WssLogSeekSample& out) {
+  if (!f.seek((uint64_t)i * kSampleBytes)) return false;
+  return f.read(&out, kSampleBytes) == (int)kSampleBytes;
+}
+
+enum SeekKey { SEEK_SEQ, SEEK_TS };
+
+// First sample whose key is > value (n when none).
+static uint32_t upper_bound(WssStorageFile& f, uint32_t n, SeekKey key, uint32_t value) {
+  uint32_t lo = 0;
+  uint32_t hi = n;
+  WssLogSeekSample s;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (!read_sample(f, mid, s)) return n;
+    uint32_t v = key == SEEK_SEQ ? s.seq : s.ts;
+    if (v <= value) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+void WssLogSeekIndex::lookup(WssStorageBackend* fs, const String& log_path, uint32_t from_seq,
+                             uint32_t to_seq, uint32_t from_ts, uint32_t to_ts,
+                             uint64_t file_size, uint64_t& start, uint64_t& end) {
+  start = 0;
+  end = file_size;
+  if (!fs) return;
+  WssStorageFile f = fs->open(path_for(log_path).c_str(), WSS_FS_READ);
+  if (!f) return;
+  uint32_t n = (uint32_t)(f.size() / kSampleBytes);
+  WssLogSeekSample s;
+
+  // Start: the last sample at or before the first possible match. Lines before a sample
+  // with seq <= from_seq (or ts < from_ts) cannot match.
+  if (from_seq) {
+    uint32_t i = upper_bound(f, n, SEEK_SEQ, from_seq);
+    if (i > 0 && read_sample(f, i - 1, s) && s.offset > start) start = s.offset;
+  }
+  if (from_ts) {
+    uint32_t i = upper_bound(f, n, SEEK_TS, from_ts - 1);
+    if (i > 0 && read_sample(f, i - 1, s) && s.offset > start) start = s.offset;
+  }
+  // End: the first sample past the last possible match.
+  if (to_seq) {
+    uint32_t i = upper_bound(f, n, SEEK_SEQ, to_seq);
+    if (i < n && read_sample(f, i, s) && s.offset < end) end = s.offset;
+  }
+  if (to_ts) {
+    uint32_t i = upper_bound(f, n, SEEK_TS, to_ts);
+    if (i < n && read_sample(f, i, s) && s.offset < end) end = s.offset;
+  }
+  f.close();
+  if (start > file_size) start = file_size;
+  if (end < start) end = start;
+}
@@ -0,0 +1,61 @@
+// src/storage/log_seek_index.h
+// Role: Sparse per-day seek index (events_YYYY-MM-DD.idx next to each day file) so seq/time
+// range queries start reading near the first matching line instead of at offset 0.
+#pragma once
+
+#include <Arduino.h>
+
+#include "storage_backend.h"
+
+#ifndef WSS_LOG_SEEK_STRIDE
+#define WSS_LOG_SEEK_STRIDE 64 // one sample every N lines
+#endif
+
+// One sample: the line starting at `offset` has this seq/ts. 12 bytes on card.
+struct WssLogSeekSample {
+  uint32_t seq = 0;
+  uint32_t ts = 0;     // epoch seconds, 0 when the line had no valid time
+  uint32_t offset = 0; // byte offset of the line in the day file
+};
+
+// Parses `"seq":<n>` and `"ts":"YYYY-MM-DDTHH:MM:SSZ"` from a JSONL line. ts_out is 0 when
+// the time is missing, malformed, or flagged `"time_valid":false`.
+bool wss_log_line_seq_ts(const char* line, uint32_t& seq_out, uint32_t& ts_out);
+
+// "YYYY-MM-DDTHH:MM[:SS][Z]" (UTC) to epoch seconds; 0 when malformed.
+uint32_t wss_iso8601_to_epoch(const char* s);
+
+class WssLogSeekIndex {
+ public:
+  // Sidecar path for a day file ("....txt" -> "....idx").
+  static String path_for(const String& log_path);
+
+  // Starts sampling for the active day file. An existing sidecar keeps its samples
+  // (a torn trailing record is cut off); the next line is always sampled.
+  void begin(WssStorageBackend* fs, const String& log_path);
+  void end();
+
+  // Called for every line appended at `offset`.
+  void note_line(const char* line, uint64_t offset);
+
+  // Appends buffered samples to the sidecar (called on SD flush).
+  bool flush();
+
+  uint32_t samples_written() const { return _samples_written; }
+
+  // Narrows [start, end) of a day file for a query using its sidecar. A bound of 0 means
+  // "unbounded". Without a sidecar the whole file is returned.
+  static void lookup(WssStorageBackend* fs, const String& log_path, uint32_t from_seq,
+                     uint32_t to_seq, uint32_t from_ts, uint32_t to_ts, uint64_t file_size,
+                     uint64_t& start, uint64_t& end);
+
+ private:
+  static const size_t kPendingMax = 16;
+
+  WssStorageBackend* _fs = nullptr;
+  String _path;
+  WssLogSeekSample _pending[kPendingMax];
+  size_t _pending_count = 0;
+  uint32_t _lines_since_sample = 0;
+  uint32_t _samples_written = 0;
+};
@@ -0,0 +1,82 @@
+// src/storage/log_write_behind.cpp
+// Role: Write-behind byte ring between the log writer and the active SD day file.
+
+#include "log_write_behind.h"
+
+#include <string.h>
+
+bool WssLogWriteBehind::begin(uint8_t* buf, size_t capacity) {
+  capacity -= capacity % kSectorBytes;
+  if (!buf || capacity == 0) {
+    _buf = nullptr;
+    _capacity = 0;
+    return false;
+  }
+  _buf = buf;
+  _capacity = capacity;
+  _high_water = 0;
+  reset(0);
+  return true;
+}
+
+void WssLogWriteBehind::reset(uint64_t offset) {
+  _start = offset;
+  _end = offset;
+}
+
+size_t WssLogWriteBehind::append(const uint8_t* data, size_t len) {
+  if (!_buf) return 0;
+  if (len > room()) len = room();
+  size_t done = 0;
+  while (done < len) {
+    const size_t pos = (size_t)(_end % _capacity);
+    size_t n = _capacity - pos;
+    if (n > len - done) n = len - done;
+    memcpy(_buf + pos, data + done, n);
+    _end += n;
+    done += n;
+  }
+  if (used() > _high_water) _high_water = used();
+  return len;
+}
+
+size_t WssLogWriteBehind::span(uint64_t off, const uint8_t*& p, size_t max) const {
+  p = nullptr;
+  if (!_buf || off < _start || off >= _end) return 0;
+  const size_t pos = (size_t)(off % _capacity);
+  size_t n = _capacity - pos;
+  if (n > _end - off) n = (size_t)(_end - off);
+  if (n > max) n = max;
+  p = _buf + pos;
+  return n;
+}
+
+void WssLogWriteBehind::release(uint64_t off) {
+  if (off > _end) off = _end;
+  if (off > _start) _start = off;
+}
+
+uint64_t WssLogWriteBehind::after_last_newline(uint64_t from, uint64_t to) const {
+  if (from < _start) from = _start;
+  if (to > _end) to = _end;
+  for (uint64_t off = to; off > from; off--) {
+    if (at(off - 1) == '\n') return off;
+  }
+  return from;
+}
+
+uint64_t WssLogWriteBehind::read_line(uint64_t off, String& out) const {
+  out = "";
+  if (off < _start) return 0;
+  uint64_t nl = off;
+  while (nl < _end && at(nl) != '\n') nl++;
+  if (nl >= _end) return 0;
+  if (!out.reserve((unsigned)(nl - off))) return 0;
+  while (off < nl) {
+    const uint8_t* p = nullptr;
+    size_t n = span(off, p, (size_t)(nl - off));
+    out.concat(reinterpret_cast<const char*>(p), n);
+    off += n;
+  }
+  return nl + 1;
+}
@@ -0,0 +1,67 @@
+// src/storage/log_write_behind.h
+// Role: Write-behind byte ring between the log writer and the active SD day file (PSRAM on
+// boards that have it), drained in large sector-aligned sequential writes.
+#pragma once
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Ring size in bytes (a multiple of 512). 0 keeps a single 512-byte sector stage; the S3
+// build raises it (the ring lives in PSRAM there).
+#ifndef WSS_LOG_WRITE_BEHIND_BYTES
+#define WSS_LOG_WRITE_BEHIND_BYTES 0
+#endif
+// Staged full sectors are written out once this many bytes of them have piled up.
+#ifndef WSS_LOG_WRITE_BEHIND_CHUNK_BYTES
+#define WSS_LOG_WRITE_BEHIND_CHUNK_BYTES 16384
+#endif
+// An SD write or flush taking at least this long is counted as a stall.
+#ifndef WSS_LOG_SD_STALL_MS
+#define WSS_LOG_SD_STALL_MS 50
+#endif
+
+// Bytes are addressed by their offset in the day file: the ring holds [start(), end()),
+// end() being the file's logical EOF. The owner writes spans out and release()s the bytes
+// it no longer needs. The capacity is a multiple of the 512-byte sector, so a span that
+// starts on a sector boundary never wraps mid-sector. Not thread-safe: the owner
+// serializes access.
+class WssLogWriteBehind {
+ public:
+  static const size_t kSectorBytes = 512;
+
+  bool begin(uint8_t* buf, size_t capacity);
+  bool ok() const { return _buf != nullptr; }
+  // Empties the ring; the next byte appended lands at file offset `offset`.
+  void reset(uint64_t offset);
+
+  size_t capacity() const { return _capacity; }
+  uint64_t start() const { return _start; }
+  uint64_t end() const { return _end; }
+  size_t used() const { return (size_t)(_end - _start); }
+  size_t room() const { return _capacity - used(); }
+  size_t high_water() const { return _high_water; }
+
+  // Appends up to room() bytes. Returns the number taken.
+  size_t append(const uint8_t* data, size_t len);
+  // Contiguous bytes at file offset `off` (start() <= off < end()), at most `max`.
+  size_t span(uint64_t off, const uint8_t*& p, size_t max) const;
+  // Drops the bytes before `off`.
+  void release(uint64_t off);
+
+  // Offset just past the last '\n' in [from, to), or `from` when there is none.
+  uint64_t after_last_newline(uint64_t from, uint64_t to) const;
+  // Copies the complete line starting at `off` (without its '\n') to `out`. Returns the
+  // offset just past the '\n', or 0 when no complete line starts there.
+  uint64_t read_line(uint64_t off, String& out) const;
+
+ private:
+  uint8_t at(uint64_t off) const { return _buf[off % _capacity]; }
+
+  uint8_t* _buf = nullptr;
+  size_t _capacity = 0;
+  uint64_t _start = 0;
+  uint64_t _end = 0;
+  size_t _high_water = 0;
+};
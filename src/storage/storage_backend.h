@@ -0,0 +1,111 @@
+// src/storage/storage_backend.h
+// Role: File-level storage backend interface used by the SD log tier (day files, index,
+// seek index, chain state, archives, retention), so that code runs on the card, in RAM or
+// on a host directory alike.
+#pragma once
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Open flags (WssStorageBackend::open).
+enum WssStorageOpenFlags : uint8_t {
+  WSS_FS_READ = 0x01,
+  WSS_FS_WRITE = 0x02,
+  WSS_FS_RDWR = WSS_FS_READ | WSS_FS_WRITE,
+  WSS_FS_CREATE = 0x04,  // create when missing
+  WSS_FS_TRUNC = 0x08,   // cut to 0 bytes on open
+  WSS_FS_APPEND = 0x10,  // every write goes to the end
+};
+
+// One open file; implemented per backend. Offsets are absolute byte positions.
+class WssStorageFileImpl {
+ public:
+  virtual ~WssStorageFileImpl() = default;
+  virtual int32_t read(void* buf, size_t len) = 0;         // bytes read, -1 on error
+  virtual size_t write(const void* buf, size_t len) = 0;   // bytes written
+  virtual bool seek(uint64_t pos) = 0;
+  virtual uint64_t position() const = 0;
+  virtual uint64_t size() const = 0;
+  virtual bool truncate(uint64_t len) = 0;
+  virtual bool sync() = 0;
+  // Reserves contiguous space past the end without changing size(). Best-effort.
+  virtual bool preallocate(uint64_t len) {
+    (void)len;
+    return false;
+  }
+};
+
+// Owning, move-only handle (closes on destruction). A default-constructed or failed
+// open converts to false.
+class WssStorageFile {
+ public:
+  WssStorageFile() = default;
+  explicit WssStorageFile(WssStorageFileImpl* impl) : _impl(impl) {}
+  ~WssStorageFile() { close(); }
+  WssStorageFile(WssStorageFile&& o) : _impl(o._impl) { o._impl = nullptr; }
+  WssStorageFile& operator=(WssStorageFile&& o) {
+    if (this != &o) {
+      close();
+      _impl = o._impl;
+      o._impl = nullptr;
+    }
+    return *this;
+  }
+  WssStorageFile(const WssStorageFile&) = delete;
+  WssStorageFile& operator=(const WssStorageFile&) = delete;
+
+  explicit operator bool() const { return _impl != nullptr; }
+
+  int32_t read(void* buf, size_t len) { return _impl ? _impl->read(buf, len) : -1; }
+  size_t write(const void* buf, size_t len) { return _impl ? _impl->write(buf, len) : 0; }
+  bool seek(uint64_t pos) { return _impl && _impl->seek(pos); }
+  uint64_t position() const { return _impl ? _impl->position() : 0; }
+  uint64_t size() const { return _impl ? _impl->size() : 0; }
+  bool truncate(uint64_t len) { return _impl && _impl->truncate(len); }
+  bool sync() { return _impl && _impl->sync(); }
+  bool preallocate(uint64_t len) { return _impl && _impl->preallocate(len); }
+  void close() {
+    delete _impl;
+    _impl = nullptr;
+  }
+
+ private:
+  WssStorageFileImpl* _impl = nullptr;
+};
+
+struct WssStorageDirEntry {
+  const char* name = "";  // entry name only (no directory part)
+  bool is_dir = false;
+  uint64_t size = 0;
+};
+
+// Return false to stop the listing early.
+typedef bool (*WssStorageListFn)(const WssStorageDirEntry& e, void* ctx);
+
+// Paths are absolute ("/logs/2026/01/events_2026-01-23.txt"). Implementations:
+// WssSdBackend (SdFat card), WssRamBackend (heap), WssPosixBackend (host directory), and
+// two decorators: WssFaultBackend injects slow writes, ENOSPC and torn writes, and
+// WssTimedBackend keeps latency histograms. The flash-ring tier has its own device
+// interface (WssFlashDevice).
+class WssStorageBackend {
+ public:
+  virtual ~WssStorageBackend() = default;
+  virtual const char* name() const = 0;
+
+  // Returns a closed handle on failure. Directories cannot be opened.
+  virtual WssStorageFile open(const char* path, uint8_t flags) = 0;
+  virtual bool exists(const char* path) = 0;
+  virtual bool stat(const char* path, uint64_t& size, bool& is_dir) = 0;
+  virtual bool remove(const char* path) = 0;  // files only
+  virtual bool rename(const char* from, const char* to) = 0;  // fails when `to` exists
+  virtual bool mkdir(const char* path) = 0;   // one level; the parent must exist
+  // Calls `fn` for each entry of `dir` (not recursive, no "." / ".."). False when `dir`
+  // cannot be listed.
+  virtual bool list(const char* dir, WssStorageListFn fn, void* ctx) = 0;
+  // Volume size and free space in bytes. False when unknown.
+  virtual bool space(uint64_t& total, uint64_t& free_bytes) = 0;
+  // Cheap liveness check (card still answering). Backends that cannot vanish say true.
+  virtual bool probe() { return true; }
+};
@@ -0,0 +1,82 @@
+// src/storage/storage_backend_fault.cpp
+// Role: Fault-injecting WssStorageBackend decorator.
+
+#include "storage_backend_fault.h"
+
+#include <new>
+#include <utility>
+
+class WssFaultBackend::FileImpl : public WssStorageFileImpl {
+ public:
+  FileImpl(WssFaultBackend* fs, WssStorageFile&& f) : _fs(fs), _f(std::move(f)) {}
+
+  int32_t read(void* buf, size_t len) override { return _f.read(buf, len); }
+
+  size_t write(const void* buf, size_t len) override {
+    const WssStorageFaults& fl = _fs->_faults;
+    WssStorageFaultStats& st = _fs->_stats;
+    st.writes++;
+    uint32_t wait = fl.write_delay_ms;
+    if (fl.stall_every && fl.stall_ms && st.writes % fl.stall_every == 0) {
+      wait += fl.stall_ms;
+      st.stalls++;
+    }
+    if (wait) delay(wait);
+
+    size_t n = _fs->budget(len);
+    const bool torn = fl.torn_write_at && st.writes == fl.torn_write_at;
+    if (torn && n > len / 2) n = len / 2;
+    size_t done = n ? _f.write(buf, n) : 0;
+    st.bytes_written += done;
+    if (done < len) st.short_writes++;
+    if (torn) st.torn_writes++;
+    return done;
+  }
+
+  bool seek(uint64_t pos) override { return _f.seek(pos); }
+  uint64_t position() const override { return _f.position(); }
+  uint64_t size() const override { return _f.size(); }
+  bool truncate(uint64_t len) override { return _f.truncate(len); }
+
+  bool sync() override {
+    if (_fs->_faults.sync_delay_ms) delay(_fs->_faults.sync_delay_ms);
+    bool ok = _f.sync();
+    if (_fs->_faults.fail_sync) {
+      _fs->_stats.failed_syncs++;
+      return false;
+    }
+    return ok;
+  }
+
+  bool preallocate(uint64_t len) override { return _f.preallocate(len); }
+
+ private:
+  WssFaultBackend* _fs;
+  WssStorageFile _f;
+};
+
+size_t WssFaultBackend::budget(size_t len) const {
+  if (!_faults.space_bytes) return len;
+  if (_stats.bytes_written >= _faults.space_bytes) return 0;
+  const uint64_t left = _faults.space_bytes - _stats.bytes_written;
+  return left < len ? (size_t)left : len;
+}
+
+WssStorageFile WssFaultBackend::open(const char* path, uint8_t flags) {
+  if (_faults.fail_open && (flags & (WSS_FS_WRITE | WSS_FS_CREATE))) return WssStorageFile();
+  WssStorageFile f = _inner->open(path, flags);
+  if (!f) return f;
+  FileImpl* impl = new (std::nothrow) FileImpl(this, std::move(f));
+  return impl ? WssStorageFile(impl) : WssStorageFile();
+}
+
+bool WssFaultBackend::space(uint64_t& total, uint64_t& free_bytes) {
+  if (!_inner->space(total, free_bytes)) return false;
+  if (_faults.space_bytes) {
+    const uint64_t left = _faults.space_bytes > _stats.bytes_written
+                              ? _faults.space_bytes - _stats.bytes_written
+                              : 0;
+    if (left < free_bytes) free_bytes = left;
+  }
+  return true;
+}
@@ -0,0 +1,67 @@
+// src/storage/storage_backend_fault.h
+// Role: WssStorageBackend decorator that injects card faults (slow writes, full volume,
+// torn writes, failed syncs) into another backend, to exercise the log tier's error paths.
+#pragma once
+
+#include <Arduino.h>
+
+#include "storage_backend.h"
+
+struct WssStorageFaults {
+  uint32_t write_delay_ms = 0;  // added to every write (slow card)
+  uint32_t stall_every = 0;     // every Nth write also stalls...
+  uint32_t stall_ms = 0;        // ...for this long (0 = off)
+  uint32_t sync_delay_ms = 0;   // added to every sync
+  uint64_t space_bytes = 0;     // writes past this many bytes in total come up short (ENOSPC)
+  uint32_t torn_write_at = 0;   // the Nth write (1-based) stores only its first half and fails
+  bool fail_sync = false;       // every sync reports failure (data is still synced)
+  bool fail_open = false;       // opens for writing fail (card went read-only / vanished)
+  bool fail_probe = false;      // probe() reports the card gone
+};
+
+struct WssStorageFaultStats {
+  uint32_t writes = 0;
+  uint64_t bytes_written = 0;
+  uint32_t stalls = 0;
+  uint32_t short_writes = 0;    // ENOSPC and torn writes
+  uint32_t torn_writes = 0;
+  uint32_t failed_syncs = 0;
+};
+
+// Faults apply to files opened after set_faults(); counters cover all of them. The inner
+// backend must outlive this one, and handles must not outlive either.
+class WssFaultBackend : public WssStorageBackend {
+ public:
+  explicit WssFaultBackend(WssStorageBackend* inner) : _inner(inner) {}
+
+  void set_faults(const WssStorageFaults& f) { _faults = f; }
+  const WssStorageFaults& faults() const { return _faults; }
+  const WssStorageFaultStats& fault_stats() const { return _stats; }
+  void reset_stats() { _stats = WssStorageFaultStats(); }
+
+  const char* name() const override { return "fault"; }
+  WssStorageFile open(const char* path, uint8_t flags) override;
+  bool exists(const char* path) override { return _inner->exists(path); }
+  bool stat(const char* path, uint64_t& size, bool& is_dir) override {
+    return _inner->stat(path, size, is_dir);
+  }
+  bool remove(const char* path) override { return _inner->remove(path); }
+  bool rename(const char* from, const char* to) override { return _inner->rename(from, to); }
+  bool mkdir(const char* path) override { return !_faults.fail_open && _inner->mkdir(path); }
+  bool list(const char* dir, WssStorageListFn fn, void* ctx) override {
+    return _inner->list(dir, fn, ctx);
+  }
+  bool space(uint64_t& total, uint64_t& free_bytes) override;
+  bool probe() override { return !_faults.fail_probe && _inner->probe(); }
+
+ private:
+  class FileImpl;
+  friend class FileImpl;
+
+  // Bytes the next write may store (ENOSPC budget); SIZE_MAX when unlimited.
+  size_t budget(size_t len) const;
+
+  WssStorageBackend* _inner;
+  WssStorageFaults _faults;
+  WssStorageFaultStats _stats;
+};
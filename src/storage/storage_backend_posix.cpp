@@ -0,0 +1,153 @@
+// src/storage/storage_backend_posix.cpp
+// Role: WssStorageBackend over a host directory.
+
+#include "storage_backend_posix.h"
+
+#if !defined(ARDUINO)
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <new>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+namespace {
+
+class PosixFileImpl : public WssStorageFileImpl {
+ public:
+  explicit PosixFileImpl(int fd) : _fd(fd) {}
+  ~PosixFileImpl() override { ::close(_fd); }
+
+  int32_t read(void* buf, size_t len) override {
+    ssize_t n;
+    do {
+      n = ::read(_fd, buf, len);
+    } while (n < 0 && errno == EINTR);
+    return n < 0 ? -1 : (int32_t)n;
+  }
+
+  size_t write(const void* buf, size_t len) override {
+    const uint8_t* p = static_cast<const uint8_t*>(buf);
+    size_t done = 0;
+    while (done < len) {
+      ssize_t n = ::write(_fd, p + done, len - done);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) break; // ENOSPC etc.: report the short count
+      done += (size_t)n;
+    }
+    return done;
+  }
+
+  bool seek(uint64_t pos) override { return ::lseek(_fd, (off_t)pos, SEEK_SET) >= 0; }
+  uint64_t position() const override {
+    off_t at = ::lseek(_fd, 0, SEEK_CUR);
+    return at < 0 ? 0 : (uint64_t)at;
+  }
+  uint64_t size() const override {
+    struct stat st;
+    return ::fstat(_fd, &st) == 0 ? (uint64_t)st.st_size : 0;
+  }
+  bool truncate(uint64_t len) override { return ::ftruncate(_fd, (off_t)len) == 0; }
+  bool sync() override { return ::fsync(_fd) == 0; }
+
+ private:
+  int _fd;
+};
+
+}  // namespace
+
+String WssPosixBackend::host_path(const char* path) const {
+  String p = _root;
+  if (path[0] != '/') p += '/';
+  p += path;
+  return p;
+}
+
+WssStorageFile WssPosixBackend::open(const char* path, uint8_t flags) {
+  int oflag = 0;
+  if ((flags & WSS_FS_RDWR) == WSS_FS_RDWR) {
+    oflag = O_RDWR;
+  } else if (flags & WSS_FS_WRITE) {
+    oflag = O_WRONLY;
+  } else {
+    oflag = O_RDONLY;
+  }
+  if (flags & WSS_FS_CREATE) oflag |= O_CREAT;
+  if (flags & WSS_FS_TRUNC) oflag |= O_TRUNC;
+  if (flags & WSS_FS_APPEND) oflag |= O_APPEND;
+
+  String hp = host_path(path);
+  struct stat st;
+  if (::stat(hp.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) return WssStorageFile();
+  int fd = ::open(hp.c_str(), oflag | O_CLOEXEC, 0644);
+  if (fd < 0) return WssStorageFile();
+  PosixFileImpl* impl = new (std::nothrow) PosixFileImpl(fd);
+  if (!impl) {
+    ::close(fd);
+    return WssStorageFile();
+  }
+  return WssStorageFile(impl);
+}
+
+bool WssPosixBackend::exists(const char* path) {
+  struct stat st;
+  return ::stat(host_path(path).c_str(), &st) == 0;
+}
+
+bool WssPosixBackend::stat(const char* path, uint64_t& size, bool& is_dir) {
+  struct stat st;
+  if (::stat(host_path(path).c_str(), &st) != 0) return false;
+  is_dir = S_ISDIR(st.st_mode);
+  size = is_dir ? 0 : (uint64_t)st.st_size;
+  return true;
+}
+
+bool WssPosixBackend::remove(const char* path) {
+  return ::unlink(host_path(path).c_str()) == 0;
+}
+
+bool WssPosixBackend::rename(const char* from, const char* to) {
+  // Same contract as the SD backend: never replaces an existing file.
+  if (exists(to)) return false;
+  return ::rename(host_path(from).c_str(), host_path(to).c_str()) == 0;
+}
+
+bool WssPosixBackend::mkdir(const char* path) {
+  return ::mkdir(host_path(path).c_str(), 0755) == 0;
+}
+
+bool WssPosixBackend::list(const char* dir, WssStorageListFn fn, void* ctx) {
+  String hp = host_path(dir);
+  DIR* d = ::opendir(hp.c_str());
+  if (!d) return false;
+  while (struct dirent* de = ::readdir(d)) {
+    if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) continue;
+    String child = hp + "/" + de->d_name;
+    struct stat st;
+    if (::stat(child.c_str(), &st) != 0) continue;
+    WssStorageDirEntry e;
+    e.name = de->d_name;
+    e.is_dir = S_ISDIR(st.st_mode);
+    e.size = e.is_dir ? 0 : (uint64_t)st.st_size;
+    if (!fn(e, ctx)) break;
+  }
+  ::closedir(d);
+  return true;
+}
+
+bool WssPosixBackend::space(uint64_t& total, uint64_t& free_bytes) {
+  struct statvfs vfs;
+  if (::statvfs(_root.c_str(), &vfs) != 0) return false;
+  total = (uint64_t)vfs.f_blocks * vfs.f_frsize;
+  free_bytes = (uint64_t)vfs.f_bavail * vfs.f_frsize;
+  return true;
+}
+
+bool WssPosixBackend::probe() {
+  struct stat st;
+  return ::stat(_root.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+#endif  // !ARDUINO
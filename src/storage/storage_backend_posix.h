@@ -0,0 +1,35 @@
+// src/storage/storage_backend_posix.h
+// Role: WssStorageBackend over a host directory (Linux/macOS builds of the log pipeline:
+// benchmarks, fault runs, replaying a card image). Not built for the device.
+#pragma once
+
+#if !defined(ARDUINO)
+
+#include <Arduino.h>
+
+#include "storage_backend.h"
+
+// Backend paths are resolved under `root` ("/logs/x" -> "<root>/logs/x"); the root
+// directory must exist. sync() is fsync(2), so timings include the host's write-back.
+class WssPosixBackend : public WssStorageBackend {
+ public:
+  explicit WssPosixBackend(const char* root) : _root(root) {}
+
+  const char* name() const override { return "posix"; }
+  WssStorageFile open(const char* path, uint8_t flags) override;
+  bool exists(const char* path) override;
+  bool stat(const char* path, uint64_t& size, bool& is_dir) override;
+  bool remove(const char* path) override;
+  bool rename(const char* from, const char* to) override;
+  bool mkdir(const char* path) override;
+  bool list(const char* dir, WssStorageListFn fn, void* ctx) override;
+  bool space(uint64_t& total, uint64_t& free_bytes) override;
+  bool probe() override;
+
+ private:
+  String host_path(const char* path) const;
+
+  String _root;
+};
+
+#endif  // !ARDUINO
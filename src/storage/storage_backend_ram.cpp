@@ -0,0 +1,229 @@
+// src/storage/storage_backend_ram.cpp
+// Role: WssStorageBackend held entirely in heap memory.
+
+#include "storage_backend_ram.h"
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+class WssRamBackend::FileImpl : public WssStorageFileImpl {
+ public:
+  FileImpl(WssRamBackend* fs, Node* n, bool readable, bool writable, bool append)
+      : _fs(fs), _n(n), _read(readable), _write(writable), _append(append) {
+    _n->refs++;
+  }
+  ~FileImpl() override { _fs->release(_n); }
+
+  int32_t read(void* buf, size_t len) override {
+    if (!_read) return -1;
+    if (_pos >= _n->size) return 0;
+    size_t n = _n->size - (size_t)_pos;
+    if (n > len) n = len;
+    memcpy(buf, _n->data + _pos, n);
+    _pos += n;
+    return (int32_t)n;
+  }
+
+  size_t write(const void* buf, size_t len) override {
+    if (!_write || _n->unlinked) return 0;
+    if (_append) _pos = _n->size;
+    size_t end = (size_t)_pos + len;
+    if (end > _n->size) {
+      // Past the capacity cap: take what fits, like a full card.
+      uint64_t grow = end - _n->size;
+      const uint64_t room = _fs->_capacity ? _fs->_capacity - _fs->_used : grow;
+      if (grow > room) grow = room;
+      end = _n->size + (size_t)grow;
+      if (end <= _pos || !_fs->resize(_n, end)) return 0;
+      len = end - (size_t)_pos;
+    }
+    memcpy(_n->data + _pos, buf, len);
+    _pos += len;
+    return len;
+  }
+
+  bool seek(uint64_t pos) override {
+    if (pos > _n->size) return false;
+    _pos = pos;
+    return true;
+  }
+  uint64_t position() const override { return _pos; }
+  uint64_t size() const override { return _n->size; }
+  bool truncate(uint64_t len) override {
+    if (!_write || len > _n->size || !_fs->resize(_n, (size_t)len)) return false;
+    if (_pos > len) _pos = len;
+    return true;
+  }
+  bool sync() override { return _write && !_n->unlinked; }
+
+ private:
+  WssRamBackend* _fs;
+  Node* _n;
+  bool _read;
+  bool _write;
+  bool _append;
+  uint64_t _pos = 0;
+};
+
+WssRamBackend::~WssRamBackend() {
+  // Handles must not outlive the backend.
+  for (size_t i = 0; i < _count; i++) {
+    free(_nodes[i]->data);
+    delete _nodes[i];
+  }
+  free(_nodes);
+}
+
+WssRamBackend::Node* WssRamBackend::find(const char* path) const {
+  for (size_t i = 0; i < _count; i++) {
+    if (!_nodes[i]->unlinked && _nodes[i]->path == path) return _nodes[i];
+  }
+  return nullptr;
+}
+
+bool WssRamBackend::parent_is_dir(const char* path) const {
+  const char* slash = strrchr(path, '/');
+  if (!slash || path[0] != '/') return false;
+  if (slash == path) return true; // under "/"
+  String parent(path);
+  parent.remove((unsigned)(slash - path));
+  Node* p = find(parent.c_str());
+  return p && p->is_dir;
+}
+
+bool WssRamBackend::resize(Node* n, size_t size) {
+  if (size > n->size && _capacity && _used + (size - n->size) > _capacity) return false;
+  if (size > n->cap) {
+    size_t cap = n->cap ? n->cap : 256;
+    while (cap < size) cap *= 2;
+    uint8_t* p = static_cast<uint8_t*>(realloc(n->data, cap));
+    if (!p) return false;
+    n->data = p;
+    n->cap = cap;
+  }
+  _used = _used - n->size + size;
+  n->size = size;
+  return true;
+}
+
+void WssRamBackend::drop(size_t i) {
+  Node* n = _nodes[i];
+  _used -= n->size;
+  free(n->data);
+  delete n;
+  _nodes[i] = _nodes[--_count];
+}
+
+void WssRamBackend::release(Node* n) {
+  if (n->refs > 0) n->refs--;
+  if (n->refs > 0 || !n->unlinked) return;
+  for (size_t i = 0; i < _count; i++) {
+    if (_nodes[i] == n) {
+      drop(i);
+      return;
+    }
+  }
+}
+
+WssStorageFile WssRamBackend::open(const char* path, uint8_t flags) {
+  Node* n = find(path);
+  if (n && n->is_dir) return WssStorageFile();
+  if (!n) {
+    if (!(flags & WSS_FS_CREATE) || !parent_is_dir(path)) return WssStorageFile();
+    if (_count == _slots) {
+      size_t slots = _slots ? _slots * 2 : 16;
+      Node** p = static_cast<Node**>(realloc(_nodes, slots * sizeof(Node*)));
+      if (!p) return WssStorageFile();
+      _nodes = p;
+      _slots = slots;
+    }
+    n = new (std::nothrow) Node();
+    if (!n) return WssStorageFile();
+    n->path = path;
+    _nodes[_count++] = n;
+  }
+  const bool writable = (flags & WSS_FS_WRITE) != 0;
+  if ((flags & WSS_FS_TRUNC) && writable) (void)resize(n, 0);
+  FileImpl* impl = new (std::nothrow)
+      FileImpl(this, n, (flags & WSS_FS_READ) != 0, writable, (flags & WSS_FS_APPEND) != 0);
+  return impl ? WssStorageFile(impl) : WssStorageFile();
+}
+
+bool WssRamBackend::stat(const char* path, uint64_t& size, bool& is_dir) {
+  if (strcmp(path, "/") == 0) {
+    size = 0;
+    is_dir = true;
+    return true;
+  }
+  Node* n = find(path);
+  if (!n) return false;
+  size = n->size;
+  is_dir = n->is_dir;
+  return true;
+}
+
+bool WssRamBackend::remove(const char* path) {
+  for (size_t i = 0; i < _count; i++) {
+    Node* n = _nodes[i];
+    if (n->unlinked || n->is_dir || n->path != path) continue;
+    if (n->refs > 0) {
+      n->unlinked = true;
+    } else {
+      drop(i);
+    }
+    return true;
+  }
+  return false;
+}
+
+bool WssRamBackend::rename(const char* from, const char* to) {
+  Node* n = find(from);
+  if (!n || n->is_dir || find(to) || !parent_is_dir(to)) return false;
+  n->path = to;
+  return true;
+}
+
+bool WssRamBackend::mkdir(const char* path) {
+  if (strcmp(path, "/") == 0 || find(path) || !parent_is_dir(path)) return false;
+  if (_count == _slots) {
+    size_t slots = _slots ? _slots * 2 : 16;
+    Node** p = static_cast<Node**>(realloc(_nodes, slots * sizeof(Node*)));
+    if (!p) return false;
+    _nodes = p;
+    _slots = slots;
+  }
+  Node* n = new (std::nothrow) Node();
+  if (!n) return false;
+  n->path = path;
+  n->is_dir = true;
+  _nodes[_count++] = n;
+  return true;
+}
+
+bool WssRamBackend::list(const char* dir, WssStorageListFn fn, void* ctx) {
+  String prefix(dir);
+  if (prefix != "/") {
+    Node* d = find(dir);
+    if (!d || !d->is_dir) return false;
+    prefix += '/';
+  }
+  for (size_t i = 0; i < _count; i++) {
+    Node* n = _nodes[i];
+    if (n->unlinked || !n->path.startsWith(prefix)) continue;
+    const char* name = n->path.c_str() + prefix.length();
+    if (!*name || strchr(name, '/')) continue; // deeper level
+    WssStorageDirEntry e;
+    e.name = name;
+    e.is_dir = n->is_dir;
+    e.size = n->size;
+    if (!fn(e, ctx)) break;
+  }
+  return true;
+}
+
+bool WssRamBackend::space(uint64_t& total, uint64_t& free_bytes) {
+  total = _capacity;
+  free_bytes = _capacity > _used ? _capacity - _used : 0;
+  return _capacity != 0;
+}
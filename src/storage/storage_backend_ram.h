@@ -0,0 +1,57 @@
+// src/storage/storage_backend_ram.h
+// Role: WssStorageBackend held entirely in heap memory (benchmarks, fault tests, and boards
+// running the SD log tier without a card).
+#pragma once
+
+#include <Arduino.h>
+
+#include "storage_backend.h"
+
+// A flat table of paths; "/" always exists. Open handles share the file's bytes, and a
+// removed file stays readable through handles opened before. `capacity_bytes` caps the
+// sum of file sizes (writes past it come up short, like a full card); 0 = heap-limited.
+class WssRamBackend : public WssStorageBackend {
+ public:
+  explicit WssRamBackend(uint64_t capacity_bytes = 0) : _capacity(capacity_bytes) {}
+  ~WssRamBackend() override;
+  WssRamBackend(const WssRamBackend&) = delete;
+  WssRamBackend& operator=(const WssRamBackend&) = delete;
+
+  const char* name() const override { return "ram"; }
+  WssStorageFile open(const char* path, uint8_t flags) override;
+  bool exists(const char* path) override { return find(path) != nullptr; }
+  bool stat(const char* path, uint64_t& size, bool& is_dir) override;
+  bool remove(const char* path) override;
+  bool rename(const char* from, const char* to) override;
+  bool mkdir(const char* path) override;
+  bool list(const char* dir, WssStorageListFn fn, void* ctx) override;
+  bool space(uint64_t& total, uint64_t& free_bytes) override;
+
+  uint64_t used_bytes() const { return _used; }
+
+ private:
+  class FileImpl;
+  friend class FileImpl;
+
+  struct Node {
+    String path;
+    bool is_dir = false;
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t cap = 0;
+    uint32_t refs = 0;     // open handles
+    bool unlinked = false; // removed while open; freed with the last handle
+  };
+
+  Node* find(const char* path) const;
+  bool parent_is_dir(const char* path) const;
+  bool resize(Node* n, size_t size); // grows/shrinks size; false when out of space
+  void release(Node* n);
+  void drop(size_t i);
+
+  Node** _nodes = nullptr;
+  size_t _count = 0;
+  size_t _slots = 0;
+  uint64_t _capacity;
+  uint64_t _used = 0;
+};
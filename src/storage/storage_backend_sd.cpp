@@ -0,0 +1,110 @@
+// src/storage/storage_backend_sd.cpp
+// Role: WssStorageBackend over an SdFat volume.
+
+#include "storage_backend_sd.h"
+
+#if WSS_FEATURE_SD
+
+#include <new>
+
+namespace {
+
+class SdFileImpl : public WssStorageFileImpl {
+ public:
+  explicit SdFileImpl(const FsFile& f) : _f(f) {}
+  ~SdFileImpl() override { _f.close(); }
+  int32_t read(void* buf, size_t len) override { return _f.read(buf, len); }
+  size_t write(const void* buf, size_t len) override { return _f.write(buf, len); }
+  bool seek(uint64_t pos) override { return _f.seekSet(pos); }
+  uint64_t position() const override { return const_cast<FsFile&>(_f).curPosition(); }
+  uint64_t size() const override { return const_cast<FsFile&>(_f).fileSize(); }
+  bool truncate(uint64_t len) override { return _f.truncate(len); }
+  bool sync() override { return _f.sync(); }
+  bool preallocate(uint64_t len) override { return _f.preAllocate(len); }
+
+ private:
+  FsFile _f;
+};
+
+oflag_t to_oflag(uint8_t flags) {
+  oflag_t o = 0;
+  if ((flags & WSS_FS_RDWR) == WSS_FS_RDWR) o = O_RDWR;
+  else if (flags & WSS_FS_WRITE) o = O_WRONLY;
+  else o = O_RDONLY;
+  if (flags & WSS_FS_CREATE) o |= O_CREAT;
+  if (flags & WSS_FS_TRUNC) o |= O_TRUNC;
+  if (flags & WSS_FS_APPEND) o |= O_APPEND;
+  return o;
+}
+
+}  // namespace
+
+WssStorageFile WssSdBackend::open(const char* path, uint8_t flags) {
+  FsFile f = _sd->open(path, to_oflag(flags));
+  if (!f) return WssStorageFile();
+  if (f.isDir()) {
+    f.close();
+    return WssStorageFile();
+  }
+  SdFileImpl* impl = new (std::nothrow) SdFileImpl(f);
+  if (!impl) {
+    f.close();
+    return WssStorageFile();
+  }
+  return WssStorageFile(impl);
+}
+
+bool WssSdBackend::stat(const char* path, uint64_t& size, bool& is_dir) {
+  FsFile f = _sd->open(path, O_RDONLY);
+  if (!f) return false;
+  is_dir = f.isDir();
+  size = is_dir ? 0 : f.fileSize();
+  f.close();
+  return true;
+}
+
+bool WssSdBackend::list(const char* dir, WssStorageListFn fn, void* ctx) {
+  FsFile d = _sd->open(dir, O_RDONLY);
+  if (!d) return false;
+  if (!d.isDir()) {
+    d.close();
+    return false;
+  }
+  FsFile child;
+  char name[64];
+  while (child.openNext(&d, O_RDONLY)) {
+    name[0] = 0;
+    child.getName(name, sizeof(name));
+    WssStorageDirEntry e;
+    e.name = name;
+    e.is_dir = child.isDir();
+    e.size = e.is_dir ? 0 : child.fileSize();
+    child.close();
+    if (!fn(e, ctx)) break;
+  }
+  d.close();
+  return true;
+}
+
+bool WssSdBackend::space(uint64_t& total, uint64_t& free_bytes) {
+  total = 0;
+  free_bytes = 0;
+  if (_sd->card()) total = (uint64_t)_sd->card()->sectorCount() * 512ULL;
+  // FsVolume provides freeClusterCount()/sectorsPerCluster() for FAT/exFAT.
+  if (!_sd->vol()) return false;
+  uint64_t free_clusters = _sd->vol()->freeClusterCount();
+  uint64_t spc = _sd->vol()->sectorsPerCluster();
+  free_bytes = free_clusters * spc * 512ULL;
+  return true;
+}
+
+// One SEND_STATUS (CMD13) exchange, no FAT access. A card that was pulled answers 0xFF
+// bytes, which reads back as a non-zero R1 (or as the all-ones "no answer" value).
+bool WssSdBackend::probe() {
+  SdCard* card = _sd->card();
+  if (!card) return false;
+  const uint32_t st = card->status();
+  return st != 0xFFFFFFFFUL && (st & 0xFF00UL) == 0;
+}
+
+#endif
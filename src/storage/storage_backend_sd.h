@@ -0,0 +1,31 @@
+// src/storage/storage_backend_sd.h
+// Role: WssStorageBackend over an SdFat volume (the microSD log tier on the device).
+#pragma once
+
+#include <Arduino.h>
+
+#if WSS_FEATURE_SD
+#include <SdFat.h>
+
+#include "storage_backend.h"
+
+// The caller mounts the card (SdFs::begin); this only maps file operations onto it.
+class WssSdBackend : public WssStorageBackend {
+ public:
+  explicit WssSdBackend(SdFs* sd) : _sd(sd) {}
+
+  const char* name() const override { return "sd"; }
+  WssStorageFile open(const char* path, uint8_t flags) override;
+  bool exists(const char* path) override { return _sd->exists(path); }
+  bool stat(const char* path, uint64_t& size, bool& is_dir) override;
+  bool remove(const char* path) override { return _sd->remove(path); }
+  bool rename(const char* from, const char* to) override { return _sd->rename(from, to); }
+  bool mkdir(const char* path) override { return _sd->mkdir(path, false); }
+  bool list(const char* dir, WssStorageListFn fn, void* ctx) override;
+  bool space(uint64_t& total, uint64_t& free_bytes) override;
+  bool probe() override;
+
+ private:
+  SdFs* _sd;
+};
+#endif
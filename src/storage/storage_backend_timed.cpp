@@ -0,0 +1,108 @@
+// src/storage/storage_backend_timed.cpp
+// Role: Timing/accounting WssStorageBackend decorator.
+
+#include "storage_backend_timed.h"
+
+#include <new>
+#include <utility>
+
+const char* wss_storage_op_name(WssStorageOp op) {
+  switch (op) {
+    case WSS_STORAGE_OP_OPEN: return "open";
+    case WSS_STORAGE_OP_APPEND: return "append";
+    case WSS_STORAGE_OP_FLUSH: return "flush";
+    case WSS_STORAGE_OP_READ: return "read";
+    case WSS_STORAGE_OP_FREE_SPACE: return "free_space";
+    case WSS_STORAGE_OP_PROBE: return "probe";
+    default: return "?";
+  }
+}
+
+class WssTimedBackend::FileImpl : public WssStorageFileImpl {
+ public:
+  FileImpl(WssTimedBackend* fs, WssStorageFile&& f, bool append)
+      : _fs(fs), _f(std::move(f)), _append(append) {}
+
+  int32_t read(void* buf, size_t len) override {
+    const uint32_t start_us = micros();
+    int32_t n = _f.read(buf, len);
+    _fs->note(WSS_STORAGE_OP_READ, start_us);
+    return n;
+  }
+
+  size_t write(const void* buf, size_t len) override {
+    // Position and size are cached by the file object; no card access.
+    const uint64_t size = _f.size();
+    const uint64_t pos = _append ? size : _f.position();
+    const uint32_t start_us = micros();
+    size_t n = _f.write(buf, len);
+    _fs->note(WSS_STORAGE_OP_APPEND, start_us);
+    if (pos + n > size) _fs->_grown += pos + n - size;
+    return n;
+  }
+
+  bool seek(uint64_t pos) override { return _f.seek(pos); }
+  uint64_t position() const override { return _f.position(); }
+  uint64_t size() const override { return _f.size(); }
+
+  bool truncate(uint64_t len) override {
+    const uint64_t size = _f.size();
+    if (!_f.truncate(len)) return false;
+    if (len < size) _fs->_released += size - len;
+    return true;
+  }
+
+  bool sync() override {
+    const uint32_t start_us = micros();
+    bool ok = _f.sync();
+    _fs->note(WSS_STORAGE_OP_FLUSH, start_us);
+    return ok;
+  }
+
+  bool preallocate(uint64_t len) override { return _f.preallocate(len); }
+
+ private:
+  WssTimedBackend* _fs;
+  WssStorageFile _f;
+  bool _append;
+};
+
+WssStorageFile WssTimedBackend::open(const char* path, uint8_t flags) {
+  // A truncating open releases what the file held (only rare rewrites of small files).
+  uint64_t old_size = 0;
+  bool is_dir = false;
+  const bool trunc = (flags & WSS_FS_TRUNC) && (flags & WSS_FS_WRITE);
+  if (trunc && !_inner->stat(path, old_size, is_dir)) old_size = 0;
+
+  const uint32_t start_us = micros();
+  WssStorageFile f = _inner->open(path, flags);
+  note(WSS_STORAGE_OP_OPEN, start_us);
+  if (!f) return f;
+  if (trunc) _released += old_size;
+  FileImpl* impl =
+      new (std::nothrow) FileImpl(this, std::move(f), (flags & WSS_FS_APPEND) != 0);
+  return impl ? WssStorageFile(impl) : WssStorageFile();
+}
+
+bool WssTimedBackend::remove(const char* path) {
+  uint64_t size = 0;
+  bool is_dir = false;
+  const bool known = _inner->stat(path, size, is_dir);
+  if (!_inner->remove(path)) return false;
+  if (known && !is_dir) _released += size;
+  return true;
+}
+
+bool WssTimedBackend::space(uint64_t& total, uint64_t& free_bytes) {
+  const uint32_t start_us = micros();
+  bool ok = _inner->space(total, free_bytes);
+  note(WSS_STORAGE_OP_FREE_SPACE, start_us);
+  return ok;
+}
+
+bool WssTimedBackend::probe() {
+  const uint32_t start_us = micros();
+  bool ok = _inner->probe();
+  note(WSS_STORAGE_OP_PROBE, start_us);
+  return ok;
+}
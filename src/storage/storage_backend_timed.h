@@ -0,0 +1,66 @@
+// src/storage/storage_backend_timed.h
+// Role: WssStorageBackend decorator that times every card operation into per-operation
+// histograms and counts the bytes files grew and shrank by (free-space estimate).
+#pragma once
+
+#include <Arduino.h>
+
+#include "latency_hist.h"
+#include "storage_backend.h"
+
+// The SD free-space figure is re-read from the FAT this often (a full FAT scan); between
+// reads it is estimated from bytes_grown() / bytes_released().
+#ifndef WSS_SD_FREE_REFRESH_MS
+#define WSS_SD_FREE_REFRESH_MS 600000
+#endif
+
+enum WssStorageOp : uint8_t {
+  WSS_STORAGE_OP_OPEN = 0,
+  WSS_STORAGE_OP_APPEND, // any write
+  WSS_STORAGE_OP_FLUSH,  // sync
+  WSS_STORAGE_OP_READ,
+  WSS_STORAGE_OP_FREE_SPACE,
+  WSS_STORAGE_OP_PROBE,
+  WSS_STORAGE_OP_COUNT,
+};
+
+// Status/JSON key of an operation ("open", "append", ...).
+const char* wss_storage_op_name(WssStorageOp op);
+
+// Callers serialize access (the storage lock), as for the inner backend.
+class WssTimedBackend : public WssStorageBackend {
+ public:
+  explicit WssTimedBackend(WssStorageBackend* inner) : _inner(inner) {}
+
+  const WssLatencyHist& hist(WssStorageOp op) const { return _hist[op]; }
+  // Bytes added past EOF and released (truncate, remove) since boot. Directory entries and
+  // cluster rounding are not counted.
+  uint64_t bytes_grown() const { return _grown; }
+  uint64_t bytes_released() const { return _released; }
+
+  const char* name() const override { return _inner->name(); }
+  WssStorageFile open(const char* path, uint8_t flags) override;
+  bool exists(const char* path) override { return _inner->exists(path); }
+  bool stat(const char* path, uint64_t& size, bool& is_dir) override {
+    return _inner->stat(path, size, is_dir);
+  }
+  bool remove(const char* path) override;
+  bool rename(const char* from, const char* to) override { return _inner->rename(from, to); }
+  bool mkdir(const char* path) override { return _inner->mkdir(path); }
+  bool list(const char* dir, WssStorageListFn fn, void* ctx) override {
+    return _inner->list(dir, fn, ctx);
+  }
+  bool space(uint64_t& total, uint64_t& free_bytes) override;
+  bool probe() override;
+
+ private:
+  class FileImpl;
+  friend class FileImpl;
+
+  void note(WssStorageOp op, uint32_t start_us) { _hist[op].add(micros() - start_us); }
+
+  WssStorageBackend* _inner;
+  WssLatencyHist _hist[WSS_STORAGE_OP_COUNT];
+  uint64_t _grown = 0;
+  uint64_t _released = 0;
+};
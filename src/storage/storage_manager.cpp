@@ -4,6 +4,11 @@
 #include "storage_manager.h"
 
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include "../config/config_store.h"
@@ -11,15 +16,29 @@
 #include "../config/pin_policy.h"
 #include "../logging/event_logger.h"
 #include "flash_ring.h"
+#include "log_chain_state.h"
+#include "log_checkpoint.h"
+#include "log_flush_policy.h"
+#include "log_index.h"
+#include "log_query_filter.h"
+#include "log_record_codec.h"
+#include "log_retention.h"
+#include "log_seek_index.h"
+#include "log_write_behind.h"
+#include "storage_backend_sd.h"
+#include "storage_backend_timed.h"
 #include "time_manager.h"
 
+#include "../logging/log_chain_line.h"
 #include "../logging/sha256_hex.h"
+#include "../psram_alloc.h"
 
 #include "version.h"
 
 #if WSS_FEATURE_SD
 #include <SPI.h>
 #include <SdFat.h>
+#include <esp_system.h>
 #endif
 
 static WssStorageStatus g_status;
@@ -32,17 +51,365 @@ static uint32_t g_last_poll_ms = 0;
 
 #if WSS_FEATURE_SD
 static SdFs g_sd;
-static FsFile g_file;
+// Every file operation of the SD tier goes through the backend; only the mount and
+// the FAT type query use g_sd directly.
+static WssSdBackend g_sd_fs(&g_sd);
+static WssTimedBackend g_sd_timed(&g_sd_fs); // per-operation latency + free-space accounting
+static WssStorageBackend* g_fs = &g_sd_timed;
+static WssStorageFile g_file;
 static String g_last_day_key;
+
+// Day-file index: the active day's record lives in RAM and is written back on rotation,
+// on flush_pending and at most every kIndexSaveIntervalMs (a power cut only leaves the
+// newest record stale, and reopening the day re-scans it when its size disagrees).
+static WssLogIndex g_log_index;
+static WssLogIndexEntry g_active_entry;
+static bool g_active_dirty = false;
+static uint32_t g_active_saved_ms = 0;
+static const uint32_t kIndexSaveIntervalMs = 60000;
+
+// Sparse seq/ts -> offset samples for the active day file (events_*.idx sidecar).
+static WssLogSeekIndex g_seek_index;
+
+// Age/quota retention and monthly archive compaction, run in slices from the loop.
+static WssLogRetention g_retention;
+static const uint32_t kRetentionSliceMs = 10;
+
+// Chain head + EOF of the active day file as of the last flush (/logs/chain.bin).
+static WssLogChainState g_chain_state;
+static const char* g_chain_resume_source = ""; // index|chain_state|scan|new
+static const uint64_t kChainStateMaxGap = 64 * 1024; // longer unrecorded tails are re-scanned
+
+// Merkle checkpoint segment: chained lines written to the active day file since the last
+// log_checkpoint/day_close/log_resume record.
+static WssMerkle g_ckpt;
+static uint32_t g_ckpt_first_seq = 0;
+static uint32_t g_ckpt_last_seq = 0;
+static uint32_t g_checkpoints_written = 0;
+
+// Flash ring -> SD backfill after a (re)mount: stranded lines are copied oldest-first into
+// their day files and re-chained onto the SD chain. New lines keep going to the ring
+// until it is drained, so every day file stays in seq order.
+static bool g_backfill_active = false;
+static WssFlashLogCursor g_backfill_cursor;
+static uint32_t g_backfill_lines = 0; // since boot
+static const size_t kBackfillBatchLines = 16;
+static const uint32_t kBackfillBudgetMs = 15;
+static const size_t kBackfillMaxBatchLines = 40; // legacy NVS ring (larger steps)
 #endif
 
 // M3: hash chaining state (best-effort, per active backend/day)
 static bool g_hash_chain_enabled = false;
 static String g_prev_hash;
+static String g_flash_prev_hash; // chain of lines in the flash ring
 static const char* kZeroHash64 = "0000000000000000000000000000000000000000000000000000000000000000";
 
-// M3: retention enforcement pacing
-static uint32_t g_last_retention_check_ms = 0;
+// Async log pipeline: producers only enqueue; the writer task owns SD/NVS log writes.
+// Every SD/flash-ring access (writer, loop, web handlers) is serialized by g_storage_lock.
+static WssLogQueue g_log_queue;
+static SemaphoreHandle_t g_storage_lock = nullptr;
+// Last status read under g_storage_lock, for loop-side readers that find it held.
+static WssStorageStatus g_status_snap;
+static SemaphoreHandle_t g_status_snap_lock = nullptr;
+static TaskHandle_t g_writer_task = nullptr;
+static uint32_t g_log_batches = 0;
+static uint32_t g_log_lines_committed = 0;
+static uint32_t g_log_max_batch_lines = 0;
+static const uint32_t kWriterStackBytes = 6144;
+static const UBaseType_t kWriterPriority = 1;
+static const BaseType_t kWriterCore = 0;
+static const uint32_t kWriterIdleWaitMs = 250;
+static const size_t kWriterMaxBatchLines = 32;
+
+// SD durability policy (log_flush_policy.h).
+static WssLogFlushMode g_flush_mode = WSS_LOG_FLUSH_SEVERITY;
+static uint32_t g_flush_interval_ms = 1000;
+static uint32_t g_unflushed_bytes = 0;
+static uint32_t g_last_flush_ms = 0;
+static uint32_t g_flush_count = 0;
+
+static bool g_log_binary_cfg = false; // config `log_format=binary`
+
+#if WSS_FEATURE_SD
+// Preallocated, sector-aligned day files. New day files reserve `log_prealloc_kb` of
+// contiguous clusters up front. Appends are staged in the write-behind ring g_wb, which
+// holds the file bytes from at most the sector at g_wb_written up to the logical EOF.
+// Full sectors go out in large sequential writes (WSS_LOG_WRITE_BEHIND_CHUNK_BYTES, or
+// when the ring fills); a flush also writes the partial sector in place, and it is
+// rewritten whole once it fills, so every SD write starts on a sector boundary. The FAT
+// size never covers the preallocated tail; rotation truncates the unused clusters.
+//
+// The ring also keeps every line that is not completely on the card (from g_wb_safe), so
+// a failed write can move those lines to the flash ring instead of losing them.
+static const size_t kSdSectorBytes = WssLogWriteBehind::kSectorBytes;
+static WssLogWriteBehind g_wb;
+static uint8_t g_wb_sector[kSdSectorBytes]; // used when no larger ring is configured/available
+static bool g_wb_psram = false;
+static size_t g_wb_chunk_bytes = kSdSectorBytes;
+static uint64_t g_wb_written = 0;    // sector-aligned: the full sectors before it are on the card
+static uint64_t g_wb_safe = 0;       // line boundary: the lines before it are on the card
+static bool g_wb_partial_head = false; // ring start cut into a line (ring was full)
+static uint32_t g_wb_mirrored_lines = 0;
+static uint32_t g_sector_writes = 0;
+static uint32_t g_prealloc_bytes = 0;
+static bool g_prealloc_ok = false;
+
+// Day file format (config `log_format`, see g_log_binary_cfg): new files take the
+// configured one, a reopened file keeps the one its first line was written in. Byte counts
+// are since boot.
+static bool g_file_binary = false;
+static uint64_t g_log_text_bytes = 0;   // JSONL bytes of the lines committed to SD
+static uint64_t g_log_stored_bytes = 0; // bytes those lines took in the day files
+
+// SD write/flush latency: calls slower than WSS_LOG_SD_STALL_MS (e.g. card-internal erase).
+static uint32_t g_sd_stalls = 0;
+static uint32_t g_sd_stall_last_ms = 0;
+static uint32_t g_sd_stall_max_ms = 0;
+static uint32_t g_sd_stall_total_ms = 0;
+
+// Health probe (card status command every poll).
+static uint32_t g_sd_probe_failures = 0; // unanswered probes since boot
+static uint8_t g_sd_probe_misses = 0;    // consecutive
+
+static void sd_write_failed();
+
+static void sd_wb_alloc() {
+  if (g_wb.ok()) return;
+  size_t bytes = WSS_LOG_WRITE_BEHIND_BYTES;
+  bytes -= bytes % kSdSectorBytes;
+  if (bytes > kSdSectorBytes) {
+    uint8_t* buf = static_cast<uint8_t*>(wss_large_alloc(bytes));
+    if (buf && g_wb.begin(buf, bytes)) {
+      g_wb_psram = wss_psram_available();
+    } else {
+      wss_large_free(buf);
+    }
+  }
+  if (!g_wb.ok()) (void)g_wb.begin(g_wb_sector, sizeof(g_wb_sector));
+  g_wb_chunk_bytes = WSS_LOG_WRITE_BEHIND_CHUNK_BYTES;
+  if (g_wb_chunk_bytes > g_wb.capacity() / 2) g_wb_chunk_bytes = g_wb.capacity() / 2;
+  g_wb_chunk_bytes -= g_wb_chunk_bytes % kSdSectorBytes;
+  if (g_wb_chunk_bytes < kSdSectorBytes) g_wb_chunk_bytes = kSdSectorBytes;
+}
+
+static uint64_t sd_logical_eof() {
+  return g_wb.end();
+}
+
+static void sd_note_latency(uint32_t ms) {
+  if (ms < WSS_LOG_SD_STALL_MS) return;
+  g_sd_stalls++;
+  g_sd_stall_last_ms = ms;
+  g_sd_stall_total_ms += ms;
+  if (ms > g_sd_stall_max_ms) g_sd_stall_max_ms = ms;
+}
+
+// Writes ring bytes [from, to) at their file offset; `from` is sector-aligned. One write
+// per contiguous span (two when the range wraps the ring).
+static bool sd_wb_write(uint64_t from, uint64_t to) {
+  if (!g_file.seek(from)) return false;
+  while (from < to) {
+    const uint8_t* p = nullptr;
+    size_t n = g_wb.span(from, p, (size_t)(to - from));
+    if (n == 0) return false;
+    const uint32_t start_ms = millis();
+    const bool ok = g_file.write(p, n) == n;
+    sd_note_latency(millis() - start_ms);
+    if (!ok) return false;
+    g_sector_writes++;
+    from += n;
+  }
+  return true;
+}
+
+// Gives back ring space up to the older of the first line not yet on the card and the
+// partial sector (which is rewritten whole later).
+static void sd_wb_release() {
+  g_wb.release(g_wb_safe < g_wb_written ? g_wb_safe : g_wb_written);
+}
+
+// Writes up to `max_bytes` of staged full sectors.
+static bool sd_wb_drain(size_t max_bytes) {
+  const uint64_t eof = g_wb.end();
+  uint64_t to = eof - (eof % kSdSectorBytes);
+  if (to - g_wb_written > max_bytes) to = g_wb_written + (max_bytes - max_bytes % kSdSectorBytes);
+  if (to <= g_wb_written) return true;
+  if (!sd_wb_write(g_wb_written, to)) return false;
+  g_wb_written = to;
+  const uint64_t safe = g_wb.after_last_newline(g_wb_safe, to);
+  if (safe > g_wb_safe) {
+    g_wb_safe = safe;
+    g_wb_partial_head = false;
+  }
+  sd_wb_release();
+  return true;
+}
+
+// Ring full: writes out every full sector. If a line that is not completely on the card
+// still pins the ring, it stops being kept for the mirror.
+static bool sd_wb_make_room() {
+  if (!sd_wb_drain(g_wb.capacity())) return false;
+  if (g_wb.room() == 0 && g_wb_safe < g_wb_written) {
+    g_wb.release(g_wb_written);
+    g_wb_safe = g_wb_written;
+    g_wb_partial_head = true;
+  }
+  return g_wb.room() > 0;
+}
+
+// Positions the ring at the sector containing `eof` (re-reading its partial bytes).
+static bool sd_wb_load(uint64_t eof) {
+  const uint64_t base = eof - (eof % kSdSectorBytes);
+  g_wb.reset(base);
+  g_wb_written = base;
+  g_wb_safe = eof;
+  g_wb_partial_head = false;
+  if (eof > base) {
+    uint8_t buf[128];
+    if (!g_file.seek(base)) return false;
+    for (uint64_t off = base; off < eof;) {
+      size_t n = sizeof(buf);
+      if (n > eof - off) n = (size_t)(eof - off);
+      if (g_file.read(buf, n) != (int32_t)n) return false;
+      (void)g_wb.append(buf, n);
+      off += n;
+    }
+  }
+  return g_file.seek(base);
+}
+
+// Appends to the active day file through the ring. Returns bytes accepted (0 on error).
+static size_t sd_log_write(const uint8_t* data, size_t len) {
+  size_t done = 0;
+  while (done < len) {
+    if (g_wb.room() == 0 && !sd_wb_make_room()) return 0;
+    done += g_wb.append(data + done, len - done);
+  }
+  return len;
+}
+
+static size_t sd_log_println(const String& line) {
+  size_t n = sd_log_write(reinterpret_cast<const uint8_t*>(line.c_str()), line.length());
+  if (n != line.length()) return 0;
+  if (sd_log_write(reinterpret_cast<const uint8_t*>("\n"), 1) != 1) return 0;
+  return n + 1;
+}
+
+// Appends one chained JSONL line in the active file's format. Returns bytes taken (0 on
+// error). A line that cannot be encoded (no memory) goes out as text: readers decide per
+// line.
+static size_t sd_log_line(const String& text) {
+  size_t n = 0;
+  String rec;
+  if (g_file_binary && wss_log_record_encode(text.c_str(), text.length(), rec)) {
+    n = sd_log_println(rec);
+  } else {
+    n = sd_log_println(text);
+  }
+  if (n) {
+    g_log_text_bytes += text.length() + 1;
+    g_log_stored_bytes += n;
+  }
+  return n;
+}
+
+// True when the day file's first line is a binary record.
+static bool sd_file_is_binary(WssStorageFile& f) {
+  uint8_t first = 0;
+  return f.seek(0) && f.read(&first, 1) == 1 && first == kWssLogRecordMarker;
+}
+#endif
+
+// Forces buffered bytes of the active day file out to the card. Caller holds the lock.
+static void sd_flush_now() {
+#if WSS_FEATURE_SD
+  if (g_file && g_unflushed_bytes > 0) {
+    const uint64_t eof = g_wb.end();
+    bool ok = sd_wb_drain(g_wb.capacity());
+    if (ok && eof > g_wb_written) ok = sd_wb_write(g_wb_written, eof);
+    if (ok) {
+      const uint32_t start_ms = millis();
+      ok = g_file.sync();
+      sd_note_latency(millis() - start_ms);
+    }
+    if (!ok) {
+      sd_write_failed();
+      g_unflushed_bytes = 0;
+      g_last_flush_ms = millis();
+      return;
+    }
+    g_wb_safe = eof; // lines are appended whole
+    g_wb_partial_head = false;
+    sd_wb_release();
+    (void)g_seek_index.flush(); // samples never point past flushed data
+    WssLogChainStateRecord cs;   // likewise the chain-state record
+    cs.date = g_active_entry.date;
+    cs.seq = g_active_entry.last_seq;
+    cs.offset = eof;
+    memcpy(cs.head, g_active_entry.chain_head, sizeof(cs.head));
+    (void)g_chain_state.store(cs);
+    g_flush_count++;
+  }
+#endif
+  g_unflushed_bytes = 0;
+  g_last_flush_ms = millis();
+}
+
+static void sd_flush_if_due() {
+  if (g_unflushed_bytes == 0) return;
+  if ((uint32_t)(millis() - g_last_flush_ms) >= g_flush_interval_ms) sd_flush_now();
+}
+
+#if WSS_FEATURE_SD
+static void sd_save_active_entry();
+
+// Flushes the ring, releases the unused preallocated tail, then closes.
+static void sd_close_log_file() {
+  if (g_file) sd_flush_now();
+  if (g_file) {
+    (void)g_file.truncate(sd_logical_eof());
+    sd_save_active_entry();
+    g_seek_index.end();
+    g_file.close();
+  }
+  g_wb.reset(0);
+  g_wb_written = 0;
+  g_wb_safe = 0;
+  g_wb_partial_head = false;
+  g_unflushed_bytes = 0;
+  g_last_flush_ms = millis();
+}
+#endif
+
+struct StorageLock {
+  StorageLock() {
+    if (g_storage_lock) xSemaphoreTakeRecursive(g_storage_lock, portMAX_DELAY);
+  }
+  ~StorageLock() {
+    if (g_storage_lock) xSemaphoreGiveRecursive(g_storage_lock);
+  }
+};
+
+// Zero-wait variant for the loop task. The writer holds g_storage_lock across SD writes and
+// syncs, so a stalled card must cost the loop a skipped step, never a wait.
+struct StorageTryLock {
+  StorageTryLock()
+      : held(!g_storage_lock || xSemaphoreTakeRecursive(g_storage_lock, 0) == pdTRUE) {}
+  ~StorageTryLock() {
+    if (held && g_storage_lock) xSemaphoreGiveRecursive(g_storage_lock);
+  }
+  const bool held;
+};
+
+// Temporarily releases one level of g_storage_lock (e.g. while writing to a slow HTTP client).
+struct StorageUnlock {
+  StorageUnlock() {
+    if (g_storage_lock) xSemaphoreGiveRecursive(g_storage_lock);
+  }
+  ~StorageUnlock() {
+    if (g_storage_lock) xSemaphoreTakeRecursive(g_storage_lock, portMAX_DELAY);
+  }
+};
 
 static String date_key_utc(time_t t) {
   struct tm tm_utc;
@@ -119,42 +486,62 @@ static String fs_type_string() {
   return String("FAT?") + String(t);
 }
 
-static void update_capacity_free() {
+// Free space: counting free clusters walks the whole FAT (seconds on a large FAT32 card),
+// so the figure is read at mount and every WSS_SD_FREE_REFRESH_MS, and in between moved by
+// the bytes our own files grew and released. Cluster slack and preallocation make the
+// estimate err low, never high.
+static uint64_t g_free_base = 0;
+static uint64_t g_free_grown_at = 0;
+static uint64_t g_free_released_at = 0;
+static uint32_t g_free_refresh_ms = 0;
+static uint32_t g_free_refreshes = 0;
+static bool g_free_estimated = false;
+
+static void update_capacity_free(bool refresh) {
   if (!g_status.sd_mounted) {
     g_status.capacity_bytes = 0;
     g_status.free_bytes = 0;
     return;
   }
 
-  if (g_sd.card()) {
-    uint64_t sectors = (uint64_t)g_sd.card()->sectorCount();
-    g_status.capacity_bytes = sectors * 512ULL;
+  if (refresh || (uint32_t)(millis() - g_free_refresh_ms) >= WSS_SD_FREE_REFRESH_MS) {
+    uint64_t total = 0;
+    uint64_t free_bytes = 0;
+    const bool known = g_fs->space(total, free_bytes);
+    if (total) g_status.capacity_bytes = total;
+    g_free_base = known ? free_bytes : 0;
+    g_free_grown_at = g_sd_timed.bytes_grown();
+    g_free_released_at = g_sd_timed.bytes_released();
+    g_free_refresh_ms = millis();
+    g_free_refreshes++;
+    g_free_estimated = false;
+    g_status.free_bytes = g_free_base;
+    return;
   }
 
-  // FsVolume provides freeClusterCount()/sectorsPerCluster() for FAT/exFAT.
-  if (g_sd.vol()) {
-    uint64_t free_clusters = g_sd.vol()->freeClusterCount();
-    uint64_t spc = g_sd.vol()->sectorsPerCluster();
-    g_status.free_bytes = free_clusters * spc * 512ULL;
-  } else {
-    g_status.free_bytes = 0;
-  }
+  const uint64_t grown = g_sd_timed.bytes_grown() - g_free_grown_at;
+  const uint64_t released = g_sd_timed.bytes_released() - g_free_released_at;
+  uint64_t est = g_free_base + released;
+  est = est > grown ? est - grown : 0;
+  if (est > g_status.capacity_bytes && g_status.capacity_bytes) est = g_status.capacity_bytes;
+  g_status.free_bytes = est;
+  g_free_estimated = true;
 }
 
 static bool ensure_sd_dirs(time_t now) {
   String y = year_str_utc(now);
   String m = month_str_utc(now);
   // Create /logs, /logs/YYYY, /logs/YYYY/MM
-  if (!g_sd.exists("/logs")) {
-    if (!g_sd.mkdir("/logs")) return false;
+  if (!g_fs->exists("/logs")) {
+    if (!g_fs->mkdir("/logs")) return false;
   }
   String ydir = String("/logs/") + y;
-  if (!g_sd.exists(ydir.c_str())) {
-    if (!g_sd.mkdir(ydir.c_str())) return false;
+  if (!g_fs->exists(ydir.c_str())) {
+    if (!g_fs->mkdir(ydir.c_str())) return false;
   }
   String mdir = ydir + String("/") + m;
-  if (!g_sd.exists(mdir.c_str())) {
-    if (!g_sd.mkdir(mdir.c_str())) return false;
+  if (!g_fs->exists(mdir.c_str())) {
+    if (!g_fs->mkdir(mdir.c_str())) return false;
   }
   return true;
 }
@@ -167,57 +554,123 @@ static String log_path_for(time_t now) {
 }
 
 static bool ensure_nfc_dir() {
-  if (!g_sd.exists("/nfc")) {
-    if (!g_sd.mkdir("/nfc")) return false;
+  if (!g_fs->exists("/nfc")) {
+    if (!g_fs->mkdir("/nfc")) return false;
   }
   return true;
 }
 
-static bool sd_read_last_hash(const String& path, String& out_hash) {
-  out_hash = String(kZeroHash64);
-  FsFile f = g_sd.open(path.c_str(), O_RDONLY);
-  if (!f) return false;
-  uint64_t sz = f.fileSize();
-  // Read up to last 2048 bytes for the last JSONL line.
-  const uint32_t kTail = 2048;
-  uint32_t to_read = (sz > kTail) ? kTail : (uint32_t)sz;
-  if (to_read == 0) {
-    f.close();
-    return true;
+// Writes the active day's index record if it changed. Caller holds the lock.
+static void sd_save_active_entry() {
+  if (!g_active_dirty || !g_active_entry.date) return;
+  // The record never counts bytes that are still only in the write-behind ring.
+  if (g_unflushed_bytes > 0) sd_flush_now();
+  if (!g_active_dirty || !g_file) return;
+  g_active_entry.size_bytes = (uint32_t)sd_logical_eof();
+  if (g_log_index.put(g_active_entry)) g_active_dirty = false;
+  g_active_saved_ms = millis();
+}
+
+// Folds one line written to the active day file into its index record. Backfilled lines
+// can be older than records already in the file, so the seq span is a min/max.
+static void sd_note_active_line(const String& line, const char* hash) {
+  const char* p = strstr(line.c_str(), "\"seq\":");
+  if (p) {
+    uint32_t seq = (uint32_t)strtoul(p + 6, nullptr, 10);
+    if (!g_active_entry.first_seq || seq < g_active_entry.first_seq) g_active_entry.first_seq = seq;
+    if (seq > g_active_entry.last_seq) g_active_entry.last_seq = seq;
   }
-  uint64_t start = (sz > kTail) ? (sz - kTail) : 0;
-  f.seekSet(start);
-  String tail;
-  tail.reserve(to_read + 8);
-  char buf[129];
-  uint32_t remaining = to_read;
-  while (remaining > 0) {
-    uint32_t n = remaining > (sizeof(buf) - 1) ? (sizeof(buf) - 1) : remaining;
-    int32_t got = f.read(buf, n);
-    if (got <= 0) break;
-    buf[got] = 0;
-    tail.concat(String(buf));
-    remaining -= (uint32_t)got;
+  if (hash && strlen(hash) == 64) {
+    (void)wss_hex_parse(hash, g_active_entry.chain_head, sizeof(g_active_entry.chain_head));
   }
-  f.close();
+  g_active_dirty = true;
+}
+
+// Chains and appends a record the storage layer writes itself (file header, checkpoints).
+// These are not Merkle leaves, and not seek samples: their seq is taken at write time and
+// can be newer than backfilled lines that follow. Caller holds the lock with hash
+// chaining enabled.
+static bool sd_write_meta_line(const JsonDocument& d) {
+  String base;
+  serializeJson(d, base);
+  String out_line;
+  char out_hash[65];
+  String prev = clamp_prev_hash(g_prev_hash);
+  if (!wss_log_chain_line(base.c_str(), base.length(), prev.c_str(), out_line, out_hash)) {
+    return false;
+  }
+  size_t n = sd_log_line(out_line);
+  if (n == 0) return false;
+  g_unflushed_bytes += (uint32_t)n;
+  sd_note_active_line(out_line, out_hash);
+  g_prev_hash = out_hash;
+  g_status.chain_head_hash = g_prev_hash;
+  return true;
+}
 
-  // Find last non-empty line.
-  int end = tail.length() - 1;
-  while (end >= 0 && (tail[end] == '\n' || tail[end] == '\r')) end--;
-  if (end < 0) return true;
-  int start_line = tail.lastIndexOf('\n', end);
-  if (start_line < 0) start_line = 0; else start_line += 1;
-  String line = tail.substring(start_line, end + 1);
-  line.trim();
-  if (!line.length()) return true;
+static void fill_meta_header(JsonDocument& d, const char* event_type, const char* msg) {
+  bool tv = false;
+  d["ts"] = wss_time_now_iso8601_utc(tv);
+  d["seq"] = g_log->reserve_seq();
+  d["severity"] = "info";
+  d["source"] = "log";
+  d["event_type"] = event_type;
+  d["msg"] = msg;
+  d["time_valid"] = tv;
+}
 
-  DynamicJsonDocument d(768);
-  DeserializationError de = deserializeJson(d, line);
-  if (de) return false;
-  String h = d["hash"] | String("");
-  if (h.length() == 64) {
-    out_hash = h;
+// Closes the current Merkle segment with a log_checkpoint or day_close record.
+static void sd_write_checkpoint(const char* event_type, const char* msg) {
+  if (!g_log) return;
+  uint8_t root[32];
+  g_ckpt.root(root);
+  char root_hex[65];
+  wss_hex_lower(root, sizeof(root), root_hex);
+  StaticJsonDocument<448> d;
+  fill_meta_header(d, event_type, msg);
+  JsonObject extra = d.createNestedObject("extra");
+  extra["first_seq"] = g_ckpt_first_seq;
+  extra["last_seq"] = g_ckpt_last_seq;
+  extra["lines"] = g_ckpt.count();
+  extra["merkle_root"] = root_hex;
+  if (sd_write_meta_line(d)) g_checkpoints_written++;
+  g_ckpt.reset();
+  g_ckpt_first_seq = 0;
+  g_ckpt_last_seq = 0;
+}
+
+// Adds a chained line just written to the active file to the checkpoint segment.
+static void sd_note_checkpoint_leaf(const String& line, const String& hash) {
+  uint8_t leaf[32];
+  if (hash.length() != 64 || !wss_hex_parse(hash.c_str(), leaf, sizeof(leaf))) return;
+  g_ckpt.add(leaf);
+  const char* p = strstr(line.c_str(), "\"seq\":");
+  if (p) {
+    uint32_t seq = (uint32_t)strtoul(p + 6, nullptr, 10);
+    if (!g_ckpt_first_seq) g_ckpt_first_seq = seq;
+    g_ckpt_last_seq = seq;
   }
+  if (g_ckpt.count() >= WSS_LOG_CHECKPOINT_LINES) {
+    sd_write_checkpoint("log_checkpoint", "log checkpoint");
+  }
+}
+
+// Brings a stale index record up to date from the chain-state record: one 64-byte read,
+// plus a forward scan of lines flushed after the record was written (normally none).
+// False when the record is torn, names another file or does not end on a line there.
+static bool sd_resume_from_chain_state(WssLogIndexEntry& e, uint64_t eof) {
+  WssLogChainStateRecord r;
+  if (!g_chain_state.load(r) || r.date != e.date || r.offset == 0 || r.offset > eof) return false;
+  if (eof - r.offset > kChainStateMaxGap) return false;
+  char c = 0;
+  if (!g_file.seek(r.offset - 1) || g_file.read(&c, 1) != 1 || c != '\n') return false;
+  uint32_t last_seq = r.seq > e.last_seq ? r.seq : e.last_seq;
+  uint8_t head[32];
+  memcpy(head, r.head, sizeof(head));
+  if (!WssLogChainState::scan_forward(g_file, r.offset, eof, last_seq, head)) return false;
+  e.size_bytes = (uint32_t)eof;
+  e.last_seq = last_seq;
+  memcpy(e.chain_head, head, sizeof(e.chain_head));
   return true;
 }
 
@@ -225,69 +678,144 @@ static bool open_log_file_if_needed(time_t now) {
   String day = date_key_utc(now);
   if (g_status.active_log_path.length() > 0 && g_last_day_key == day && g_file) return true;
 
-  if (g_file) g_file.close();
+  // Day rotation: seal the finished day with a last checkpoint; the next file's header
+  // links to it through the index chain head. A backfill can step back to an older day
+  // file; the one it leaves is only sealed with a checkpoint, as more lines may follow.
+  if (g_file && g_hash_chain_enabled && g_last_day_key.length() && g_last_day_key != day) {
+    if (day > g_last_day_key) sd_write_checkpoint("day_close", "day close");
+    else if (g_ckpt.count() > 0) sd_write_checkpoint("log_checkpoint", "log checkpoint");
+  }
+  sd_close_log_file();
   g_status.active_log_path = "";
 
   if (!ensure_sd_dirs(now)) return false;
 
   String path = log_path_for(now);
-  FsFile f = g_sd.open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND);
-  if (!f) return false;
-  bool is_new = (f.fileSize() == 0);
-  g_file = f;
+  // Not WSS_FS_APPEND: the write-behind ring rewrites the partial last sector in place.
+  g_file = g_fs->open(path.c_str(), WSS_FS_RDWR | WSS_FS_CREATE);
+  if (!g_file) return false;
+  uint64_t eof = g_file.size();
+  bool is_new = (eof == 0);
+  g_file_binary = is_new ? g_log_binary_cfg : sd_file_is_binary(g_file);
+
+  // Contiguous clusters for the whole day up front (best-effort: fragmented cards or
+  // unsupported volumes simply grow the file as before).
+  g_prealloc_bytes = 0;
+  g_prealloc_ok = false;
+  if (is_new && g_cfg) {
+    uint32_t kb = g_cfg->doc()["log_prealloc_kb"] | 1024;
+    if (kb > 65536) kb = 65536;
+    g_prealloc_bytes = kb * 1024UL;
+    if (g_prealloc_bytes > 0) g_prealloc_ok = g_file.preallocate(g_prealloc_bytes);
+  }
+  if (!sd_wb_load(eof)) {
+    g_file.close();
+    return false;
+  }
+
   g_last_day_key = day;
   g_status.active_log_path = path;
+  g_seek_index.begin(g_fs, path);
+
+  // Index record for the day. A stale one (power cut since the last index save) is brought
+  // up to date from the chain-state record; the file is re-scanned only when that is off too.
+  uint32_t date = WssLogIndex::date_from_key(day);
+  g_active_entry = WssLogIndexEntry();
+  g_active_entry.date = date;
+  g_chain_resume_source = "new";
+  if (!is_new) {
+    const bool found = g_log_index.find(date, g_active_entry);
+    g_chain_resume_source = "index";
+    if (!found || g_active_entry.size_bytes != eof) {
+      g_chain_resume_source = "chain_state";
+      if (!found || !sd_resume_from_chain_state(g_active_entry, eof)) {
+        (void)g_log_index.scan_file(date, g_active_entry);
+        g_chain_resume_source = "scan";
+      }
+    }
+  }
+  // Recorded with the day, so range queries never open closed files to learn it.
+  g_active_entry.format = g_file_binary ? WSS_LOG_FILE_BINARY : WSS_LOG_FILE_JSONL;
+  g_active_dirty = true;
+  sd_save_active_entry();
 
-  // M3: initialize hash chain state for this day/file.
+  // M3: initialize hash chain state for this day/file (chain head from the index record).
   if (g_hash_chain_enabled) {
     if (is_new) {
       g_prev_hash = String(kZeroHash64);
     } else {
-      String last;
-      if (!sd_read_last_hash(path, last)) last = String(kZeroHash64);
-      g_prev_hash = clamp_prev_hash(last);
+      char head[65];
+      wss_hex_lower(g_active_entry.chain_head, sizeof(g_active_entry.chain_head), head);
+      g_prev_hash = clamp_prev_hash(String(head));
     }
     g_status.chain_head_hash = g_prev_hash;
   }
 
+  // Checkpoint segments never span a reopen: lines before it that no checkpoint covers
+  // stay protected by the per-line chain only.
+  g_ckpt.reset();
+  g_ckpt_first_seq = 0;
+  g_ckpt_last_seq = 0;
+
   // M3: write a schema-correct file header event on new files when hash chaining is enabled.
   if (g_hash_chain_enabled && is_new && g_log && g_cfg) {
-    bool tv = false;
-    String ts = wss_time_now_iso8601_utc(tv);
-    StaticJsonDocument<384> hdr;
-    hdr["ts"] = ts;
-    hdr["seq"] = g_log->reserve_seq();
-    hdr["severity"] = "info";
-    hdr["source"] = "log";
-    hdr["event_type"] = "file_header";
-    hdr["msg"] = "file header";
-    hdr["time_valid"] = tv;
+    StaticJsonDocument<512> hdr;
+    fill_meta_header(hdr, "file_header", "file header");
     JsonObject extra = hdr.createNestedObject("extra");
     extra["firmware"] = WSS_FIRMWARE_VERSION;
     extra["log_schema_version"] = WSS_LOG_SCHEMA_VERSION;
     extra["config_schema_version"] = WSS_CONFIG_SCHEMA_VERSION;
     extra["nfc_record_version"] = WSS_NFC_RECORD_VERSION;
     extra["device_suffix"] = g_cfg->device_suffix();
-
-    String base;
-    serializeJson(hdr, base);
-    String out_line;
-    String out_hash;
-    if (apply_hash_chain_to_jsonl(base, g_prev_hash, out_line, out_hash)) {
-      g_file.println(out_line);
-      g_file.flush();
-      g_prev_hash = out_hash;
-      g_status.chain_head_hash = g_prev_hash;
+    // Links the day to the last hash of the previous day file (its day_close record).
+    WssLogIndexEntry prev_day;
+    static const uint8_t kZeroHead[32] = {0};
+    char prev_head[65];
+    if (g_log_index.last_before(date, prev_day) &&
+        memcmp(prev_day.chain_head, kZeroHead, sizeof(kZeroHead)) != 0) {
+      wss_hex_lower(prev_day.chain_head, sizeof(prev_day.chain_head), prev_head);
+      extra["prev_day_head"] = prev_head;
     }
+    if (sd_write_meta_line(hdr)) sd_flush_now();
+  } else if (g_hash_chain_enabled && !is_new && g_log) {
+    StaticJsonDocument<320> d;
+    fill_meta_header(d, "log_resume", "log resume");
+    (void)sd_write_meta_line(d);
   }
   return true;
 }
 
+#if WSS_FEATURE_SD
+static const char* kAllowlistPath = "/nfc/allowlist.json";
+static const char* kAllowlistTmpPath = "/nfc/allowlist.json.tmp";
+static const char* kAllowlistJournalPath = "/nfc/allowlist.jnl";
+
+// Streams a file into `out` in small chunks; stops early when `out` takes less. False when
+// the file cannot be opened. Caller holds the lock.
+static bool sd_stream_file(const char* path, Print& out, uint64_t& bytes, bool& read_error) {
+  bytes = 0;
+  read_error = false;
+  WssStorageFile f = g_fs->open(path, WSS_FS_READ);
+  if (!f) return false;
+  uint8_t buf[512];
+  for (;;) {
+    int32_t got = f.read(buf, sizeof(buf));
+    if (got < 0) read_error = true;
+    if (got <= 0) break;
+    bytes += (uint64_t)got;
+    if (out.write(buf, (size_t)got) != (size_t)got) break;
+  }
+  f.close();
+  return true;
+}
+#endif
+
 bool wss_storage_write_allowlist(const String& payload, String& err) {
 #if !WSS_FEATURE_SD
   err = "sd_disabled";
   return false;
 #else
+  StorageLock lock;
   if (!g_status.sd_mounted) {
     err = "sd_not_mounted";
     return false;
@@ -296,52 +824,108 @@ bool wss_storage_write_allowlist(const String& payload, String& err) {
     err = "nfc_dir_create_failed";
     return false;
   }
-  FsFile f = g_sd.open("/nfc/allowlist.json", O_WRONLY | O_CREAT | O_TRUNC);
+  WssStorageFile f = g_fs->open(kAllowlistTmpPath, WSS_FS_WRITE | WSS_FS_CREATE | WSS_FS_TRUNC);
   if (!f) {
     err = "allowlist_open_failed";
     return false;
   }
-  int32_t wrote = f.write(payload.c_str(), payload.length());
+  size_t wrote = f.write(payload.c_str(), payload.length());
+  bool synced = f.sync();
   f.close();
-  if (wrote < 0 || (size_t)wrote != payload.length()) {
+  if (wrote != payload.length() || !synced) {
+    (void)g_fs->remove(kAllowlistTmpPath);
     err = "allowlist_write_failed";
     return false;
   }
+  // The complete snapshot is on the card before the old one goes; a crash before the
+  // rename is finished by wss_storage_read_allowlist(). Only then is the journal dropped.
+  (void)g_fs->remove(kAllowlistPath);
+  if (!g_fs->rename(kAllowlistTmpPath, kAllowlistPath)) {
+    err = "allowlist_rename_failed";
+    return false;
+  }
+  (void)g_fs->remove(kAllowlistJournalPath);
   return true;
 #endif
 }
 
-bool wss_storage_read_allowlist(String& payload, String& err) {
+bool wss_storage_append_allowlist_journal(const char* rec, size_t len, String& err) {
 #if !WSS_FEATURE_SD
+  (void)rec;
+  (void)len;
   err = "sd_disabled";
   return false;
 #else
+  StorageLock lock;
   if (!g_status.sd_mounted) {
     err = "sd_not_mounted";
     return false;
   }
-  FsFile f = g_sd.open("/nfc/allowlist.json", O_RDONLY);
-  if (!f) {
-    err = "allowlist_missing";
+  if (!len || !ensure_nfc_dir()) {
+    err = "nfc_dir_create_failed";
     return false;
   }
-  uint64_t sz = f.fileSize();
-  if (sz > 16384) {
-    f.close();
-    err = "allowlist_too_large";
+  WssStorageFile f = g_fs->open(kAllowlistJournalPath, WSS_FS_RDWR | WSS_FS_CREATE);
+  if (!f) {
+    err = "allowlist_journal_open_failed";
     return false;
   }
-  payload = "";
-  payload.reserve((size_t)sz + 8);
-  char buf[129];
-  while (f.available()) {
-    int32_t got = f.read(buf, sizeof(buf) - 1);
-    if (got <= 0) break;
-    buf[got] = 0;
-    payload.concat(String(buf));
+  // Records are fixed-size: cut a torn tail left by an interrupted append first.
+  uint64_t end = f.size();
+  if (end % len) {
+    end -= end % len;
+    if (!f.truncate(end)) {
+      f.close();
+      err = "allowlist_journal_write_failed";
+      return false;
+    }
   }
+  bool ok = f.seek(end) && f.write(rec, len) == len && f.sync();
   f.close();
-  if (!payload.length()) {
+  if (!ok) {
+    err = "allowlist_journal_write_failed";
+    return false;
+  }
+  return true;
+#endif
+}
+
+bool wss_storage_read_allowlist(Print& snapshot, Print& journal, String& err) {
+  err = "";
+#if !WSS_FEATURE_SD
+  (void)snapshot;
+  (void)journal;
+  err = "sd_disabled";
+  return false;
+#else
+  StorageLock lock;
+  if (!g_status.sd_mounted) {
+    err = "sd_not_mounted";
+    return false;
+  }
+  if (g_fs->exists(kAllowlistTmpPath)) {
+    // Left by an interrupted compaction: complete if the old snapshot was already removed.
+    if (g_fs->exists(kAllowlistPath)) {
+      (void)g_fs->remove(kAllowlistTmpPath);
+    } else {
+      (void)g_fs->rename(kAllowlistTmpPath, kAllowlistPath);
+    }
+  }
+  uint64_t snapshot_bytes = 0;
+  uint64_t journal_bytes = 0;
+  bool snapshot_err = false;
+  bool journal_err = false;
+  bool have_snapshot = sd_stream_file(kAllowlistPath, snapshot, snapshot_bytes, snapshot_err);
+  bool have_journal = sd_stream_file(kAllowlistJournalPath, journal, journal_bytes, journal_err);
+  if (snapshot_err || journal_err) {
+    err = "allowlist_read_failed";
+    return false;
+  }
+  if (!have_snapshot && !have_journal) {
+    err = "allowlist_missing";
+    return false;
+  }
+  if (!snapshot_bytes && !journal_bytes) {
     err = "allowlist_empty";
     return false;
   }
@@ -349,12 +933,26 @@ bool wss_storage_read_allowlist(String& payload, String& err) {
 #endif
 }
 
+// Time of the oldest pending ring line, or `fallback` when it has none (or no valid ts).
+static time_t backfill_first_time(time_t fallback) {
+  if (!g_backfill_active) return fallback;
+  WssFlashLogCursor cur;
+  WssFlashLogCursor at;
+  String rec;
+  uint32_t seq = 0;
+  uint32_t ts = 0;
+  if (!g_fallback.next_pending(cur, rec, at)) return fallback;
+  (void)wss_log_line_seq_ts(rec.c_str(), seq, ts);
+  return ts ? (time_t)ts : fallback;
+}
+
 static bool sd_try_mount(const char* reason) {
   (void)reason;
   g_status.sd_mounted = false;
   g_status.fs_type = "";
   g_status.sd_status = "MISSING";
   g_sd_last_error = "";
+  g_sd_probe_misses = 0;
 
   if (g_status.sd_cs_gpio < 0) {
     g_status.sd_status = "DISABLED";
@@ -381,12 +979,20 @@ static bool sd_try_mount(const char* reason) {
   g_status.sd_mounted = true;
   g_status.fs_type = fs_type_string();
   g_status.sd_status = "OK";
-  update_capacity_free();
-
+  update_capacity_free(true);
+  (void)g_log_index.begin(g_fs); // loads, or rebuilds when missing/stale
+  (void)g_chain_state.begin(g_fs);
+  (void)g_retention.begin(g_fs, &g_log_index);
+
+  // Stranded ring lines are backfilled before new lines go to SD again; the first one
+  // picks the day file to open so the backfill walks the days forward.
+  g_backfill_active = g_fallback.pending() > 0;
+  g_backfill_cursor = WssFlashLogCursor();
   time_t now = time(nullptr);
-  if (!open_log_file_if_needed(now)) {
+  if (!open_log_file_if_needed(backfill_first_time(now))) {
     g_status.sd_status = "ERROR";
     g_status.sd_mounted = false;
+    g_backfill_active = false;
     g_sd_last_error = "sd_log_open_failed";
     return false;
   }
@@ -422,102 +1028,87 @@ static void emit_sd_init_log(bool ok) {
   }
 }
 
-// M3: best-effort retention enforcement (delete logs older than configured days).
+// M3: retention. A pass (age limit, then byte quota / minimum free space, then archive
+// compaction) is planned hourly, or within a minute when the card runs low, and then
+// advanced by retention_step() in slices of at most kRetentionSliceMs.
 static uint32_t g_last_retention_ms = 0;
-static void enforce_retention_if_due() {
-  if (!g_cfg || !g_log || !g_status.sd_mounted) return;
-  // Only enforce retention when time is valid to avoid deleting based on 1970.
-  auto tstat = wss_time_status();
-  if (!tstat.time_valid) return;
+static WssLogRetentionStats g_retention_pass_start;
+static void plan_retention_if_due() {
+  if (!g_cfg || !g_log || !g_status.sd_mounted || g_retention.running()) return;
+  const uint64_t min_free = (uint64_t)(g_cfg->doc()["log_min_free_mb"] | 64) * 1024ULL * 1024ULL;
+  const bool low_space = min_free && g_status.free_bytes < min_free;
 
   const uint32_t now_ms = millis();
-  if ((uint32_t)(now_ms - g_last_retention_ms) < 60UL * 60UL * 1000UL) return; // hourly
+  const uint32_t since_ms = (uint32_t)(now_ms - g_last_retention_ms);
+  if (since_ms < (low_space ? 60UL * 1000UL : 60UL * 60UL * 1000UL)) return;
   g_last_retention_ms = now_ms;
 
   int days = g_cfg->doc()["log_retention_days"] | 365;
   if (days < 7) days = 7;
   if (days > 3650) days = 3650;
+  int archive_days = g_cfg->doc()["log_archive_after_days"] | 30;
+  if (archive_days < 0) archive_days = 0;
+  if (archive_days > 3650) archive_days = 3650;
 
-  time_t now = time(nullptr);
-  time_t cutoff = now - (time_t)days * 86400;
-  String cutoff_key = date_key_utc(cutoff);
-
-  uint32_t deleted = 0;
-  FsFile logs = g_sd.open("/logs", O_RDONLY);
-  if (!logs) return;
-
-  FsFile year_dir;
-  while (year_dir.openNext(&logs, O_RDONLY)) {
-    if (!year_dir.isDir()) {
-      year_dir.close();
-      continue;
-    }
-    char yname[16] = {0};
-    year_dir.getName(yname, sizeof(yname));
-    String y = String(yname);
-
-    FsFile month_dir;
-    while (month_dir.openNext(&year_dir, O_RDONLY)) {
-      if (!month_dir.isDir()) {
-        month_dir.close();
-        continue;
-      }
-      char mname[16] = {0};
-      month_dir.getName(mname, sizeof(mname));
-      String m = String(mname);
-
-      FsFile file;
-      while (file.openNext(&month_dir, O_RDONLY)) {
-        if (file.isDir()) {
-          file.close();
-          continue;
-        }
-        char fname[48] = {0};
-        file.getName(fname, sizeof(fname));
-        String n = String(fname);
-        file.close();
-
-        if (!n.startsWith("events_") || !n.endsWith(".txt")) continue;
-        if (n.length() < 21) continue; // events_YYYY-MM-DD.txt
-        String date_key = n.substring(7, 17);
-        if (date_key < cutoff_key) {
-          String p = String("/logs/") + y + String("/") + m + String("/") + n;
-          if (g_sd.remove(p.c_str())) {
-            deleted++;
-          }
-        }
-      }
-      month_dir.close();
+  WssLogRetentionPolicy p;
+  // Age and archive cutoffs only with valid time, to avoid acting on 1970.
+  if (wss_time_status().time_valid) {
+    time_t now = time(nullptr);
+    p.age_cutoff = WssLogIndex::date_from_key(date_key_utc(now - (time_t)days * 86400));
+    if (archive_days > 0 && archive_days < days) {
+      p.archive_cutoff =
+          WssLogIndex::date_from_key(date_key_utc(now - (time_t)archive_days * 86400));
     }
-    year_dir.close();
   }
-  logs.close();
+  p.active_date = g_file ? g_active_entry.date : 0;
+  p.quota_bytes = (uint64_t)(g_cfg->doc()["log_quota_mb"] | 0) * 1024ULL * 1024ULL;
+  p.min_free_bytes = min_free;
+  p.free_bytes = g_status.free_bytes;
+  sd_save_active_entry(); // quota math uses the active day's current size
+  g_retention_pass_start = g_retention.stats();
+  (void)g_retention.start(p);
+}
 
-  if (deleted > 0) {
-    StaticJsonDocument<192> extra;
-    extra["deleted"] = deleted;
-    extra["cutoff_date"] = cutoff_key;
-    JsonObjectConst o = extra.as<JsonObjectConst>();
+static void retention_step() {
+  if (!g_retention.running()) return;
+  StorageLock lock;
+  if (!g_status.sd_mounted) {
+    g_retention.end();
+    return;
+  }
+  const uint32_t start_ms = millis();
+  do {
+    if (!g_retention.step()) break;
+  } while ((uint32_t)(millis() - start_ms) < kRetentionSliceMs);
+  if (g_retention.running() || !g_log) return;
+
+  const WssLogRetentionStats st = g_retention.stats();
+  const WssLogRetentionStats& st0 = g_retention_pass_start;
+  const uint32_t deleted = st.files_deleted - st0.files_deleted;
+  const uint32_t archived = st.days_archived - st0.days_archived;
+  const uint32_t archives_deleted = st.archives_deleted - st0.archives_deleted;
+  if (!deleted && !archived && !archives_deleted && !st.quota_unreachable &&
+      !st.last_error.length()) {
+    return;
+  }
+  StaticJsonDocument<320> extra;
+  extra["deleted"] = deleted;
+  extra["archived"] = archived;
+  extra["archives_deleted"] = archives_deleted;
+  extra["used_bytes"] = st.used_bytes;
+  extra["archive_bytes"] = st.archive_bytes;
+  if (st.quota_unreachable) extra["quota_unreachable"] = true;
+  if (st.last_error.length()) extra["err"] = st.last_error;
+  JsonObjectConst o = extra.as<JsonObjectConst>();
+  if (st.quota_unreachable || st.last_error.length()) {
+    g_log->log_warn("sd", "log_retention", "log retention incomplete", &o);
+  } else {
     g_log->log_info("sd", "log_retention", "log retention enforced", &o);
   }
 }
 #endif
 
 #if WSS_FEATURE_SD
-static bool parse_log_date_key(const String& name, String& out_key) {
-  if (!name.startsWith("events_") || !name.endsWith(".txt")) return false;
-  if (name.length() < 21) return false; // events_YYYY-MM-DD.txt
-  String key = name.substring(7, 17);
-  if (key.length() != 10) return false;
-  if (key[4] != '-' || key[7] != '-') return false;
-  for (size_t i = 0; i < key.length(); i++) {
-    if (i == 4 || i == 7) continue;
-    if (key[i] < '0' || key[i] > '9') return false;
-  }
-  out_key = key;
-  return true;
-}
-
 static void compute_range_keys(WssLogRange range, String& start_key, String& end_key) {
   start_key = "";
   end_key = "";
@@ -531,87 +1122,131 @@ static void compute_range_keys(WssLogRange range, String& start_key, String& end
   end_key = date_key_utc(now);
 }
 
-static bool log_in_range(const String& date_key, const String& start_key,
-                         const String& end_key, WssLogRange range) {
-  if (range == WSS_LOG_RANGE_ALL) return true;
-  if (!start_key.length() || !end_key.length()) return false;
-  return date_key >= start_key && date_key <= end_key;
-}
-
+// cb gets each day file in the range, oldest first, with its size and whether it holds
+// binary records (from the index; a file whose format was never recorded is checked).
 static bool for_each_log_file(WssLogRange range,
-                              bool (*cb)(const String& path, uint64_t size_bytes, void* ctx),
+                              bool (*cb)(const String& path, uint64_t size_bytes, bool binary,
+                                         void* ctx),
                               void* ctx, String& err) {
   if (!g_status.sd_mounted) {
     err = "sd_not_mounted";
     return false;
   }
-  if (!g_sd.exists("/logs")) return true;
-  FsFile logs = g_sd.open("/logs", O_RDONLY);
-  if (!logs) {
-    err = "logs_dir_open_failed";
+  if (!g_log_index.ready() && !g_log_index.begin(g_fs)) {
+    err = "log_index_unavailable";
     return false;
   }
 
   String start_key;
   String end_key;
   compute_range_keys(range, start_key, end_key);
+  uint32_t start_date = 0;
+  uint32_t end_date = 0xFFFFFFFFUL;
+  if (range != WSS_LOG_RANGE_ALL) {
+    start_date = WssLogIndex::date_from_key(start_key);
+    end_date = WssLogIndex::date_from_key(end_key);
+    if (!start_date || !end_date) return true;
+  }
 
-  FsFile year_dir;
-  while (year_dir.openNext(&logs, O_RDONLY)) {
-    if (!year_dir.isDir()) {
-      year_dir.close();
-      continue;
-    }
-    char yname[16] = {0};
-    year_dir.getName(yname, sizeof(yname));
-    String y = String(yname);
-
-    FsFile month_dir;
-    while (month_dir.openNext(&year_dir, O_RDONLY)) {
-      if (!month_dir.isDir()) {
-        month_dir.close();
-        continue;
-      }
-      char mname[16] = {0};
-      month_dir.getName(mname, sizeof(mname));
-      String m = String(mname);
-
-      FsFile file;
-      while (file.openNext(&month_dir, O_RDONLY)) {
-        if (file.isDir()) {
-          file.close();
-          continue;
-        }
-        char fname[48] = {0};
-        file.getName(fname, sizeof(fname));
-        String n = String(fname);
-        String date_key;
-        if (!parse_log_date_key(n, date_key)) {
-          file.close();
-          continue;
-        }
-        if (!log_in_range(date_key, start_key, end_key, range)) {
-          file.close();
-          continue;
-        }
-        String path = String("/logs/") + y + String("/") + m + String("/") + n;
-        uint64_t size_bytes = file.fileSize();
-        file.close();
-        if (cb && !cb(path, size_bytes, ctx)) {
-          logs.close();
-          return false;
-        }
-      }
-      month_dir.close();
+  // Re-seek by date after every callback: stream_cb drops the lock while writing, and the
+  // writer may rotate (append a record) or retention may rewrite the index meanwhile.
+  WssLogIndexEntry e;
+  uint32_t next_date = start_date;
+  while (g_log_index.next_at_or_after(next_date, e) && e.date <= end_date) {
+    const String path = WssLogIndex::path_for(e.date);
+    uint64_t size_bytes = e.size_bytes;
+    bool binary = e.format == WSS_LOG_FILE_BINARY;
+    if (g_file && e.date == g_active_entry.date) {
+      size_bytes = sd_logical_eof();
+      binary = g_file_binary;
+    } else if (e.format == WSS_LOG_FILE_UNKNOWN && size_bytes) {
+      WssStorageFile f = g_fs->open(path.c_str(), WSS_FS_READ);
+      binary = f && sd_file_is_binary(f);
     }
-    year_dir.close();
+    if (cb && !cb(path, size_bytes, binary, ctx)) return false;
+    next_date = e.date + 1;
   }
-  logs.close();
   return true;
 }
 #endif
 
+static size_t drain_pending_batch(size_t max_lines);
+static void sd_flush_if_due();
+#if WSS_FEATURE_SD
+static void backfill_step();
+static void retention_step();
+static bool sd_wb_drain_if_due();
+static void storage_shutdown_handler();
+static void verify_report_step();
+#endif
+
+static void load_flush_policy() {
+  if (!g_cfg) return;
+  g_flush_mode = wss_log_flush_mode_parse(g_cfg->doc()["sd_flush_mode"] | "severity");
+  g_flush_interval_ms = wss_log_flush_interval_clamp(g_cfg->doc()["sd_flush_interval_ms"] | 1000);
+}
+
+// Format for day files opened from now on; the active file keeps its own.
+static void load_log_format() {
+  if (!g_cfg) return;
+  String fmt = g_cfg->doc()["log_format"] | String("jsonl");
+  g_log_binary_cfg = (fmt == "binary");
+}
+
+static void log_writer_task(void* arg) {
+  (void)arg;
+  for (;;) {
+    uint32_t wait_ms = kWriterIdleWaitMs;
+    if (g_unflushed_bytes > 0 && g_flush_interval_ms < wait_ms) wait_ms = g_flush_interval_ms;
+#if WSS_FEATURE_SD
+    // Backfill and retention advance one bounded slice per wakeup.
+    if (g_backfill_active || g_retention.running()) wait_ms = 1;
+#endif
+    (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+    // Lines that piled up while the previous batch was being written commit together.
+    // The lock is released between batches so loop/web SD users can interleave.
+    while (drain_pending_batch(kWriterMaxBatchLines) == kWriterMaxBatchLines) {
+    }
+#if WSS_FEATURE_SD
+    // Staged sectors go out in large writes, one chunk per lock hold, while no lines wait;
+    // a card stall there is absorbed by the queue rather than by the producers.
+    while (g_log_queue.empty() && sd_wb_drain_if_due()) {
+    }
+#endif
+    if (g_unflushed_bytes > 0) {
+      StorageLock lock;
+      sd_flush_if_due();
+    }
+    if (g_status.fallback_active && g_log_queue.empty()) {
+      // Erase the next ring sector while idle instead of on a rollover append.
+      StorageLock lock;
+      g_fallback.maintain();
+    }
+#if WSS_FEATURE_SD
+    // Card-heavy housekeeping lives here, on the task that already owns SD, so a card
+    // stall delays it rather than the loop (alarm path).
+    if (g_log_queue.empty()) backfill_step();
+    if (g_log_queue.empty()) retention_step();
+#endif
+  }
+}
+
+static void start_log_writer() {
+  if (g_writer_task) return;
+  BaseType_t ok = xTaskCreatePinnedToCore(log_writer_task, "wss_logw", kWriterStackBytes, nullptr,
+                                          kWriterPriority, &g_writer_task, kWriterCore);
+  if (ok != pdPASS) {
+    // wss_storage_loop() drains inline instead.
+    g_writer_task = nullptr;
+    Serial.println("[storage] WARN: log writer task not started; draining from loop");
+  }
+}
+
 void wss_storage_begin(WssConfigStore* cfg, WssEventLogger* log) {
+  if (!g_storage_lock) g_storage_lock = xSemaphoreCreateRecursiveMutex();
+  if (!g_status_snap_lock) g_status_snap_lock = xSemaphoreCreateMutex();
+  StorageLock lock;
+
   g_cfg = cfg;
   g_log = log;
   g_status = WssStorageStatus{};
@@ -625,12 +1260,16 @@ void wss_storage_begin(WssConfigStore* cfg, WssEventLogger* log) {
   }
   g_status.hash_chain_enabled = g_hash_chain_enabled;
   g_prev_hash = String(kZeroHash64);
+  g_flash_prev_hash = String(kZeroHash64);
   g_status.chain_head_hash = g_prev_hash;
+  load_flush_policy();
+  load_log_format();
   g_status.write_fail_count = 0;
   g_status.last_write_ok = true;
   g_status.last_write_backend = "";
   g_status.last_write_error = "";
 
+  (void)g_log_queue.begin();
   g_fallback.begin();
   g_status.fallback_count = g_fallback.count();
 
@@ -641,9 +1280,15 @@ void wss_storage_begin(WssConfigStore* cfg, WssEventLogger* log) {
   g_status.sd_status = "DISABLED";
   g_status.fallback_active = true;
   g_status.active_backend = "flash";
+  start_log_writer();
   return;
 #else
   g_status.feature_enabled = true;
+  sd_wb_alloc();
+  static bool shutdown_registered = false;
+  if (!shutdown_registered) {
+    shutdown_registered = esp_register_shutdown_handler(storage_shutdown_handler) == ESP_OK;
+  }
 
   bool sd_enabled = true;
   int sd_cs_gpio = wss_pin_policy_role_default_gpio("sd.cs", 13);
@@ -662,6 +1307,7 @@ void wss_storage_begin(WssConfigStore* cfg, WssEventLogger* log) {
     if (g_log) g_log->log_warn("sd", "sd_disabled", "SD disabled by config");
     g_sd_last_error = "sd_disabled_cfg";
     emit_sd_init_log(false);
+    start_log_writer();
     return;
   }
 
@@ -673,14 +1319,15 @@ void wss_storage_begin(WssConfigStore* cfg, WssEventLogger* log) {
     if (g_log) g_log->log_warn("sd", "sd_disabled", "SD disabled: pin map not configured");
     g_sd_last_error = "sd_cs_unset";
     emit_sd_init_log(false);
+    start_log_writer();
     return;
   }
 
   g_status.pinmap_configured = true;
 
   bool ok = sd_try_mount("boot");
-  g_status.fallback_active = !ok;
-  g_status.active_backend = ok ? "sd" : "flash";
+  g_status.fallback_active = !ok || g_backfill_active;
+  g_status.active_backend = g_status.fallback_active ? "flash" : "sd";
 
   if (ok) {
     emit_sd_status_log("SD mounted");
@@ -689,13 +1336,37 @@ void wss_storage_begin(WssConfigStore* cfg, WssEventLogger* log) {
     emit_sd_status_log("SD not mounted; using fallback ring");
     emit_sd_init_log(false);
   }
+  start_log_writer();
 #endif
 }
 
 void wss_storage_loop() {
+  if (!g_writer_task) {
+    // No writer task (creation failed): commit queued lines and do the writer's SD
+    // housekeeping from the main loop.
+    while (drain_pending_batch(kWriterMaxBatchLines) == kWriterMaxBatchLines) {
+    }
+#if WSS_FEATURE_SD
+    (void)sd_wb_drain_if_due();
+    backfill_step();
+    retention_step();
+#endif
+  }
+
+#if WSS_FEATURE_SD
+  verify_report_step();
+#endif
+
   const uint32_t now_ms = millis();
   if ((uint32_t)(now_ms - g_last_poll_ms) < 2000) return;
+
+  // Config is read here (it belongs to the loop task); while the writer holds the lock the
+  // poll is retried on the next call instead of waiting on the card.
+  StorageTryLock lock;
+  if (!lock.held) return;
   g_last_poll_ms = now_ms;
+  load_flush_policy(); // applies config changes without a reboot
+  load_log_format();
 
   g_status.fallback_count = g_fallback.count();
 
@@ -712,10 +1383,17 @@ void wss_storage_loop() {
 
   bool mounted_before = g_status.sd_mounted;
 
-  // Quick health check: try chdir to root.
+  // Card status command; one failed answer is retried on the next poll before the card
+  // counts as gone (a card busy finishing a write can miss one).
   bool still_ok = false;
   if (g_status.sd_mounted) {
-    still_ok = g_sd.chdir("/");
+    still_ok = g_fs->probe();
+    if (still_ok) {
+      g_sd_probe_misses = 0;
+    } else {
+      g_sd_probe_failures++;
+      still_ok = ++g_sd_probe_misses < 2;
+    }
   }
 
   if (mounted_before && !still_ok) {
@@ -723,7 +1401,7 @@ void wss_storage_loop() {
     g_status.sd_status = "MISSING";
     g_status.fallback_active = true;
     g_status.active_backend = "flash";
-    if (g_file) g_file.close();
+    sd_close_log_file();
     g_status.active_log_path = "";
     emit_sd_status_log("SD removed/unavailable; switched to fallback ring");
   }
@@ -731,90 +1409,394 @@ void wss_storage_loop() {
   if (!g_status.sd_mounted) {
     // Attempt remount periodically.
     bool ok = sd_try_mount("poll");
-    if (ok) {
+    if (ok && g_backfill_active) {
+      emit_sd_status_log("SD remounted; backfilling fallback ring");
+    } else if (ok) {
       g_status.fallback_active = false;
       g_status.active_backend = "sd";
       emit_sd_status_log("SD remounted; switched to SD logging");
     }
   } else {
-    update_capacity_free();
+    update_capacity_free(false);
     time_t now = time(nullptr);
-    (void)open_log_file_if_needed(now); // rotation scaffolding
-    enforce_retention_if_due();
+    // The backfill picks the day file itself until the ring is drained.
+    if (!g_backfill_active) (void)open_log_file_if_needed(now); // rotation scaffolding
+    if (g_active_dirty && (uint32_t)(now_ms - g_active_saved_ms) >= kIndexSaveIntervalMs) {
+      sd_save_active_entry();
+    }
+    plan_retention_if_due();
   }
 #endif
 }
 
+// Queue counters are atomics: always current, with or without g_storage_lock.
+static void fill_queue_status(WssStorageStatus& st) {
+  WssLogQueueStats q = g_log_queue.stats();
+  st.writer_task_running = (g_writer_task != nullptr);
+  st.log_queue_capacity = q.capacity;
+  st.log_queue_depth = q.depth;
+  st.log_queue_high_water = q.high_water;
+  st.log_dropped_count = q.dropped;
+  st.log_dropped_debug = q.dropped_debug;
+  st.log_dropped_info = q.dropped_info;
+  st.log_dropped_warn = q.dropped_warn;
+  st.log_dropped_overlong = q.dropped_overlong;
+}
+
 WssStorageStatus wss_storage_status() {
+  // Read from the loop task (/api/status): while the writer is inside an SD write or sync
+  // this returns the last copy read under the lock instead of waiting for the card.
+  StorageTryLock lock;
+  if (!lock.held) {
+    WssStorageStatus st;
+    if (g_status_snap_lock) xSemaphoreTake(g_status_snap_lock, portMAX_DELAY);
+    st = g_status_snap;
+    if (g_status_snap_lock) xSemaphoreGive(g_status_snap_lock);
+    fill_queue_status(st);
+    st.status_stale = true;
+    return st;
+  }
   g_status.fallback_count = g_fallback.count();
+  fill_queue_status(g_status);
+  g_status.log_batches = g_log_batches;
+  g_status.log_lines_committed = g_log_lines_committed;
+  g_status.log_max_batch_lines = g_log_max_batch_lines;
+  WssFlashLogStats fl = g_fallback.stats();
+  g_status.fallback_backend = g_fallback.backend();
+  g_status.fallback_capacity_bytes = fl.capacity_bytes;
+  g_status.fallback_used_bytes = fl.used_bytes;
+  g_status.fallback_erases = fl.erases;
+  g_status.fallback_max_wear = fl.max_wear;
+  g_status.fallback_torn_records = fl.torn_records;
+  g_status.sd_flush_mode = wss_log_flush_mode_str(g_flush_mode);
+  g_status.sd_flush_interval_ms = g_flush_interval_ms;
+  g_status.sd_unflushed_bytes = g_unflushed_bytes;
+  g_status.sd_last_flush_age_ms = (uint32_t)(millis() - g_last_flush_ms);
+  g_status.sd_flush_count = g_flush_count;
+#if WSS_FEATURE_SD
+  g_status.sd_prealloc_bytes = g_prealloc_bytes;
+  g_status.sd_prealloc_ok = g_prealloc_ok;
+  g_status.sd_sector_writes = g_sector_writes;
+  g_status.sd_write_behind_bytes = (uint32_t)g_wb.capacity();
+  g_status.sd_write_behind_psram = g_wb_psram;
+  g_status.sd_write_behind_pending = g_file ? (uint32_t)(g_wb.end() - g_wb_written) : 0;
+  g_status.sd_write_behind_high_water = (uint32_t)g_wb.high_water();
+  g_status.sd_write_behind_mirrored = g_wb_mirrored_lines;
+  g_status.sd_write_stalls = g_sd_stalls;
+  g_status.sd_write_stall_last_ms = g_sd_stall_last_ms;
+  g_status.sd_write_stall_max_ms = g_sd_stall_max_ms;
+  g_status.sd_write_stall_total_ms = g_sd_stall_total_ms;
+  for (size_t i = 0; i < WSS_STORAGE_OP_COUNT; i++) {
+    g_status.sd_latency[i] = g_sd_timed.hist((WssStorageOp)i);
+  }
+  g_status.sd_probe_failures = g_sd_probe_failures;
+  g_status.sd_free_estimated = g_free_estimated;
+  g_status.sd_free_refreshes = g_free_refreshes;
+  g_status.sd_free_refresh_age_s =
+      g_free_refreshes ? (uint32_t)(millis() - g_free_refresh_ms) / 1000 : 0;
+  g_status.sd_logical_eof = g_file ? (uint32_t)sd_logical_eof() : 0;
+  g_status.log_format = (g_file ? g_file_binary : g_log_binary_cfg) ? "binary" : "jsonl";
+  g_status.log_text_bytes = g_log_text_bytes;
+  g_status.log_stored_bytes = g_log_stored_bytes;
+  g_status.log_index_ready = g_log_index.ready();
+  g_status.log_index_files = g_log_index.count();
+  g_status.log_index_rebuilds = g_log_index.rebuilds();
+  g_status.log_checkpoints_written = g_checkpoints_written;
+  g_status.chain_resume_source = g_chain_resume_source;
+  g_status.chain_state_writes = g_chain_state.writes();
+  WssLogRetentionStats rs = g_retention.stats();
+  g_status.retention_running = rs.running;
+  g_status.retention_phase = rs.phase;
+  g_status.retention_files_deleted = rs.files_deleted;
+  g_status.retention_archives_deleted = rs.archives_deleted;
+  g_status.retention_days_archived = rs.days_archived;
+  g_status.retention_quota_unreachable = rs.quota_unreachable;
+  g_status.log_used_bytes = rs.used_bytes;
+  g_status.log_archive_bytes = rs.archive_bytes;
+  g_status.log_archive_months = rs.archive_months;
+  g_status.backfill_active = g_backfill_active;
+  g_status.backfill_lines = g_backfill_lines;
+#endif
+  g_status.backfill_pending = g_fallback.pending();
+  if (g_status_snap_lock) xSemaphoreTake(g_status_snap_lock, portMAX_DELAY);
+  g_status_snap = g_status;
+  if (g_status_snap_lock) xSemaphoreGive(g_status_snap_lock);
   return g_status;
 }
 
-bool wss_storage_append_line(const String& line) {
-  // M3: optionally attach hash chain fields (or explicit nulls when disabled).
-  String out = line;
-  bool transformed = false;
+// M3: attaches hash chain fields continuing from `prev_hash` (or explicit nulls when
+// disabled) in a single pass; the parse/re-serialize path only handles lines the fast
+// path refuses. True when the line was chained and `prev_hash` advanced.
+static bool chain_line(const char* line, size_t len, String& prev_hash, String& out) {
+  char new_hash[65];
+  if (!g_hash_chain_enabled) {
+    if (!wss_log_chain_line(line, len, nullptr, out, new_hash)) out = line;
+    return false;
+  }
+  String prev = clamp_prev_hash(prev_hash);
+  String slow_hash;
+  if (wss_log_chain_line(line, len, prev.c_str(), out, new_hash)) {
+    prev_hash = new_hash;
+    return true;
+  }
+  if (apply_hash_chain_to_jsonl(String(line), prev, out, slow_hash)) {
+    prev_hash = slow_hash;
+    return true;
+  }
+  out = line;
+  return false;
+}
 
-  if (g_hash_chain_enabled) {
-    String hashed;
-    String new_hash;
-    if (apply_hash_chain_to_jsonl(line, g_prev_hash, hashed, new_hash)) {
-      out = hashed;
-      g_prev_hash = new_hash;
-      g_status.chain_head_hash = g_prev_hash;
-      transformed = true;
-    }
-  } else {
-    // Best-effort: explicit nulls for clarity when hashing is disabled.
-    DynamicJsonDocument d(768);
-    if (!deserializeJson(d, line)) {
-      JsonObject root = d.as<JsonObject>();
-      if (!root.isNull()) {
-        root["prev_hash"] = nullptr;
-        root["hash"] = nullptr;
-        String tmp;
-        serializeJson(root, tmp);
-        out = tmp;
-        transformed = true;
-      }
-    }
+#if WSS_FEATURE_SD
+// Storage-written records (file header, checkpoints, resume markers) belong to the file
+// they were written into; they are not carried over to the flash ring.
+static bool is_meta_line(const String& line) {
+  if (line.indexOf("\"source\":\"log\"") < 0) return false;
+  return line.indexOf("\"event_type\":\"log_checkpoint\"") >= 0 ||
+         line.indexOf("\"event_type\":\"day_close\"") >= 0 ||
+         line.indexOf("\"event_type\":\"file_header\"") >= 0 ||
+         line.indexOf("\"event_type\":\"log_resume\"") >= 0;
+}
+
+// Copies the lines that are still only in the write-behind ring to the flash ring, on
+// the ring's own chain; the backfill re-chains them onto the SD chain. Lines being
+// backfilled are skipped: the flash ring still has them pending.
+static void sd_wb_mirror_pending() {
+  if (g_backfill_active) return;
+  uint64_t off = g_wb_safe > g_wb.start() ? g_wb_safe : g_wb.start();
+  String line;
+  if (g_wb_partial_head && off == g_wb.start()) {
+    off = g_wb.read_line(off, line); // its head went out to the card; cannot be mirrored
+  }
+  while (off > 0 && off < g_wb.end()) {
+    off = g_wb.read_line(off, line);
+    if (off == 0) break; // a line torn by the failed write
+    if (!wss_log_record_to_text(line) || is_meta_line(line)) continue;
+    (void)wss_log_strip_chain(line);
+    String out;
+    (void)chain_line(line.c_str(), line.length(), g_flash_prev_hash, out);
+    if (g_fallback.append(out)) g_wb_mirrored_lines++;
   }
+}
+
+// A write to the active day file failed: unmount and switch logging to the flash ring,
+// moving the lines that never reached the card there first. Caller holds the lock.
+static void sd_write_failed() {
+  sd_wb_mirror_pending();
+  g_status.write_fail_count++;
+  g_status.last_write_backend = "sd";
+  g_status.last_write_ok = false;
+  g_status.last_write_error = "sd_write_failed";
+  g_status.sd_mounted = false;
+  g_status.sd_status = "ERROR";
+  g_status.fallback_active = true;
+  g_status.active_backend = "flash";
+  g_backfill_active = false;
+  // The index record may name lines that are not on the card; the next open re-derives
+  // it from the chain-state record or the file itself.
+  g_active_dirty = false;
+  g_wb.reset(g_wb_safe); // the file is cut back to the last line known to be on the card
+  g_unflushed_bytes = 0;
+  sd_close_log_file();
+  g_status.active_log_path = "";
+  // Only enqueues (never recurses into the writer).
+  if (g_log) g_log->log_warn("sd", "sd_status", "SD write failed; switched to fallback ring");
+}
+
+// Chains one line onto the SD chain and appends it to the active day file. Caller holds
+// g_storage_lock and has checked that the file is open. A write error unmounts the card
+// and switches logging to the flash ring.
+static bool sd_commit_line(const char* line, size_t len, bool flush_now) {
+  String out;
+  const bool chained = chain_line(line, len, g_prev_hash, out);
+  if (chained) g_status.chain_head_hash = g_prev_hash;
+  const uint64_t line_offset = sd_logical_eof();
+  size_t n = sd_log_line(out);
+  if (n == 0) {
+    sd_write_failed();
+    return false;
+  }
+  g_status.last_write_backend = "sd";
+  g_status.last_write_ok = true;
+  g_status.last_write_error = "";
+  g_unflushed_bytes += (uint32_t)n;
+  sd_note_active_line(out, g_hash_chain_enabled ? g_prev_hash.c_str() : nullptr);
+  g_seek_index.note_line(out.c_str(), line_offset);
+  if (chained) sd_note_checkpoint_leaf(out, g_prev_hash);
+  if (flush_now) sd_flush_now(); // a failure here mirrors the line to the flash ring
+  return true;
+}
+
+// Writer side: writes out one chunk of staged full sectors once enough have piled up.
+// True when a chunk was written (more may be due).
+static bool sd_wb_drain_if_due() {
+  StorageLock lock;
+  if (!g_file || g_wb.end() - g_wb_written < g_wb_chunk_bytes) return false;
+  if (!sd_wb_drain(g_wb_chunk_bytes)) {
+    sd_write_failed();
+    return false;
+  }
+  return true;
+}
 
-  // Prefer SD if mounted.
+// esp_restart() paths that did not go through wss_storage_flush_pending(): the ring is
+// written out, or mirrored to the flash ring when the card fails.
+static void storage_shutdown_handler() {
+  if (!g_storage_lock) return;
+  if (xSemaphoreTakeRecursive(g_storage_lock, pdMS_TO_TICKS(500)) != pdTRUE) return;
+  sd_flush_now();
+  xSemaphoreGiveRecursive(g_storage_lock);
+}
+#endif
+
+// Writer side: persists one line to the active backend. Caller holds g_storage_lock.
+// SD lines are flushed per the durability policy (wss_log_flush_required / sd_flush_if_due).
+static bool commit_line(const char* line, size_t len, WssLogSeverity sev, uint8_t flags) {
+  // Prefer SD if mounted. While a backfill runs, new lines queue up behind the stranded
+  // ones in the flash ring so the day files stay in seq order.
 #if WSS_FEATURE_SD
-  if (g_status.feature_enabled && g_status.pinmap_configured && g_status.sd_mounted && g_file) {
-    size_t n = g_file.println(out);
-    g_file.flush();
-    g_status.last_write_backend = "sd";
-    g_status.last_write_ok = (n > 0);
-    g_status.last_write_error = g_status.last_write_ok ? "" : "sd_write_failed";
-    if (n > 0) return true;
-
-    // If write fails, fall back.
-    g_status.write_fail_count++;
-    g_status.sd_mounted = false;
-    g_status.sd_status = "ERROR";
-    g_status.fallback_active = true;
-    g_status.active_backend = "flash";
-    if (g_file) g_file.close();
-    g_status.active_log_path = "";
-    if (g_log) g_log->log_warn("sd", "sd_status", "SD write failed; switched to fallback ring");
+  if (g_status.feature_enabled && g_status.pinmap_configured && g_status.sd_mounted && g_file &&
+      !g_backfill_active) {
+    if (sd_commit_line(line, len, wss_log_flush_required(g_flush_mode, sev, flags))) return true;
   }
 #endif
+  (void)sev;
+  (void)flags;
 
+  // The ring keeps its own chain; the backfill re-chains its lines onto the SD chain.
+  String out;
+  (void)chain_line(line, len, g_flash_prev_hash, out);
   bool ok = g_fallback.append(out);
   g_status.last_write_backend = "flash";
   g_status.last_write_ok = ok;
   g_status.last_write_error = ok ? "" : "flash_ring_append_failed";
   if (!ok) {
     g_status.write_fail_count++;
-    // Cannot log via logger here (would recurse). Make failure visible via status + serial.
+    // Logging here would only re-queue the failure. Make it visible via status + serial.
     Serial.println("[storage] ERROR: flash ring append failed (logs may be lost)");
   }
   return ok;
 }
 
+#if WSS_FEATURE_SD
+// Copies the next few stranded ring lines (kBackfillBatchLines / kBackfillBudgetMs) to
+// their day files, flushes, and only then marks them drained: a power cut in between
+// duplicates lines on the card instead of losing them. Runs on the writer task (the loop
+// only without one), so neither the flush nor a day-file open is on the alarm path; the
+// budget keeps each lock hold short for the queue and web readers.
+static void backfill_step() {
+  if (!g_backfill_active) return;
+  StorageLock lock;
+  if (!g_backfill_active || !g_status.sd_mounted || !g_file) return;
+
+  // The legacy NVS ring keeps its drained mark in RAM only, so it goes in larger steps (a
+  // reboot mid-copy copies lines again, never loses them); the time budget bounds both.
+  const bool nvs = strcmp(g_fallback.backend(), "nvs") == 0;
+  const size_t max_lines = nvs ? kBackfillMaxBatchLines : kBackfillBatchLines;
+  const uint32_t start_ms = millis();
+  WssFlashLogCursor done[kBackfillMaxBatchLines];
+  size_t n = 0;
+  String rec;
+  WssFlashLogCursor at;
+  while (n < max_lines && (uint32_t)(millis() - start_ms) < kBackfillBudgetMs) {
+    if (!g_fallback.next_pending(g_backfill_cursor, rec, at)) break;
+    (void)wss_log_strip_chain(rec);
+    uint32_t seq = 0;
+    uint32_t ts = 0;
+    (void)wss_log_line_seq_ts(rec.c_str(), seq, ts);
+    if (ts && date_key_utc((time_t)ts) != g_last_day_key &&
+        !open_log_file_if_needed((time_t)ts)) {
+      // Left pending; the next mount retries.
+      g_backfill_active = false;
+      g_sd_last_error = "sd_backfill_open_failed";
+      break;
+    }
+    if (!g_file || !sd_commit_line(rec.c_str(), rec.length(), false)) break;
+    done[n++] = at;
+  }
+  if (n > 0 && g_status.sd_mounted && g_file) {
+    sd_flush_now();
+    for (size_t i = 0; i < n; i++) (void)g_fallback.mark_drained(done[i]);
+    g_backfill_lines += (uint32_t)n;
+  }
+  if (!g_status.sd_mounted) return;
+  if (g_backfill_active && g_fallback.pending() > 0) return;
+
+  const bool completed = g_backfill_active;
+  g_backfill_active = false;
+  (void)open_log_file_if_needed(time(nullptr));
+  if (!g_file) return;
+  g_status.fallback_active = false;
+  g_status.active_backend = "sd";
+  if (completed && g_log) {
+    StaticJsonDocument<128> extra;
+    extra["lines_since_boot"] = g_backfill_lines;
+    JsonObjectConst o = extra.as<JsonObjectConst>();
+    g_log->log_info("sd", "log_backfill", "fallback ring copied to SD", &o);
+  }
+}
+#endif
+
+// Writer side: drains up to `max_lines` queued lines and commits them with one SD flush.
+static size_t drain_pending_batch(size_t max_lines) {
+  if (g_log_queue.empty()) return 0;
+  StorageLock lock;
+  size_t n = 0;
+  WssLogQueueItem item;
+  while (n < max_lines && g_log_queue.peek(item)) {
+    (void)commit_line(item.data, item.len, item.sev, item.flags);
+    g_log_queue.pop();
+    n++;
+  }
+  // Group commit: lines that did not force a flush share one FAT update per interval.
+  sd_flush_if_due();
+  if (n > 0) {
+    g_log_batches++;
+    g_log_lines_committed += (uint32_t)n;
+    if (n > g_log_max_batch_lines) g_log_max_batch_lines = (uint32_t)n;
+  }
+  return n;
+}
+
+bool wss_storage_queue_begin() {
+  return g_log_queue.begin();
+}
+
+bool wss_storage_append_line(const String& line, WssLogSeverity sev, uint8_t flags) {
+  // Callers (state machine, NFC, HTTP handlers) never wait on SD latency here.
+  bool ok = g_log_queue.push(line.c_str(), line.length(), sev, flags);
+  if (ok && g_writer_task) xTaskNotifyGive(g_writer_task);
+  return ok;
+}
+
+bool wss_storage_flush_pending(uint32_t timeout_ms) {
+  const uint32_t start_ms = millis();
+  if (!g_writer_task) {
+    StorageLock lock;
+    while (drain_pending_batch(kWriterMaxBatchLines) > 0) {
+    }
+    sd_flush_now();
+#if WSS_FEATURE_SD
+    sd_save_active_entry();
+#endif
+    return g_log_queue.empty();
+  }
+  while (!g_log_queue.empty()) {
+    if ((uint32_t)(millis() - start_ms) >= timeout_ms) return false;
+    xTaskNotifyGive(g_writer_task);
+    delay(5);
+  }
+  // The writer pops under the lock, so taking it waits out the in-flight batch.
+  StorageLock lock;
+  sd_flush_now();
+#if WSS_FEATURE_SD
+  sd_save_active_entry();
+#endif
+  return true;
+}
+
 size_t wss_storage_read_fallback(String* out, size_t max_items) {
+  StorageLock lock;
   return g_fallback.read_recent(out, max_items);
 }
 
@@ -827,10 +1809,12 @@ bool wss_storage_list_log_files(WssLogFileInfo* out, size_t max_items, size_t& o
   err = "sd_disabled";
   return false;
 #else
+  StorageLock lock;
   if (!g_status.sd_mounted) {
     err = "sd_not_mounted";
     return false;
   }
+  sd_flush_now(); // report sizes that include buffered lines
   struct ListCtx {
     WssLogFileInfo* out;
     size_t max_items;
@@ -838,7 +1822,8 @@ bool wss_storage_list_log_files(WssLogFileInfo* out, size_t max_items, size_t& o
     bool truncated;
   };
   ListCtx ctx{out, max_items, 0, false};
-  auto cb = [](const String& path, uint64_t size_bytes, void* ptr) -> bool {
+  auto cb = [](const String& path, uint64_t size_bytes, bool binary, void* ptr) -> bool {
+    (void)binary;
     ListCtx* c = static_cast<ListCtx*>(ptr);
     if (c->count < c->max_items) {
       c->out[c->count].name = path;
@@ -865,17 +1850,20 @@ bool wss_storage_log_bytes(WssLogRange range, uint64_t& total_bytes, size_t& fil
   err = "sd_disabled";
   return false;
 #else
+  StorageLock lock;
   if (!g_status.sd_mounted) {
     err = "sd_not_mounted";
     return false;
   }
+  sd_flush_now(); // report sizes that include buffered lines
   struct SizeCtx {
     uint64_t total_bytes;
     size_t file_count;
   };
   SizeCtx size_ctx{0, 0};
-  auto size_cb = [](const String& path, uint64_t size_bytes, void* ptr) -> bool {
+  auto size_cb = [](const String& path, uint64_t size_bytes, bool binary, void* ptr) -> bool {
     (void)path;
+    (void)binary;
     SizeCtx* c = static_cast<SizeCtx*>(ptr);
     c->total_bytes += size_bytes;
     c->file_count++;
@@ -889,42 +1877,125 @@ bool wss_storage_log_bytes(WssLogRange range, uint64_t& total_bytes, size_t& fil
 #endif
 }
 
-bool wss_storage_stream_logs(WssLogRange range, Stream& out, uint32_t max_bytes,
+bool wss_storage_log_range_info(WssLogRange range, uint64_t& total_bytes, size_t& file_count,
+                                String& etag, bool& converted, String& err) {
+  total_bytes = 0;
+  file_count = 0;
+  etag = "";
+  converted = false;
+  err = "";
+#if !WSS_FEATURE_SD
+  (void)range;
+  err = "sd_disabled";
+  return false;
+#else
+  StorageLock lock;
+  sd_flush_now(); // sizes include buffered lines
+  struct InfoCtx {
+    WssSha256* sha;
+    uint64_t total_bytes;
+    size_t file_count;
+    bool converted;
+  };
+  WssSha256 sha;
+  InfoCtx ctx{&sha, 0, 0, false};
+  auto info_cb = [](const String& path, uint64_t size_bytes, bool binary, void* ptr) -> bool {
+    InfoCtx* c = static_cast<InfoCtx*>(ptr);
+    c->sha->update(path.c_str(), path.length());
+    if (!(g_file && path == g_status.active_log_path)) {
+      c->sha->update(reinterpret_cast<const uint8_t*>(&size_bytes), sizeof(size_bytes));
+    }
+    c->converted = c->converted || (binary && size_bytes);
+    c->total_bytes += size_bytes;
+    c->file_count++;
+    return true;
+  };
+  if (!for_each_log_file(range, info_cb, &ctx, err)) return false;
+  uint8_t digest[32];
+  sha.finish(digest);
+  char hex[17];
+  wss_hex_lower(digest, 8, hex);
+  etag = String("\"") + String(hex) + String("\"");
+  total_bytes = ctx.total_bytes;
+  file_count = ctx.file_count;
+  converted = ctx.converted;
+  return true;
+#endif
+}
+
+bool wss_storage_stream_logs(WssLogRange range, Print& out, uint64_t offset, uint64_t length,
                              size_t& bytes_sent, String& err) {
   bytes_sent = 0;
   err = "";
 #if !WSS_FEATURE_SD
+  (void)range;
+  (void)out;
+  (void)offset;
+  (void)length;
   err = "sd_disabled";
   return false;
 #else
-  uint64_t total_bytes = 0;
-  size_t file_count = 0;
-  if (!wss_storage_log_bytes(range, total_bytes, file_count, err)) return false;
-  if (total_bytes > max_bytes) {
-    err = "too_large";
-    return false;
-  }
+  StorageLock lock;
+  sd_flush_now(); // downloads include lines still buffered by the durability policy
 
   struct StreamCtx {
-    Stream* out;
+    Print* out;
+    WssLogJsonlExport* jsonl; // begun at the first binary day file
+    bool jsonl_ready;
+    uint64_t pos;       // offset of the current file within the concatenation
+    uint64_t offset;    // first byte to send
+    uint64_t remaining; // bytes still to send
     size_t bytes_sent;
     String err;
   };
-  StreamCtx stream_ctx{&out, 0, ""};
-  auto stream_cb = [](const String& path, uint64_t size_bytes, void* ptr) -> bool {
-    (void)size_bytes;
+  WssLogJsonlExport jsonl;
+  StreamCtx stream_ctx{&out, &jsonl, false, 0, offset, length, 0, ""};
+  auto stream_cb = [](const String& path, uint64_t size_bytes, bool binary, void* ptr) -> bool {
     StreamCtx* c = static_cast<StreamCtx*>(ptr);
-    FsFile f = g_sd.open(path.c_str(), O_RDONLY);
+    const uint64_t file_start = c->pos;
+    c->pos += size_bytes;
+    if (c->remaining == 0) return false;
+    if (c->pos <= c->offset) return true; // entirely before the requested range
+    WssStorageFile f = g_fs->open(path.c_str(), WSS_FS_READ);
     if (!f) {
       c->err = "log_open_failed";
       return false;
     }
+    uint64_t skip = c->offset > file_start ? c->offset - file_start : 0;
+    // Never past the size the range was measured with (the active file keeps growing).
+    uint64_t avail = size_bytes - skip;
+    // Binary day files go out as their JSONL text (whole files only: the caller sends no
+    // byte ranges for them, see wss_storage_log_range_info()).
+    if (binary && !c->jsonl_ready) {
+      c->jsonl_ready = c->jsonl->begin(*c->out);
+      if (!c->jsonl_ready) {
+        f.close();
+        c->err = "no_memory";
+        return false;
+      }
+    }
+    Print* sink = binary ? static_cast<Print*>(c->jsonl) : c->out;
+    if (!f.seek(skip)) {
+      f.close();
+      c->err = "log_seek_failed";
+      return false;
+    }
     uint8_t buf[1024];
-    while (f.available()) {
-      int32_t got = f.read(buf, sizeof(buf));
+    while (avail > 0 && c->remaining > 0) {
+      size_t want = sizeof(buf);
+      if (want > avail) want = (size_t)avail;
+      if (want > c->remaining) want = (size_t)c->remaining;
+      int32_t got = f.read(buf, want);
       if (got <= 0) break;
-      size_t wrote = c->out->write(buf, (size_t)got);
+      size_t wrote = 0;
+      {
+        // Don't hold the writer off SD while a slow client drains the socket.
+        StorageUnlock unlock;
+        wrote = sink->write(buf, (size_t)got);
+      }
       c->bytes_sent += wrote;
+      c->remaining -= wrote;
+      avail -= wrote;
       if (wrote != (size_t)got) {
         c->err = "log_stream_failed";
         f.close();
@@ -932,14 +2003,460 @@ bool wss_storage_stream_logs(WssLogRange range, Stream& out, uint32_t max_bytes,
       }
     }
     f.close();
-    return true;
+    if (binary) (void)c->jsonl->finish(); // a record cut by the range end is dropped
+    return c->remaining > 0;
   };
   bool ok = for_each_log_file(range, stream_cb, &stream_ctx, err);
-  if (!ok) {
-    if (stream_ctx.err.length()) err = stream_ctx.err;
+  bytes_sent = stream_ctx.bytes_sent;
+  if (stream_ctx.err.length()) {
+    err = stream_ctx.err;
     return false;
   }
-  bytes_sent = stream_ctx.bytes_sent;
+  // for_each stops early (returns false) once the requested bytes are out.
+  if (!ok && stream_ctx.remaining > 0 && err.length()) return false;
+  return true;
+#endif
+}
+
+#if WSS_FEATURE_SD
+static const size_t kQueryMaxLine = WSS_LOG_LINE_MAX;
+
+// Line buffers for query/verify: the assembled day-file line, then room for the JSONL text
+// of a binary record.
+static char* alloc_line_buffers() {
+  return static_cast<char*>(malloc(2 * (kQueryMaxLine + 1)));
+}
+
+// JSONL text of one assembled line (NUL-terminated): binary records are decoded into the
+// second half of the buffer. Null when a record is malformed.
+static const char* line_text(char* line, size_t& len) {
+  if (!wss_log_record_is_binary(line, len)) return line;
+  char* text = line + kQueryMaxLine + 1;
+  return wss_log_record_decode(line, len, text, kQueryMaxLine + 1, len) ? text : nullptr;
+}
+
+struct QueryScan {
+  const WssLogQuery* q;
+  Print* out;
+  WssLogQueryResult* res;
+  bool file_done; // an event line passed to_seq (event seqs only grow within a file)
+  WssLogFieldFilter event_type;
+  WssLogFieldFilter source;
+  WssLogFieldFilter severity;
+};
+
+static bool query_filters_begin(QueryScan& st, const WssLogQuery& q) {
+  return st.event_type.begin("event_type", q.event_type) &&
+         st.source.begin("source", q.source) &&
+         st.severity.begin("severity", q.severity, true);
+}
+
+// Applies the query filters to one complete line and writes it when it matches.
+static void query_line(QueryScan& st, const char* line, size_t len) {
+  const WssLogQuery& q = *st.q;
+  uint32_t seq = 0;
+  uint32_t ts = 0;
+  bool has_seq = wss_log_line_seq_ts(line, seq, ts);
+  if (q.from_seq || q.to_seq) {
+    if (!has_seq) return;
+    if (q.to_seq && seq > q.to_seq) {
+      // Checkpoints written during a flash-ring backfill carry newer seqs than the
+      // backfilled lines around them, so only event lines end the file.
+      if (wss_log_meta_kind(line) == WSS_LOG_META_NONE) st.file_done = true;
+      return;
+    }
+    if (q.from_seq && seq < q.from_seq) return;
+  }
+  if (!st.event_type.match(line) || !st.source.match(line) || !st.severity.match(line)) return;
+  if (q.from_ts && (ts == 0 || ts < q.from_ts)) return;
+  if (q.to_ts && (ts == 0 || ts > q.to_ts)) return;
+  {
+    // Don't hold the writer off SD while a slow client drains the socket.
+    StorageUnlock unlock;
+    st.out->write(reinterpret_cast<const uint8_t*>(line), len);
+    st.out->write('\n');
+  }
+  st.res->lines++;
+  if (has_seq) st.res->last_seq = seq;
+}
+
+// Reads [start, end) of one day file line by line. Returns false on read errors.
+static bool query_file(QueryScan& st, uint32_t date, const String& path, uint64_t start,
+                       uint64_t end, char* line) {
+  WssStorageFile f = g_fs->open(path.c_str(), WSS_FS_READ);
+  if (!f) return false;
+  if (!f.seek(start)) {
+    f.close();
+    return false;
+  }
+  st.res->files++;
+  st.file_done = false;
+  uint8_t buf[512];
+  size_t line_len = 0;
+  bool overlong = false;
+  uint64_t pos = start;
+  const uint32_t max_lines = st.q->max_lines ? st.q->max_lines : UINT32_MAX;
+  while (pos < end && !st.file_done && !st.res->truncated) {
+    size_t want = sizeof(buf);
+    if (end - pos < want) want = (size_t)(end - pos);
+    int32_t got = f.read(buf, want);
+    if (got <= 0) break;
+    const uint64_t chunk_pos = pos;
+    pos += (uint64_t)got;
+    st.res->bytes_scanned += (uint64_t)got;
+    for (int32_t i = 0; i < got && !st.file_done; i++) {
+      char c = (char)buf[i];
+      if (c != '\n') {
+        if (line_len < kQueryMaxLine) line[line_len++] = c;
+        else overlong = true;
+        continue;
+      }
+      size_t text_len = line_len;
+      const char* text = nullptr;
+      if (line_len && !overlong) {
+        line[line_len] = 0;
+        text = line_text(line, text_len);
+      }
+      if (text) {
+        query_line(st, text, text_len);
+        if (st.res->lines >= max_lines) {
+          st.res->truncated = true;
+          st.res->next_date = date;
+          st.res->next_offset = (uint32_t)(chunk_pos + (uint64_t)i + 1);
+          break;
+        }
+      }
+      line_len = 0;
+      overlong = false;
+    }
+  }
+  f.close();
+  return true;
+}
+#endif
+
+bool wss_storage_query_valid(const WssLogQuery& q, String& err) {
+  WssLogFieldFilter f;
+  if (f.begin("event_type", q.event_type) && f.begin("source", q.source) &&
+      f.begin("severity", q.severity, true)) {
+    return true;
+  }
+  err = "bad_filter";
+  return false;
+}
+
+bool wss_storage_query_logs(const WssLogQuery& q, Print& out, WssLogQueryResult& res,
+                            String& err) {
+  res = WssLogQueryResult();
+  err = "";
+#if !WSS_FEATURE_SD
+  (void)q;
+  (void)out;
+  err = "sd_disabled";
+  return false;
+#else
+  StorageLock lock;
+  if (!g_status.sd_mounted) {
+    err = "sd_not_mounted";
+    return false;
+  }
+  if (!g_log_index.ready() && !g_log_index.begin(g_fs)) {
+    err = "log_index_unavailable";
+    return false;
+  }
+  sd_flush_now(); // buffered lines and their seek samples become readable
+
+  uint32_t start_date = 0;
+  uint32_t end_date = UINT32_MAX;
+  if (q.from_ts) start_date = WssLogIndex::date_from_key(date_key_utc((time_t)q.from_ts));
+  if (q.to_ts) end_date = WssLogIndex::date_from_key(date_key_utc((time_t)q.to_ts));
+  if (q.cursor_date > start_date) start_date = q.cursor_date;
+
+  char* line = alloc_line_buffers();
+  if (!line) {
+    err = "no_memory";
+    return false;
+  }
+  QueryScan st;
+  st.q = &q;
+  st.out = &out;
+  st.res = &res;
+  st.file_done = false;
+  if (!query_filters_begin(st, q)) {
+    free(line);
+    err = "bad_filter";
+    return false;
+  }
+  bool ok = true;
+  WssLogIndexEntry e;
+  uint32_t next_date = start_date;
+  while (!res.truncated && g_log_index.next_at_or_after(next_date, e) && e.date <= end_date) {
+    next_date = e.date + 1;
+    if (g_file && e.date == g_active_entry.date) {
+      e = g_active_entry;
+      e.size_bytes = (uint32_t)sd_logical_eof();
+    }
+    // Skip whole days by their seq span (0 = unknown, so the file is read).
+    if (q.from_seq && e.last_seq && e.last_seq < q.from_seq) continue;
+    if (q.to_seq && e.first_seq && e.first_seq > q.to_seq) continue;
+
+    String path = WssLogIndex::path_for(e.date);
+    uint64_t start = 0;
+    uint64_t end = e.size_bytes;
+    WssLogSeekIndex::lookup(g_fs, path, q.from_seq, q.to_seq, q.from_ts, q.to_ts,
+                            e.size_bytes, start, end);
+    if (e.date == q.cursor_date && q.cursor_offset > start) start = q.cursor_offset;
+    if (start >= end) continue;
+    if (!query_file(st, e.date, path, start, end, line)) {
+      err = "log_open_failed";
+      ok = false;
+      break;
+    }
+  }
+  free(line);
+  return ok;
+#endif
+}
+
+#if WSS_FEATURE_SD
+static const uint32_t kVerifyStackBytes = 8192;
+static const UBaseType_t kVerifyPriority = 1;
+static TaskHandle_t g_verify_task = nullptr;
+static WssLogVerifyStatus g_verify; // guarded by g_storage_lock
+static bool g_verify_log_pending = false;
+
+// A malformed binary record goes to the verifier as is, which reports it as malformed.
+static void verify_line(WssLogChainVerifier& v, char* line, size_t len, uint64_t next) {
+  line[len] = 0;
+  size_t text_len = len;
+  const char* text = line_text(line, text_len);
+  if (text) v.line(text, text_len, next);
+  else v.line(line, len, next);
+}
+
+static bool verify_span(WssLogChainVerifier& v, WssStorageFile& f, uint64_t start, uint64_t end,
+                        char* line);
+
+// Checkpoint mode: reads a segment that failed the first pass again, re-hashing each line.
+// Only one level deep: nothing comes due while the verifier is re-hashing.
+static bool verify_rehash_if_due(WssLogChainVerifier& v, WssStorageFile& f, char* line) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+  if (!v.rehash_due(start, end)) return true;
+  v.begin_rehash();
+  const bool ok = verify_span(v, f, start, end, line);
+  v.end_rehash();
+  return ok;
+}
+
+// Feeds the lines of [start, end) of an open day file to the verifier. SD is only touched
+// under the lock, so the writer keeps committing while a long check runs.
+static bool verify_span(WssLogChainVerifier& v, WssStorageFile& f, uint64_t start, uint64_t end,
+                        char* line) {
+  uint8_t buf[512];
+  size_t line_len = 0;
+  uint64_t pos = start;
+  while (pos < end) {
+    size_t want = sizeof(buf);
+    if (end - pos < want) want = (size_t)(end - pos);
+    int32_t got;
+    {
+      StorageLock lock;
+      got = (g_status.sd_mounted && f.seek(pos)) ? f.read(buf, want) : -1;
+    }
+    if (got <= 0) return false;
+    const uint64_t chunk_pos = pos;
+    pos += (uint64_t)got;
+    {
+      StorageLock lock;
+      g_verify.bytes_scanned += (uint64_t)got;
+    }
+    for (int32_t i = 0; i < got; i++) {
+      char c = (char)buf[i];
+      if (c != '\n') {
+        // Overlong lines are cut and then reported as malformed.
+        if (line_len < kQueryMaxLine) line[line_len++] = c;
+        continue;
+      }
+      verify_line(v, line, line_len, chunk_pos + (uint64_t)i + 1);
+      line_len = 0;
+      if (!verify_rehash_if_due(v, f, line)) return false;
+    }
+  }
+  if (line_len) {
+    verify_line(v, line, line_len, end);
+    if (!verify_rehash_if_due(v, f, line)) return false;
+  }
   return true;
+}
+
+// Verifies one day file; in checkpoint mode failed segments and the uncovered tail are
+// re-read and re-hashed as they come up.
+static bool verify_file(WssLogChainVerifier& v, const WssLogIndexEntry& e, char* line) {
+  String path = WssLogIndex::path_for(e.date);
+  WssStorageFile f;
+  uint64_t end = 0;
+  {
+    StorageLock lock;
+    if (g_file && e.date == g_active_entry.date) {
+      sd_flush_now();
+      end = sd_logical_eof();
+    } else {
+      end = e.size_bytes;
+    }
+    f = g_fs->open(path.c_str(), WSS_FS_READ);
+    if (!f) return false;
+  }
+  v.begin_file(WssLogIndex::key_for(e.date));
+  bool ok = verify_span(v, f, 0, end, line);
+  if (ok) {
+    v.end_data(end);
+    ok = verify_rehash_if_due(v, f, line);
+  }
+  v.end_file();
+  StorageLock lock;
+  f.close();
+  return ok;
+}
+
+static void verify_task(void* arg) {
+  (void)arg;
+  const uint32_t start_ms = millis();
+  WssLogRange range;
+  WssLogVerifyMode mode;
+  {
+    StorageLock lock;
+    range = g_verify.range;
+    mode = g_verify.mode;
+  }
+  WssLogChainVerifier v(mode);
+  String err;
+  char* line = alloc_line_buffers();
+  if (!line) err = "no_memory";
+
+  String start_key;
+  String end_key;
+  compute_range_keys(range, start_key, end_key);
+  uint32_t next_date = 0;
+  uint32_t end_date = UINT32_MAX;
+  if (range != WSS_LOG_RANGE_ALL) {
+    next_date = WssLogIndex::date_from_key(start_key);
+    end_date = WssLogIndex::date_from_key(end_key);
+  }
+  while (!err.length()) {
+    WssLogIndexEntry e;
+    {
+      StorageLock lock;
+      if (!g_status.sd_mounted) {
+        err = "sd_not_mounted";
+        break;
+      }
+      if (!g_log_index.next_at_or_after(next_date, e) || e.date > end_date) break;
+    }
+    next_date = e.date + 1;
+    if (!verify_file(v, e, line)) err = "log_read_failed";
+    StorageLock lock;
+    g_verify.report = v.report();
+    g_verify.elapsed_ms = millis() - start_ms;
+  }
+  free(line);
+
+  WssLogVerifyReport rep = v.report();
+  {
+    StorageLock lock;
+    g_verify.report = rep;
+    g_verify.error = err;
+    g_verify.elapsed_ms = millis() - start_ms;
+    g_verify.ok = !err.length() && rep.bad_lines == 0;
+    g_verify.done = true;
+    g_verify.running = false;
+    g_verify_log_pending = true; // logged by wss_storage_loop(), not from this task
+  }
+  {
+    StorageLock lock;
+    g_verify_task = nullptr;
+  }
+  vTaskDelete(nullptr);
+}
+
+// Logs a finished audit from the loop task: the event logger is only entered from the
+// loop and the storage writer, never from the audit task.
+static void verify_report_step() {
+  WssLogVerifyStatus v;
+  {
+    StorageTryLock lock;  // a busy writer only defers the report
+    if (!lock.held || !g_verify_log_pending) return;
+    g_verify_log_pending = false;
+    v = g_verify;
+  }
+  if (!g_log) return;
+  const WssLogVerifyReport& rep = v.report;
+  StaticJsonDocument<320> extra;
+  extra["mode"] = v.mode == WSS_LOG_VERIFY_FULL ? "full" : "checkpoint";
+  extra["files"] = rep.files;
+  extra["lines"] = rep.lines;
+  extra["rehashed_lines"] = rep.rehashed_lines;
+  extra["checkpoints"] = rep.checkpoints;
+  extra["bad_lines"] = rep.bad_lines;
+  extra["elapsed_ms"] = v.elapsed_ms;
+  if (rep.bad_lines) {
+    extra["first_bad_seq"] = rep.first_bad_seq;
+    extra["first_bad_file"] = rep.first_bad_file;
+    extra["reason"] = rep.first_bad_reason;
+  }
+  if (v.error.length()) extra["error"] = v.error;
+  JsonObjectConst o = extra.as<JsonObjectConst>();
+  if (rep.bad_lines || v.error.length()) {
+    g_log->log_warn("log", "log_verify_failed", "log chain verification failed", &o);
+  } else {
+    g_log->log_info("log", "log_verify", "log chain verified", &o);
+  }
+}
+#endif
+
+bool wss_storage_verify_start(WssLogRange range, WssLogVerifyMode mode, String& err) {
+  err = "";
+#if !WSS_FEATURE_SD
+  (void)range;
+  (void)mode;
+  err = "sd_disabled";
+  return false;
+#else
+  StorageLock lock;
+  // A finished job still counts until wss_storage_loop() has logged its result.
+  if (g_verify_task || g_verify.running || g_verify_log_pending) {
+    err = "verify_running";
+    return false;
+  }
+  if (!g_status.sd_mounted) {
+    err = "sd_not_mounted";
+    return false;
+  }
+  if (!g_log_index.ready() && !g_log_index.begin(g_fs)) {
+    err = "log_index_unavailable";
+    return false;
+  }
+  g_verify = WssLogVerifyStatus();
+  g_verify.range = range;
+  g_verify.mode = mode;
+  g_verify.running = true;
+  BaseType_t ok = xTaskCreatePinnedToCore(verify_task, "wss_logv", kVerifyStackBytes, nullptr,
+                                          kVerifyPriority, &g_verify_task, kWriterCore);
+  if (ok != pdPASS) {
+    g_verify_task = nullptr;
+    g_verify.running = false;
+    err = "task_create_failed";
+    return false;
+  }
+  return true;
+#endif
+}
+
+WssLogVerifyStatus wss_storage_verify_status() {
+#if !WSS_FEATURE_SD
+  return WssLogVerifyStatus();
+#else
+  StorageLock lock;
+  return g_verify;
 #endif
 }
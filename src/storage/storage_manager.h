@@ -4,6 +4,11 @@
 
 #include <Arduino.h>
 
+#include "latency_hist.h"
+#include "log_checkpoint.h"
+#include "log_queue.h"
+#include "storage_backend_timed.h"
+
 class WssConfigStore;
 class WssEventLogger;
 
@@ -22,6 +27,15 @@ struct WssStorageStatus {
 
   bool fallback_active = true;
   uint32_t fallback_count = 0;
+  String fallback_backend;             // partition|nvs (raw `logring` partition or legacy NVS ring)
+  uint32_t fallback_capacity_bytes = 0; // partition backend only
+  uint32_t fallback_used_bytes = 0;
+  uint32_t fallback_erases = 0;         // sector erases since boot
+  uint32_t fallback_max_wear = 0;       // highest per-sector erase count
+  uint32_t fallback_torn_records = 0;   // partial writes recovered at mount
+  bool backfill_active = false;         // copying ring lines to SD after a (re)mount
+  uint32_t backfill_pending = 0;        // ring lines not yet on SD
+  uint32_t backfill_lines = 0;          // lines copied to SD since boot
 
   // M3: log hashing + write diagnostics
   bool hash_chain_enabled = false;
@@ -33,6 +47,77 @@ struct WssStorageStatus {
 
   String active_backend; // sd|flash
   String active_log_path; // when sd backend
+
+  // Async log pipeline (bounded queue + writer task with group commit)
+  bool writer_task_running = false;
+  bool status_stale = false; // writer busy on the card: all but the queue fields are a copy
+  uint32_t log_queue_capacity = 0;
+  uint32_t log_queue_depth = 0;
+  uint32_t log_queue_high_water = 0;
+  uint32_t log_dropped_count = 0;
+  uint32_t log_dropped_debug = 0;
+  uint32_t log_dropped_info = 0;
+  uint32_t log_dropped_warn = 0; // warn + error
+  uint32_t log_dropped_overlong = 0; // over WSS_LOG_LINE_MAX, refused whole
+  uint32_t log_batches = 0;
+  uint32_t log_lines_committed = 0;
+  uint32_t log_max_batch_lines = 0;
+
+  // SD durability policy (config `sd_flush_mode` / `sd_flush_interval_ms`)
+  String sd_flush_mode;            // per_event|interval|severity
+  uint32_t sd_flush_interval_ms = 0;
+  uint32_t sd_unflushed_bytes = 0; // written to the active file but not yet flushed
+  uint32_t sd_last_flush_age_ms = 0;
+  uint32_t sd_flush_count = 0;
+
+  // Active day file layout (config `log_prealloc_kb`)
+  uint32_t sd_prealloc_bytes = 0;  // requested for the active file (0 = disabled/existing file)
+  bool sd_prealloc_ok = false;     // contiguous clusters were reserved
+  uint32_t sd_sector_writes = 0;   // sector-aligned writes issued since boot
+  uint32_t sd_logical_eof = 0;     // bytes of log data in the active file
+
+  // Day file format (config `log_format`); byte counts since boot
+  String log_format;               // jsonl|binary (of the active file)
+  uint64_t log_text_bytes = 0;     // JSONL size of the lines committed to SD
+  uint64_t log_stored_bytes = 0;   // bytes they took in the day files
+
+  // Write-behind ring in front of the active file (WSS_LOG_WRITE_BEHIND_BYTES; PSRAM on S3)
+  uint32_t sd_write_behind_bytes = 0;      // ring capacity
+  bool sd_write_behind_psram = false;
+  uint32_t sd_write_behind_pending = 0;    // staged bytes not yet written as full sectors
+  uint32_t sd_write_behind_high_water = 0; // most bytes held at once since boot
+  uint32_t sd_write_behind_mirrored = 0;   // lines moved to the flash ring after a failed write
+  uint32_t sd_write_stalls = 0;            // SD writes/flushes >= WSS_LOG_SD_STALL_MS since boot
+  uint32_t sd_write_stall_last_ms = 0;
+  uint32_t sd_write_stall_max_ms = 0;
+  uint32_t sd_write_stall_total_ms = 0;
+
+  // SD operation latency, indexed by WssStorageOp (open/append/flush/read/free_space/probe)
+  WssLatencyHist sd_latency[WSS_STORAGE_OP_COUNT];
+  uint32_t sd_probe_failures = 0;    // card status probes unanswered since boot
+  bool sd_free_estimated = false;    // free_bytes estimated from our writes since the last FAT read
+  uint32_t sd_free_refreshes = 0;    // FAT free-cluster scans since boot
+  uint32_t sd_free_refresh_age_s = 0;
+
+  // Day-file index (/logs/index.bin)
+  bool log_index_ready = false;
+  uint32_t log_index_files = 0;
+  uint32_t log_index_rebuilds = 0; // since boot (missing/stale index)
+  uint32_t log_checkpoints_written = 0; // log_checkpoint/day_close records since boot
+  String chain_resume_source;           // how the active file's chain head was recovered: index|chain_state|scan|new
+  uint32_t chain_state_writes = 0;      // /logs/chain.bin rewrites since boot
+
+  // Retention (config `log_retention_days` / `log_quota_mb` / `log_min_free_mb` /
+  // `log_archive_after_days`); counters are since boot.
+  bool retention_running = false;
+  String retention_phase;               // idle|age|quota|archive
+  uint32_t retention_files_deleted = 0;
+  uint32_t retention_archives_deleted = 0;
+  uint32_t retention_days_archived = 0;
+  bool retention_quota_unreachable = false; // over quota with only the active day left
+  uint64_t log_used_bytes = 0;          // day files + archives
+  uint64_t log_archive_bytes = 0;
+  uint32_t log_archive_months = 0;
 };
 
 struct WssLogFileInfo {
@@ -50,8 +135,19 @@ void wss_storage_begin(WssConfigStore* cfg, WssEventLogger* log);
 void wss_storage_loop();
 WssStorageStatus wss_storage_status();
 
-// Append a single JSONL line to the active backend (SD when available, else flash ring).
-bool wss_storage_append_line(const String& line);
+// Reserves the log queue's line slots (see log_queue.h). The event logger calls it from its
+// begin(), so lines logged before wss_storage_begin() are queued too.
+bool wss_storage_queue_begin();
+
+// Queue a single JSONL line for the active backend (SD when available, else flash ring).
+// Never blocks on SD/NVS: the writer task hash-chains and commits lines in batches.
+// Returns false when the line was dropped by the queue overflow policy (see log_queue.h).
+// `flags` (WssLogFlags) marks lines that must reach the card immediately in `severity` mode.
+bool wss_storage_append_line(const String& line, WssLogSeverity sev = WSS_LOG_SEV_INFO,
+                             uint8_t flags = WSS_LOG_FLAG_NONE);
+
+// Wait (bounded) until every queued line has been committed, e.g. before a reboot.
+bool wss_storage_flush_pending(uint32_t timeout_ms);
 
 // Export most-recent flash ring items (newest-last). Returns number written.
 size_t wss_storage_read_fallback(String* out, size_t max_items);
@@ -60,15 +156,89 @@ size_t wss_storage_read_fallback(String* out, size_t max_items);
 bool wss_storage_list_log_files(WssLogFileInfo* out, size_t max_items, size_t& out_count,
                                 bool& out_truncated, String& err);
 
-// Sum SD log bytes for a range (used to enforce download limits).
+// Sum SD log bytes for a range.
 bool wss_storage_log_bytes(WssLogRange range, uint64_t& total_bytes, size_t& file_count,
                            String& err);
 
-// Stream SD log files for the requested range to an output stream with a byte limit.
-// Returns false with err="too_large" if size exceeds max_bytes.
-bool wss_storage_stream_logs(WssLogRange range, Stream& out, uint32_t max_bytes,
+// Size plus a strong ETag for the concatenated day files of a range. The ETag covers the
+// date and size of every closed file; the active day file (always last, append-only)
+// contributes only its path, so bytes already downloaded stay valid while it grows and
+// a transfer can be resumed with Range + If-Range. `converted` is set when a file holds
+// binary records (`log_format=binary`): the download is then their JSONL text, whose size
+// is not known up front, so it can only be sent whole.
+bool wss_storage_log_range_info(WssLogRange range, uint64_t& total_bytes, size_t& file_count,
+                                String& etag, bool& converted, String& err);
+
+// Streams bytes [offset, offset + length) of the concatenated day files for the range.
+// Binary day files are decoded to JSONL on the way (offset 0 only); `bytes_sent` counts
+// day-file bytes. Memory use is constant regardless of the range size.
+bool wss_storage_stream_logs(WssLogRange range, Print& out, uint64_t offset, uint64_t length,
                              size_t& bytes_sent, String& err);
 
-// NFC allowlist persistence (SD preferred; returns false if SD unavailable).
+// Range query over SD day files. Bounds are inclusive; 0 means unbounded.
+struct WssLogQuery {
+  uint32_t from_seq = 0;
+  uint32_t to_seq = 0;
+  uint32_t from_ts = 0; // epoch seconds (UTC)
+  uint32_t to_ts = 0;
+  uint32_t max_lines = 500;
+  // Comma-separated accepted values, empty = any. severity also takes "warn+" (warn and
+  // above). Matched on the raw line bytes (WssLogFieldFilter).
+  String event_type;
+  String source;
+  String severity;
+  // Resume point from a previous truncated result: day file date and byte offset.
+  uint32_t cursor_date = 0; // YYYYMMDD, 0 = start from the filters
+  uint32_t cursor_offset = 0;
+};
+
+struct WssLogQueryResult {
+  uint32_t lines = 0;          // lines written to `out`
+  uint32_t files = 0;          // day files read
+  uint64_t bytes_scanned = 0;  // bytes read from SD
+  bool truncated = false;      // stopped at max_lines
+  uint32_t last_seq = 0;       // seq of the last line written (resume with from_seq = last_seq + 1)
+  uint32_t next_date = 0;      // when truncated: cursor_date/cursor_offset to resume from
+  uint32_t next_offset = 0;
+};
+
+// False (with err = "bad_filter") when a field filter list is malformed.
+bool wss_storage_query_valid(const WssLogQuery& q, String& err);
+
+// Streams matching JSONL lines (oldest first). Day files are picked from the log index and
+// each file is entered at the nearest seek-index sample, so only the matching span is read.
+bool wss_storage_query_logs(const WssLogQuery& q, Print& out, WssLogQueryResult& res,
+                            String& err);
+
+// On-device hash-chain check of a range of day files (see WssLogChainVerifier).
+// WSS_LOG_VERIFY_CHECKPOINT checks the stored line hashes against the Merkle checkpoints
+// and the checkpoint / day_close / file header records themselves, and re-hashes only the
+// segments that fail and the lines no checkpoint covers yet. WSS_LOG_VERIFY_FULL re-hashes
+// every line. Runs in a background task; poll wss_storage_verify_status() for progress and
+// the first broken seq. The result is logged from wss_storage_loop().
+struct WssLogVerifyStatus {
+  bool running = false;
+  bool done = false;
+  bool ok = false;           // done, no error and no broken line
+  WssLogRange range = WSS_LOG_RANGE_TODAY;
+  WssLogVerifyMode mode = WSS_LOG_VERIFY_CHECKPOINT;
+  String error;              // job failure (sd_not_mounted, log_read_failed, ...)
+  uint32_t elapsed_ms = 0;
+  uint64_t bytes_scanned = 0;
+  WssLogVerifyReport report;
+};
+
+// False with err = "verify_running" when a job is already in progress.
+bool wss_storage_verify_start(WssLogRange range, WssLogVerifyMode mode, String& err);
+WssLogVerifyStatus wss_storage_verify_status();
+
+// NFC allowlist persistence (SD preferred; returns false if SD unavailable). The list is a
+// JSON snapshot (/nfc/allowlist.json) plus a journal of fixed-size change records
+// (/nfc/allowlist.jnl) appended since.
+// Replaces the snapshot crash-safely (.tmp, sync, swap), then drops the journal.
 bool wss_storage_write_allowlist(const String& payload, String& err);
-bool wss_storage_read_allowlist(String& payload, String& err);
+// Appends one journal record of `len` bytes (all records have the same length).
+bool wss_storage_append_allowlist_journal(const char* rec, size_t len, String& err);
+// Streams the snapshot, then the journal, into the sinks in 512-byte chunks (either may be
+// missing). False with err = "allowlist_missing" when the card has neither.
+bool wss_storage_read_allowlist(Print& snapshot, Print& journal, String& err);
@@ -21,6 +21,9 @@
 #include "config/pin_policy.h"
 #include "storage/time_manager.h"
 #include "storage/storage_manager.h"
+#include "storage/log_index.h"
+#include "storage/log_seek_index.h"
+#include "gzip_stream.h"
 #include "wifi/wifi_manager.h"
 #include "nfc/nfc_allowlist.h"
 
@@ -36,10 +39,13 @@
 static WebServer server(80);
 static WssConfigStore* g_cfg = nullptr;
 static WssEventLogger* g_log = nullptr;
-static const uint32_t kLogDownloadMaxBytes = 512 * 1024;
+static const uint32_t kFallbackSnapshotMaxBytes = 512 * 1024;
 static const size_t kMaxLogListItems = 128;
 static const size_t kMaxFallbackItems = 64;
+static const uint32_t kLogQueryDefaultLines = 500;
+static const uint32_t kLogQueryMaxLines = 5000;
 static const uint32_t kOtaRebootDelayMs = 200;
+static const uint32_t kRebootLogFlushTimeoutMs = 1000;
 
 struct OtaSession {
   bool in_progress = false;
@@ -388,6 +394,15 @@ static void handle_status() {
     s["active_log_path"] = sstat.active_log_path;
     s["fallback_active"] = sstat.fallback_active;
     s["fallback_count"] = sstat.fallback_count;
+    s["fallback_backend"] = sstat.fallback_backend;
+    s["fallback_capacity_bytes"] = sstat.fallback_capacity_bytes;
+    s["fallback_used_bytes"] = sstat.fallback_used_bytes;
+    s["fallback_erases"] = sstat.fallback_erases;
+    s["fallback_max_wear"] = sstat.fallback_max_wear;
+    s["fallback_torn_records"] = sstat.fallback_torn_records;
+    s["backfill_active"] = sstat.backfill_active;
+    s["backfill_pending"] = sstat.backfill_pending;
+    s["backfill_lines"] = sstat.backfill_lines;
 
     // M3: tamper-aware log diagnostics
     s["hash_chain_enabled"] = sstat.hash_chain_enabled;
@@ -396,6 +411,89 @@ static void handle_status() {
     s["last_write_ok"] = sstat.last_write_ok;
     s["last_write_backend"] = sstat.last_write_backend;
     s["last_write_error"] = sstat.last_write_error;
+
+    // Async log pipeline (writer task + bounded queue, drop-debug-first).
+    s["writer_task_running"] = sstat.writer_task_running;
+    if (sstat.status_stale) s["status_stale"] = true;
+    s["log_queue_capacity"] = sstat.log_queue_capacity;
+    s["log_queue_depth"] = sstat.log_queue_depth;
+    s["log_queue_high_water"] = sstat.log_queue_high_water;
+    s["log_dropped_count"] = sstat.log_dropped_count;
+    s["log_dropped_debug"] = sstat.log_dropped_debug;
+    s["log_dropped_info"] = sstat.log_dropped_info;
+    s["log_dropped_warn"] = sstat.log_dropped_warn;
+    s["log_dropped_overlong"] = sstat.log_dropped_overlong;
+    s["log_batches"] = sstat.log_batches;
+    s["log_lines_committed"] = sstat.log_lines_committed;
+    s["log_max_batch_lines"] = sstat.log_max_batch_lines;
+
+    // SD durability policy
+    s["sd_flush_mode"] = sstat.sd_flush_mode;
+    s["sd_flush_interval_ms"] = sstat.sd_flush_interval_ms;
+    s["sd_unflushed_bytes"] = sstat.sd_unflushed_bytes;
+    s["sd_last_flush_age_ms"] = sstat.sd_last_flush_age_ms;
+    s["sd_flush_count"] = sstat.sd_flush_count;
+    s["sd_prealloc_bytes"] = sstat.sd_prealloc_bytes;
+    s["sd_prealloc_ok"] = sstat.sd_prealloc_ok;
+    s["sd_sector_writes"] = sstat.sd_sector_writes;
+    s["sd_logical_eof"] = sstat.sd_logical_eof;
+    s["log_format"] = sstat.log_format;
+    s["log_text_bytes"] = sstat.log_text_bytes;
+    s["log_stored_bytes"] = sstat.log_stored_bytes;
+    s["sd_write_behind_bytes"] = sstat.sd_write_behind_bytes;
+    s["sd_write_behind_psram"] = sstat.sd_write_behind_psram;
+    s["sd_write_behind_pending"] = sstat.sd_write_behind_pending;
+    s["sd_write_behind_high_water"] = sstat.sd_write_behind_high_water;
+    s["sd_write_behind_mirrored"] = sstat.sd_write_behind_mirrored;
+    s["sd_write_stalls"] = sstat.sd_write_stalls;
+    s["sd_write_stall_last_ms"] = sstat.sd_write_stall_last_ms;
+    s["sd_write_stall_max_ms"] = sstat.sd_write_stall_max_ms;
+    s["sd_write_stall_total_ms"] = sstat.sd_write_stall_total_ms;
+    s["sd_probe_failures"] = sstat.sd_probe_failures;
+    s["sd_free_estimated"] = sstat.sd_free_estimated;
+    s["sd_free_refreshes"] = sstat.sd_free_refreshes;
+    s["sd_free_refresh_age_s"] = sstat.sd_free_refresh_age_s;
+    {
+      // Buckets: <250us, <1ms, <4ms, <16ms, <64ms, <256ms, <1s, >=1s (WssLatencyHist).
+      JsonObject lat = s.createNestedObject("sd_latency");
+      for (size_t i = 0; i < WSS_STORAGE_OP_COUNT; i++) {
+        const WssLatencyHist& h = sstat.sd_latency[i];
+        JsonObject o = lat.createNestedObject(wss_storage_op_name((WssStorageOp)i));
+        o["count"] = h.count;
+        o["avg_us"] = h.count ? (uint32_t)(h.total_us / h.count) : 0;
+        o["max_us"] = h.max_us;
+        JsonArray b = o.createNestedArray("buckets");
+        for (size_t j = 0; j < WssLatencyHist::kBuckets; j++) b.add(h.buckets[j]);
+      }
+    }
+    s["log_index_ready"] = sstat.log_index_ready;
+    s["log_index_files"] = sstat.log_index_files;
+    s["log_index_rebuilds"] = sstat.log_index_rebuilds;
+    s["log_checkpoints_written"] = sstat.log_checkpoints_written;
+    s["chain_resume_source"] = sstat.chain_resume_source;
+    s["chain_state_writes"] = sstat.chain_state_writes;
+    s["retention_running"] = sstat.retention_running;
+    s["retention_phase"] = sstat.retention_phase;
+    s["retention_files_deleted"] = sstat.retention_files_deleted;
+    s["retention_archives_deleted"] = sstat.retention_archives_deleted;
+    s["retention_days_archived"] = sstat.retention_days_archived;
+    s["retention_quota_unreachable"] = sstat.retention_quota_unreachable;
+    s["log_used_bytes"] = (uint64_t)sstat.log_used_bytes;
+    s["log_archive_bytes"] = (uint64_t)sstat.log_archive_bytes;
+    s["log_archive_months"] = sstat.log_archive_months;
+  }
+
+  // Event logger internals (append-only).
+  if (g_log) {
+    JsonObject lg = doc.createNestedObject("logging");
+    WssSeqLeaseStats seq = g_log->seq_stats();
+    lg["seq_last"] = seq.last_seq;
+    lg["seq_lease_block"] = seq.lease_block;
+    lg["seq_lease_end"] = seq.lease_end;
+    lg["seq_persistent"] = seq.persistent;
+    lg["seq_nvs_commits"] = seq.commits;
+    lg["seq_nvs_commits_avoided"] = seq.commits_avoided;
+    lg["seq_nvs_commit_failures"] = seq.commit_failures;
   }
 
   // M4: explicit state machine
@@ -474,15 +572,77 @@ static void handle_status() {
   send_json(200, doc);
 }
 
+// Print adapter that sends buffered output as HTTP chunks (bounded memory).
+class ChunkedResponse : public Print {
+ public:
+  ~ChunkedResponse() { end(); }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* data, size_t len) override {
+    size_t done = 0;
+    while (done < len) {
+      size_t n = len - done;
+      if (n > sizeof(_buf) - _len) n = sizeof(_buf) - _len;
+      memcpy(_buf + _len, data + done, n);
+      _len += n;
+      done += n;
+      if (_len == sizeof(_buf)) flush_buf();
+    }
+    return len;
+  }
+
+  void end() {
+    if (_ended) return;
+    flush_buf();
+    server.sendContent("");
+    _ended = true;
+  }
+
+ private:
+  void flush_buf() {
+    if (_len) server.sendContent(reinterpret_cast<const char*>(_buf), _len);
+    _len = 0;
+  }
+
+  uint8_t _buf[512];
+  size_t _len = 0;
+  bool _ended = false;
+};
+
 static void handle_events() {
+  // limit=all dumps the whole ring; a missing, zero or malformed limit gets the default
+  // page (0 means "no limit" to the logger, so it must never come from the query).
+  const size_t max_limit = g_log ? g_log->recent_capacity() : 0;
   size_t limit = 20;
   if (server.hasArg("limit")) {
-    limit = (size_t)server.arg("limit").toInt();
-    if (limit > 60) limit = 60;
+    const String arg = server.arg("limit");
+    if (arg == "all") {
+      limit = max_limit;
+    } else {
+      char* end = nullptr;
+      const unsigned long v = strtoul(arg.c_str(), &end, 10);
+      if (arg.length() && isdigit((unsigned char)arg[0]) && *end == '\0' && v > 0) {
+        limit = (size_t)v;
+      }
+    }
   }
-  DynamicJsonDocument out(8192);
-  if (g_log) g_log->recent_events(out, limit);
-  send_json(200, out);
+  if (limit > max_limit) limit = max_limit;
+  uint32_t after_seq = 0;
+  if (server.hasArg("after_seq")) {
+    after_seq = (uint32_t)strtoul(server.arg("after_seq").c_str(), nullptr, 10);
+  }
+
+  // Streamed straight from the binary ring; no intermediate JSON documents.
+  server.sendHeader("Cache-Control", "no-store");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  ChunkedResponse out;
+  if (g_log) {
+    (void)g_log->write_recent_events_json(out, limit, after_seq);
+  } else {
+    out.print("[]");
+  }
+  out.end();
 }
 
 static bool ota_available() {
@@ -557,6 +717,7 @@ static void handle_ota_upload_done() {
   out["reboot"] = true;
   out["message"] = g_ota.message;
   send_json(200, out);
+  (void)wss_storage_flush_pending(kRebootLogFlushTimeoutMs);
   delay(kOtaRebootDelayMs);
   ESP.restart();
 }
@@ -673,15 +834,25 @@ static bool parse_log_range(const String& range, WssLogRange& out) {
   return false;
 }
 
+// raw_bytes/elapsed_ms (optional) add compression ratio and throughput for downloads.
 static void log_logs_event(const char* severity, const char* event_type, const char* msg,
                            const char* range, uint64_t bytes, size_t file_count,
-                           const char* reason) {
+                           const char* reason, uint64_t raw_bytes = 0,
+                           uint32_t elapsed_ms = 0) {
   if (!g_log) return;
-  StaticJsonDocument<192> extra;
+  StaticJsonDocument<320> extra;
   if (range && range[0]) extra["range"] = range;
   if (bytes) extra["bytes"] = bytes;
   if (file_count) extra["file_count"] = (uint32_t)file_count;
   if (reason && reason[0]) extra["reason"] = reason;
+  if (raw_bytes && bytes) {
+    extra["raw_bytes"] = raw_bytes;
+    extra["ratio"] = (float)((double)raw_bytes / (double)bytes);
+  }
+  if (elapsed_ms) {
+    extra["elapsed_ms"] = elapsed_ms;
+    extra["kbps"] = (uint32_t)((raw_bytes ? raw_bytes : bytes) * 8 / elapsed_ms);
+  }
   JsonObjectConst o = extra.as<JsonObjectConst>();
   if (severity && strcmp(severity, "warn") == 0) {
     g_log->log_warn("ui", event_type, msg, &o);
@@ -740,7 +911,7 @@ static bool build_flash_fallback_snapshot(String* lines, size_t max_items, size_
   for (size_t i = 0; i < count; i++) {
     total_bytes += lines[i].length() + 1;
   }
-  if (total_bytes > kLogDownloadMaxBytes) {
+  if (total_bytes > kFallbackSnapshotMaxBytes) {
     err = "too_large";
     return false;
   }
@@ -760,6 +931,54 @@ static void write_flash_fallback_snapshot(const String* lines, size_t count, siz
   }
 }
 
+static String u64_str(uint64_t v) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%llu", (unsigned long long)v);
+  return String(buf);
+}
+
+// Parses a single "bytes=a-b" / "bytes=a-" / "bytes=-n" range against `total`.
+// Returns false for absent, multi-range or malformed headers (serve the whole body);
+// `unsatisfiable` is set when the range is well-formed but starts past the end.
+static bool parse_byte_range(const String& hdr, uint64_t total, uint64_t& start,
+                             uint64_t& len, bool& unsatisfiable) {
+  unsatisfiable = false;
+  if (!hdr.startsWith("bytes=") || hdr.indexOf(',') >= 0) return false;
+  String spec = hdr.substring(6);
+  spec.trim();
+  int dash = spec.indexOf('-');
+  if (dash < 0) return false;
+  String a = spec.substring(0, dash);
+  String b = spec.substring(dash + 1);
+  a.trim();
+  b.trim();
+  for (size_t i = 0; i < a.length(); i++) if (a[i] < '0' || a[i] > '9') return false;
+  for (size_t i = 0; i < b.length(); i++) if (b[i] < '0' || b[i] > '9') return false;
+  if (!a.length() && !b.length()) return false;
+  if (!a.length()) {
+    // Suffix range: the last n bytes.
+    uint64_t n = strtoull(b.c_str(), nullptr, 10);
+    if (n == 0) {
+      unsatisfiable = true;
+      return true;
+    }
+    if (n > total) n = total;
+    start = total - n;
+    len = n;
+    return true;
+  }
+  start = strtoull(a.c_str(), nullptr, 10);
+  uint64_t last = b.length() ? strtoull(b.c_str(), nullptr, 10) : (total ? total - 1 : 0);
+  if (b.length() && last < start) return false;
+  if (start >= total) {
+    unsatisfiable = true;
+    return true;
+  }
+  if (last >= total) last = total - 1;
+  len = last - start + 1;
+  return true;
+}
+
 static void handle_logs_download() {
   if (!admin_required("logs_download")) return;
   String range_str = server.hasArg("range") ? server.arg("range") : String("");
@@ -770,31 +989,22 @@ static void handle_logs_download() {
       range_str.c_str(), 0, 0, "bad_range");
     return;
   }
-  log_logs_event("info", "logs_download_start", "logs download started",
-    range_str.c_str(), 0, 0, "");
 
   uint64_t total_bytes = 0;
   size_t file_count = 0;
+  String etag;
+  bool converted = false;
   String err;
   WssStorageStatus sstat = wss_storage_status();
-  String fallback_lines[kMaxFallbackItems];
-  size_t fallback_count = 0;
-  size_t fallback_total = 0;
-  if (sstat.sd_mounted) {
-    if (!wss_storage_log_bytes(range, total_bytes, file_count, err)) {
-      server.send(500, "application/json", "{\"error\":\"log_download_failed\"}");
-      log_logs_event("error", "logs_download_failed", "logs download failed",
-        range_str.c_str(), 0, 0, err.c_str());
-      return;
-    }
-    if (total_bytes > kLogDownloadMaxBytes) {
-      server.send(409, "application/json",
-        "{\"error\":\"too_large\",\"message\":\"Too large to download. Choose a shorter range.\"}");
-      log_logs_event("warn", "logs_download_refused", "logs download refused: too large",
-        range_str.c_str(), total_bytes, file_count, "too_large");
-      return;
-    }
-  } else {
+  server.sendHeader("Cache-Control", "no-store");
+  server.sendHeader("Content-Disposition",
+    String("attachment; filename=\"logs_") + range_str + String(".txt\""));
+
+  if (!sstat.sd_mounted) {
+    // The flash fallback snapshot is small and changes constantly: no ranges.
+    String fallback_lines[kMaxFallbackItems];
+    size_t fallback_count = 0;
+    size_t fallback_total = 0;
     if (!build_flash_fallback_snapshot(fallback_lines, kMaxFallbackItems,
           fallback_count, fallback_total, err)) {
       server.send(409, "application/json",
@@ -803,30 +1013,286 @@ static void handle_logs_download() {
         range_str.c_str(), 0, 0, "too_large");
       return;
     }
-  }
-
-  server.sendHeader("Cache-Control", "no-store");
-  server.sendHeader("Content-Disposition",
-    String("attachment; filename=\"logs_") + range_str + String(".txt\""));
-  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
-  server.send(200, "text/plain", "");
-
-  size_t bytes_sent = 0;
-  if (!sstat.sd_mounted) {
+    log_logs_event("info", "logs_download_start", "logs download started",
+      range_str.c_str(), 0, 0, "");
+    size_t bytes_sent = 0;
+    server.setContentLength(fallback_total);
+    server.send(200, "text/plain", "");
     write_flash_fallback_snapshot(fallback_lines, fallback_count, bytes_sent);
     log_logs_event("info", "logs_download_ok", "logs download complete (flash fallback)",
       range_str.c_str(), bytes_sent, 0, "flash_fallback");
     return;
   }
 
-  auto client = server.client();
-  if (!wss_storage_stream_logs(range, client, kLogDownloadMaxBytes, bytes_sent, err)) {
+  if (!wss_storage_log_range_info(range, total_bytes, file_count, etag, converted, err)) {
+    server.send(500, "application/json", "{\"error\":\"log_download_failed\"}");
     log_logs_event("error", "logs_download_failed", "logs download failed",
       range_str.c_str(), 0, 0, err.c_str());
     return;
   }
+
+  // Range is honored only when If-Range (if sent) still names this representation, and
+  // never for binary day files: their JSONL text has no known length to address.
+  uint64_t start = 0;
+  uint64_t len = total_bytes;
+  bool partial = false;
+  String range_hdr = server.header("Range");
+  String if_range = server.header("If-Range");
+  if (!converted && range_hdr.length() && (!if_range.length() || if_range == etag)) {
+    bool unsatisfiable = false;
+    partial = parse_byte_range(range_hdr, total_bytes, start, len, unsatisfiable);
+    if (partial && unsatisfiable) {
+      server.sendHeader("Content-Range", String("bytes */") + u64_str(total_bytes));
+      server.send(416, "application/json", "{\"error\":\"range_not_satisfiable\"}");
+      log_logs_event("warn", "logs_download_refused", "logs download refused: bad byte range",
+        range_str.c_str(), total_bytes, file_count, "range_not_satisfiable");
+      return;
+    }
+  }
+
+  // gzip only for whole-body responses; byte ranges always address the identity body.
+  // Without memory for the window the response simply goes out uncompressed.
+  const uint32_t start_ms = millis();
+  WssGzipStream gz;
+  String accept_enc = server.header("Accept-Encoding");
+  if (!partial && accept_enc.indexOf("gzip") >= 0 && gz.reserve()) {
+    log_logs_event("info", "logs_download_start", "logs download started",
+      range_str.c_str(), total_bytes, file_count, "gzip");
+    server.sendHeader("Content-Encoding", "gzip");
+    server.sendHeader("Vary", "Accept-Encoding");
+    if (!converted) {
+      server.sendHeader("ETag", etag.substring(0, etag.length() - 1) + String("-gz\""));
+    }
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain", "");
+    size_t raw_sent = 0;
+    bool ok;
+    {
+      ChunkedResponse body;
+      ok = gz.begin(body) && wss_storage_stream_logs(range, gz, 0, total_bytes, raw_sent, err);
+      ok = gz.finish() && ok;
+    }
+    const uint32_t elapsed_ms = millis() - start_ms;
+    if (!ok) {
+      log_logs_event("error", "logs_download_failed", "logs download failed",
+        range_str.c_str(), gz.bytes_out(), 0, err.length() ? err.c_str() : "gzip_stream_failed");
+      return;
+    }
+    log_logs_event("info", "logs_download_ok", "logs download complete",
+      range_str.c_str(), gz.bytes_out(), file_count, "gzip", raw_sent, elapsed_ms);
+    return;
+  }
+
+  if (converted) {
+    log_logs_event("info", "logs_download_start", "logs download started",
+      range_str.c_str(), total_bytes, file_count, "jsonl_export");
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain", "");
+    size_t raw_sent = 0;
+    bool ok;
+    {
+      ChunkedResponse body;
+      ok = wss_storage_stream_logs(range, body, 0, total_bytes, raw_sent, err);
+    }
+    if (!ok) {
+      log_logs_event("error", "logs_download_failed", "logs download failed",
+        range_str.c_str(), raw_sent, 0, err.c_str());
+      return;
+    }
+    log_logs_event("info", "logs_download_ok", "logs download complete",
+      range_str.c_str(), raw_sent, file_count, "jsonl_export", 0, millis() - start_ms);
+    return;
+  }
+
+  log_logs_event("info", "logs_download_start", "logs download started",
+    range_str.c_str(), len, file_count, partial ? "partial" : "");
+  server.sendHeader("Accept-Ranges", "bytes");
+  server.sendHeader("ETag", etag);
+  if (partial) {
+    server.sendHeader("Content-Range", String("bytes ") + u64_str(start) + String("-") +
+      u64_str(start + len - 1) + String("/") + u64_str(total_bytes));
+  }
+  // size_t is 32 bits on ESP32: a body too long for Content-Length (range=all on a large
+  // card) goes out chunked rather than with a wrapped length; Range still resumes it.
+  const bool chunked = len >= (uint64_t)CONTENT_LENGTH_NOT_SET;
+  server.setContentLength(chunked ? CONTENT_LENGTH_UNKNOWN : (size_t)len);
+  server.send(partial ? 206 : 200, "text/plain", "");
+
+  size_t bytes_sent = 0;
+  bool ok;
+  if (chunked) {
+    ChunkedResponse body;
+    ok = wss_storage_stream_logs(range, body, start, len, bytes_sent, err);
+  } else {
+    auto client = server.client();
+    ok = wss_storage_stream_logs(range, client, start, len, bytes_sent, err);
+  }
+  if (!ok) {
+    log_logs_event("error", "logs_download_failed", "logs download failed",
+      range_str.c_str(), bytes_sent, 0, err.c_str());
+    return;
+  }
   log_logs_event("info", "logs_download_ok", "logs download complete",
-    range_str.c_str(), bytes_sent, file_count, "");
+    range_str.c_str(), bytes_sent, file_count, partial ? "partial" : "", 0,
+    millis() - start_ms);
+}
+
+// Accepts epoch seconds or "YYYY-MM-DDTHH:MM[:SS][Z]" (UTC).
+static bool parse_query_ts(const char* name, uint32_t& out) {
+  out = 0;
+  if (!server.hasArg(name)) return true;
+  String v = server.arg(name);
+  v.trim();
+  if (!v.length()) return true;
+  bool digits = true;
+  for (size_t i = 0; i < v.length(); i++) {
+    if (v[i] < '0' || v[i] > '9') digits = false;
+  }
+  out = digits ? (uint32_t)strtoul(v.c_str(), nullptr, 10) : wss_iso8601_to_epoch(v.c_str());
+  return out != 0;
+}
+
+static uint32_t parse_query_u32(const char* name, uint32_t fallback) {
+  if (!server.hasArg(name)) return fallback;
+  return (uint32_t)strtoul(server.arg(name).c_str(), nullptr, 10);
+}
+
+// "YYYYMMDD.offset" as produced in next_cursor.
+static bool parse_query_cursor(const String& v, uint32_t& date, uint32_t& offset) {
+  int dot = v.indexOf('.');
+  if (dot != 8) return false;
+  for (int i = 0; i < (int)v.length(); i++) {
+    if (i != dot && (v[i] < '0' || v[i] > '9')) return false;
+  }
+  if ((int)v.length() == dot + 1) return false;
+  date = WssLogIndex::date_from_key(v.substring(0, 4) + "-" + v.substring(4, 6) + "-" +
+                                    v.substring(6, 8));
+  offset = (uint32_t)strtoul(v.c_str() + dot + 1, nullptr, 10);
+  return date != 0;
+}
+
+static void handle_logs_query() {
+  if (!admin_required("logs_query")) return;
+  WssLogQuery q;
+  q.from_seq = parse_query_u32("from_seq", 0);
+  q.to_seq = parse_query_u32("to_seq", 0);
+  q.max_lines = parse_query_u32("limit", kLogQueryDefaultLines);
+  if (q.max_lines == 0 || q.max_lines > kLogQueryMaxLines) q.max_lines = kLogQueryMaxLines;
+  if (!parse_query_ts("from_ts", q.from_ts) || !parse_query_ts("to_ts", q.to_ts)) {
+    server.send(400, "application/json", "{\"error\":\"bad_ts\"}");
+    return;
+  }
+  q.event_type = server.arg("event_type");
+  q.source = server.arg("source");
+  q.severity = server.arg("severity");
+  String filter_err;
+  if (!wss_storage_query_valid(q, filter_err)) {
+    server.send(400, "application/json", "{\"error\":\"bad_filter\"}");
+    return;
+  }
+  // `cursor` (empty to start) opts into a trailing {"next_cursor":...} line when the
+  // limit cut the result; pass it back to continue exactly after the last line.
+  const bool want_cursor = server.hasArg("cursor");
+  if (want_cursor && server.arg("cursor").length() &&
+      !parse_query_cursor(server.arg("cursor"), q.cursor_date, q.cursor_offset)) {
+    server.send(400, "application/json", "{\"error\":\"bad_cursor\"}");
+    return;
+  }
+  WssStorageStatus sstat = wss_storage_status();
+  if (!sstat.sd_mounted) {
+    server.send(409, "application/json", "{\"error\":\"sd_not_mounted\"}");
+    return;
+  }
+
+  server.sendHeader("Cache-Control", "no-store");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/x-ndjson", "");
+  WssLogQueryResult res;
+  String err;
+  bool ok;
+  {
+    ChunkedResponse body;
+    ok = wss_storage_query_logs(q, body, res, err);
+    if (ok && want_cursor && res.truncated) {
+      char tail[64];
+      int n = snprintf(tail, sizeof(tail), "{\"next_cursor\":\"%lu.%lu\"}\n",
+                       (unsigned long)res.next_date, (unsigned long)res.next_offset);
+      if (n > 0) body.write(reinterpret_cast<const uint8_t*>(tail), (size_t)n);
+    }
+  }
+  if (!ok) {
+    log_logs_event("error", "logs_query_failed", "logs query failed", "", 0, res.files,
+      err.c_str());
+    return;
+  }
+  log_logs_event("info", "logs_query", "logs query served", "", res.bytes_scanned, res.files,
+    res.truncated ? "truncated" : "");
+}
+
+static const char* log_range_str(WssLogRange range) {
+  if (range == WSS_LOG_RANGE_7D) return "7d";
+  if (range == WSS_LOG_RANGE_ALL) return "all";
+  return "today";
+}
+
+// GET /api/logs/verify?range=today|7d|all[&mode=checkpoint|full] starts an on-device chain
+// check (202); GET /api/logs/verify without range reports progress and the result. The default
+// checkpoint mode checks links and checkpoint roots and re-hashes only the intervals that fail;
+// mode=full re-hashes every line.
+static void handle_logs_verify() {
+  if (!admin_required("logs_verify")) return;
+  int code = 200;
+  if (server.hasArg("range")) {
+    WssLogRange range = WSS_LOG_RANGE_TODAY;
+    if (!parse_log_range(server.arg("range"), range)) {
+      server.send(400, "application/json", "{\"error\":\"bad_range\"}");
+      return;
+    }
+    WssLogVerifyMode mode = WSS_LOG_VERIFY_CHECKPOINT;
+    if (server.hasArg("mode")) {
+      const String m = server.arg("mode");
+      if (m == "full") {
+        mode = WSS_LOG_VERIFY_FULL;
+      } else if (m != "checkpoint") {
+        server.send(400, "application/json", "{\"error\":\"bad_mode\"}");
+        return;
+      }
+    }
+    String err;
+    if (!wss_storage_verify_start(range, mode, err)) {
+      StaticJsonDocument<96> e;
+      e["error"] = err;
+      send_json(409, e);
+      return;
+    }
+    code = 202;
+  }
+
+  WssLogVerifyStatus v = wss_storage_verify_status();
+  StaticJsonDocument<768> doc;
+  doc["running"] = v.running;
+  doc["done"] = v.done;
+  doc["ok"] = v.ok;
+  doc["range"] = log_range_str(v.range);
+  doc["mode"] = v.mode == WSS_LOG_VERIFY_FULL ? "full" : "checkpoint";
+  if (v.error.length()) doc["error"] = v.error;
+  doc["elapsed_ms"] = v.elapsed_ms;
+  doc["bytes_scanned"] = v.bytes_scanned;
+  doc["files"] = v.report.files;
+  doc["lines"] = v.report.lines;
+  doc["checkpoints"] = v.report.checkpoints;
+  doc["uncheckpointed_lines"] = v.report.uncheckpointed_lines;
+  doc["unchained_lines"] = v.report.unchained_lines;
+  doc["day_links"] = v.report.day_links;
+  doc["rehashed_lines"] = v.report.rehashed_lines;
+  doc["rehashed_spans"] = v.report.rehashed_spans;
+  doc["bad_lines"] = v.report.bad_lines;
+  if (v.report.bad_lines) {
+    doc["first_bad_seq"] = v.report.first_bad_seq;
+    doc["first_bad_file"] = v.report.first_bad_file;
+    doc["first_bad_reason"] = v.report.first_bad_reason;
+  }
+  send_json(code, doc);
 }
 
 static void handle_admin_status() {
@@ -1241,6 +1707,7 @@ static void handle_factory_restore() {
   out["ok"] = true;
   out["rebooting"] = true;
   send_json(200, out);
+  (void)wss_storage_flush_pending(kRebootLogFlushTimeoutMs);
   delay(200);
   esp_restart();
   return;
@@ -1368,13 +1835,15 @@ void wss_web_begin(WssConfigStore& cfg, WssEventLogger& log) {
   g_cfg = &cfg;
   g_log = &log;
 
-  const char* header_keys[] = {"X-Admin-Token"};
-  server.collectHeaders(header_keys, 1);
+  const char* header_keys[] = {"X-Admin-Token", "Range", "If-Range", "Accept-Encoding"};
+  server.collectHeaders(header_keys, 4);
 
   server.on("/api/status", HTTP_GET, handle_status);
   server.on("/api/events", HTTP_GET, handle_events);
   server.on("/api/logs/list", HTTP_GET, handle_logs_list);
   server.on("/api/logs/download", HTTP_GET, handle_logs_download);
+  server.on("/api/logs/query", HTTP_GET, handle_logs_query);
+  server.on("/api/logs/verify", HTTP_GET, handle_logs_verify);
   server.on("/api/ota/status", HTTP_GET, handle_ota_status);
   server.on("/api/ota/upload", HTTP_POST, handle_ota_upload_done, handle_ota_upload);
 
@@ -0,0 +1,114 @@
+// test/host/bench_allowlist_table.cpp
+// Role: Tap lookup cost of the allowlist hash table (Bloom filter in front, as
+// wss_nfc_allowlist_get_role_digest() does) against the linear scan over hex Strings it
+// replaced, plus the filter's false-positive rate and the cost of filling the table.
+
+#include <Arduino.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "logging/sha256_hex.h"
+#include "nfc/allowlist_table.h"
+
+static uint32_t g_rng = 1;
+static volatile unsigned g_sink;  // keeps the lookups from being optimized away
+
+static uint32_t rnd() {
+  g_rng = g_rng * 1103515245u + 12345u;
+  return g_rng;
+}
+
+static double now_ns() {
+  using namespace std::chrono;
+  return (double)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Digests are salted SHA-256 output, so SHA-256 of a counter is a fair stand-in.
+static void make_digest(uint32_t id, uint8_t out[32]) {
+  uint8_t in[4];
+  memcpy(in, &id, sizeof(in));
+  const String hex = wss_sha256_hex(in, sizeof(in));
+  wss_hex_parse(hex.c_str(), out, 32);
+}
+
+static uint8_t table_role(const WssAllowlistTable& t, const uint8_t d[32]) {
+  return t.may_contain(d) ? t.find(d) : 0;
+}
+
+static uint8_t linear_role(const std::vector<String>& tags, const std::vector<uint8_t>& roles,
+                           const String& hex) {
+  for (size_t i = 0; i < tags.size(); i++) {
+    if (tags[i] == hex) return roles[i];
+  }
+  return 0;
+}
+
+static void run(size_t n) {
+  std::vector<std::vector<uint8_t>> digests(n, std::vector<uint8_t>(32));
+  std::vector<String> tags;
+  std::vector<uint8_t> roles;
+  for (size_t i = 0; i < n; i++) {
+    make_digest((uint32_t)i, digests[i].data());
+    char hex[65];
+    wss_hex_lower(digests[i].data(), 32, hex);
+    tags.push_back(String(hex));
+    roles.push_back((uint8_t)(1 + i % 3));
+  }
+
+  WssAllowlistTable t;
+  bool changed;
+  double t0 = now_ns();
+  for (size_t i = 0; i < n; i++) t.put(digests[i].data(), roles[i], changed);
+  const double fill_ns = now_ns() - t0;
+
+  // Half the taps are enrolled tags, half unknown ones.
+  const size_t kProbes = 4096;
+  std::vector<std::vector<uint8_t>> probes(kProbes, std::vector<uint8_t>(32));
+  std::vector<String> probe_hex;
+  for (size_t i = 0; i < kProbes; i++) {
+    const uint32_t id = i % 2 ? (uint32_t)(rnd() % n) : (uint32_t)(n + rnd() % 1000000);
+    make_digest(id, probes[i].data());
+    char hex[65];
+    wss_hex_lower(probes[i].data(), 32, hex);
+    probe_hex.push_back(String(hex));
+  }
+
+  const int kRounds = n >= 10000 ? 2 : 50;
+  unsigned sink = 0;
+  t0 = now_ns();
+  for (int r = 0; r < kRounds; r++) {
+    for (size_t i = 0; i < kProbes; i++) sink += linear_role(tags, roles, probe_hex[i]);
+  }
+  const double linear_ns = (now_ns() - t0) / (kRounds * kProbes);
+
+  const int kTableRounds = 500;
+  t0 = now_ns();
+  for (int r = 0; r < kTableRounds; r++) {
+    for (size_t i = 0; i < kProbes; i++) sink += table_role(t, probes[i].data());
+  }
+  const double table_ns = (now_ns() - t0) / (kTableRounds * kProbes);
+
+  // False positives: unknown tags the filter lets through to the table.
+  const uint32_t kUnknown = 200000;
+  uint32_t passed = 0;
+  uint8_t d[32];
+  for (uint32_t i = 0; i < kUnknown; i++) {
+    make_digest((uint32_t)(n + 2000000 + i), d);
+    passed += t.may_contain(d);
+  }
+
+  g_sink = sink;
+  printf("  n=%-6zu table %7.1f ns  linear %9.1f ns  bloom fp %5.2f%%  fill %7.2f ms\n", n,
+         table_ns, linear_ns, 100.0 * passed / kUnknown, fill_ns / 1e6);
+}
+
+int main() {
+  printf("per tap lookup (50%% enrolled), Bloom false positives, table fill:\n");
+  const size_t sizes[] = {10, 100, 1000, 10000};
+  for (size_t n : sizes) run(n);
+  return 0;
+}
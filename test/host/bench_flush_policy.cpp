@@ -0,0 +1,98 @@
+// test/host/bench_flush_policy.cpp
+// Role: What each SD durability mode costs and risks on a typical event mix: syncs issued,
+// card time spent in writes and syncs, and how many lines (and how old) sat unflushed.
+// The card is the RAM backend behind injected delays, so the figures are model time on the
+// host's virtual clock, not a real card's.
+
+#include <Arduino.h>
+
+#include <stdio.h>
+
+#include "storage/log_flush_policy.h"
+#include "storage/storage_backend_fault.h"
+#include "storage/storage_backend_ram.h"
+#include "storage/storage_backend_timed.h"
+
+static const int kEvents = 6000;
+static const uint32_t kEventGapMs = 100;    // a busy door: ten events a second
+static const uint32_t kIntervalMs = 1000;   // sd_flush_interval_ms default
+static const uint32_t kWriteDelayMs = 1;
+static const uint32_t kSyncDelayMs = 20;    // FAT + data sector update on a typical card
+
+struct Result {
+  uint32_t syncs = 0;
+  uint64_t card_us = 0;
+  uint32_t max_lines_at_risk = 0;
+  uint32_t max_age_at_risk_ms = 0;
+};
+
+// Every 10th event is a state transition (durable hint), every 25th a warning.
+static void event_kind(int i, WssLogSeverity& sev, uint8_t& flags) {
+  sev = i % 25 == 0 ? WSS_LOG_SEV_WARN : WSS_LOG_SEV_INFO;
+  flags = i % 10 == 0 ? WSS_LOG_FLAG_DURABLE : WSS_LOG_FLAG_NONE;
+}
+
+static bool run(WssLogFlushMode mode, Result& r) {
+  WssRamBackend ram;
+  WssFaultBackend fault(&ram);
+  WssTimedBackend fs(&fault);
+  WssStorageFaults f;
+  f.write_delay_ms = kWriteDelayMs;
+  f.sync_delay_ms = kSyncDelayMs;
+  fault.set_faults(f);
+  WssStorageFile file = fs.open("/events.txt", WSS_FS_RDWR | WSS_FS_CREATE | WSS_FS_TRUNC);
+  if (!file) return false;
+
+  uint32_t unflushed = 0;
+  uint32_t oldest_ms = 0;
+  uint32_t last_flush_ms = millis();
+  auto flush = [&]() {
+    if (!unflushed) return true;
+    const uint32_t age = millis() - oldest_ms;
+    if (age > r.max_age_at_risk_ms) r.max_age_at_risk_ms = age;
+    unflushed = 0;
+    last_flush_ms = millis();
+    r.syncs++;
+    return file.sync();
+  };
+
+  char line[200];
+  for (int i = 0; i < kEvents; i++) {
+    wss_host_advance_ms(kEventGapMs);
+    // The writer task wakes for the interval even when no line arrives.
+    if (unflushed && millis() - last_flush_ms >= kIntervalMs && !flush()) return false;
+
+    WssLogSeverity sev;
+    uint8_t flags;
+    event_kind(i, sev, flags);
+    const int n = snprintf(line, sizeof(line),
+                           "{\"ts\":\"2026-01-23T19:46:12Z\",\"seq\":%d,\"event_type\":"
+                           "\"nfc_scan\",\"severity\":\"info\",\"source\":\"nfc\",\"msg\":"
+                           "\"NFC scan allowed\",\"prev_hash\":null,\"hash\":null}\n",
+                           i + 1);
+    if (file.write(line, (size_t)n) != (size_t)n) return false;
+    if (!unflushed) oldest_ms = millis();
+    unflushed++;
+    if (unflushed > r.max_lines_at_risk) r.max_lines_at_risk = unflushed;
+    if (wss_log_flush_required(mode, sev, flags) && !flush()) return false;
+  }
+  if (!flush()) return false;
+  r.card_us = fs.hist(WSS_STORAGE_OP_APPEND).total_us + fs.hist(WSS_STORAGE_OP_FLUSH).total_us;
+  return true;
+}
+
+int main() {
+  printf("%d events %u ms apart, interval %u ms, write %u ms, sync %u ms\n", kEvents,
+         kEventGapMs, kIntervalMs, kWriteDelayMs, kSyncDelayMs);
+  printf("  %-10s %7s %10s %14s %12s\n", "mode", "syncs", "card ms", "lines at risk",
+         "age at risk");
+  const WssLogFlushMode modes[] = {WSS_LOG_FLUSH_PER_EVENT, WSS_LOG_FLUSH_SEVERITY,
+                                   WSS_LOG_FLUSH_INTERVAL};
+  for (WssLogFlushMode m : modes) {
+    Result r;
+    if (!run(m, r)) return 1;
+    printf("  %-10s %7u %10llu %14u %9u ms\n", wss_log_flush_mode_str(m), r.syncs,
+           (unsigned long long)(r.card_us / 1000), r.max_lines_at_risk, r.max_age_at_risk_ms);
+  }
+  return 0;
+}
@@ -0,0 +1,86 @@
+// test/host/bench_log_chain_line.cpp
+// Role: Per-line time and heap allocations of the single-pass chainer against the
+// String-concatenating hash step it replaced. The old path also parsed and re-serialized
+// every line with ArduinoJson (a 768-byte document and three serializations); that part is
+// not in the host build, so the baseline here is a lower bound.
+
+#include <Arduino.h>
+
+#include <stdio.h>
+
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "logging/log_chain_line.h"
+#include "logging/sha256_hex.h"
+
+static size_t g_allocs = 0;
+
+void* operator new(size_t n) {
+  g_allocs++;
+  if (void* p = malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static double now_ns() {
+  using namespace std::chrono;
+  return (double)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// The hash and output steps of the old path: content + prev_hash hashed as one String,
+// then the line rebuilt by concatenation.
+static void chain_by_concat(const String& content, String& prev, String& out) {
+  const String input = content + prev;
+  const String hash = wss_sha256_hex_str(input);
+  String head = content;
+  head.remove(head.length() - 1);
+  out = head + String(",\"prev_hash\":\"") + prev + String("\",\"hash\":\"") + hash +
+        String("\"}");
+  prev = hash;
+}
+
+int main() {
+  const int kLines = 20000;
+  std::vector<String> lines;
+  for (int i = 0; i < kLines; i++) {
+    char buf[320];
+    snprintf(buf, sizeof(buf),
+             "{\"ts\":\"2026-01-23T19:%02d:%02dZ\",\"seq\":%d,\"event_type\":\"nfc_scan\","
+             "\"severity\":\"info\",\"source\":\"nfc\",\"msg\":\"NFC scan allowed\","
+             "\"extra\":{\"result\":\"allow\",\"role\":\"user\",\"tag_prefix\":\"04a1b2\"}}",
+             i / 60 % 60, i % 60, i + 1);
+    lines.push_back(String(buf));
+  }
+
+  String prev(std::string(64, '0').c_str());
+  String out;
+  size_t a0 = g_allocs;
+  double t0 = now_ns();
+  for (const String& l : lines) chain_by_concat(l, prev, out);
+  const double concat_ns = (now_ns() - t0) / kLines;
+  const double concat_allocs = (double)(g_allocs - a0) / kLines;
+  const String concat_head = prev;
+
+  prev = String(std::string(64, '0').c_str());
+  char hash[65];
+  a0 = g_allocs;
+  t0 = now_ns();
+  for (const String& l : lines) {
+    if (!wss_log_chain_line(l.c_str(), l.length(), prev.c_str(), out, hash)) return 1;
+    prev = hash;
+  }
+  const double one_pass_ns = (now_ns() - t0) / kLines;
+  const double one_pass_allocs = (double)(g_allocs - a0) / kLines;
+
+  printf("%d lines of %u bytes\n", kLines, lines[0].length());
+  printf("  concat + one-shot hash  %8.0f ns/line  %5.1f allocs/line\n", concat_ns,
+         concat_allocs);
+  printf("  single pass             %8.0f ns/line  %5.1f allocs/line\n", one_pass_ns,
+         one_pass_allocs);
+  // Both paths must land on the same chain head.
+  return prev == concat_head ? 0 : 1;
+}
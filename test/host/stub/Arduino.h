@@ -0,0 +1,141 @@
+// test/host/stub/Arduino.h
+// Role: Host stand-in for the parts of the Arduino core the portable modules use: String,
+// Print, millis()/micros()/delay(). Enough to build src/storage, src/logging and the
+// allowlist helpers on a desktop toolchain; not a general Arduino emulation.
+#pragma once
+
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+class String {
+ public:
+  String() {}
+  String(const char* c) : _s(c ? c : "") {}
+  String(const std::string& s) : _s(s) {}
+  explicit String(char c) : _s(1, c) {}
+  explicit String(int v) : _s(std::to_string(v)) {}
+  explicit String(unsigned v) : _s(std::to_string(v)) {}
+  explicit String(long v) : _s(std::to_string(v)) {}
+  explicit String(unsigned long v) : _s(std::to_string(v)) {}
+  explicit String(long long v) : _s(std::to_string(v)) {}
+  explicit String(unsigned long long v) : _s(std::to_string(v)) {}
+
+  unsigned length() const { return (unsigned)_s.size(); }
+  const char* c_str() const { return _s.c_str(); }
+  bool reserve(unsigned n) {
+    _s.reserve(n);
+    return true;
+  }
+  bool concat(const char* c, unsigned n) {
+    _s.append(c, n);
+    return true;
+  }
+  bool concat(const String& o) {
+    _s += o._s;
+    return true;
+  }
+  bool concat(const char* c) {
+    _s += c;
+    return true;
+  }
+  bool concat(char c) {
+    _s += c;
+    return true;
+  }
+  String& operator+=(const char* c) {
+    _s += c;
+    return *this;
+  }
+  String& operator+=(char c) {
+    _s += c;
+    return *this;
+  }
+  String& operator+=(const String& o) {
+    _s += o._s;
+    return *this;
+  }
+  friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+  friend String operator+(const String& a, const char* b) { return String(a._s + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b._s); }
+  bool operator==(const String& o) const { return _s == o._s; }
+  bool operator==(const char* o) const { return _s == o; }
+  bool operator!=(const String& o) const { return _s != o._s; }
+  bool operator!=(const char* o) const { return _s != o; }
+  bool operator<(const String& o) const { return _s < o._s; }
+  bool operator>(const String& o) const { return _s > o._s; }
+  bool operator<=(const String& o) const { return _s <= o._s; }
+  bool operator>=(const String& o) const { return _s >= o._s; }
+  char operator[](unsigned i) const { return i < _s.size() ? _s[i] : 0; }
+  char charAt(unsigned i) const { return (*this)[i]; }
+  bool equals(const String& o) const { return _s == o._s; }
+  bool startsWith(const String& p) const { return _s.compare(0, p._s.size(), p._s) == 0; }
+  bool endsWith(const String& p) const {
+    return _s.size() >= p._s.size() &&
+           _s.compare(_s.size() - p._s.size(), p._s.size(), p._s) == 0;
+  }
+  String substring(unsigned from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+  String substring(unsigned from, unsigned to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.size()) return String();
+    return String(_s.substr(from, to - from));
+  }
+  int indexOf(char c, unsigned from = 0) const { return pos(_s.find(c, from)); }
+  int indexOf(const char* c, unsigned from = 0) const { return pos(_s.find(c, from)); }
+  int indexOf(const String& c, unsigned from = 0) const { return pos(_s.find(c._s, from)); }
+  int lastIndexOf(char c) const { return pos(_s.rfind(c)); }
+  long toInt() const { return atol(_s.c_str()); }
+  void toLowerCase() {
+    for (auto& ch : _s) ch = (char)tolower((unsigned char)ch);
+  }
+  void toUpperCase() {
+    for (auto& ch : _s) ch = (char)toupper((unsigned char)ch);
+  }
+  void trim() {
+    size_t b = 0;
+    while (b < _s.size() && isspace((unsigned char)_s[b])) b++;
+    size_t e = _s.size();
+    while (e > b && isspace((unsigned char)_s[e - 1])) e--;
+    _s = _s.substr(b, e - b);
+  }
+  void remove(unsigned index) {
+    if (index < _s.size()) _s.erase(index);
+  }
+  void remove(unsigned index, unsigned count) {
+    if (index < _s.size()) _s.erase(index, count);
+  }
+
+ private:
+  static int pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+  std::string _s;
+};
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (n < len && write(buf[n])) n++;
+    return n;
+  }
+  size_t write(const char* s) { return s ? write(reinterpret_cast<const uint8_t*>(s), strlen(s)) : 0; }
+  size_t write(const char* buf, size_t len) { return write(reinterpret_cast<const uint8_t*>(buf), len); }
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write(s.c_str(), s.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t println(const char* s) { return print(s) + print('\n'); }
+  size_t println(const String& s) { return print(s) + print('\n'); }
+};
+
+// Monotonic milliseconds/microseconds since the first call; tests may advance the clock
+// with wss_host_advance_ms() instead of sleeping.
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void wss_host_advance_ms(uint32_t ms);
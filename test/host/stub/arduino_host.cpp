@@ -0,0 +1,21 @@
+// test/host/stub/arduino_host.cpp
+// Role: Host clock for the Arduino stand-in. delay() advances a virtual offset instead of
+// sleeping, so injected card stalls cost no wall time but still show up in millis() and
+// micros().
+
+#include <Arduino.h>
+
+#include <chrono>
+
+static uint64_t g_offset_us = 0;
+
+static uint64_t now_us() {
+  using namespace std::chrono;
+  static const steady_clock::time_point t0 = steady_clock::now();
+  return (uint64_t)duration_cast<microseconds>(steady_clock::now() - t0).count() + g_offset_us;
+}
+
+uint32_t millis() { return (uint32_t)(now_us() / 1000); }
+uint32_t micros() { return (uint32_t)now_us(); }
+void delay(uint32_t ms) { wss_host_advance_ms(ms); }
+void wss_host_advance_ms(uint32_t ms) { g_offset_us += (uint64_t)ms * 1000; }
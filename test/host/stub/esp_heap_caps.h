@@ -0,0 +1,13 @@
+// test/host/stub/esp_heap_caps.h
+// Role: Host stand-in for the ESP-IDF capability allocator (no PSRAM: plain malloc).
+#pragma once
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT (1u << 2)
+#define MALLOC_CAP_SPIRAM (1u << 10)
+
+inline void* heap_caps_malloc(size_t size, unsigned caps) {
+  (void)caps;
+  return malloc(size);
+}
@@ -0,0 +1,120 @@
+// test/host/stub/mbedtls/sha256.h
+// Role: Host stand-in for the mbedtls SHA-256 API used by the firmware (plain C++, no
+// library dependency).
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+struct mbedtls_sha256_context {
+  uint32_t state[8];
+  uint64_t total;
+  uint8_t buf[64];
+};
+
+namespace wss_host_sha256 {
+
+inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+inline void block(mbedtls_sha256_context* c, const uint8_t* p) {
+  static const uint32_t k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+    0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+    0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+    0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+    0xc67178f2};
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = ((uint32_t)p[i * 4] << 24) | ((uint32_t)p[i * 4 + 1] << 16) |
+           ((uint32_t)p[i * 4 + 2] << 8) | p[i * 4 + 3];
+  }
+  for (int i = 16; i < 64; i++) {
+    const uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    const uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = c->state[0], b = c->state[1], cc = c->state[2], d = c->state[3];
+  uint32_t e = c->state[4], f = c->state[5], g = c->state[6], h = c->state[7];
+  for (int i = 0; i < 64; i++) {
+    const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) +
+                        k[i] + w[i];
+    const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & cc) ^ (b & cc));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = cc;
+    cc = b;
+    b = a;
+    a = t1 + t2;
+  }
+  c->state[0] += a;
+  c->state[1] += b;
+  c->state[2] += cc;
+  c->state[3] += d;
+  c->state[4] += e;
+  c->state[5] += f;
+  c->state[6] += g;
+  c->state[7] += h;
+}
+
+}  // namespace wss_host_sha256
+
+inline void mbedtls_sha256_init(mbedtls_sha256_context* c) { memset(c, 0, sizeof(*c)); }
+inline void mbedtls_sha256_free(mbedtls_sha256_context* c) { (void)c; }
+inline void mbedtls_sha256_clone(mbedtls_sha256_context* dst, const mbedtls_sha256_context* src) {
+  *dst = *src;
+}
+
+inline int mbedtls_sha256_starts_ret(mbedtls_sha256_context* c, int is224) {
+  static const uint32_t iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  if (is224) return -1;  // not used by the firmware
+  memcpy(c->state, iv, sizeof(iv));
+  c->total = 0;
+  return 0;
+}
+
+inline int mbedtls_sha256_update_ret(mbedtls_sha256_context* c, const unsigned char* in,
+                                     size_t len) {
+  size_t fill = (size_t)(c->total & 63);
+  c->total += len;
+  while (len) {
+    size_t n = 64 - fill;
+    if (n > len) n = len;
+    memcpy(c->buf + fill, in, n);
+    fill += n;
+    in += n;
+    len -= n;
+    if (fill == 64) {
+      wss_host_sha256::block(c, c->buf);
+      fill = 0;
+    }
+  }
+  return 0;
+}
+
+inline int mbedtls_sha256_finish_ret(mbedtls_sha256_context* c, unsigned char out[32]) {
+  const uint64_t bits = c->total * 8;
+  static const uint8_t pad0 = 0x80;
+  static const uint8_t zeros[64] = {0};
+  mbedtls_sha256_update_ret(c, &pad0, 1);
+  const size_t fill = (size_t)(c->total & 63);
+  mbedtls_sha256_update_ret(c, zeros, fill <= 56 ? 56 - fill : 120 - fill);
+  uint8_t len_be[8];
+  for (int i = 0; i < 8; i++) len_be[i] = (uint8_t)(bits >> (56 - i * 8));
+  mbedtls_sha256_update_ret(c, len_be, sizeof(len_be));
+  for (int i = 0; i < 8; i++) {
+    out[i * 4] = (uint8_t)(c->state[i] >> 24);
+    out[i * 4 + 1] = (uint8_t)(c->state[i] >> 16);
+    out[i * 4 + 2] = (uint8_t)(c->state[i] >> 8);
+    out[i * 4 + 3] = (uint8_t)c->state[i];
+  }
+  return 0;
+}
@@ -0,0 +1,89 @@
+// test/host/test_allowlist_json_loader.cpp
+// Role: Snapshot generation and journal record counts, the two figures boot compares to pick
+// the newer allowlist copy (SD or NVS).
+
+#include <Arduino.h>
+
+#include <string.h>
+
+#include <string>
+
+#include "logging/sha256_hex.h"
+#include "nfc/allowlist_journal.h"
+#include "nfc/allowlist_json_loader.h"
+#include "nfc/allowlist_table.h"
+#include "nfc/nfc_allowlist.h"
+#include "wss_test.h"
+
+static const char kTagA[] = "aa00000000000000000000000000000000000000000000000000000000000001";
+static const char kTagB[] = "bb00000000000000000000000000000000000000000000000000000000000002";
+
+// Feeds `doc` one byte at a time; returns the loader's generation, or -1 when it fails.
+static long long load(const std::string& doc, WssAllowlistTable& t) {
+  WssAllowlistJsonLoader loader(t);
+  for (char c : doc) loader.write((uint8_t)c);
+  return loader.finish() ? (long long)loader.generation() : -1;
+}
+
+static std::string snapshot(const char* generation) {
+  std::string s = "{\"version\":1,";
+  if (generation) s += std::string("\"generation\":") + generation + ",";
+  return s + "\"entries\":[{\"tag\":\"" + kTagA + "\",\"role\":\"admin\"}]}";
+}
+
+static void test_generation() {
+  WssAllowlistTable t;
+  WSS_CHECK_EQ(load(snapshot("42"), t), 42);
+  WSS_CHECK_EQ(t.count(), 1);
+  WSS_CHECK_EQ(load(snapshot("4294967295"), t), 4294967295u);
+  WSS_CHECK_EQ(load(snapshot(nullptr), t), 0);  // written before generations
+  WSS_CHECK_EQ(load(snapshot("4294967296"), t), 0);
+  WSS_CHECK_EQ(load(snapshot("-3"), t), 0);
+  WSS_CHECK_EQ(load(snapshot("1.5"), t), 0);
+  WSS_CHECK_EQ(load(snapshot("\"7\""), t), 0);
+  // Generation after the entries, and a nested key of the same name, which is not it.
+  WSS_CHECK_EQ(load(std::string("{\"entries\":[{\"tag\":\"") + kTagA +
+                        "\",\"generation\":9}],\"generation\":12}",
+                    t),
+               12);
+  WSS_CHECK_EQ(load(std::string("{\"meta\":{\"generation\":9},\"entries\":[]}"), t), 0);
+  WSS_CHECK_EQ(load(snapshot("12") + "x", t), -1);
+}
+
+// A copy's generation is its snapshot's plus its journal records; a torn tail left by an
+// interrupted append is not a record.
+static void test_copy_generation() {
+  WssAllowlistTable t;
+  WSS_CHECK_EQ(load(snapshot("5"), t), 5);
+  uint8_t b[32];
+  WSS_CHECK(wss_hex_parse(kTagB, b, sizeof(b)));
+  uint8_t a[32];
+  WSS_CHECK(wss_hex_parse(kTagA, a, sizeof(a)));
+  char rec[kWssAllowlistJournalRecLen + 1];
+  std::string jnl;
+  wss_allowlist_journal_record(b, WSS_NFC_ROLE_USER, false, rec);
+  jnl += rec;
+  wss_allowlist_journal_record(a, WSS_NFC_ROLE_UNKNOWN, true, rec);
+  jnl += rec;
+
+  // The card missed the revocation of A: its copy still lets A in, and counts lower.
+  WssAllowlistJournalReplay sd(t);
+  sd.write(reinterpret_cast<const uint8_t*>(jnl.data()), kWssAllowlistJournalRecLen);
+  sd.write(reinterpret_cast<const uint8_t*>(jnl.data()) + kWssAllowlistJournalRecLen, 30);
+  WSS_CHECK_EQ(5 + sd.records(), 6);
+  WSS_CHECK_EQ(t.find(a), WSS_NFC_ROLE_ADMIN);
+
+  WssAllowlistTable t2;
+  WSS_CHECK_EQ(load(snapshot("5"), t2), 5);
+  WssAllowlistJournalReplay nvs(t2);
+  nvs.write(reinterpret_cast<const uint8_t*>(jnl.data()), jnl.size());
+  WSS_CHECK_EQ(5 + nvs.records(), 7);
+  WSS_CHECK_EQ(t2.find(a), WSS_NFC_ROLE_UNKNOWN);
+  WSS_CHECK_EQ(t2.find(b), WSS_NFC_ROLE_USER);
+}
+
+int main() {
+  WSS_RUN(test_generation);
+  WSS_RUN(test_copy_generation);
+  return 0;
+}
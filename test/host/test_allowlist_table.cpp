@@ -0,0 +1,105 @@
+// test/host/test_allowlist_table.cpp
+// Role: Randomized put/remove/find against std::map, with digests that share their home
+// slot and Bloom bits, so probe runs, backward-shift deletion and filter rebuilds are hit.
+
+#include <Arduino.h>
+
+#include <string.h>
+
+#include <array>
+#include <map>
+
+#include "nfc/allowlist_table.h"
+#include "wss_test.h"
+
+typedef std::array<uint8_t, 32> Digest;
+
+static uint32_t g_rng = 7;
+
+static uint32_t rnd() {
+  g_rng = g_rng * 1103515245u + 12345u;
+  return g_rng >> 8;
+}
+
+// Drawn from a small pool in which every four ids share their first four bytes (the home
+// slot hash); the rest of the bytes tell them apart.
+static Digest digest_from(uint32_t id) {
+  Digest d;
+  for (size_t i = 0; i < d.size(); i++) d[i] = (uint8_t)(id * 131 + i * 17 + (id >> 8));
+  const uint32_t home = (id / 4) * 2654435761u;
+  memcpy(d.data(), &home, sizeof(home));
+  memcpy(d.data() + 28, &id, sizeof(id));
+  return d;
+}
+
+static void check_same(const WssAllowlistTable& t, const std::map<Digest, uint8_t>& m) {
+  WSS_CHECK_EQ(t.count(), m.size());
+  size_t roles[4] = {0};
+  for (const auto& kv : m) {
+    WSS_CHECK_EQ(t.find(kv.first.data()), kv.second);
+    WSS_CHECK(t.may_contain(kv.first.data()));  // no false negatives
+    roles[kv.second]++;
+  }
+  for (uint8_t r = 0; r < 4; r++) WSS_CHECK_EQ(t.count_role(r), roles[r]);
+  for (size_t i = 0; i < t.count(); i++) {
+    Digest d;
+    memcpy(d.data(), t.at(i).digest, d.size());
+    const auto it = m.find(d);
+    WSS_CHECK(it != m.end());
+    WSS_CHECK_EQ(t.at(i).role, it->second);
+  }
+}
+
+static void test_random_ops() {
+  WssAllowlistTable t;
+  std::map<Digest, uint8_t> m;
+  for (int op = 0; op < 200000; op++) {
+    const Digest d = digest_from(rnd() % 3000);
+    const uint32_t kind = rnd() % 10;
+    if (kind < 5) {
+      const uint8_t role = (uint8_t)(1 + rnd() % 3);
+      bool changed = false;
+      WSS_CHECK(t.put(d.data(), role, changed));
+      const auto it = m.find(d);
+      WSS_CHECK_EQ(changed, it == m.end() || it->second != role);
+      m[d] = role;
+    } else if (kind < 8) {
+      WSS_CHECK_EQ(t.remove(d.data()), m.erase(d) == 1);
+    } else {
+      const auto it = m.find(d);
+      WSS_CHECK_EQ(t.find(d.data()), it == m.end() ? 0 : it->second);
+    }
+    if (op % 5000 == 0) check_same(t, m);
+  }
+  check_same(t, m);
+
+  t.clear();
+  m.clear();
+  check_same(t, m);
+  WSS_CHECK_EQ(t.find(digest_from(1).data()), 0);
+}
+
+static void test_rejects_bad_role() {
+  WssAllowlistTable t;
+  bool changed = true;
+  WSS_CHECK(!t.put(digest_from(1).data(), 4, changed));
+  WSS_CHECK(!changed);
+  WSS_CHECK_EQ(t.count(), 0);
+  WSS_CHECK(!t.remove(digest_from(1).data()));
+}
+
+static void test_reserve_keeps_entries() {
+  WssAllowlistTable t;
+  bool changed;
+  for (uint32_t i = 0; i < 100; i++) WSS_CHECK(t.put(digest_from(i).data(), 1, changed));
+  WSS_CHECK(t.reserve(20000));
+  for (uint32_t i = 0; i < 100; i++) WSS_CHECK_EQ(t.find(digest_from(i).data()), 1);
+  WSS_CHECK_EQ(t.count_role(1), 100);
+}
+
+int main() {
+  WSS_RUN(test_random_ops);
+  WSS_RUN(test_rejects_bad_role);
+  WSS_RUN(test_reserve_keeps_entries);
+  return 0;
+}
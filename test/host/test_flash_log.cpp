@@ -0,0 +1,355 @@
+// test/host/test_flash_log.cpp
+// Role: Power-cut suite for the flash-ring segment log on emulated NOR flash: torn record
+// writes, torn drain-flag writes, wrap-around that drops the oldest sector, and a drain
+// cursor whose sector was erased under it.
+
+#include <Arduino.h>
+
+#include "storage/flash_log.h"
+#include "wss_test.h"
+
+static const uint32_t kSector = WssFlashLog::kSectorBytes;
+static const uint32_t kRecordSpan = 24;  // 12-byte header + "rec 00000" padded to 4
+static const uint32_t kPerSector = (kSector - 16) / kRecordSpan;
+
+// WssRamFlash with a power switch. cut_after(n) lets the next n bytes of programming
+// through; the write that crosses the budget stops there and the device is dead (every
+// later write, erase and read fails) until power_on(), like a supply dropping mid-program.
+class PowerCutFlash : public WssFlashDevice {
+ public:
+  explicit PowerCutFlash(uint32_t size) : _mem(size) {}
+
+  void cut_after(size_t bytes) {
+    _armed = true;
+    _budget = bytes;
+  }
+  void power_on() {
+    _armed = false;
+    _dead = false;
+  }
+  bool dead() const { return _dead; }
+
+  uint32_t size() const override { return _mem.size(); }
+  bool read(uint32_t offset, void* buf, size_t len) override {
+    return !_dead && _mem.read(offset, buf, len);
+  }
+  bool write(uint32_t offset, const void* buf, size_t len) override {
+    if (_dead) return false;
+    if (_armed && len > _budget) {
+      if (_budget) (void)_mem.write(offset, buf, _budget);
+      _dead = true;
+      return false;
+    }
+    if (_armed) _budget -= len;
+    return _mem.write(offset, buf, len);
+  }
+  bool erase_sector(uint32_t offset) override {
+    if (_dead) return false;
+    if (_armed && _budget == 0) {
+      _dead = true;  // cut before the erase started: the sector keeps its old contents
+      return false;
+    }
+    return _mem.erase_sector(offset);
+  }
+
+ private:
+  WssRamFlash _mem;
+  bool _armed = false;
+  bool _dead = false;
+  size_t _budget = 0;
+};
+
+static bool append_rec(WssFlashLog& log, uint32_t i) {
+  char b[16];
+  const int n = snprintf(b, sizeof(b), "rec %05lu", (unsigned long)i);
+  return log.append(reinterpret_cast<const uint8_t*>(b), (size_t)n);
+}
+
+static uint32_t rec_no(const String& s) {
+  WSS_CHECK(s.startsWith("rec "));
+  return (uint32_t)atol(s.c_str() + 4);
+}
+
+// Checks that read_recent() returns exactly first..last, in order.
+static void check_contents(WssFlashLog& log, uint32_t first, uint32_t last) {
+  const uint32_t n = last - first + 1;
+  WSS_CHECK_EQ(log.count(), n);
+  String* out = new String[n + 8];
+  WSS_CHECK_EQ(log.read_recent(out, n + 8), n);
+  for (uint32_t i = 0; i < n; i++) WSS_CHECK_EQ(rec_no(out[i]), first + i);
+  delete[] out;
+}
+
+// Drains everything pending and returns how many records came out, checking they are in
+// increasing order starting at `first`.
+static uint32_t drain_all(WssFlashLog& log, uint32_t first) {
+  WssFlashLogCursor cur;
+  WssFlashLogCursor at;
+  String line;
+  uint32_t n = 0;
+  while (log.next_pending(cur, line, at)) {
+    WSS_CHECK_EQ(rec_no(line), first + n);
+    WSS_CHECK(log.mark_drained(at));
+    n++;
+  }
+  WSS_CHECK_EQ(log.pending(), 0);
+  return n;
+}
+
+static void reboot(PowerCutFlash& dev, WssFlashLog& log) {
+  dev.power_on();
+  WSS_CHECK(log.begin(&dev));
+}
+
+// A cut part-way through a record's payload: its header is complete but the CRC fails.
+static void test_torn_record_payload() {
+  PowerCutFlash dev(8 * kSector);
+  WssFlashLog log;
+  WSS_CHECK(log.begin(&dev));
+  for (uint32_t i = 0; i < 5; i++) WSS_CHECK(append_rec(log, i));
+  dev.cut_after(12 + 4);
+  WSS_CHECK(!append_rec(log, 5));
+  WSS_CHECK(dev.dead());
+
+  WssFlashLog after;
+  reboot(dev, after);
+  WSS_CHECK_EQ(after.stats().torn_records, 1);
+  WSS_CHECK_EQ(after.pending(), 5);
+  check_contents(after, 0, 4);
+
+  // The torn sector is sealed; appends continue in the next one.
+  WSS_CHECK(append_rec(after, 6));
+  WSS_CHECK_EQ(after.stats().used_sectors, 2);
+
+  // Once the sector is no longer the head it is not CRC-checked at mount; the torn record
+  // must still not come back as a record.
+  WssFlashLog again;
+  reboot(dev, again);
+  WSS_CHECK_EQ(again.stats().torn_records, 0);
+  WSS_CHECK_EQ(again.count(), 6);
+  WSS_CHECK_EQ(again.pending(), 6);
+  String out[8];
+  WSS_CHECK_EQ(again.read_recent(out, 8), 6);
+  WSS_CHECK_EQ(rec_no(out[4]), 4);
+  WSS_CHECK_EQ(rec_no(out[5]), 6);
+
+  WssFlashLogCursor cur;
+  WssFlashLogCursor at;
+  String line;
+  uint32_t seen = 0;
+  while (again.next_pending(cur, line, at)) {
+    WSS_CHECK(rec_no(line) != 5);
+    WSS_CHECK(again.mark_drained(at));
+    seen++;
+  }
+  WSS_CHECK_EQ(seen, 6);
+}
+
+// A cut inside the record header (len written, ~len not): the length check fails.
+static void test_torn_record_header() {
+  PowerCutFlash dev(8 * kSector);
+  WssFlashLog log;
+  WSS_CHECK(log.begin(&dev));
+  for (uint32_t i = 0; i < 3; i++) WSS_CHECK(append_rec(log, i));
+  dev.cut_after(2);
+  WSS_CHECK(!append_rec(log, 3));
+
+  WssFlashLog after;
+  reboot(dev, after);
+  WSS_CHECK_EQ(after.stats().torn_records, 1);
+  check_contents(after, 0, 2);
+  WSS_CHECK(append_rec(after, 4));
+  WSS_CHECK_EQ(after.stats().used_sectors, 2);
+
+  WssFlashLog again;
+  reboot(dev, again);
+  WSS_CHECK_EQ(again.count(), 4);
+  static const uint32_t kWant[] = {0, 1, 2, 4};
+  WssFlashLogCursor cur;
+  WssFlashLogCursor at;
+  String line;
+  for (uint32_t want : kWant) {
+    WSS_CHECK(again.next_pending(cur, line, at));
+    WSS_CHECK_EQ(rec_no(line), want);
+    WSS_CHECK(again.mark_drained(at));
+  }
+  WSS_CHECK(!again.next_pending(cur, line, at));
+}
+
+// A cut before the first byte was programmed leaves clean free space: nothing is torn and
+// the sector keeps filling.
+static void test_cut_before_write() {
+  PowerCutFlash dev(8 * kSector);
+  WssFlashLog log;
+  WSS_CHECK(log.begin(&dev));
+  for (uint32_t i = 0; i < 3; i++) WSS_CHECK(append_rec(log, i));
+  dev.cut_after(0);
+  WSS_CHECK(!append_rec(log, 3));
+
+  WssFlashLog after;
+  reboot(dev, after);
+  WSS_CHECK_EQ(after.stats().torn_records, 0);
+  WSS_CHECK(append_rec(after, 3));
+  WSS_CHECK_EQ(after.stats().used_sectors, 1);
+  check_contents(after, 0, 3);
+}
+
+// Drain flags are the one in-place write. A flag write cut after one of its two bytes
+// still reads as drained; one that never started leaves the record pending, so it is
+// delivered again (at least once, never lost).
+static void test_torn_drain_flag() {
+  PowerCutFlash dev(8 * kSector);
+  WssFlashLog log;
+  WSS_CHECK(log.begin(&dev));
+  for (uint32_t i = 0; i < 10; i++) WSS_CHECK(append_rec(log, i));
+
+  WssFlashLogCursor cur;
+  WssFlashLogCursor at;
+  String line;
+  for (uint32_t i = 0; i < 3; i++) {
+    WSS_CHECK(log.next_pending(cur, line, at));
+    WSS_CHECK(log.mark_drained(at));
+  }
+  WSS_CHECK(log.next_pending(cur, line, at));
+  WSS_CHECK_EQ(rec_no(line), 3);
+  dev.cut_after(1);
+  WSS_CHECK(!log.mark_drained(at));
+
+  WssFlashLog after;
+  reboot(dev, after);
+  WSS_CHECK_EQ(after.count(), 10);
+  WSS_CHECK_EQ(after.pending(), 6);  // 3 drained + 1 torn flag
+  WssFlashLogCursor c2;
+  WSS_CHECK(after.next_pending(c2, line, at));
+  WSS_CHECK_EQ(rec_no(line), 4);
+
+  // Now the cut lands before the flag write starts: record 4 stays pending.
+  dev.cut_after(0);
+  WSS_CHECK(!after.mark_drained(at));
+  WssFlashLog again;
+  reboot(dev, again);
+  WSS_CHECK_EQ(again.pending(), 6);
+  WSS_CHECK_EQ(drain_all(again, 4), 6);
+  check_contents(again, 0, 9);  // draining never removes records
+}
+
+// A batch retried after a partial failure marks some records a second time; the pending
+// count must only drop once per record, or the backfill stops with records left behind.
+static void test_mark_drained_twice() {
+  PowerCutFlash dev(8 * kSector);
+  WssFlashLog log;
+  WSS_CHECK(log.begin(&dev));
+  for (uint32_t i = 0; i < 10; i++) WSS_CHECK(append_rec(log, i));
+
+  WssFlashLogCursor cur;
+  WssFlashLogCursor at[3];
+  String line;
+  for (uint32_t i = 0; i < 3; i++) {
+    WSS_CHECK(log.next_pending(cur, line, at[i]));
+    WSS_CHECK(log.mark_drained(at[i]));
+  }
+  for (uint32_t i = 0; i < 3; i++) WSS_CHECK(log.mark_drained(at[i]));
+  WSS_CHECK_EQ(log.pending(), 7);
+  WSS_CHECK_EQ(drain_all(log, 3), 7);
+}
+
+// Filling the ring wraps onto the oldest sector, which is dropped with its records. One
+// sector is always kept erased ahead of the head.
+static void test_wrap_drops_tail() {
+  const uint32_t sectors = 4;
+  PowerCutFlash dev(sectors * kSector);
+  WssFlashLog log;
+  WSS_CHECK(log.begin(&dev));
+  const uint32_t total = kPerSector * 7 + 11;
+  for (uint32_t i = 0; i < total; i++) {
+    WSS_CHECK(append_rec(log, i));
+    log.maintain();
+  }
+  // Live: the head (11 records) and the two full sectors before it.
+  const uint32_t first = total - 11 - 2 * kPerSector;
+  WSS_CHECK_EQ(log.stats().used_sectors, sectors - 1);
+  check_contents(log, first, total - 1);
+  WSS_CHECK_EQ(log.pending(), total - first);
+
+  WssFlashLog after;
+  reboot(dev, after);
+  WSS_CHECK_EQ(after.stats().torn_records, 0);
+  check_contents(after, first, total - 1);
+  WSS_CHECK_EQ(drain_all(after, first), total - first);
+
+  // Without maintain() the erase-ahead is still owed when the head fills again, so the
+  // rollover erases inline. Power is lost before that erase: the sector keeps its records
+  // (they are still the live tail) and the erase simply happens after the reboot.
+  uint32_t i = total;
+  for (; i < total + kPerSector - 11 + kPerSector; i++) WSS_CHECK(append_rec(after, i));
+  WSS_CHECK_EQ(after.stats().used_sectors, sectors);  // tail not yet erased
+  dev.cut_after(0);
+  WSS_CHECK(!append_rec(after, i));
+  const uint32_t last = i - 1;
+
+  WssFlashLog again;
+  reboot(dev, again);
+  WSS_CHECK_EQ(again.stats().torn_records, 0);
+  check_contents(again, last + 1 - sectors * kPerSector, last);
+  again.maintain();  // the owed erase drops the oldest sector
+  check_contents(again, last + 1 - (sectors - 1) * kPerSector, last);
+  WSS_CHECK(append_rec(again, last + 1));
+  again.maintain();
+  check_contents(again, last + 1 - (sectors - 2) * kPerSector, last + 1);
+}
+
+// A drain cursor parked in the tail sector while appends wrap over it resumes at the new
+// oldest record; a drain mark for the erased sector is refused.
+static void test_next_pending_after_erase() {
+  const uint32_t sectors = 4;
+  PowerCutFlash dev(sectors * kSector);
+  WssFlashLog log;
+  WSS_CHECK(log.begin(&dev));
+  uint32_t n = 0;
+  for (; n < kPerSector * 2; n++) WSS_CHECK(append_rec(log, n));
+
+  WssFlashLogCursor cur;
+  WssFlashLogCursor at;
+  String line;
+  for (uint32_t i = 0; i < 5; i++) {
+    WSS_CHECK(log.next_pending(cur, line, at));
+    WSS_CHECK(log.mark_drained(at));
+  }
+  WSS_CHECK(log.next_pending(cur, line, at));  // record 5, not yet marked
+  WSS_CHECK_EQ(rec_no(line), 5);
+
+  // Two more sectors' worth; the erase-ahead then takes sector 0 (records 0..169).
+  for (; n < kPerSector * 4; n++) WSS_CHECK(append_rec(log, n));
+  log.maintain();
+  WSS_CHECK(!log.mark_drained(at));
+
+  const uint32_t oldest = kPerSector;
+  WSS_CHECK(log.next_pending(cur, line, at));
+  WSS_CHECK_EQ(rec_no(line), oldest);
+  WSS_CHECK(log.mark_drained(at));
+  uint32_t next = oldest + 1;
+  while (log.next_pending(cur, line, at)) {
+    WSS_CHECK_EQ(rec_no(line), next);
+    WSS_CHECK(log.mark_drained(at));
+    next++;
+  }
+  WSS_CHECK_EQ(next, n);
+  WSS_CHECK_EQ(log.pending(), 0);
+
+  // Records appended after the drain caught up are found from the same cursor.
+  WSS_CHECK(append_rec(log, n));
+  WSS_CHECK(log.next_pending(cur, line, at));
+  WSS_CHECK_EQ(rec_no(line), n);
+}
+
+int main() {
+  WSS_CHECK_EQ(kPerSector, 170);
+  WSS_RUN(test_torn_record_payload);
+  WSS_RUN(test_torn_record_header);
+  WSS_RUN(test_cut_before_write);
+  WSS_RUN(test_torn_drain_flag);
+  WSS_RUN(test_mark_drained_twice);
+  WSS_RUN(test_wrap_drops_tail);
+  WSS_RUN(test_next_pending_after_erase);
+  return 0;
+}
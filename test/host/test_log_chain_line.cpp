@@ -0,0 +1,107 @@
+// test/host/test_log_chain_line.cpp
+// Role: Checks the single-pass chainer against the M3 rule computed the long way:
+// hash = SHA256(line_without_hash_fields + prev_hash), fields appended in place of '}'.
+
+#include <Arduino.h>
+
+#include <string.h>
+
+#include <string>
+
+#include "logging/log_chain_line.h"
+#include "logging/sha256_hex.h"
+#include "wss_test.h"
+
+static const std::string kZero(64, '0');
+
+static std::string line_at(uint32_t seq) {
+  return "{\"ts\":\"2026-01-23T19:46:12Z\",\"seq\":" + std::to_string(seq) +
+         ",\"event_type\":\"nfc_scan\",\"severity\":\"info\",\"source\":\"nfc\","
+         "\"msg\":\"NFC scan allowed\",\"extra\":{\"result\":\"allow\",\"role\":\"user\"}}";
+}
+
+static std::string expected_hash(const std::string& line, const std::string& prev) {
+  const String h = wss_sha256_hex_str(String((line + prev).c_str()));
+  return std::string(h.c_str(), h.length());
+}
+
+static void test_matches_rule() {
+  std::string prev = kZero;
+  for (uint32_t seq = 1; seq <= 200; seq++) {
+    const std::string line = line_at(seq);
+    String out;
+    char hash[65];
+    WSS_CHECK(wss_log_chain_line(line.c_str(), line.size(), prev.c_str(), out, hash));
+    const std::string want = expected_hash(line, prev);
+    WSS_CHECK(want == hash);
+    const std::string want_line = line.substr(0, line.size() - 1) + ",\"prev_hash\":\"" + prev +
+                                  "\",\"hash\":\"" + want + "\"}";
+    WSS_CHECK(want_line == out.c_str());
+    WSS_CHECK(out.length() <= line.size() + kWssLogChainSuffixMax);
+    prev = hash;
+  }
+}
+
+static void test_trailing_whitespace_and_empty_object() {
+  const std::string line = line_at(7);
+  String a, b;
+  char ha[65], hb[65];
+  WSS_CHECK(wss_log_chain_line(line.c_str(), line.size(), kZero.c_str(), a, ha));
+  const std::string padded = line + " \r\n";
+  WSS_CHECK(wss_log_chain_line(padded.c_str(), padded.size(), kZero.c_str(), b, hb));
+  WSS_CHECK(strcmp(ha, hb) == 0);
+  WSS_CHECK(a == b);
+
+  String out;
+  char hash[65];
+  WSS_CHECK(wss_log_chain_line("{}", 2, kZero.c_str(), out, hash));
+  WSS_CHECK(expected_hash("{}", kZero) == hash);
+  WSS_CHECK(std::string("{\"prev_hash\":\"") + kZero + "\",\"hash\":\"" + hash + "\"}" ==
+            out.c_str());
+}
+
+static void test_chaining_disabled() {
+  const std::string line = line_at(3);
+  String out;
+  char hash[65] = "x";
+  WSS_CHECK(wss_log_chain_line(line.c_str(), line.size(), nullptr, out, hash));
+  WSS_CHECK_EQ(hash[0], 0);
+  WSS_CHECK(line.substr(0, line.size() - 1) + ",\"prev_hash\":null,\"hash\":null}" ==
+            out.c_str());
+}
+
+// Lines the parse path has to handle are refused, not mangled.
+static void test_refuses_other_lines() {
+  const char* const lines[] = {
+      "",  "{", "not json", "[1,2]", "{\"a\":1",
+      "{\"a\":1,\"hash\":null}", "{\"a\":1,\"prev_hash\":\"00\"}",
+  };
+  for (const char* line : lines) {
+    String out;
+    char hash[65];
+    WSS_CHECK(!wss_log_chain_line(line, strlen(line), kZero.c_str(), out, hash));
+  }
+  String out;
+  char hash[65];
+  WSS_CHECK(!wss_log_chain_line(nullptr, 0, kZero.c_str(), out, hash));
+}
+
+// Only [line, line+len) is the line: a "hash" key in the bytes after it (the next line of a
+// read buffer) must not refuse it.
+static void test_reads_only_len_bytes() {
+  const std::string line = line_at(4);
+  const std::string buf = line + "\n{\"a\":1,\"hash\":null}";
+  String out;
+  char hash[65];
+  WSS_CHECK(wss_log_chain_line(buf.c_str(), line.size(), kZero.c_str(), out, hash));
+  WSS_CHECK(strncmp(out.c_str(), line.c_str(), line.size() - 1) == 0);
+}
+
+int main() {
+  WSS_RUN(test_matches_rule);
+  WSS_RUN(test_trailing_whitespace_and_empty_object);
+  WSS_RUN(test_chaining_disabled);
+  WSS_RUN(test_refuses_other_lines);
+  WSS_RUN(test_reads_only_len_bytes);
+  return 0;
+}
@@ -0,0 +1,221 @@
+// test/host/test_log_checkpoint.cpp
+// Role: Checks for the chain verifier's two modes on a synthetic day file: checkpoint mode
+// passes clean files without re-hashing the event lines, re-hashes only the intervals that
+// fail and the uncovered tail, and lands on the same first broken seq as the full re-hash.
+
+#include <Arduino.h>
+
+#include <string>
+
+#include "logging/log_chain_line.h"
+#include "logging/sha256_hex.h"
+#include "storage/log_checkpoint.h"
+#include "wss_test.h"
+
+static const uint32_t kPerCheckpoint = 8;
+
+struct DayOptions {
+  uint32_t events = 43;   // 5 full segments and a 3-line tail
+  uint32_t ghost_seq = 0; // counted in its checkpoint root, then left out of the file
+};
+
+static std::string meta_line(uint32_t seq, const char* type, const std::string& extra) {
+  return "{\"ts\":\"2026-10-16T08:00:00Z\",\"seq\":" + std::to_string(seq) +
+         ",\"severity\":\"info\",\"source\":\"log\",\"event_type\":\"" + type +
+         "\",\"msg\":\"" + type + "\",\"time_valid\":true,\"extra\":{" + extra + "}}";
+}
+
+static std::string event_line(uint32_t seq) {
+  return "{\"ts\":\"2026-10-16T08:00:00Z\",\"seq\":" + std::to_string(seq) +
+         ",\"event_type\":\"nfc_scan\",\"severity\":\"info\",\"source\":\"nfc\","
+         "\"msg\":\"NFC scan allowed\",\"extra\":{\"result\":\"allow\",\"role\":\"user\"}}";
+}
+
+// Builds a day file the way the storage layer writes it: a file header, chained events and
+// a log_checkpoint after every kPerCheckpoint events.
+static std::string build_day(const DayOptions& o) {
+  std::string text;
+  std::string prev(64, '0');
+  uint32_t seq = 1;
+  auto append = [&](const std::string& raw, bool emit, char hash[65]) {
+    String out;
+    WSS_CHECK(wss_log_chain_line(raw.c_str(), raw.size(), prev.c_str(), out, hash));
+    if (!emit) return;
+    text.append(out.c_str(), out.length());
+    text += '\n';
+    prev = hash;
+  };
+  char hash[65];
+  append(meta_line(seq++, "file_header", ""), true, hash);
+  WssMerkle m;
+  uint32_t first = 0;
+  uint32_t last = 0;
+  for (uint32_t i = 0; i < o.events; i++) {
+    const uint32_t s = seq++;
+    append(event_line(s), s != o.ghost_seq, hash);
+    uint8_t leaf[32];
+    WSS_CHECK(wss_hex_parse(hash, leaf, sizeof(leaf)));
+    m.add(leaf);
+    if (!first) first = s;
+    last = s;
+    if (m.count() < kPerCheckpoint) continue;
+    uint8_t root[32];
+    m.root(root);
+    char root_hex[65];
+    wss_hex_lower(root, sizeof(root), root_hex);
+    const std::string extra = "\"first_seq\":" + std::to_string(first) +
+                              ",\"last_seq\":" + std::to_string(last) +
+                              ",\"lines\":" + std::to_string(m.count()) +
+                              ",\"merkle_root\":\"" + root_hex + "\"";
+    append(meta_line(seq++, "log_checkpoint", extra), true, hash);
+    m.reset();
+    first = 0;
+  }
+  return text;
+}
+
+static size_t line_start(const std::string& text, uint32_t seq) {
+  const size_t p = text.find("\"seq\":" + std::to_string(seq) + ",");
+  WSS_CHECK(p != std::string::npos);
+  return text.rfind('\n', p) + 1;
+}
+
+// Changes the event line's msg without touching its chain fields.
+static void edit_content(std::string& text, uint32_t seq) {
+  const size_t p = text.find("allowed", line_start(text, seq));
+  WSS_CHECK(p != std::string::npos);
+  text[p] = 'A';
+}
+
+// Flips the first hex digit of the line's stored hash.
+static void edit_hash(std::string& text, uint32_t seq) {
+  const size_t p = text.find("\"hash\":\"", line_start(text, seq)) + 8;
+  text[p] = text[p] == '0' ? '1' : '0';
+}
+
+static void feed(WssLogChainVerifier& v, const std::string& text, uint64_t start, uint64_t end);
+
+// Mirrors verify_rehash_if_due() in the storage manager.
+static void rehash_if_due(WssLogChainVerifier& v, const std::string& text) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+  if (!v.rehash_due(start, end)) return;
+  v.begin_rehash();
+  feed(v, text, start, end);
+  v.end_rehash();
+}
+
+static void feed(WssLogChainVerifier& v, const std::string& text, uint64_t start, uint64_t end) {
+  uint64_t pos = start;
+  while (pos < end) {
+    size_t nl = text.find('\n', pos);
+    if (nl == std::string::npos || nl >= end) nl = end;
+    std::string line = text.substr(pos, nl - pos);
+    pos = nl < end ? nl + 1 : end;
+    v.line(line.c_str(), line.size(), pos);
+    rehash_if_due(v, text);
+  }
+}
+
+static WssLogVerifyReport verify(const std::string& text, WssLogVerifyMode mode) {
+  WssLogChainVerifier v(mode);
+  v.begin_file("20261016");
+  feed(v, text, 0, text.size());
+  v.end_data(text.size());
+  rehash_if_due(v, text);
+  v.end_file();
+  return v.report();
+}
+
+static void check_same_finding(const WssLogVerifyReport& a, const WssLogVerifyReport& b) {
+  WSS_CHECK_EQ(a.lines, b.lines);
+  WSS_CHECK_EQ(a.bad_lines, b.bad_lines);
+  WSS_CHECK_EQ(a.first_bad_seq, b.first_bad_seq);
+  WSS_CHECK(a.first_bad_reason == b.first_bad_reason);
+}
+
+static void test_clean_day() {
+  const std::string text = build_day(DayOptions());
+  const WssLogVerifyReport full = verify(text, WSS_LOG_VERIFY_FULL);
+  const WssLogVerifyReport ckpt = verify(text, WSS_LOG_VERIFY_CHECKPOINT);
+  WSS_CHECK_EQ(full.bad_lines, 0);
+  WSS_CHECK_EQ(full.rehashed_lines, full.lines);
+  WSS_CHECK_EQ(full.rehashed_spans, 0);
+  WSS_CHECK_EQ(ckpt.bad_lines, 0);
+  WSS_CHECK_EQ(ckpt.lines, 1 + 43 + 5);
+  WSS_CHECK_EQ(ckpt.checkpoints, 5);
+  WSS_CHECK_EQ(ckpt.uncheckpointed_lines, 3);
+  // The header, the five checkpoints and the three tail lines; the tail is one span.
+  WSS_CHECK_EQ(ckpt.rehashed_lines, 1 + 5 + 3);
+  WSS_CHECK_EQ(ckpt.rehashed_spans, 1);
+}
+
+static void test_no_tail() {
+  DayOptions o;
+  o.events = 40;
+  const WssLogVerifyReport r = verify(build_day(o), WSS_LOG_VERIFY_CHECKPOINT);
+  WSS_CHECK_EQ(r.bad_lines, 0);
+  WSS_CHECK_EQ(r.rehashed_lines, 1 + 5);
+  WSS_CHECK_EQ(r.rehashed_spans, 0);
+}
+
+// The documented gap: an edit that leaves the stored hash alone only fails the full re-hash.
+static void test_content_edit_needs_full() {
+  std::string text = build_day(DayOptions());
+  edit_content(text, 12);
+  const WssLogVerifyReport ckpt = verify(text, WSS_LOG_VERIFY_CHECKPOINT);
+  WSS_CHECK_EQ(ckpt.bad_lines, 0);
+  const WssLogVerifyReport full = verify(text, WSS_LOG_VERIFY_FULL);
+  WSS_CHECK_EQ(full.bad_lines, 1);
+  WSS_CHECK_EQ(full.first_bad_seq, 12);
+  WSS_CHECK(full.first_bad_reason == "hash_mismatch");
+}
+
+// Lines no checkpoint covers are always re-hashed, so the same edit in the tail is caught.
+static void test_tail_edit_caught() {
+  std::string text = build_day(DayOptions());
+  edit_content(text, 48);
+  const WssLogVerifyReport ckpt = verify(text, WSS_LOG_VERIFY_CHECKPOINT);
+  check_same_finding(ckpt, verify(text, WSS_LOG_VERIFY_FULL));
+  WSS_CHECK_EQ(ckpt.first_bad_seq, 48);
+  WSS_CHECK(ckpt.first_bad_reason == "hash_mismatch");
+}
+
+// An edit with a touched-up hash breaks the next link and the root: only that interval and
+// the tail are re-hashed, and the re-hash pins the edited line.
+static void test_hash_edit_rehashes_one_interval() {
+  std::string text = build_day(DayOptions());
+  edit_content(text, 21);
+  edit_hash(text, 21);
+  const WssLogVerifyReport ckpt = verify(text, WSS_LOG_VERIFY_CHECKPOINT);
+  check_same_finding(ckpt, verify(text, WSS_LOG_VERIFY_FULL));
+  WSS_CHECK_EQ(ckpt.first_bad_seq, 21);
+  WSS_CHECK(ckpt.first_bad_reason == "hash_mismatch");
+  WSS_CHECK_EQ(ckpt.rehashed_spans, 2);
+  WSS_CHECK_EQ(ckpt.rehashed_lines, 1 + 5 + kPerCheckpoint + 3);
+  WSS_CHECK_EQ(ckpt.checkpoints, 4);
+}
+
+// A line removed and the rest chained again keeps every link and hash valid; only the
+// checkpoint root over the interval notices.
+static void test_rechained_deletion() {
+  DayOptions o;
+  o.ghost_seq = 30;
+  const std::string text = build_day(o);
+  const WssLogVerifyReport ckpt = verify(text, WSS_LOG_VERIFY_CHECKPOINT);
+  check_same_finding(ckpt, verify(text, WSS_LOG_VERIFY_FULL));
+  WSS_CHECK_EQ(ckpt.bad_lines, 1);
+  WSS_CHECK(ckpt.first_bad_reason == "merkle_mismatch");
+  WSS_CHECK_EQ(ckpt.first_bad_seq, 29); // first_seq of the interval
+  WSS_CHECK_EQ(ckpt.rehashed_spans, 2);
+}
+
+int main() {
+  WSS_RUN(test_clean_day);
+  WSS_RUN(test_no_tail);
+  WSS_RUN(test_content_edit_needs_full);
+  WSS_RUN(test_tail_edit_caught);
+  WSS_RUN(test_hash_edit_rehashes_one_interval);
+  WSS_RUN(test_rechained_deletion);
+  return 0;
+}
@@ -0,0 +1,135 @@
+// test/host/test_log_queue.cpp
+// Role: Checks for the log line queue: lines come out whole and in order from the slot
+// arena, over-long lines are refused (not cut), and the drop-debug-first admission holds.
+
+#include <Arduino.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/log_queue.h"
+#include "wss_test.h"
+
+static std::string line_of(uint32_t producer, uint32_t i, size_t pad = 0) {
+  char b[64];
+  snprintf(b, sizeof(b), "{\"p\":%lu,\"i\":%lu,\"x\":\"", (unsigned long)producer,
+           (unsigned long)i);
+  return std::string(b) + std::string(pad, 'x') + "\"}";
+}
+
+static bool push(WssLogQueue& q, const std::string& s, WssLogSeverity sev = WSS_LOG_SEV_WARN) {
+  return q.push(s.c_str(), s.size(), sev);
+}
+
+static void test_refused_before_begin() {
+  WssLogQueue q;
+  WSS_CHECK(!push(q, line_of(0, 0)));
+  WSS_CHECK_EQ(q.stats().dropped_warn, 1);
+  WSS_CHECK(q.empty());
+}
+
+static void test_fifo_in_place() {
+  WssLogQueue q;
+  WSS_CHECK(q.begin());
+  WSS_CHECK(q.begin());  // idempotent
+  for (uint32_t round = 0; round < 5; round++) {
+    for (uint32_t i = 0; i < WssLogQueue::kCapacity; i++) {
+      WSS_CHECK(push(q, line_of(round, i, i * 7)));
+    }
+    WSS_CHECK(!push(q, line_of(round, 999)));  // full
+    for (uint32_t i = 0; i < WssLogQueue::kCapacity; i++) {
+      WssLogQueueItem item;
+      WSS_CHECK(q.peek(item));
+      const std::string want = line_of(round, i, i * 7);
+      WSS_CHECK_EQ(item.len, want.size());
+      WSS_CHECK(want == item.data);  // NUL-terminated in its slot
+      q.pop();
+    }
+    WSS_CHECK(q.empty());
+  }
+  WSS_CHECK_EQ(q.stats().enqueued, 5 * WssLogQueue::kCapacity);
+  WSS_CHECK_EQ(q.stats().dropped_warn, 5);
+}
+
+static void test_overlong_refused_whole() {
+  WssLogQueue q;
+  WSS_CHECK(q.begin());
+  const std::string fits(WSS_LOG_LINE_MAX, 'a');
+  const std::string too_long(WSS_LOG_LINE_MAX + 1, 'a');
+  WSS_CHECK(push(q, fits));
+  WSS_CHECK(!push(q, too_long, WSS_LOG_SEV_ERROR));
+  WssLogQueueStats st = q.stats();
+  WSS_CHECK_EQ(st.dropped_overlong, 1);
+  WSS_CHECK_EQ(st.dropped_warn, 0);
+  WSS_CHECK_EQ(st.dropped, 1);
+  WssLogQueueItem item;
+  WSS_CHECK(q.peek(item));
+  WSS_CHECK_EQ(item.len, WSS_LOG_LINE_MAX);
+  q.pop();
+  WSS_CHECK(!q.peek(item));
+}
+
+static void test_debug_dropped_first() {
+  WssLogQueue q;
+  WSS_CHECK(q.begin());
+  const std::string s = line_of(0, 0);
+  uint32_t debug = 0;
+  while (push(q, s, WSS_LOG_SEV_DEBUG)) debug++;
+  WSS_CHECK_EQ(debug, WssLogQueue::kCapacity / 2);
+  uint32_t info = 0;
+  while (push(q, s, WSS_LOG_SEV_INFO)) info++;
+  WSS_CHECK_EQ(debug + info, WssLogQueue::kCapacity - WssLogQueue::kCapacity / 8);
+  while (push(q, s, WSS_LOG_SEV_ERROR)) {
+  }
+  WSS_CHECK_EQ(q.depth(), WssLogQueue::kCapacity);
+  WSS_CHECK_EQ(q.stats().dropped_debug, 1);
+  WSS_CHECK_EQ(q.stats().dropped_info, 1);
+}
+
+// Four producers against one consumer: every accepted line comes out exactly once, intact,
+// and each producer's lines keep their order.
+static void test_concurrent_producers() {
+  WssLogQueue q;
+  WSS_CHECK(q.begin());
+  const uint32_t kProducers = 4;
+  const uint32_t kLines = 20000;
+  std::vector<std::thread> producers;
+  for (uint32_t p = 0; p < kProducers; p++) {
+    producers.emplace_back([&q, p]() {
+      for (uint32_t i = 0; i < kLines; i++) {
+        const std::string s = line_of(p, i, i % 300);
+        while (!push(q, s)) std::this_thread::yield();
+      }
+    });
+  }
+  std::vector<uint32_t> next(kProducers, 0);
+  uint32_t got = 0;
+  while (got < kProducers * kLines) {
+    WssLogQueueItem item;
+    if (!q.peek(item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    unsigned long p = 0;
+    unsigned long i = 0;
+    WSS_CHECK(sscanf(item.data, "{\"p\":%lu,\"i\":%lu", &p, &i) == 2);
+    WSS_CHECK(p < kProducers);
+    WSS_CHECK_EQ(i, next[p]);
+    WSS_CHECK(line_of(p, i, i % 300) == item.data);
+    next[p]++;
+    q.pop();
+    got++;
+  }
+  for (std::thread& t : producers) t.join();
+  WSS_CHECK(q.empty());
+}
+
+int main() {
+  WSS_RUN(test_refused_before_begin);
+  WSS_RUN(test_fifo_in_place);
+  WSS_RUN(test_overlong_refused_whole);
+  WSS_RUN(test_debug_dropped_first);
+  WSS_RUN(test_concurrent_producers);
+  return 0;
+}
@@ -0,0 +1,289 @@
+// test/host/test_log_record_codec.cpp
+// Role: Round-trip checks for the binary log record codec: logger lines must come back byte
+// for byte, including the shapes the tokens do not cover (odd timestamps, leading zeros,
+// quoted keys, stuffing bytes), and the JSONL export must restore a mixed day file.
+
+#include <Arduino.h>
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "storage/log_record_codec.h"
+#include "wss_test.h"
+
+struct StringSink : Print {
+  std::string s;
+  size_t write(uint8_t c) override {
+    s.push_back((char)c);
+    return 1;
+  }
+  size_t write(const uint8_t* data, size_t len) override {
+    s.append(reinterpret_cast<const char*>(data), len);
+    return len;
+  }
+};
+
+static uint32_t g_rng = 1;
+
+static uint32_t rnd() {
+  g_rng = g_rng * 1103515245u + 12345u;
+  return g_rng >> 8;
+}
+
+static std::string hex64() {
+  std::string h;
+  for (int i = 0; i < 64; i++) h += "0123456789abcdef"[rnd() % 16];
+  return h;
+}
+
+static std::string encode(const std::string& text) {
+  String out;
+  WSS_CHECK(wss_log_record_encode(text.data(), text.size(), out));
+  return std::string(out.c_str(), out.length());
+}
+
+// Encodes, checks the record is one safe line, and decodes it back three ways.
+static std::string round_trip(const std::string& text) {
+  const std::string rec = encode(text);
+  WSS_CHECK(wss_log_record_is_binary(rec.data(), rec.size()));
+  WSS_CHECK_EQ((uint8_t)rec[0], kWssLogRecordMarker);
+  for (size_t i = 0; i < rec.size(); i++) {
+    const uint8_t c = (uint8_t)rec[i];
+    WSS_CHECK(c != 0x00 && c != '\n' && c != '\r');
+  }
+
+  std::vector<char> buf(text.size() + 1);
+  size_t n = 0;
+  WSS_CHECK(wss_log_record_decode(rec.data(), rec.size(), buf.data(), buf.size(), n));
+  WSS_CHECK_EQ(n, text.size());
+  WSS_CHECK(memcmp(buf.data(), text.data(), n) == 0);
+
+  size_t measured = 0;
+  WSS_CHECK(wss_log_record_decode(rec.data(), rec.size(), nullptr, 0, measured));
+  WSS_CHECK_EQ(measured, text.size());
+  if (!text.empty()) {
+    // One byte short of the terminator does not fit.
+    WSS_CHECK(!wss_log_record_decode(rec.data(), rec.size(), buf.data(), text.size(), n));
+  }
+
+  if (text.find('\0') == std::string::npos) {
+    String line(rec.c_str());
+    WSS_CHECK(wss_log_record_to_text(line));
+    WSS_CHECK(std::string(line.c_str(), line.length()) == text);
+  }
+  return rec;
+}
+
+static uint32_t peek_seq(const std::string& rec) {
+  uint32_t seq = 0xFFFFFFFF;
+  WSS_CHECK(wss_log_record_peek(rec.data(), rec.size(), &seq, nullptr, nullptr));
+  return seq;
+}
+
+// A line as EventLogger serializes it.
+static std::string logger_line(const char* ts, const char* seq, const char* msg,
+                               const std::string& extra, bool chained) {
+  std::string s = std::string("{\"ts\":\"") + ts + "\",\"seq\":" + seq +
+                  ",\"event_type\":\"nfc_scan\",\"severity\":\"info\",\"source\":\"nfc\","
+                  "\"msg\":\"" + msg + "\"" + extra;
+  if (chained) {
+    s += ",\"prev_hash\":\"" + hex64() + "\",\"hash\":\"" + hex64() + "\"}";
+  } else {
+    s += ",\"prev_hash\":null,\"hash\":null}";
+  }
+  return s;
+}
+
+static void test_logger_lines() {
+  for (int i = 0; i < 500; i++) {
+    char ts[24];
+    char seq[12];
+    char extra[96];
+    snprintf(ts, sizeof(ts), "2026-%02d-%02dT%02d:%02d:%02dZ", 1 + i % 12, 1 + i % 28, i % 24,
+             i % 60, i * 7 % 60);
+    snprintf(seq, sizeof(seq), "%u", 100000u + (unsigned)i);
+    snprintf(extra, sizeof(extra),
+             ",\"extra\":{\"result\":\"allow\",\"role\":\"admin\",\"elapsed_ms\":%u}",
+             (unsigned)i * 13);
+    const std::string line = logger_line(ts, seq, "NFC scan allowed", extra, i % 5 != 0);
+    const std::string rec = round_trip(line);
+    WSS_CHECK_EQ(peek_seq(rec), 100000u + (unsigned)i);
+    WSS_CHECK(rec.size() < line.size() / 2);
+  }
+  round_trip("{\"ts\":\"1970-01-01T00:00:05Z\",\"seq\":0,\"event_type\":\"boot\","
+             "\"severity\":\"info\",\"source\":\"core\",\"msg\":\"boot\",\"time_valid\":false,"
+             "\"prev_hash\":null,\"hash\":null}");
+  round_trip("{\"ts\":\"2026-01-23T19:46:12Z\",\"seq\":4096,\"event_type\":\"log_checkpoint\","
+             "\"extra\":{\"first_seq\":1,\"last_seq\":4096,\"lines\":4096,\"merkle_root\":\"" +
+             hex64() + "\"},\"prev_hash\":\"" + hex64() + "\",\"hash\":\"" + hex64() + "\"}");
+}
+
+// Timestamps that do not print back the same way stay literal text.
+static void test_non_canonical_timestamps() {
+  const char* const stamps[] = {
+      "2026-02-30T00:00:00Z", "2026-1-05T10:00:00Z",   "2026-01-23T19:46:12.123Z",
+      "2026-01-23T24:00:00Z", "2026-01-23T19:60:00Z",  "2026-01-23t19:46:12z",
+      "2026-01-23T19:46:12",  "2026-01-23T19:46:12+02:00", "1969-12-31T23:59:59Z",
+      "2106-01-01T00:00:00Z", "0000-00-00T00:00:00Z",  "2026-13-01T00:00:00Z",
+      "1970-01-01T00:00:00Z", "2105-12-31T23:59:59Z",
+  };
+  for (const char* ts : stamps) {
+    const std::string rec = round_trip(logger_line(ts, "12", "t", "", true));
+    WSS_CHECK_EQ(peek_seq(rec), 12);
+  }
+}
+
+// Numbers with leading zeros (and seqs that are not canonical) are not tokenized as numbers.
+static void test_leading_zeros() {
+  const char* const seqs[] = {"007", "00", "0", "0123", "4294967295", "4294967296",
+                              "99999999999", "-1", "1e5", "12.0"};
+  for (const char* seq : seqs) {
+    round_trip(logger_line("2026-01-23T19:46:12Z", seq, "z", "", false));
+  }
+  WSS_CHECK_EQ(peek_seq(encode(logger_line("2026-01-23T19:46:12Z", "007", "z", "", false))), 0);
+  WSS_CHECK_EQ(peek_seq(encode(logger_line("2026-01-23T19:46:12Z", "0", "z", "", false))), 0);
+  WSS_CHECK_EQ(peek_seq(encode(logger_line("2026-01-23T19:46:12Z", "4294967295", "z", "",
+                                           false))),
+               4294967295u);
+  round_trip("{\"n\":0123456789012345678901234,\"m\":000,\"k\":-0010,\"f\":1.050,\"z\":1000000}");
+  round_trip("{\"elapsed_ms\":18446744073709551615,\"x\":99999999999999999999999}");
+}
+
+// A msg that quotes another line carries an escaped `\"seq\":`; the header seq is the key.
+static void test_escaped_seq_in_msg() {
+  const std::string msg = "replayed {\\\"seq\\\":41,\\\"hash\\\":\\\"" + hex64() + "\\\"}";
+  const std::string rec = round_trip(logger_line("2026-01-23T19:46:12Z", "42", msg.c_str(),
+                                                 "", true));
+  WSS_CHECK_EQ(peek_seq(rec), 42);
+
+  // Quoted before the real key, and with no real key at all.
+  const std::string early = "{\"msg\":\"x \\\"seq\\\":7\",\"seq\":9,\"hash\":null}";
+  WSS_CHECK_EQ(peek_seq(round_trip(early)), 9);
+  const std::string none = "{\"msg\":\"x \\\"seq\\\":7\",\"hash\":null}";
+  WSS_CHECK_EQ(peek_seq(round_trip(none)), 0);
+  // An escaped backslash before the quote closes the string: that one is the key.
+  const std::string closed = "{\"msg\":\"x\\\\\",\"seq\":5}";
+  WSS_CHECK_EQ(peek_seq(round_trip(closed)), 5);
+}
+
+// Stuffing bytes, marker bytes and other control/high bytes anywhere in the text.
+static void test_stuffing_bytes() {
+  const std::string ctl = std::string("esc \x1B[31m red \x1B[0m nl \n cr \r rs \x1E us \x1F") +
+                          " del \x7F hi \xC3\xA9 \xFF";
+  round_trip(logger_line("2026-01-23T19:46:12Z", "27", ctl.c_str(), "", true));
+  round_trip("\x1B");
+  round_trip("\n");
+  round_trip("\x1B\x1B\n\n\r\x1B");
+  round_trip("");
+  round_trip("plain not json \x1B\x1E");
+
+  // Seq and hash bytes that are themselves stuffing values.
+  std::string hash(64, '0');
+  hash.replace(0, 8, "1b0a0d00");
+  const std::string line = "{\"ts\":\"2026-01-23T19:46:12Z\",\"seq\":" +
+                           std::to_string(0x0A0D1B00u) + ",\"prev_hash\":\"" + hash +
+                           "\",\"hash\":\"" + hash + "\"}";
+  const std::string rec = round_trip(line);
+  WSS_CHECK_EQ(peek_seq(rec), 0x0A0D1B00u);
+
+  const char alphabet[] = "{}\":,0123456789abcdefTZ-seqhash_ \x1B\r\n\x1E\x7F\xC3\xA9\\";
+  for (int i = 0; i < 20000; i++) {
+    std::string t;
+    const int n = (int)(rnd() % 300);
+    for (int k = 0; k < n; k++) t += alphabet[rnd() % (sizeof(alphabet) - 1)];
+    round_trip(t);
+  }
+}
+
+static void test_peek_head_only() {
+  const std::string line =
+      logger_line("2026-01-23T19:46:12Z", "100005", "NFC scan allowed", "", true);
+  const std::string rec = encode(line);
+  uint32_t seq = 0;
+  bool has_hash = false;
+  uint8_t hash[32];
+  // The first 141 bytes always hold the head.
+  WSS_CHECK(wss_log_record_peek(rec.data(), rec.size() < 141 ? rec.size() : 141, &seq,
+                                &has_hash, hash));
+  WSS_CHECK_EQ(seq, 100005);
+  WSS_CHECK(has_hash);
+  static const char kHex[] = "0123456789abcdef";
+  std::string hex;
+  for (uint8_t b : hash) {
+    hex += kHex[b >> 4];
+    hex += kHex[b & 0x0F];
+  }
+  WSS_CHECK(line.compare(line.size() - 66, 64, hex) == 0);
+}
+
+static void test_corrupt_records_rejected() {
+  const std::string rec =
+      encode(logger_line("2026-01-23T19:46:12Z", "8", "NFC scan allowed", "", true));
+  size_t n = 0;
+  char buf[WSS_LOG_LINE_MAX + 1];
+  for (size_t cut = 1; cut < rec.size(); cut++) {
+    WSS_CHECK(!wss_log_record_decode(rec.data(), cut, buf, sizeof(buf), n));
+  }
+  std::string extra = rec + "x";
+  WSS_CHECK(!wss_log_record_decode(extra.data(), extra.size(), buf, sizeof(buf), n));
+  std::string version = rec;
+  version[1] = 0x07;
+  WSS_CHECK(!wss_log_record_decode(version.data(), version.size(), buf, sizeof(buf), n));
+  std::string dangling = encode("abc") + "\x1B";
+  WSS_CHECK(!wss_log_record_decode(dangling.data(), dangling.size(), buf, sizeof(buf), n));
+}
+
+// A day file with text and binary lines, fed in odd chunks, comes out as the original JSONL;
+// a torn binary tail is dropped and counted.
+static void test_jsonl_export() {
+  std::vector<std::string> lines;
+  for (int i = 0; i < 300; i++) {
+    char ts[24];
+    char seq[12];
+    snprintf(ts, sizeof(ts), "2026-01-%02dT%02d:%02d:%02dZ", 1 + i % 28, i % 24, i % 60,
+             i * 7 % 60);
+    snprintf(seq, sizeof(seq), "%u", 500u + (unsigned)i);
+    const char* msg = i % 7 == 0 ? "esc \x1B[0m rs \x1E" : "NFC scan allowed";
+    lines.push_back(logger_line(ts, seq, msg, "", i % 4 != 0));
+  }
+  lines.push_back(logger_line("2026-02-30T00:00:00Z", "007", "quoted \\\"seq\\\":1", "", true));
+
+  std::string file;
+  std::string want;
+  for (size_t i = 0; i < lines.size(); i++) {
+    file += i % 3 == 0 ? lines[i] : encode(lines[i]);
+    file += '\n';
+    want += lines[i] + '\n';
+  }
+  const std::string torn = encode(lines[1]);
+  file += torn.substr(0, 40);
+
+  StringSink sink;
+  WssLogJsonlExport ex;
+  WSS_CHECK(ex.begin(sink));
+  for (size_t pos = 0; pos < file.size();) {
+    size_t n = 1 + rnd() % 700;
+    if (n > file.size() - pos) n = file.size() - pos;
+    WSS_CHECK_EQ(ex.write(reinterpret_cast<const uint8_t*>(file.data()) + pos, n), n);
+    pos += n;
+  }
+  WSS_CHECK(ex.finish());
+  WSS_CHECK(sink.s == want);
+  WSS_CHECK_EQ(ex.bytes_out(), want.size());
+  WSS_CHECK_EQ(ex.records(), lines.size() - (lines.size() + 2) / 3);
+  WSS_CHECK_EQ(ex.dropped(), 1);
+}
+
+int main() {
+  WSS_RUN(test_logger_lines);
+  WSS_RUN(test_non_canonical_timestamps);
+  WSS_RUN(test_leading_zeros);
+  WSS_RUN(test_escaped_seq_in_msg);
+  WSS_RUN(test_stuffing_bytes);
+  WSS_RUN(test_peek_head_only);
+  WSS_RUN(test_corrupt_records_rejected);
+  WSS_RUN(test_jsonl_export);
+  return 0;
+}
@@ -0,0 +1,145 @@
+// test/host/test_seq_lease.cpp
+// Role: Power-loss checks for the leased seq allocator: a reset at any point inside a
+// lease, and failed lease commits, must never make a seq come out twice.
+
+#include <Arduino.h>
+
+#include "logging/seq_lease.h"
+#include "wss_test.h"
+
+// The NVS key as the lease sees it. `fail_stores` makes the next N commits fail.
+struct FakeStore {
+  uint32_t value = 0;
+  bool present = true;     // load() works
+  uint32_t fail_stores = 0;
+  uint32_t stores = 0;
+};
+
+static bool load_fn(uint32_t& out, void* ctx) {
+  FakeStore* s = static_cast<FakeStore*>(ctx);
+  if (!s->present) return false;
+  out = s->value;
+  return true;
+}
+
+static bool store_fn(uint32_t high_water, void* ctx) {
+  FakeStore* s = static_cast<FakeStore*>(ctx);
+  if (s->fail_stores) {
+    s->fail_stores--;
+    return false;
+  }
+  s->value = high_water;
+  s->stores++;
+  return true;
+}
+
+// A reset is a fresh allocator over the same store (RAM state lost).
+static void reset(WssSeqLease& lease, FakeStore& store, uint32_t block) {
+  lease = WssSeqLease();
+  lease.begin(block, load_fn, store_fn, &store);
+}
+
+static void test_reset_anywhere_in_lease() {
+  const uint32_t block = 8;
+  for (uint32_t cut = 0; cut <= 3 * block; cut++) {
+    FakeStore store;
+    WssSeqLease lease;
+    reset(lease, store, block);
+    uint32_t last = 0;
+    for (uint32_t i = 0; i < cut; i++) {
+      const uint32_t seq = lease.next();
+      WSS_CHECK(seq > last);
+      last = seq;
+    }
+    reset(lease, store, block);
+    WSS_CHECK(lease.stats().persistent);
+    WSS_CHECK(lease.next() > last);
+  }
+}
+
+static void test_one_commit_per_block() {
+  FakeStore store;
+  WssSeqLease lease;
+  reset(lease, store, 256);
+  for (uint32_t i = 1; i <= 1000; i++) WSS_CHECK_EQ(lease.next(), i);
+  WSS_CHECK_EQ(store.stores, 4);
+  WSS_CHECK_EQ(lease.stats().commits, 4);
+  WSS_CHECK_EQ(lease.stats().commits_avoided, 996);
+  WSS_CHECK_EQ(store.value, 1024);
+}
+
+static void test_random_resets() {
+  FakeStore store;
+  WssSeqLease lease;
+  reset(lease, store, 16);
+  uint32_t last = 0;
+  uint32_t rng = 12345;
+  for (int i = 0; i < 20000; i++) {
+    rng = rng * 1103515245u + 12345u;
+    if ((rng >> 16) % 37 == 0) {
+      reset(lease, store, 16);
+      continue;
+    }
+    const uint32_t seq = lease.next();
+    WSS_CHECK(seq > last);
+    last = seq;
+  }
+}
+
+// A failed commit leaves seqs past the persisted mark. The commit is retried on the next
+// call, not a block later, so once the store accepts writes again a reset cannot hand out
+// any of them twice.
+static void test_failed_store_then_reset() {
+  const uint32_t block = 8;
+  for (uint32_t failures = 1; failures <= 2 * block; failures++) {
+    FakeStore store;
+    WssSeqLease lease;
+    reset(lease, store, block);
+    uint32_t last = 0;
+    for (uint32_t i = 0; i < block; i++) last = lease.next();
+    store.fail_stores = failures;  // the commit at the lease boundary and retries fail
+    for (uint32_t i = 0; i <= failures; i++) {
+      const uint32_t seq = lease.next();
+      WSS_CHECK(seq > last);
+      last = seq;
+    }
+    WSS_CHECK_EQ(store.fail_stores, 0);
+    WSS_CHECK_EQ(lease.stats().commit_failures, failures);
+    WSS_CHECK(store.value >= last);  // the store covers every seq issued so far
+
+    reset(lease, store, block);
+    WSS_CHECK(lease.next() > last);
+  }
+}
+
+// Store unavailable at boot: seqs still come (RAM only) and the stats say so.
+static void test_store_unavailable() {
+  FakeStore store;
+  store.present = false;
+  WssSeqLease lease;
+  reset(lease, store, 8);
+  WSS_CHECK(!lease.stats().persistent);
+  WSS_CHECK_EQ(lease.next(), 1);
+  WSS_CHECK_EQ(lease.next(), 2);
+  WSS_CHECK_EQ(store.stores, 0);
+}
+
+// Older firmware stored the last used seq; it resumes past it like any lease mark.
+static void test_resume_past_legacy_value() {
+  FakeStore store;
+  store.value = 41;
+  WssSeqLease lease;
+  reset(lease, store, 8);
+  WSS_CHECK_EQ(lease.next(), 42);
+  WSS_CHECK_EQ(store.value, 49);
+}
+
+int main() {
+  WSS_RUN(test_reset_anywhere_in_lease);
+  WSS_RUN(test_one_commit_per_block);
+  WSS_RUN(test_random_resets);
+  WSS_RUN(test_failed_store_then_reset);
+  WSS_RUN(test_store_unavailable);
+  WSS_RUN(test_resume_past_legacy_value);
+  return 0;
+}
@@ -0,0 +1,276 @@
+// test/host/test_storage_backend.cpp
+// Role: Runs the SD log tier's file formats (day files, index, chain state, retention and
+// monthly archives) on the host directory and fault-injection backends, and checks what
+// the log tier sees when the card runs out of space, tears a write or turns slow.
+
+#include <Arduino.h>
+
+#include "storage/log_chain_state.h"
+#include "storage/log_index.h"
+#include "storage/log_retention.h"
+#include "storage/storage_backend_fault.h"
+#include "storage/storage_backend_posix.h"
+#include "storage/storage_backend_ram.h"
+#include "storage/storage_backend_timed.h"
+#include "wss_test.h"
+
+static const int kLineBytes = 110;  // every test line has exactly this length
+
+static bool mkdirs_for(WssStorageBackend* fs, uint32_t date) {
+  const String key = WssLogIndex::key_for(date);
+  const String y = "/logs/" + key.substring(0, 4);
+  const String m = y + "/" + key.substring(5, 7);
+  if (!fs->exists("/logs") && !fs->mkdir("/logs")) return false;
+  if (!fs->exists(y.c_str()) && !fs->mkdir(y.c_str())) return false;
+  return fs->exists(m.c_str()) || fs->mkdir(m.c_str());
+}
+
+// Writes `lines` JSONL lines (seq0, seq0+1, ...) as one write each. Returns false at the
+// first short write or failed sync; `wrote` is what the backend accepted.
+static bool write_day(WssStorageBackend* fs, uint32_t date, uint32_t seq0, int lines,
+                      size_t* wrote = nullptr) {
+  if (wrote) *wrote = 0;
+  if (!mkdirs_for(fs, date)) return false;
+  WssStorageFile f =
+    fs->open(WssLogIndex::path_for(date).c_str(), WSS_FS_RDWR | WSS_FS_CREATE | WSS_FS_TRUNC);
+  if (!f) return false;
+  const String key = WssLogIndex::key_for(date);
+  for (int i = 0; i < lines; i++) {
+    char buf[160];
+    int n = snprintf(buf, sizeof(buf),
+                     "{\"ts\":\"%sT00:00:00Z\",\"seq\":%lu,\"msg\":\"line %04d\","
+                     "\"prev_hash\":null,\"hash\":null}",
+                     key.c_str(), (unsigned long)(seq0 + i), i);
+    while (n < kLineBytes - 1) buf[n++] = ' ';
+    buf[n++] = '\n';
+    const size_t w = f.write(buf, (size_t)n);
+    if (wrote) *wrote += w;
+    if (w != (size_t)n) return false;
+  }
+  return f.sync();
+}
+
+// A fresh subdirectory of the test's scratch directory, as a backend root.
+static String scratch_root(const char* name) {
+  WssPosixBackend top(WSS_TEST_DIR);
+  const String sub = String("/") + name;
+  WSS_CHECK(top.mkdir(sub.c_str()));
+  return String(WSS_TEST_DIR) + sub;
+}
+
+static void run_pipeline(WssStorageBackend* fs) {
+  for (uint32_t d = 1; d <= 20; d++) WSS_CHECK(write_day(fs, 20260100 + d, d * 1000, 200));
+
+  WssLogIndex index;
+  WSS_CHECK(index.begin(fs));  // no index.bin yet: rebuilt from the tree
+  WSS_CHECK_EQ(index.count(), 20);
+  WssLogIndexEntry e;
+  WSS_CHECK(index.find(20260105, e));
+  WSS_CHECK_EQ(e.first_seq, 5000);
+  WSS_CHECK_EQ(e.last_seq, 5199);
+  WSS_CHECK_EQ(e.size_bytes, 200 * kLineBytes);
+  WSS_CHECK_EQ(e.format, WSS_LOG_FILE_JSONL);
+
+  WssLogChainState chain;
+  WSS_CHECK(chain.begin(fs));
+  WssLogChainStateRecord r;
+  r.date = 20260120;
+  r.seq = 20199;
+  r.offset = 123;
+  WSS_CHECK(chain.store(r));
+  WssLogChainStateRecord back;
+  WSS_CHECK(chain.load(back));
+  WSS_CHECK_EQ(back.seq, 20199);
+  WSS_CHECK_EQ(back.offset, 123);
+
+  WssLogRetention ret;
+  WSS_CHECK(ret.begin(fs, &index));
+  WssLogRetentionPolicy p;
+  p.age_cutoff = 20260104;
+  p.archive_cutoff = 20260110;
+  p.active_date = 20260120;
+  WSS_CHECK(ret.start(p));
+  while (ret.step()) {
+  }
+  const WssLogRetentionStats st = ret.stats();
+  WSS_CHECK(st.last_error.length() == 0);
+  WSS_CHECK_EQ(st.files_deleted, 3);
+  WSS_CHECK_EQ(st.days_archived, 6);
+  WSS_CHECK_EQ(index.count(), 11);
+  WSS_CHECK(!fs->exists(WssLogIndex::path_for(20260102).c_str()));
+  uint64_t size = 0;
+  bool is_dir = true;
+  WSS_CHECK(fs->stat("/logs/2026/01/archive_2026-01.jsonl.gz", size, is_dir));
+  WSS_CHECK(!is_dir && size > 0);
+
+  // A fresh mount reads the index back instead of rebuilding it.
+  WssLogIndex again;
+  WSS_CHECK(again.begin(fs));
+  WSS_CHECK_EQ(again.count(), 11);
+  WSS_CHECK_EQ(again.rebuilds(), 0);
+}
+
+static void test_pipeline_posix() {
+  const String root = scratch_root("pipeline");
+  WssPosixBackend fs(root.c_str());
+  WSS_CHECK(fs.probe());
+  run_pipeline(&fs);
+}
+
+static void test_pipeline_fault_passthrough() {
+  // No faults set: the decorator must be invisible.
+  const String root = scratch_root("passthrough");
+  WssPosixBackend posix(root.c_str());
+  WssFaultBackend fs(&posix);
+  run_pipeline(&fs);
+  WSS_CHECK(fs.fault_stats().writes > 0);
+  WSS_CHECK_EQ(fs.fault_stats().short_writes, 0);
+}
+
+static void test_posix_semantics() {
+  const String root = scratch_root("semantics");
+  WssPosixBackend fs(root.c_str());
+  WSS_CHECK(fs.mkdir("/sem"));
+  {
+    WssStorageFile f = fs.open("/sem/a", WSS_FS_WRITE | WSS_FS_CREATE);
+    WSS_CHECK(f);
+    WSS_CHECK_EQ(f.write("hello", 5), 5);
+    WSS_CHECK(f.sync());
+  }
+  {
+    WssStorageFile f = fs.open("/sem/b", WSS_FS_WRITE | WSS_FS_CREATE);
+    WSS_CHECK(f);
+  }
+  WSS_CHECK(!fs.rename("/sem/a", "/sem/b"));  // the target exists, as on the card
+  WSS_CHECK(fs.remove("/sem/b"));
+  WSS_CHECK(fs.rename("/sem/a", "/sem/b"));
+  {
+    WssStorageFile f = fs.open("/sem/b", WSS_FS_WRITE | WSS_FS_APPEND);
+    WSS_CHECK(f);
+    WSS_CHECK_EQ(f.write(" world", 6), 6);
+  }
+  WssStorageFile f = fs.open("/sem/b", WSS_FS_READ);
+  char buf[16] = {0};
+  WSS_CHECK_EQ(f.read(buf, sizeof(buf)), 11);
+  WSS_CHECK(strcmp(buf, "hello world") == 0);
+  WSS_CHECK(!fs.open("/sem/missing", WSS_FS_READ));
+  uint64_t total = 0;
+  uint64_t free_bytes = 0;
+  WSS_CHECK(fs.space(total, free_bytes) && total > 0);
+}
+
+static void test_enospc() {
+  const String root = scratch_root("enospc");
+  WssPosixBackend posix(root.c_str());
+  WssFaultBackend fs(&posix);
+  WssStorageFaults f;
+  f.space_bytes = 50 * kLineBytes + 40;  // room for 50 lines and part of the 51st
+  fs.set_faults(f);
+  size_t wrote = 0;
+  WSS_CHECK(!write_day(&fs, 20260201, 1, 100, &wrote));
+  WSS_CHECK_EQ(wrote, f.space_bytes);
+  WSS_CHECK_EQ(fs.fault_stats().short_writes, 1);
+  uint64_t total = 0;
+  uint64_t free_bytes = 1;
+  WSS_CHECK(fs.space(total, free_bytes));
+  WSS_CHECK_EQ(free_bytes, 0);
+
+  // The index sees the 50 complete lines; the cut one is not counted.
+  fs.set_faults(WssStorageFaults());
+  WssLogIndex index;
+  WSS_CHECK(index.begin(&fs));
+  WssLogIndexEntry e;
+  WSS_CHECK(index.find(20260201, e));
+  WSS_CHECK_EQ(e.first_seq, 1);
+  WSS_CHECK_EQ(e.last_seq, 50);
+}
+
+static void test_torn_write() {
+  const String root = scratch_root("torn");
+  WssPosixBackend posix(root.c_str());
+  WssFaultBackend fs(&posix);
+  WssStorageFaults f;
+  f.torn_write_at = 10;
+  fs.set_faults(f);
+  size_t wrote = 0;
+  WSS_CHECK(!write_day(&fs, 20260301, 1, 100, &wrote));
+  WSS_CHECK_EQ(wrote, 9 * kLineBytes + kLineBytes / 2);
+  WSS_CHECK_EQ(fs.fault_stats().torn_writes, 1);
+  WSS_CHECK_EQ(fs.fault_stats().short_writes, 1);
+
+  uint64_t size = 0;
+  bool is_dir = true;
+  WSS_CHECK(posix.stat(WssLogIndex::path_for(20260301).c_str(), size, is_dir));
+  WSS_CHECK_EQ(size, wrote);  // the half line really is on disk
+
+  WssLogIndex index;
+  WSS_CHECK(index.begin(&posix));
+  WssLogIndexEntry e;
+  WSS_CHECK(index.find(20260301, e));
+  WSS_CHECK_EQ(e.last_seq, 9);
+}
+
+static void test_slow_writes() {
+  WssRamBackend ram;
+  WssFaultBackend fault(&ram);
+  WssTimedBackend fs(&fault);
+  WssStorageFaults f;
+  f.write_delay_ms = 2;  // every write lands in the 1-4 ms bucket...
+  f.stall_every = 25;    // ...and every 25th stalls like a card erasing a block
+  f.stall_ms = 300;
+  f.sync_delay_ms = 20;
+  fault.set_faults(f);
+  WSS_CHECK(write_day(&fs, 20260401, 1, 100));  // slow, but nothing is lost
+  WSS_CHECK_EQ(fault.fault_stats().writes, 100);
+  WSS_CHECK_EQ(fault.fault_stats().stalls, 4);
+  WSS_CHECK_EQ(fault.fault_stats().short_writes, 0);
+
+  const WssLatencyHist& w = fs.hist(WSS_STORAGE_OP_APPEND);
+  WSS_CHECK_EQ(w.count, 100);
+  WSS_CHECK(w.max_us >= 302000);
+  WSS_CHECK_EQ(w.buckets[6], 4);   // 256 ms .. 1 s
+  WSS_CHECK(w.buckets[2] >= 90);   // 1 .. 4 ms (host scheduling may push a few higher)
+  const WssLatencyHist& s = fs.hist(WSS_STORAGE_OP_FLUSH);
+  WSS_CHECK_EQ(s.count, 1);
+  WSS_CHECK(s.max_us >= 20000);
+
+  WssLogIndex index;
+  WSS_CHECK(index.begin(&fs));
+  WssLogIndexEntry e;
+  WSS_CHECK(index.find(20260401, e));
+  WSS_CHECK_EQ(e.last_seq, 100);
+}
+
+static void test_failed_sync_open_probe() {
+  WssRamBackend ram;
+  WssFaultBackend fs(&ram);
+  WssStorageFaults f;
+  f.fail_sync = true;
+  fs.set_faults(f);
+  WSS_CHECK(!write_day(&fs, 20260501, 1, 10));
+  WSS_CHECK_EQ(fs.fault_stats().failed_syncs, 1);
+  WssLogIndex index;
+  WSS_CHECK(index.begin(&ram));
+  WssLogIndexEntry e;
+  WSS_CHECK(index.find(20260501, e));
+  WSS_CHECK_EQ(e.last_seq, 10);  // the data still reached the medium
+
+  f = WssStorageFaults();
+  f.fail_open = true;
+  f.fail_probe = true;
+  fs.set_faults(f);
+  WSS_CHECK(!fs.open("/x", WSS_FS_WRITE | WSS_FS_CREATE));
+  WSS_CHECK(fs.open(WssLogIndex::path_for(20260501).c_str(), WSS_FS_READ));
+  WSS_CHECK(!fs.probe());
+}
+
+int main() {
+  WSS_RUN(test_pipeline_posix);
+  WSS_RUN(test_pipeline_fault_passthrough);
+  WSS_RUN(test_posix_semantics);
+  WSS_RUN(test_enospc);
+  WSS_RUN(test_torn_write);
+  WSS_RUN(test_slow_writes);
+  WSS_RUN(test_failed_sync_open_probe);
+  return 0;
+}
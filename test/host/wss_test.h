@@ -0,0 +1,33 @@
+// test/host/wss_test.h
+// Role: Minimal check macros for the host tests (no framework: each test is a program that
+// exits non-zero on the first failed check, which is what ctest looks at).
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WSS_CHECK(cond)                                                         \
+  do {                                                                          \
+    if (!(cond)) {                                                              \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      exit(1);                                                                  \
+    }                                                                           \
+  } while (0)
+
+#define WSS_CHECK_EQ(a, b)                                                          \
+  do {                                                                              \
+    const unsigned long long wss_a_ = (unsigned long long)(a);                      \
+    const unsigned long long wss_b_ = (unsigned long long)(b);                      \
+    if (wss_a_ != wss_b_) {                                                         \
+      fprintf(stderr, "%s:%d: check failed: %s == %s (%llu vs %llu)\n", __FILE__, \
+              __LINE__, #a, #b, wss_a_, wss_b_);                                    \
+      exit(1);                                                                      \
+    }                                                                               \
+  } while (0)
+
+// Runs one test function and reports it.
+#define WSS_RUN(fn)            \
+  do {                         \
+    fn();                      \
+    printf("  ok  %s\n", #fn); \
+  } while (0)